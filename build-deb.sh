@@ -74,11 +74,6 @@ check_dependency "g++"
 check_dependency "dpkg-deb"
 
 # Check for required libraries
-if ! pkg-config --exists pugixml; then
-    log_error "pugixml development package is required (libpugixml-dev)"
-    exit 1
-fi
-
 if ! pkg-config --exists gtk+-3.0; then
     log_warning "GTK+3 development package not found. GUI might not build properly."
 fi
@@ -278,7 +273,7 @@ Version: ${PACKAGE_VERSION}-${PACKAGE_REVISION}
 Architecture: ${PACKAGE_ARCHITECTURE}
 Maintainer: ${PACKAGE_MAINTAINER}
 Installed-Size: ${INSTALLED_SIZE}
-Depends: libc6 (>= 2.34), libgcc-s1 (>= 3.0), libstdc++6 (>= 11), libpugixml1v5, libwxbase3.2-1, libwxgtk3.2-1, libmapnik3.1 | libmapnik (>= 3.0)
+Depends: libc6 (>= 2.34), libgcc-s1 (>= 3.0), libstdc++6 (>= 11), libwxbase3.2-1, libwxgtk3.2-1, libmapnik3.1 | libmapnik (>= 3.0)
 Recommends: gdal-bin, nautilus | dolphin | nemo | pcmanfm
 Suggests: osmium-tool
 Section: utils
@@ -79,7 +79,7 @@ Version: ${PACKAGE_VERSION}
 Architecture: ${PACKAGE_ARCHITECTURE}
 Maintainer: Claude Code <noreply@anthropic.com>
 Installed-Size: ${INSTALLED_SIZE}
-Depends: libc6, libstdc++6, libpugixml1v5, libwxbase3.2-1, libwxgtk3.2-1
+Depends: libc6, libstdc++6, libwxbase3.2-1, libwxgtk3.2-1
 Section: utils
 Priority: optional
 Description: Garmin FIT file utilities suite
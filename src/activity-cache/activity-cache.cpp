@@ -0,0 +1,598 @@
+#include "activity-cache.hpp"
+
+#include "binary-mapper.hpp"
+#include "session-scanner.hpp"
+#include "convert.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace darauble {
+
+struct ActivityCache::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t count;
+    uint8_t reserved[40];
+};
+
+const std::string ActivityCache::FILE_NAME {".garmin-activities.cache"};
+
+static const char CACHE_MAGIC[8] = {'G', 'F', 'U', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t CACHE_VERSION = 1;
+static const size_t INITIAL_CAPACITY = 1024;
+
+static std::string trim(const std::string& str) {
+    size_t first = str.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+}
+
+template <typename T>
+static bool parseValue(const std::string& str, T& value) {
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    return result.ec == std::errc();
+}
+
+CachedActivity::CachedActivity() {
+    std::memset(this, 0, sizeof(CachedActivity));
+    swcLat = FIT_SINT32_INVALID;
+    swcLong = FIT_SINT32_INVALID;
+    necLat = FIT_SINT32_INVALID;
+    necLong = FIT_SINT32_INVALID;
+}
+
+void CachedActivity::assign(const ActivityData& data) {
+    SessionData aggregated = data.getAggregatedData();
+
+    status = STATUS_PARSED;
+    timestamp = aggregated.timestamp;
+    sport = data.primarySport;
+    subSport = data.primarySubSport;
+    sessionCount = static_cast<uint16_t>(data.sessions.size());
+    elapsedTime = aggregated.totalElapsedTime;
+    totalDistance = aggregated.totalDistance;
+    avgSpeed = aggregated.avgSpeed;
+    avgHeartRate = aggregated.avgHeartRate;
+    totalSets = aggregated.totalSets;
+    swcLat = aggregated.swcLat;
+    swcLong = aggregated.swcLong;
+    necLat = aggregated.necLat;
+    necLong = aggregated.necLong;
+    setName(data.activityName);
+}
+
+std::string CachedActivity::getName() const {
+    return std::string(name, strnlen(name, NAME_SIZE));
+}
+
+void CachedActivity::setName(const std::string& _name) {
+    size_t length = std::min(_name.size(), NAME_SIZE - 1);
+
+    // Don't cut a multi-byte character in half
+    if (length < _name.size()) {
+        while (length > 0 && (static_cast<uint8_t>(_name[length]) & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+
+    std::memset(name, 0, NAME_SIZE);
+    std::memcpy(name, _name.data(), length);
+}
+
+bool CachedActivity::hasBounds() const {
+    return necLat != FIT_SINT32_INVALID && necLong != FIT_SINT32_INVALID
+        && swcLat != FIT_SINT32_INVALID && swcLong != FIT_SINT32_INVALID;
+}
+
+#if !defined(_WIN32)
+static int64_t modifiedTime(const struct stat& st) {
+#if defined(__APPLE__)
+    return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+#endif
+
+fs::path ActivityCache::findRoot(const fs::path& directory) {
+    std::error_code ec;
+    fs::path start = fs::absolute(directory, ec).lexically_normal();
+    if (ec) {
+        return directory;
+    }
+    if (!start.has_filename()) {
+        start = start.parent_path();
+    }
+
+    for (fs::path dir = start; ; dir = dir.parent_path()) {
+        if (fs::is_regular_file(dir / FILE_NAME, ec)) {
+            return dir;
+        }
+        if (dir == dir.parent_path()) {
+            break;
+        }
+    }
+
+    return start;
+}
+
+uint64_t ActivityCache::hashPath(const std::string& relativePath) {
+    // FNV-1a, 0 marks an unused record
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : relativePath) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+uint16_t ActivityCache::readCrc(const fs::path& file) {
+    std::ifstream input(file, std::ios::binary | std::ios::ate);
+    if (!input) {
+        return 0;
+    }
+
+    std::streamsize size = input.tellg();
+    if (size < 2) {
+        return 0;
+    }
+
+    // CRC is stored at the end of FIT files
+    uint8_t crc[2] = {0, 0};
+    input.seekg(size - 2, std::ios::beg);
+    input.read(reinterpret_cast<char*>(crc), 2);
+    if (!input) {
+        return 0;
+    }
+
+    return static_cast<uint16_t>(crc[0]) | (static_cast<uint16_t>(crc[1]) << 8);
+}
+
+ActivityCache::ActivityCache(const fs::path& _root, bool _readOnly) :
+    fd {-1}, readOnly {_readOnly}, writable {false}, mapping {nullptr}, mappingSize {0}, capacity {0}
+{
+    std::error_code ec;
+    rootPath = fs::absolute(_root, ec).lexically_normal();
+    if (ec) {
+        rootPath = _root;
+    }
+    if (!rootPath.has_filename()) {
+        rootPath = rootPath.parent_path();
+    }
+    cachePath = rootPath / FILE_NAME;
+
+    open();
+}
+
+ActivityCache::~ActivityCache() {
+    close();
+}
+
+ActivityCache::Header* ActivityCache::header() const {
+    return reinterpret_cast<Header*>(mapping);
+}
+
+CachedActivity* ActivityCache::record(uint32_t position) const {
+    return reinterpret_cast<CachedActivity*>(mapping + sizeof(Header)) + position;
+}
+
+void ActivityCache::open() {
+    static_assert(sizeof(Header) == 64, "ActivityCache::Header is a file format record");
+
+#if !defined(_WIN32)
+    fd = readOnly ? -1 : ::open(cachePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    writable = fd >= 0;
+    if (fd < 0) {
+        fd = ::open(cachePath.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        // Read-only archive without a cache, files are parsed every time
+        return;
+    }
+
+    // The first process owns the cache, others only read it
+    if (writable && flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        writable = false;
+    }
+
+    Header existing {};
+    bool valid = pread(fd, &existing, sizeof(Header), 0) == sizeof(Header)
+        && std::memcmp(existing.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0
+        && existing.version == CACHE_VERSION
+        && existing.recordSize == sizeof(CachedActivity);
+
+    // New, truncated or from another version: start over
+    if (!valid && (!writable || !initialize())) {
+        close();
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        close();
+        return;
+    }
+
+    mappingSize = static_cast<size_t>(st.st_size);
+    void* address = mmap(nullptr, mappingSize, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        mapping = nullptr;
+        close();
+        return;
+    }
+    mapping = static_cast<uint8_t*>(address);
+    capacity = (mappingSize - sizeof(Header)) / sizeof(CachedActivity);
+
+    size_t count = std::min<size_t>(header()->count, capacity);
+    index.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        index[record(i)->pathHash] = i;
+    }
+#endif
+}
+
+void ActivityCache::close() {
+#if !defined(_WIN32)
+    if (mapping) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd); // Releases the lock as well
+        fd = -1;
+    }
+#endif
+    mappingSize = 0;
+    capacity = 0;
+    writable = false;
+    index.clear();
+}
+
+bool ActivityCache::initialize() {
+#if !defined(_WIN32)
+    Header fresh {};
+    std::memcpy(fresh.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    fresh.version = CACHE_VERSION;
+    fresh.recordSize = sizeof(CachedActivity);
+    fresh.count = 0;
+
+    return ftruncate(fd, 0) == 0
+        && ftruncate(fd, sizeof(Header) + INITIAL_CAPACITY * sizeof(CachedActivity)) == 0
+        && pwrite(fd, &fresh, sizeof(Header), 0) == sizeof(Header);
+#else
+    return false;
+#endif
+}
+
+bool ActivityCache::grow() {
+#if !defined(_WIN32)
+    size_t newSize = sizeof(Header) + std::max(capacity * 2, INITIAL_CAPACITY) * sizeof(CachedActivity);
+    if (ftruncate(fd, newSize) != 0) {
+        return false;
+    }
+
+    void* address = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+
+    munmap(mapping, mappingSize);
+    mapping = static_cast<uint8_t*>(address);
+    mappingSize = newSize;
+    capacity = (mappingSize - sizeof(Header)) / sizeof(CachedActivity);
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t ActivityCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+bool ActivityCache::relativeKey(const fs::path& file, uint64_t& hash) const {
+    std::error_code ec;
+    fs::path relative = fs::absolute(file, ec).lexically_normal().lexically_relative(rootPath);
+    if (ec || relative.empty() || *relative.begin() == "..") {
+        return false;
+    }
+
+    hash = hashPath(relative.generic_string());
+    return true;
+}
+
+CachedActivity* ActivityCache::find(uint64_t hash) const {
+    auto it = index.find(hash);
+    return it != index.end() ? record(it->second) : nullptr;
+}
+
+void ActivityCache::put(const CachedActivity& activity) {
+    if (!mapping || !writable) {
+        return;
+    }
+
+    if (CachedActivity* existing = find(activity.pathHash)) {
+        *existing = activity;
+        return;
+    }
+
+    uint32_t position = static_cast<uint32_t>(header()->count);
+    if (position >= capacity && !grow()) {
+        return;
+    }
+
+    // The record is complete before the count makes it visible
+    *record(position) = activity;
+    header()->count = position + 1;
+    index[activity.pathHash] = position;
+}
+
+bool ActivityCache::peek(const fs::path& file, CachedActivity& activity) const {
+    uint64_t hash = 0;
+    if (!isOpen() || !relativeKey(file, hash)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CachedActivity* existing = find(hash);
+    if (!existing || (existing->flags & CachedActivity::FLAG_NAME_ONLY)) {
+        return false;
+    }
+    activity = *existing;
+    return true;
+}
+
+bool ActivityCache::lookup(const fs::path& file, CachedActivity& activity) {
+#if !defined(_WIN32)
+    uint64_t hash = 0;
+    struct stat st;
+    if (!isOpen() || !relativeKey(file, hash) || ::stat(file.c_str(), &st) != 0) {
+        return false;
+    }
+
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (CachedActivity* existing = find(hash)) {
+            activity = *existing;
+            found = true;
+        }
+    }
+
+    if (!found && !importSidecar(file, hash)) {
+        return false;
+    }
+    if (!found) {
+        std::lock_guard<std::mutex> lock(mutex);
+        CachedActivity* imported = find(hash);
+        if (!imported) {
+            return false;
+        }
+        activity = *imported;
+    }
+
+    if ((activity.flags & CachedActivity::FLAG_NAME_ONLY) || activity.fileSize != static_cast<uint64_t>(st.st_size)) {
+        return false;
+    }
+
+    int64_t modified = modifiedTime(st);
+    if (activity.modified != modified) {
+        // Touched or copied: unchanged if the CRC is still the same
+        uint16_t crc = readCrc(file);
+        if (crc == 0 || crc != activity.crc) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (CachedActivity* existing = writable ? find(hash) : nullptr) {
+            existing->modified = modified;
+        }
+        activity.modified = modified;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ActivityCache::importSidecar(const fs::path& file, uint64_t hash) {
+#if !defined(_WIN32)
+    if (!writable) {
+        return false;
+    }
+
+    fs::path metaPath = file;
+    metaPath.replace_extension(".meta");
+
+    std::ifstream input(metaPath);
+    if (!input) {
+        return false;
+    }
+
+    std::unordered_map<std::string, std::string> values;
+    std::string line;
+    while (std::getline(input, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        size_t equalPos = line.find('=');
+        if (equalPos != std::string::npos) {
+            values[trim(line.substr(0, equalPos))] = trim(line.substr(equalPos + 1));
+        }
+    }
+
+    CachedActivity activity;
+    activity.pathHash = hash;
+
+    std::string name = values["name"];
+    if (!name.empty()) {
+        // Sidecar names always won over the FIT file, keep it that way
+        activity.setName(name);
+        activity.flags |= CachedActivity::FLAG_USER_NAME;
+    }
+
+    // The summary is only usable if the sidecar has the typed values and matches the file
+    uint32_t checksum = 0;
+    struct stat st;
+    bool current = parseValue(values["checksum"], checksum)
+        && values.count("sport_id") > 0
+        && ::stat(file.c_str(), &st) == 0
+        && checksum != 0 && checksum == readCrc(file);
+
+    if (current) {
+        unsigned value = 0;
+        activity.fileSize = static_cast<uint64_t>(st.st_size);
+        activity.modified = modifiedTime(st);
+        activity.crc = static_cast<uint16_t>(checksum);
+        activity.status = CachedActivity::STATUS_PARSED;
+        parseValue(values["timestamp"], activity.timestamp);
+        activity.sport = parseValue(values["sport_id"], value) ? static_cast<uint8_t>(value) : 0;
+        activity.subSport = parseValue(values["sub_sport_id"], value) ? static_cast<uint8_t>(value) : 0;
+        activity.sessionCount = parseValue(values["sessions"], value) ? static_cast<uint16_t>(value) : 0;
+        activity.avgSpeed = parseValue(values["avg_speed"], value) ? static_cast<uint16_t>(value) : 0;
+        activity.avgHeartRate = parseValue(values["avg_hr"], value) ? static_cast<uint16_t>(value) : 0;
+        activity.totalSets = parseValue(values["total_sets"], value) ? static_cast<uint16_t>(value) : 0;
+        parseValue(values["elapsed_time"], activity.elapsedTime);
+        parseValue(values["distance_m"], activity.totalDistance);
+
+        // "minLat,minLon,maxLat,maxLon" in degrees, or "none"
+        const std::string& bounds = values["bounds"];
+        double corners[4];
+        size_t start = 0;
+        int parsed = 0;
+        while (parsed < 4 && start <= bounds.size()) {
+            size_t end = bounds.find(',', start);
+            if (end == std::string::npos) {
+                end = bounds.size();
+            }
+            if (!parseValue(bounds.substr(start, end - start), corners[parsed])) {
+                break;
+            }
+            parsed++;
+            start = end + 1;
+        }
+        if (parsed == 4) {
+            activity.swcLat = fromDouble(corners[0]);
+            activity.swcLong = fromDouble(corners[1]);
+            activity.necLat = fromDouble(corners[2]);
+            activity.necLong = fromDouble(corners[3]);
+        }
+    } else if (name.empty()) {
+        return false;
+    } else {
+        activity.flags |= CachedActivity::FLAG_NAME_ONLY;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!find(hash)) {
+        put(activity);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ActivityCache::store(const fs::path& file, CachedActivity& activity) {
+#if !defined(_WIN32)
+    uint64_t hash = 0;
+    struct stat st;
+    if (!isOpen() || !relativeKey(file, hash) || ::stat(file.c_str(), &st) != 0) {
+        return;
+    }
+
+    activity.pathHash = hash;
+    activity.fileSize = static_cast<uint64_t>(st.st_size);
+    activity.modified = modifiedTime(st);
+    activity.crc = readCrc(file);
+    activity.flags &= ~CachedActivity::FLAG_NAME_ONLY;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CachedActivity* existing = find(hash);
+    if (existing && (existing->flags & CachedActivity::FLAG_USER_NAME)) {
+        std::memcpy(activity.name, existing->name, CachedActivity::NAME_SIZE);
+        activity.flags |= CachedActivity::FLAG_USER_NAME;
+    }
+    put(activity);
+#endif
+}
+
+CachedActivity ActivityCache::load(const fs::path& file) {
+    CachedActivity activity;
+    if (lookup(file, activity)) {
+        GFU_TRACE_COUNT("cache.hit", 1);
+        return activity;
+    }
+
+    GFU_TRACE_COUNT("cache.miss", 1);
+
+    activity = CachedActivity();
+    try {
+        BinaryMapper mapper {file};
+        SessionScanner scanner {file.filename().string(), mapper};
+
+        scanner.scan();
+
+        if (scanner.hasData()) {
+            activity.assign(scanner.getData());
+        } else {
+            activity.status = CachedActivity::STATUS_NO_DATA;
+        }
+    } catch (const std::exception& e) {
+        activity.status = CachedActivity::STATUS_PARSE_ERROR;
+    }
+
+    // Broken files are cached too, they are parsed again only when they change
+    store(file, activity);
+    return activity;
+}
+
+bool ActivityCache::rename(const fs::path& file, const std::string& name) {
+    uint64_t hash = 0;
+    if (!relativeKey(file, hash)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CachedActivity* existing = writable ? find(hash) : nullptr;
+    if (!existing) {
+        return false;
+    }
+
+    existing->setName(name);
+    existing->flags |= CachedActivity::FLAG_USER_NAME;
+    return true;
+}
+
+void ActivityCache::flush() {
+    GFU_TRACE_SCOPE("cache.flush", "io");
+
+#if !defined(_WIN32)
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mapping && writable) {
+        msync(mapping, mappingSize, MS_ASYNC);
+    }
+#endif
+}
+
+} // namespace darauble
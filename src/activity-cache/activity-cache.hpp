@@ -0,0 +1,186 @@
+/*
+  One binary cache of parsed activity summaries per archive root, shared by garmin-edit and garmin-disconnect.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+namespace darauble {
+
+struct ActivityData;
+
+/*
+  A fixed-size cache record, stored in the cache file as is (host byte order).
+  The file identity (size, modification time, CRC) decides whether the summary is still valid.
+ */
+struct CachedActivity {
+    static const size_t NAME_SIZE = 176;
+
+    enum Status : uint8_t {
+        STATUS_PARSED = 0,
+        STATUS_NO_DATA = 1,     // A FIT file without sessions
+        STATUS_PARSE_ERROR = 2
+    };
+
+    enum Flags : uint8_t {
+        FLAG_USER_NAME = 0x01,  // Name was edited by the user, re-parsing keeps it
+        FLAG_NAME_ONLY = 0x02   // Only the name is known (imported from an outdated .meta), summary must be parsed
+    };
+
+    uint64_t pathHash;      // hashPath() of the path relative to the cache root, never 0
+    uint64_t fileSize;
+    int64_t modified;       // Modification time, nanoseconds since the epoch
+    uint32_t timestamp;     // FIT time of the first session
+    uint16_t crc;           // Last two bytes of the FIT file
+    uint8_t status;
+    uint8_t flags;
+    uint8_t sport;
+    uint8_t subSport;
+    uint16_t sessionCount;
+    uint16_t avgSpeed;      // m/s * 1000
+    uint16_t avgHeartRate;  // bpm
+    uint16_t totalSets;
+    uint16_t reserved16;
+    uint32_t reserved32;
+    double elapsedTime;     // seconds
+    double totalDistance;   // meters
+    int32_t swcLat;         // Bounding box of all sessions, semicircles, FIT_SINT32_INVALID without GPS
+    int32_t swcLong;
+    int32_t necLat;
+    int32_t necLong;
+    char name[NAME_SIZE];   // UTF-8, zero terminated
+
+    CachedActivity();
+
+    /*
+      Take the summary of a parsed activity, the name included.
+     */
+    void assign(const ActivityData& data);
+
+    std::string getName() const;
+
+    /*
+      Set the name, truncated at a character boundary if it doesn't fit.
+     */
+    void setName(const std::string& _name);
+
+    bool hasBounds() const;
+};
+
+static_assert(sizeof(CachedActivity) == 256, "CachedActivity is a file format record");
+
+/*
+  Memory-mapped cache file `.garmin-activities.cache` in the archive root.
+
+  Records are appended and updated in place, an in-memory hash index maps the path
+  hash to the record. A lookup costs one stat() of the FIT file: the record is valid
+  if the size and modification time match. If only the modification time differs
+  (e.g. the archive was copied), the CRC at the end of the file decides and the
+  record is refreshed.
+
+  Old per-file `.meta` sidecars are imported on the first miss, names found there
+  are kept as user-edited names.
+
+  Only one process may write the cache, others open it read-only (lookups only).
+  A cache opened read-only on purpose is never created or modified, just used if it exists.
+  If the cache file can't be created, every load() simply parses the file.
+  Thread-safe.
+ */
+class ActivityCache {
+private:
+    struct Header;
+
+    fs::path rootPath;
+    fs::path cachePath;
+    int fd;
+    bool readOnly;
+    bool writable;
+    uint8_t* mapping;
+    size_t mappingSize;
+    size_t capacity;            // Records that fit into the mapping
+    std::unordered_map<uint64_t, uint32_t> index;
+    mutable std::mutex mutex;
+
+    void open();
+    void close();
+    bool initialize();
+    bool grow();
+    Header* header() const;
+    CachedActivity* record(uint32_t position) const;
+
+    bool relativeKey(const fs::path& file, uint64_t& hash) const;
+    CachedActivity* find(uint64_t hash) const;
+    void put(const CachedActivity& activity);
+    bool importSidecar(const fs::path& file, uint64_t hash);
+
+public:
+    static const std::string FILE_NAME;
+
+    /*
+      The closest directory, starting with the given one, that already has a cache;
+      the directory itself if none of its parents has one.
+     */
+    static fs::path findRoot(const fs::path& directory);
+
+    static uint64_t hashPath(const std::string& relativePath);
+
+    /*
+      CRC of a FIT file (last 2 bytes), 0 if it can't be read.
+     */
+    static uint16_t readCrc(const fs::path& file);
+
+    /*
+      With _readOnly, an existing cache is only read (e.g. for listing a directory
+      on a watch or a read-only share) and no cache file is created.
+     */
+    explicit ActivityCache(const fs::path& _root, bool _readOnly = false);
+    ~ActivityCache();
+
+    ActivityCache(const ActivityCache&) = delete;
+    ActivityCache& operator=(const ActivityCache&) = delete;
+
+    const fs::path& root() const { return rootPath; }
+    bool isOpen() const { return mapping != nullptr; }
+    bool isWritable() const { return writable; }
+    size_t size() const;
+
+    /*
+      Cached summary of a file, if it is still valid.
+     */
+    bool lookup(const fs::path& file, CachedActivity& activity);
+
+    /*
+      Cached summary of a file as last seen, without looking at the file itself.
+      For showing a catalog right away, the result must be validated with lookup() later.
+     */
+    bool peek(const fs::path& file, CachedActivity& activity) const;
+
+    /*
+      Store a summary, taking the identity of the file as it is now.
+      A user-edited name in the cache wins over the name in the summary, which is updated.
+     */
+    void store(const fs::path& file, CachedActivity& activity);
+
+    /*
+      Cached summary, or parse the file and cache the result. Never throws for unreadable files,
+      they are returned with an error status.
+     */
+    CachedActivity load(const fs::path& file);
+
+    /*
+      Keep a user-edited name for an activity. The file must have been loaded before.
+     */
+    bool rename(const fs::path& file, const std::string& name);
+
+    /*
+      Write the modified pages back to the disk.
+     */
+    void flush();
+};
+
+} // namespace darauble
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+namespace darauble {
+
+/*
+  Counts the heap allocations of the whole program: linking this replaces the global
+  operator new. Counters are relaxed atomics, cheap enough to leave on in a benchmark.
+ */
+class AllocationCounter {
+public:
+    static uint64_t count();
+    static uint64_t bytes();
+};
+
+} // namespace darauble
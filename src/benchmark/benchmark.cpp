@@ -0,0 +1,153 @@
+#include "benchmark.hpp"
+#include "allocation-counter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <thread>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace darauble {
+
+namespace {
+
+class NullBuffer : public std::streambuf {
+protected:
+    virtual int overflow(int c) override { return c; }
+};
+
+std::string escape(const std::string& value) {
+    std::string escaped;
+
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+
+    return escaped;
+}
+
+} // namespace
+
+const BenchmarkResult& Benchmark::run(const std::string& name, const std::string& input, uint64_t bytes, uint64_t records,
+                                      const std::function<void()>& body, const std::function<void()>& prepare) {
+    std::vector<double> times;
+    uint64_t allocations {0};
+    uint64_t allocatedBytes {0};
+
+    NullBuffer nullBuffer;
+    std::streambuf* console = std::cout.rdbuf(&nullBuffer);
+
+    if (!prepare) {
+        body();
+    }
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        if (prepare) {
+            prepare();
+        }
+
+        uint64_t count = AllocationCounter::count();
+        uint64_t allocated = AllocationCounter::bytes();
+        auto start = std::chrono::steady_clock::now();
+
+        body();
+
+        auto end = std::chrono::steady_clock::now();
+        allocations += AllocationCounter::count() - count;
+        allocatedBytes += AllocationCounter::bytes() - allocated;
+        times.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    std::cout.rdbuf(console);
+
+    std::sort(times.begin(), times.end());
+
+    results.push_back({
+        name, input, prepare ? "cold" : "warm", iterations, bytes, records,
+        times.front(), times[times.size() / 2],
+        allocations / iterations, allocatedBytes / iterations
+    });
+
+    std::cerr << "  " << name << " [" << input << ", " << results.back().mode << "]: "
+        << std::fixed << std::setprecision(3) << results.back().best * 1000 << " ms" << std::endl;
+
+    return results.back();
+}
+
+void Benchmark::evict(const fs::path& filename) {
+#if defined(__linux__)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+
+    if (fd >= 0) {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#endif
+}
+
+void Benchmark::json(std::ostream& out, const std::string& version) const {
+    std::time_t now = std::time(nullptr);
+    std::tm utc = *std::gmtime(&now);
+
+    out << "{" << std::endl
+        << "  \"version\": \"" << escape(version) << "\"," << std::endl
+        << "  \"timestamp\": \"" << std::put_time(&utc, "%Y-%m-%dT%H:%M:%SZ") << "\"," << std::endl
+        << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << "," << std::endl
+        << "  \"benchmarks\": [" << std::endl;
+
+    out << std::setprecision(9) << std::defaultfloat;
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+
+        out << "    {"
+            << "\"name\": \"" << escape(r.name) << "\", "
+            << "\"input\": \"" << escape(r.input) << "\", "
+            << "\"mode\": \"" << r.mode << "\", "
+            << "\"iterations\": " << r.iterations << ", "
+            << "\"bytes\": " << r.bytes << ", "
+            << "\"records\": " << r.records << ", "
+            << "\"seconds_best\": " << r.best << ", "
+            << "\"seconds_median\": " << r.median << ", "
+            << "\"bytes_per_second\": " << r.bytesPerSecond() << ", "
+            << "\"records_per_second\": " << r.recordsPerSecond() << ", "
+            << "\"allocations\": " << r.allocations << ", "
+            << "\"allocated_bytes\": " << r.allocatedBytes
+            << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+
+    out << "  ]" << std::endl
+        << "}" << std::endl;
+}
+
+void Benchmark::summary(std::ostream& out) const {
+    out << std::left << std::setw(32) << "Benchmark" << std::setw(28) << "Input" << std::setw(6) << "Mode"
+        << std::right << std::setw(12) << "Best ms" << std::setw(12) << "MB/s"
+        << std::setw(14) << "Records/s" << std::setw(12) << "Allocs" << std::endl;
+
+    for (const auto& r : results) {
+        out << std::left << std::setw(32) << r.name << std::setw(28) << r.input.substr(0, 27) << std::setw(6) << r.mode
+            << std::right << std::fixed
+            << std::setw(12) << std::setprecision(3) << r.best * 1000
+            << std::setw(12) << std::setprecision(1) << r.bytesPerSecond() / 1e6
+            << std::setw(14) << std::setprecision(0) << r.recordsPerSecond()
+            << std::setw(12) << r.allocations << std::endl;
+    }
+}
+
+} // namespace darauble
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace darauble {
+
+struct BenchmarkResult {
+    std::string name;
+    std::string input;
+    std::string mode;          // "warm": after a warm-up run, "cold": prepared before every iteration
+    uint32_t iterations;
+    uint64_t bytes;            // Processed by one iteration
+    uint64_t records;          // Data messages (or track points) processed by one iteration
+    double best;               // Seconds, fastest iteration
+    double median;             // Seconds
+    uint64_t allocations;      // Per iteration
+    uint64_t allocatedBytes;   // Per iteration
+
+    double bytesPerSecond() const { return best > 0 ? bytes / best : 0; }
+    double recordsPerSecond() const { return best > 0 ? records / best : 0; }
+};
+
+/*
+  Runs timed benchmark bodies and collects the results. Everything the bodies print
+  to std::cout (the scanners are chatty) is swallowed while they run.
+ */
+class Benchmark {
+private:
+    uint32_t iterations;
+    std::vector<BenchmarkResult> results;
+
+public:
+    Benchmark(uint32_t _iterations) : iterations {_iterations ? _iterations : 1} {}
+
+    /*
+      Time the body. Warm runs go after one untimed warm-up run; cold runs call
+      prepare (untimed) before every iteration instead, e.g. to drop caches.
+     */
+    const BenchmarkResult& run(const std::string& name, const std::string& input, uint64_t bytes, uint64_t records,
+                               const std::function<void()>& body, const std::function<void()>& prepare = {});
+
+    const std::vector<BenchmarkResult>& all() const { return results; }
+
+    /*
+      Ask the OS to drop the cached pages of a file, so the next read comes from the disk.
+      Works without privileges for files that are not being written; a no-op where not supported.
+     */
+    static void evict(const fs::path& filename);
+
+    void json(std::ostream& out, const std::string& version) const;
+    void summary(std::ostream& out) const;
+};
+
+} // namespace darauble
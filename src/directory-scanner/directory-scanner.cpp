@@ -2,6 +2,7 @@
 #include <algorithm>
 
 #include "directory-scanner.hpp"
+#include "trace.hpp"
 
 
 namespace darauble {
@@ -21,6 +22,7 @@ void DirectoryScanner::scan(const fs::path& directory) {
         std::string ext = to_lowercase(directory.extension().string());
 
         if (filter.empty() || std::find(filter.begin(), filter.end(), ext) != filter.end()) {
+            GFU_TRACE_SCOPE("file.handle", "sweep");
             handler.handle(directory);
         }
     } else if (fs::is_directory(directory)) {
@@ -29,6 +31,7 @@ void DirectoryScanner::scan(const fs::path& directory) {
                 std::string ext = to_lowercase(entry.path().extension().string());
                 
                 if (filter.empty() || std::find(filter.begin(), filter.end(), ext) != filter.end()) {
+                    GFU_TRACE_SCOPE("file.handle", "sweep");
                     handler.handle(entry.path());
                 }
             }
@@ -1,12 +1,53 @@
 #include "ActivitiesCommand.hpp"
 
 #include "activities.hpp"
+#include "activity-cache.hpp"
 #include "directory-scanner.hpp"
+#include "sports.hpp"
 #include "table.hpp"
 
 #include <cstring>
 
 namespace darauble {
+    // Reads the summaries from the archive's activity cache, parsing only new or changed files.
+    // Files without sessions are listed by their Sport message, as ActivityHandler does.
+    class CachedActivityHandler : public IFileHandler {
+    private:
+        ActivityCache &cache;
+        containers::Table &table;
+        ActivityHandler fallback;
+    public:
+        CachedActivityHandler(ActivityCache &_cache, containers::Table &_table) :
+            cache {_cache}, table {_table}, fallback {_table}
+        {}
+
+        void handle(const fs::path& filename) override {
+            CachedActivity activity = cache.load(filename);
+
+            if (activity.status != CachedActivity::STATUS_PARSED) {
+                fallback.handle(filename);
+                return;
+            }
+
+            std::string name = activity.getName();
+            std::string sport = "?";
+
+            if (activity.subSport > 0) {
+                if (!metadata::Sports::subNames[activity.subSport].empty()) {
+                    sport = metadata::Sports::subNames[activity.subSport];
+                }
+            } else if (!metadata::Sports::names[activity.sport].empty()) {
+                sport = metadata::Sports::names[activity.sport];
+            }
+
+            table.addRow({
+                {ActivityScanner::HEAD_FILE_NAME, filename.filename().string()},
+                {ActivityScanner::HEAD_ACTIVITY_NAME, name.empty() ? "?" : name},
+                {ActivityScanner::HEAD_SPORT, sport}
+            });
+        }
+    };
+
     void ActivitiesCommand::show(int argc, char* argv[]) {
         if (argc != 4) {
             std::cerr << "Invalid number of arguments." << std::endl << std::endl;
@@ -19,8 +60,13 @@ namespace darauble {
             return;
         }
 
+        fs::path target {argv[3]};
+        // Listing must not write to the directory (it may be a watch or a read-only share),
+        // an existing cache is only read
+        ActivityCache cache {ActivityCache::findRoot(fs::is_directory(target) ? target : target.parent_path()), true};
+
         containers::Table table {{ActivityScanner::HEAD_FILE_NAME, ActivityScanner::HEAD_ACTIVITY_NAME, ActivityScanner::HEAD_SPORT}};
-        ActivityHandler handler {table};
+        CachedActivityHandler handler {cache, table};
         DirectoryScanner scanner {handler, { ".fit" }};
 
         scanner.scan(argv[3]);
@@ -50,6 +96,8 @@ namespace darauble {
     void ActivitiesCommand::help(int argc, char* argv[]) {
         std::cout << "Usage: " << argv[0] << " show activities <directory|file>" << std::endl;
         std::cout << "Scan given directory or a single file and show short information about found activities." << std::endl;
+        std::cout << "If the directory has " << ActivityCache::FILE_NAME << " (written by Garmin Disconnect), unchanged files are not parsed again." << std::endl;
+        std::cout << "The cache is only read, this command never creates or modifies it." << std::endl;
     }
 
     const std::string ActivitiesCommand::description() {
@@ -0,0 +1,162 @@
+#include "BatchEditor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "directory-scanner.hpp"
+#include "trace.hpp"
+
+namespace darauble {
+
+namespace {
+
+class FileCollector : public IFileHandler {
+public:
+    std::vector<fs::path> files;
+
+    virtual void handle(const fs::path& filename) override {
+        files.push_back(filename);
+    }
+};
+
+} // namespace
+
+bool BatchEditor::options(int argc, char* argv[], int first) {
+    for (int i = first; i < argc; i++) {
+        if (strcmp(argv[i], "--dry-run") == 0) {
+            dryRun = true;
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            try {
+                int value = std::stoi(argv[++i]);
+
+                if (value < 1) {
+                    return false;
+                }
+
+                jobs = value;
+            } catch (const std::exception&) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BatchEditor::editFile(const fs::path& filename, Report& report) {
+    GFU_TRACE_SCOPE("batch.file", "edit");
+
+    report.files++;
+
+    try {
+        BinaryMapper::recover(filename);
+        BinaryMapper mapper(filename);
+        mapper.parse();
+
+        if (!mapper.isParsed()) {
+            throw std::runtime_error("failed to parse file");
+        }
+
+        uint64_t fields = 0;
+        {
+            GFU_TRACE_SCOPE("batch.edit", "edit");
+            fields = edit(mapper);
+        }
+
+        if (fields == 0) {
+            report.unchanged++;
+            return;
+        }
+
+        if (!dryRun) {
+            mapper.writeCRC();
+            mapper.save(filename);
+        }
+
+        report.changed++;
+        report.fields += fields;
+    } catch (const std::exception& e) {
+        report.failed++;
+        report.errors.push_back(filename.string() + ": " + e.what());
+    }
+}
+
+BatchEditor::Report BatchEditor::run(const fs::path& path) {
+    auto start = std::chrono::steady_clock::now();
+
+    FileCollector collector;
+    DirectoryScanner scanner(collector, {".fit"});
+    scanner.scan(path);
+
+    unsigned workers = jobs ? jobs : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min<size_t>(workers, std::max<size_t>(1, collector.files.size()));
+
+    Report total;
+    std::mutex totalMutex;
+    std::atomic<size_t> next {0};
+
+    auto worker = [&]() {
+        Report report;
+
+        for (size_t i = next++; i < collector.files.size(); i = next++) {
+            editFile(collector.files[i], report);
+        }
+
+        std::lock_guard<std::mutex> lock(totalMutex);
+        total.files += report.files;
+        total.changed += report.changed;
+        total.unchanged += report.unchanged;
+        total.failed += report.failed;
+        total.fields += report.fields;
+        total.errors.insert(total.errors.end(), report.errors.begin(), report.errors.end());
+    };
+
+    std::vector<std::thread> pool;
+
+    for (unsigned i = 1; i < workers; i++) {
+        pool.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    std::sort(total.errors.begin(), total.errors.end());
+    total.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    if (dryRun) {
+        std::cout << "Dry run, no files were written." << std::endl;
+    }
+
+    return total;
+}
+
+void BatchEditor::Report::print(std::ostream& out) const {
+    out << "Files:          " << files << std::endl;
+    out << "Changed:        " << changed << std::endl;
+    out << "Unchanged:      " << unchanged << std::endl;
+    out << "Failed:         " << failed << std::endl;
+    out << "Fields changed: " << fields << std::endl;
+    out << "Duration:       " << duration.count() << " ms" << std::endl;
+
+    for (const auto& error : errors) {
+        out << "  Error: " << error << std::endl;
+    }
+}
+
+void BatchEditor::help() {
+    std::cout << "      Batch options: --jobs <N> worker threads (default: one per CPU core)," << std::endl;
+    std::cout << "      --dry-run to only report what would change. Files are overwritten in place," << std::endl;
+    std::cout << "      each one atomically: an interrupted run leaves every file either old or new." << std::endl;
+    std::cout << "      Without reflinks the changed bytes are patched in place, journaled in <file>.journal;" << std::endl;
+    std::cout << "      an interrupted patch is rolled back when the file is edited again." << std::endl;
+}
+
+} // namespace darauble
@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "binary-mapper.hpp"
+
+namespace fs = std::filesystem;
+
+namespace darauble {
+
+/*
+  Applies one edit to every FIT file under a directory (or to a single file) on a pool
+  of worker threads. Every file is edited in memory and saved over the original
+  through BinaryMapper::save, so an interrupted run never leaves a half-written file:
+  a file patched in place is rolled back from its journal when it is edited again.
+  Files the edit does not change are not written at all.
+ */
+class BatchEditor {
+public:
+    /*
+      Edits the mapped file and returns the number of changed fields.
+      Runs on a worker thread, must not touch shared state.
+     */
+    using Edit = std::function<uint64_t(BinaryMapper& mapper)>;
+
+    struct Report {
+        uint64_t files {0};
+        uint64_t changed {0};
+        uint64_t unchanged {0};
+        uint64_t failed {0};
+        uint64_t fields {0};
+        std::chrono::milliseconds duration {0};
+        std::vector<std::string> errors;
+
+        void print(std::ostream& out) const;
+    };
+
+private:
+    Edit edit;
+    unsigned jobs;
+    bool dryRun;
+
+    void editFile(const fs::path& filename, Report& report);
+
+public:
+    BatchEditor(Edit _edit) : edit {_edit}, jobs {0}, dryRun {false} {}
+
+    /*
+      Parses the trailing batch options (--jobs N, --dry-run) starting at argv[first].
+      Returns false on an unknown or malformed option.
+     */
+    bool options(int argc, char* argv[], int first);
+
+    void setJobs(unsigned _jobs) { jobs = _jobs; }
+    void setDryRun(bool _dryRun) { dryRun = _dryRun; }
+
+    Report run(const fs::path& path);
+
+    static void help();
+};
+
+} // namespace darauble
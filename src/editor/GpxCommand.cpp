@@ -30,7 +30,7 @@ void GpxCommand::show(int argc, char* argv[]) {
         auto trackpoints = parsers::ReadTrackpoints(argv[4], true);
 
         std::cout << "Total points: " << trackpoints.size() << std::endl;
-        std::cout << "Total distance: " << trackpoints.at(trackpoints.size() - 1).cumulative_distance << " m" << std::endl;
+        std::cout << "Total distance: " << trackpoints.cumulative_distance.at(trackpoints.size() - 1) << " m" << std::endl;
     } else {
         std::cerr << "Invalid subcommand.[" << argv[3] << "]" << std::endl;
         help(argc, argv);
@@ -69,6 +69,7 @@ void GpxCommand::replace(int argc, char* argv[]) {
 
 
     try {
+        BinaryMapper::recover(argv[at]);
         BinaryMapper mapper(argv[at]);
         CoordinateReplacementScanner scanner(mapper);
         scanner.scan();
@@ -106,24 +107,24 @@ void GpxCommand::replace(int argc, char* argv[]) {
                 
                 int32_t newLat, newLon;
 
-                while (distance > trackpoints.at(i).cumulative_distance && i < trackpoints.size() - 1) {
+                while (distance > trackpoints.cumulative_distance.at(i) && i < trackpoints.size() - 1) {
                     i++;
-                    rlat = radiansFromDegrees(trackpoints.at(i-1).lat);
-                    rlon = radiansFromDegrees(trackpoints.at(i-1).lon);
+                    rlat = radiansFromDegrees(trackpoints.lat.at(i-1));
+                    rlon = radiansFromDegrees(trackpoints.lon.at(i-1));
 
                     if (!simple) {
                         bearing = coordinates::bearing_radians(rlat, rlon,
-                            radiansFromDegrees(trackpoints.at(i).lat),
-                            radiansFromDegrees(trackpoints.at(i).lon));
+                            radiansFromDegrees(trackpoints.lat.at(i)),
+                            radiansFromDegrees(trackpoints.lon.at(i)));
                         lastRecordDistance = distance;
                     }
                 }
 
                 if (simple) {
-                    newLat = fromDouble(trackpoints.at(i).lat);
-                    newLon = fromDouble(trackpoints.at(i).lon);
+                    newLat = fromDouble(trackpoints.lat.at(i));
+                    newLon = fromDouble(trackpoints.lon.at(i));
                 } else {
-                    if (distance < trackpoints.at(i).cumulative_distance) {
+                    if (distance < trackpoints.cumulative_distance.at(i)) {
                         double newLatRad, newLonRad;
 
                         coordinates::next_point_radians(rlat, rlon, bearing, distance - lastRecordDistance, newLatRad, newLonRad);
@@ -131,8 +132,8 @@ void GpxCommand::replace(int argc, char* argv[]) {
                         newLat = int32FromRadians(newLatRad);
                         newLon = int32FromRadians(newLonRad);
                     } else {
-                        newLat = fromDouble(trackpoints.at(i).lat);
-                        newLon = fromDouble(trackpoints.at(i).lon);
+                        newLat = fromDouble(trackpoints.lat.at(i));
+                        newLon = fromDouble(trackpoints.lon.at(i));
                     }
                 }
                     
@@ -147,16 +148,16 @@ void GpxCommand::replace(int argc, char* argv[]) {
         // Replace session start and end lat/lon
         auto sessionOffset = scanner.getSessionOffset();
         uint64_t writeOffset = sessionOffset.startLat;
-        mapper.write(writeOffset, fromDouble(trackpoints.at(0).lat), sessionOffset.architecture);
+        mapper.write(writeOffset, fromDouble(trackpoints.lat.at(0)), sessionOffset.architecture);
 
         writeOffset = sessionOffset.startLon;
-        mapper.write(writeOffset, fromDouble(trackpoints.at(0).lon), sessionOffset.architecture);
+        mapper.write(writeOffset, fromDouble(trackpoints.lon.at(0)), sessionOffset.architecture);
 
         writeOffset = sessionOffset.endLat;
-        mapper.write(writeOffset, fromDouble(trackpoints.at(trackpoints.size() - 1).lat), sessionOffset.architecture);
+        mapper.write(writeOffset, fromDouble(trackpoints.lat.at(trackpoints.size() - 1)), sessionOffset.architecture);
 
         writeOffset = sessionOffset.endLon;
-        mapper.write(writeOffset, fromDouble(trackpoints.at(trackpoints.size() - 1).lon), sessionOffset.architecture);
+        mapper.write(writeOffset, fromDouble(trackpoints.lon.at(trackpoints.size() - 1)), sessionOffset.architecture);
 
         mapper.writeCRC();
         mapper.save(argv[at + 2]);
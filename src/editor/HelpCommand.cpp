@@ -3,7 +3,7 @@
 namespace darauble {
 
 void HelpCommand::show(int argc, char* argv[]) {
-    std::cout << "Usage: " << argv[0] << " show|set|replace <command> help|[options]" << std::endl;
+    std::cout << "Usage: " << argv[0] << " show|set|replace|batch <command> help|[options]" << std::endl;
     
     if (actionMap) {
         std::cout << "Actions and commands:" << std::endl;
@@ -15,6 +15,7 @@ public:
     virtual void show(int argc, char* argv[]) { std::cout << "Show not implemented for [" << commandName << "]" << std::endl; };
     virtual void set(int argc, char* argv[]) { std::cout << "Set not implemented for [" << commandName << "]" << std::endl; };
     virtual void replace(int argc, char* argv[]) { std::cout << "Replace not implemented for [" << commandName << "]" << std::endl; };
+    virtual void batch(int argc, char* argv[]) { std::cout << "Batch not implemented for [" << commandName << "]" << std::endl; };
     virtual void help(int argc, char* argv[]) { std::cout << "Help not implemented for [" << commandName << "]" << std::endl; };
     virtual const std::string description() = 0;
 };
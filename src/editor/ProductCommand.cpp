@@ -3,6 +3,7 @@
 #include <cstring>
 #include <iostream>
 
+#include "BatchEditor.hpp"
 #include "binary-mapper.hpp"
 #include "product-scanner.hpp"
 
@@ -23,6 +24,11 @@ void ProductCommand::show(int argc, char* argv[]) {
         BinaryMapper mapper(argv[3]);
         ProductScanner scanner(mapper);
         scanner.scan();
+
+        for (const auto& p : scanner.productIds()) {
+            std::cout << (p.globalMessageNumber == FIT_MESG_NUM_FILE_ID ? "File ID" : "Device Info")
+                << " product: " << p.product << " at offset " << p.offset << std::endl;
+        }
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
     }
@@ -40,6 +46,7 @@ void ProductCommand::replace(int argc, char* argv[]) {
     }
 
     try {
+        BinaryMapper::recover(argv[5]);
         BinaryMapper mapper(argv[5]);
 
         std::cout << "File size: " << mapper.size() << " bytes" << std::endl;
@@ -65,10 +72,10 @@ void ProductCommand::replace(int argc, char* argv[]) {
 
             for (auto& productId : scanner.productIds()) {
                 std::cout << "Modify Product ID at offset " << productId.offset << std::endl;
-                uint64_t modificationOffset = productId.offset;
-                mapper.write(modificationOffset, newProductNumber, productId.architecture);
             }
 
+            replaceProduct(mapper, scanner, newProductNumber);
+
             mapper.writeCRC();
             mapper.save(argv[6]);
         } else {
@@ -80,16 +87,63 @@ void ProductCommand::replace(int argc, char* argv[]) {
     }
 }
 
+void ProductCommand::batch(int argc, char* argv[]) {
+    if (argc == 4 && strcmp(argv[3], "help") == 0) {
+        help(argc, argv);
+        return;
+    }
+
+    if (argc < 6) {
+        std::cerr << "Wrong usage of the product command, see help." << std::endl;
+        return;
+    }
+
+    try {
+        uint16_t productNumber = std::stoi(argv[3]);
+        uint16_t newProductNumber = std::stoi(argv[4]);
+
+        BatchEditor editor([productNumber, newProductNumber](BinaryMapper& mapper) {
+            ProductScanner scanner(mapper, productNumber);
+            scanner.scan();
+            return replaceProduct(mapper, scanner, newProductNumber);
+        });
+
+        if (!editor.options(argc, argv, 6)) {
+            std::cerr << "Wrong usage of the product command, see help." << std::endl;
+            return;
+        }
+
+        std::cout << "Replacing product " << productNumber << " with " << newProductNumber
+            << " in " << argv[5] << std::endl;
+
+        editor.run(argv[5]).print(std::cout);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+uint64_t ProductCommand::replaceProduct(BinaryMapper& mapper, const ProductScanner& scanner, uint16_t newProductNumber) {
+    for (auto& productId : scanner.productIds()) {
+        uint64_t modificationOffset = productId.offset;
+        mapper.write(modificationOffset, newProductNumber, productId.architecture);
+    }
+
+    return scanner.productIds().size();
+}
+
 void ProductCommand::help(int argc, char* argv[]) {
     std::cout << "Usage:" << std::endl;
     std::cout << "  " << argv[0] << " show product <file name>" << std::endl;
     std::cout << "      show all the messages that have product IDs in them and their offsets" << std::endl;
     std::cout << "  " << argv[0] << " replace product <product number to replace> <new product number> <file name> <new file name>" << std::endl;
     std::cout << "      Replaces the given product number with a new one in the file." << std::endl;
+    std::cout << "  " << argv[0] << " batch product <product number to replace> <new product number> <directory|file> [options]" << std::endl;
+    std::cout << "      Replaces the product number in place in every FIT file under the directory." << std::endl;
+    BatchEditor::help();
 }
 
 const std::string ProductCommand::description() {
-    return "show or replace product IDs in the file";
+    return "show or replace product IDs in the file or a whole directory";
 }
 
 } // namespace darauble
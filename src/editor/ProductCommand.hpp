@@ -1,12 +1,21 @@
 #pragma once
 #include "IEditCommand.hpp"
 
+#include <cstdint>
 #include <optional>
 
 namespace darauble {
 
+class BinaryMapper;
+class ProductScanner;
+
 class ProductCommand final: public IEditCommand {
 private:
+    /*
+      Writes the new product number over every product ID the scanner found.
+      Returns the number of replaced product IDs.
+     */
+    static uint64_t replaceProduct(BinaryMapper& mapper, const ProductScanner& scanner, uint16_t newProductNumber);
 
 public:
     ProductCommand() :
@@ -15,6 +24,7 @@ public:
 
     virtual void show(int argc, char* argv[]) override;
     virtual void replace(int argc, char* argv[]) override;
+    virtual void batch(int argc, char* argv[]) override;
     virtual void help(int argc, char* argv[]) override;
     virtual const std::string description() override;
 };
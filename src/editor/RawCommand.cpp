@@ -42,6 +42,7 @@ void RawCommand::set(int argc, char* argv[]) {
     }
 
     try {
+        BinaryMapper::recover(argv[6]);
         BinaryMapper mapper(argv[6]);
         mapper.parse();
 
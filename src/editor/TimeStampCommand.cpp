@@ -6,7 +6,9 @@
 
 #include <fit_profile.hpp>
 
+#include "BatchEditor.hpp"
 #include "binary-mapper.hpp"
+#include "profile-index.hpp"
 #include "timestamp-scanner.hpp"
 
 namespace darauble {
@@ -33,7 +35,7 @@ void TimeStampCommand::show(int argc, char* argv[]) {
             std::time_t unixTs {garminTs + 631065600};
             std::tm stdTs = *std::localtime(&unixTs);
 
-            auto messageMeta = fit::Profile::GetMesg(ts.definition.globalMessageNumber);
+            auto messageMeta = metadata::ProfileIndex::mesg(ts.definition.globalMessageNumber);
 
             std::cout << "Message #" << std::setw(3) << ts.definition.globalMessageNumber << " "
                 << std::setw(16) << (messageMeta ? messageMeta->name : "")
@@ -62,6 +64,7 @@ void TimeStampCommand::set(int argc, char* argv[]) {
 
 
     try {
+        BinaryMapper::recover(argv[4]);
         BinaryMapper mapper(argv[4]);
         TimestampScanner scanner(mapper);
         scanner.scan();
@@ -105,18 +108,7 @@ void TimeStampCommand::set(int argc, char* argv[]) {
         }
 
         // BinaryMapper newMapper(argv[5], mapper);
-        uint64_t counter = 0;
-
-        for (const auto& ts : scanner.timestampIds()) {
-            uint64_t offset = ts.offset;
-            int64_t oldTs = mapper.readU32(offset, ts.definition.architecture);
-            int64_t newTs = oldTs + diff;
-            
-            offset = ts.offset;
-            
-            mapper.write(offset, (uint32_t)newTs, ts.definition.architecture);
-            counter++;
-        }
+        uint64_t counter = shiftTimestamps(mapper, scanner, diff);
 
         mapper.writeCRC();
         mapper.save(argv[5]);
@@ -127,6 +119,75 @@ void TimeStampCommand::set(int argc, char* argv[]) {
     
 }
 
+void TimeStampCommand::batch(int argc, char* argv[]) {
+    if (argc == 4 && strcmp(argv[3], "help") == 0) {
+        help(argc, argv);
+        return;
+    }
+
+    if (argc < 5) {
+        std::cerr << "Wrong usage of the timestamp command, see help." << std::endl;
+        return;
+    }
+
+    try {
+        int64_t seconds = std::stoll(argv[3]);
+
+        if (seconds == 0) {
+            std::cerr << "The shift is zero, nothing to do." << std::endl;
+            return;
+        }
+
+        BatchEditor editor([seconds](BinaryMapper& mapper) {
+            TimestampScanner scanner(mapper);
+            scanner.scan();
+            return shiftTimestamps(mapper, scanner, seconds);
+        });
+
+        if (!editor.options(argc, argv, 5)) {
+            std::cerr << "Wrong usage of the timestamp command, see help." << std::endl;
+            return;
+        }
+
+        std::cout << "Shifting timestamps by " << seconds << " s in " << argv[4] << std::endl;
+
+        editor.run(argv[4]).print(std::cout);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+uint64_t TimeStampCommand::shiftTimestamps(BinaryMapper& mapper, const TimestampScanner& scanner, int64_t seconds) {
+    // Checked before anything is written: a shift out of range fails the whole file
+    for (const auto& ts : scanner.timestampIds()) {
+        uint64_t offset = ts.offset;
+        int64_t oldTs = mapper.readU32(offset, ts.definition.architecture);
+        int64_t newTs = oldTs + seconds;
+
+        if (oldTs != FIT_UINT32_INVALID && (newTs < 0 || newTs >= FIT_UINT32_INVALID)) {
+            throw std::runtime_error("Shifted timestamp " + std::to_string(newTs) + " @" + std::to_string(ts.offset) + " is out of range");
+        }
+    }
+
+    uint64_t counter = 0;
+
+    for (const auto& ts : scanner.timestampIds()) {
+        uint64_t offset = ts.offset;
+        int64_t oldTs = mapper.readU32(offset, ts.definition.architecture);
+
+        if (oldTs == FIT_UINT32_INVALID) {
+            continue;
+        }
+
+        offset = ts.offset;
+
+        mapper.write(offset, (uint32_t)(oldTs + seconds), ts.definition.architecture);
+        counter++;
+    }
+
+    return counter;
+}
+
 void TimeStampCommand::help(int argc, char* argv[]) {
     std::cout << "Usage:" << std::endl;
     std::cout << "  " << argv[0] << " show timestamp <file name>" << std::endl;
@@ -136,6 +197,10 @@ void TimeStampCommand::help(int argc, char* argv[]) {
     std::cout << "      Updates all the other time stamps by difference between oldest original and new timestamp." << std::endl;
     std::cout << "      Writes the changes to a new file (or overwrites the old one if the same path is given)." << std::endl;
     std::cout << "      Time stamp format is YYYY-MM-DD-HH:mm:ss. 24 hours and note the dash between date and time." << std::endl;
+    std::cout << "  " << argv[0] << " batch timestamp <+/-seconds> <directory|file> [options]" << std::endl;
+    std::cout << "      Shifts all the time stamps by the given number of seconds, in place in every FIT file under the directory." << std::endl;
+    std::cout << "      A file with a time stamp the shift would take out of the FIT range is left unchanged and reported as failed." << std::endl;
+    BatchEditor::help();
 }
 
 const std::string TimeStampCommand::description() {
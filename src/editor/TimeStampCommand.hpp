@@ -1,9 +1,21 @@
 #pragma once
 #include "IEditCommand.hpp"
 
+#include <cstdint>
+
 namespace darauble {
 
+class BinaryMapper;
+class TimestampScanner;
+
 class TimeStampCommand: public IEditCommand {
+private:
+    /*
+      Moves every scanned timestamp by the given number of seconds.
+      Returns the number of updated timestamps.
+     */
+    static uint64_t shiftTimestamps(BinaryMapper& mapper, const TimestampScanner& scanner, int64_t seconds);
+
 public:
     TimeStampCommand() : 
         IEditCommand("timestamp")
@@ -11,6 +23,7 @@ public:
 
     virtual void show(int argc, char* argv[]) override;
     virtual void set(int argc, char* argv[]) override;
+    virtual void batch(int argc, char* argv[]) override;
     virtual void help(int argc, char* argv[]) override;
     virtual const std::string description() override;
 };
@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "activities.hpp"
+#include "activity-cache.hpp"
+#include "activity-generator.hpp"
+#include "archive-generator.hpp"
+#include "benchmark.hpp"
+#include "binary-mapper.hpp"
+#include "bounding-box.hpp"
+#include "command-args.hpp"
+#include "convert.hpp"
+#include "coordinate-replacement-scanner.hpp"
+#include "coordinates-scanner.hpp"
+#include "directory-scanner.hpp"
+#include "file-id-scanner.hpp"
+#include "gpx-trkpt.hpp"
+#include "logger.hpp"
+#include "print-scanner.hpp"
+#include "product-scanner.hpp"
+#include "session-scanner.hpp"
+#include "single-point.hpp"
+#include "single-summary.hpp"
+#include "timestamp-scanner.hpp"
+#include "trace.hpp"
+
+constexpr auto VERSION = "1.0.0";
+
+using namespace darauble;
+
+namespace {
+
+class FileCollector : public IFileHandler {
+public:
+    std::vector<fs::path> files;
+    uint64_t bytes {0};
+
+    void handle(const fs::path& filename) override {
+        files.push_back(filename);
+        bytes += fs::file_size(filename);
+    }
+};
+
+// Results of the benchmarked calls end up here, so they can't be optimized away
+uint64_t sink {0};
+
+void fileBenchmarks(Benchmark& benchmark, const fs::path& file) {
+    std::string input = file.filename().string();
+    uint64_t bytes = fs::file_size(file);
+
+    BinaryMapper mapper(file);
+    mapper.parse();
+
+    if (!mapper.isParsed()) {
+        throw std::runtime_error("Failed to parse " + file.string());
+    }
+
+    uint64_t records = mapper.dataMessages().size();
+
+    benchmark.run("mapper.read", input, bytes, records, [&]() {
+        BinaryMapper m(file);
+        sink += m.size();
+    });
+
+    benchmark.run("mapper.parse", input, bytes, records, [&]() {
+        BinaryMapper m(file);
+        m.parse();
+        sink += m.dataMessages().size();
+    });
+
+    benchmark.run("mapper.crc", input, bytes, records, [&]() {
+        sink += mapper.CRC();
+    });
+
+    benchmark.run("scan.activity", input, bytes, records, [&]() {
+        ActivityScanner scanner(input, mapper);
+        scanner.scan();
+    });
+
+    std::vector<int32_t> la, lo;
+
+    benchmark.run("scan.coordinates", input, bytes, records, [&]() {
+        CoordinatesScanner scanner(mapper, FIT_SPORT_ALL, la, lo);
+        scanner.scan();
+    });
+
+    benchmark.run("scan.coordinate-replacement", input, bytes, records, [&]() {
+        CoordinateReplacementScanner scanner(mapper);
+        scanner.scan();
+    });
+
+    benchmark.run("scan.file-id", input, bytes, records, [&]() {
+        FileIdScanner scanner(mapper);
+        scanner.scan();
+    });
+
+    benchmark.run("scan.print", input, bytes, records, [&]() {
+        PrintScannerOptions options;
+        PrintScanner::defaultOptions(options);
+        PrintScanner scanner(mapper, {}, {}, options);
+        scanner.scan();
+    });
+
+    benchmark.run("scan.product", input, bytes, records, [&]() {
+        ProductScanner scanner(mapper);
+        scanner.scan();
+    });
+
+    benchmark.run("scan.session", input, bytes, records, [&]() {
+        SessionScanner scanner(input, mapper);
+        scanner.scan();
+    });
+
+    benchmark.run("scan.timestamp", input, bytes, records, [&]() {
+        TimestampScanner scanner(mapper);
+        scanner.scan();
+    });
+
+    // Search around a point of the track, so the box is actually crossed
+    auto valid = std::find_if(la.begin() + la.size() / 2, la.end(), [](int32_t lat) { return lat != FIT_SINT32_INVALID; });
+
+    if (la.size() > 1 && valid != la.end() && lo[valid - la.begin()] != FIT_SINT32_INVALID) {
+        double top, left, bottom, right;
+        calculate_square(fromInt32(*valid), fromInt32(lo[valid - la.begin()]), 15, top, left, bottom, right);
+
+        SingleSummary summary;
+        SinglePointHandler handler(summary, "all", BoundingBox {top, left, bottom, right});
+
+        benchmark.run("points.search", input, la.size() * 2 * sizeof(int32_t), la.size(), [&]() {
+            sink += handler.search(la, lo);
+        });
+    }
+}
+
+void gpxBenchmarks(Benchmark& benchmark, const fs::path& file) {
+    std::string input = file.filename().string();
+    uint64_t bytes = fs::file_size(file);
+    uint64_t points = parsers::ReadTrackpoints(file).size();
+
+    benchmark.run("gpx.read", input, bytes, points, [&]() {
+        sink += parsers::ReadTrackpoints(file).size();
+    });
+
+    benchmark.run("gpx.read-distance", input, bytes, points, [&]() {
+        sink += parsers::ReadTrackpoints(file, true).size();
+    });
+}
+
+/*
+  Sweeps a whole archive the way the activity list does, with the page cache dropped
+  (cold) and filled (warm). With cache set, also builds and validates the activity
+  cache in the archive root, so never on a real archive: cold runs delete the cache.
+ */
+void archiveBenchmarks(Benchmark& benchmark, const fs::path& directory, const std::string& input, bool cache) {
+    FileCollector collector;
+    DirectoryScanner scanner(collector, {".fit"});
+    scanner.scan(directory);
+
+    uint64_t records {0};
+
+    for (const auto& file : collector.files) {
+        try {
+            BinaryMapper mapper(file);
+            mapper.parse();
+            records += mapper.dataMessages().size();
+        } catch (const std::exception&) {
+        }
+    }
+
+    auto evictAll = [&]() {
+        for (const auto& file : collector.files) {
+            Benchmark::evict(file);
+        }
+    };
+
+    auto sweep = [&]() {
+        for (const auto& file : collector.files) {
+            try {
+                BinaryMapper mapper(file);
+                SessionScanner scanner(file.string(), mapper);
+                scanner.scan();
+                sink += scanner.hasData();
+            } catch (const std::exception&) {
+            }
+        }
+    };
+
+    benchmark.run("archive.sweep", input, collector.bytes, records, sweep, evictAll);
+    benchmark.run("archive.sweep", input, collector.bytes, records, sweep);
+
+    if (!cache) {
+        return;
+    }
+
+    // Cache benchmarks count files as records
+    fs::path cacheFile = directory / ActivityCache::FILE_NAME;
+
+    benchmark.run("cache.build", input, collector.bytes, collector.files.size(), [&]() {
+        ActivityCache activityCache(directory);
+
+        for (const auto& file : collector.files) {
+            sink += activityCache.load(file).sessionCount;
+        }
+
+        activityCache.flush();
+    }, [&]() {
+        fs::remove(cacheFile);
+        evictAll();
+    });
+
+    benchmark.run("cache.validate", input, 0, collector.files.size(), [&]() {
+        ActivityCache activityCache(directory);
+        CachedActivity activity;
+
+        for (const auto& file : collector.files) {
+            sink += activityCache.lookup(file, activity);
+        }
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // The standard output is reserved for the JSON results
+    std::cerr << "Garmin FIT utilities benchmark version " << VERSION << std::endl;
+    TraceSession trace("garmin-benchmark");
+    LogSession logging;
+
+    CommandArgsParser cargs;
+
+    cargs.define('h', "help", "Show help");
+    cargs.define('s', "sample", "A FIT file to run the per-file benchmarks on, besides the synthetic one", "");
+    cargs.define('g', "gpx", "A GPX file to run the GPX benchmarks on, besides the synthetic one", "");
+    cargs.define('i', "input", "An archive directory to sweep (read only), besides the synthetic one", "");
+    cargs.define('n', "iterations", "Timed iterations of every benchmark, default 5", 5);
+    cargs.define('r', "records", "Records in every synthetic activity, default 10000", 10000);
+    cargs.define('a', "archive", "Files in the synthetic archive, 0 to skip it, default 200", 200);
+    cargs.define('o', "output", "Write the JSON results to this file instead of the standard output", "");
+
+    if (cargs.parse(argc, argv) != 0) {
+        return -1;
+    }
+
+    if (cargs["help"].b()) {
+        cargs.showHelp();
+        return 0;
+    }
+
+    if (cargs["iterations"].i() < 1 || cargs["records"].i() < 2 || cargs["archive"].i() < 0) {
+        std::cerr << "Iterations must be positive, records at least 2" << std::endl;
+        return -1;
+    }
+
+    fs::path work = fs::temp_directory_path()
+        / ("garmin-benchmark-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::error_code ec;
+
+    try {
+        fs::create_directories(work);
+
+        Benchmark benchmark(cargs["iterations"].i());
+        ActivityOptions options;
+        options.records = cargs["records"].i();
+
+        ActivityGenerator generator(options);
+        generator.saveFit(work / "synthetic.fit");
+        generator.saveGpx(work / "synthetic.gpx");
+
+        // The same activity the hard way: developer fields, compressed timestamps,
+        // big-endian definitions redefined every 100 records
+        ActivityOptions stress = options;
+        stress.developerFields = ActivityGenerator::MAX_DEVELOPER_FIELDS;
+        stress.compressedTimestamps = true;
+        stress.bigEndian = true;
+        stress.redefineEvery = 100;
+        ActivityGenerator(stress).saveFit(work / "synthetic-stress.fit");
+
+        std::cerr << "Per file:" << std::endl;
+        fileBenchmarks(benchmark, work / "synthetic.fit");
+        fileBenchmarks(benchmark, work / "synthetic-stress.fit");
+
+        if (!cargs["sample"].s().empty()) {
+            fileBenchmarks(benchmark, cargs["sample"].s());
+        }
+
+        std::cerr << "GPX:" << std::endl;
+        gpxBenchmarks(benchmark, work / "synthetic.gpx");
+
+        if (!cargs["gpx"].s().empty()) {
+            gpxBenchmarks(benchmark, cargs["gpx"].s());
+        }
+
+        std::cerr << "Archive:" << std::endl;
+
+        if (cargs["archive"].i() > 0) {
+            ArchiveOptions archive;
+            archive.files = cargs["archive"].i();
+            archive.activity = options;
+            ArchiveGenerator(archive).generate(work / "archive", std::max(1U, std::thread::hardware_concurrency()));
+            archiveBenchmarks(benchmark, work / "archive", "synthetic archive", true);
+        }
+
+        if (!cargs["input"].s().empty()) {
+            archiveBenchmarks(benchmark, cargs["input"].s(), cargs["input"].s(), false);
+        }
+
+        std::cerr << std::endl;
+        benchmark.summary(std::cerr);
+
+        if (!cargs["output"].s().empty()) {
+            std::ofstream out(cargs["output"].s());
+            benchmark.json(out, VERSION);
+        } else {
+            benchmark.json(std::cout, VERSION);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        fs::remove_all(work, ec);
+        return -2;
+    }
+
+    fs::remove_all(work, ec);
+}
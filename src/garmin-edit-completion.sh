@@ -8,8 +8,8 @@ _garmin_edit_completion() {
     cur="${COMP_WORDS[COMP_CWORD]}"
     prev="${COMP_WORDS[COMP_CWORD-1]}"
 
-    # First level options: replace, set, show
-    opts="replace set show"
+    # First level options: batch, replace, set, show
+    opts="batch replace set show"
 
     # Subcommand completions
     case "${prev}" in
@@ -17,6 +17,12 @@ _garmin_edit_completion() {
             COMPREPLY=( $(compgen -W "${opts}" -- ${cur}) )
             return 0
             ;;
+        batch)
+            # Second level for 'batch' subcommand
+            subopts="product timestamp"
+            COMPREPLY=( $(compgen -W "${subopts}" -- ${cur}) )
+            return 0
+            ;;
         replace)
             # Second level for 'replace' subcommand
             subopts="gpx product"
@@ -10,6 +10,8 @@
 #include "ProductCommand.hpp"
 #include "RawCommand.hpp"
 #include "TimeStampCommand.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
 
 constexpr auto VERSION = "1.2.0";
 
@@ -17,6 +19,8 @@ using namespace darauble;
 
 int main(int argc, char* argv[]) {
     std::cout << "Garmin FIT file editor/analyzer version " << VERSION << std::endl;
+    TraceSession trace("garmin-edit");
+    LogSession logging;
 
     ActivitiesCommand activitiesCommand;
     GpxCommand gpxCommand;
@@ -49,6 +53,12 @@ int main(int argc, char* argv[]) {
                 {"gpx", gpxCommand},
                 {"product", productCommand},
             }
+        },
+        {
+            "batch", {
+                {"product", productCommand},
+                {"timestamp", timeStampCommand},
+            }
         }
     };
 
@@ -68,6 +78,8 @@ int main(int argc, char* argv[]) {
                     it_command->second.set(argc, argv);
                 } else if (it->first == "replace") {
                     it_command->second.replace(argc, argv);
+                } else if (it->first == "batch") {
+                    it_command->second.batch(argc, argv);
                 } else {
                     std::cout << "Error: unknown action " << argv[1] << std::endl;
                 }
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "activity-generator.hpp"
+#include "archive-generator.hpp"
+#include "command-args.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+
+constexpr auto VERSION = "1.0.0";
+
+using namespace darauble;
+
+int main(int argc, char *argv[]) {
+    std::cout << "Synthetic Garmin FIT files generator version " << VERSION << std::endl;
+    TraceSession trace("garmin-generate");
+    LogSession logging;
+
+    CommandArgsParser cargs;
+
+    cargs.define('h', "help", "Show help");
+    cargs.define('o', "output", "A FIT file to write, or with --files a directory to write the archive into", "");
+    cargs.define('n', "files", "Write an archive of this many activities instead of a single file, default 0", 0);
+    cargs.define('r', "records", "Records in every activity, default 3600", 3600);
+    cargs.define('i', "interval", "Seconds between records, default 1", 1);
+    cargs.define('d', "developer-fields", "Developer fields in every record, 0-4, default 0", 0);
+    cargs.define('c', "redefine-every", "Redefine the record message every N records, default 0 (never)", 0);
+    cargs.define('z', "compressed", "Use compressed timestamp headers for records");
+    cargs.define('b', "big-endian", "Write big-endian definitions");
+    cargs.define('R', "routes", "Distinct routes the archive activities repeat, default 0 (every one its own)", 0);
+    cargs.define('e', "noise", "GPS noise standard deviation in meters, default 0", 0.0);
+    cargs.define('s', "seed", "Random seed, default 1", 1);
+    cargs.define('p', "product", "Garmin product ID, default 3113", 3113);
+    cargs.define('a', "per-day", "Archive activities per day, default 2", 2);
+    cargs.define('j', "jobs", "Files written in parallel, default the number of CPUs", 0);
+    cargs.define('g', "gpx", "Also write the route as a GPX track to this file (single file only)", "");
+
+    if (cargs.parse(argc, argv) != 0) {
+        return -1;
+    }
+
+    if (cargs["help"].b()) {
+        cargs.showHelp();
+        return 0;
+    }
+
+    if (cargs["output"].s().empty()) {
+        std::cerr << "Please specify the output file or directory" << std::endl;
+        cargs.showHelp();
+        return -1;
+    }
+
+    if (cargs["files"].i() < 0 || cargs["records"].i() < 1 || cargs["interval"].i() < 1
+        || cargs["developer-fields"].i() < 0 || cargs["redefine-every"].i() < 0 || cargs["routes"].i() < 0
+        || cargs["seed"].i() < 0 || cargs["product"].i() < 0 || cargs["product"].i() > 0xFFFF
+        || cargs["per-day"].i() < 1 || cargs["jobs"].i() < 0 || cargs["noise"].d() < 0) {
+        std::cerr << "Invalid arguments, counts must not be negative" << std::endl;
+        return -1;
+    }
+
+    if (cargs["per-day"].i() > 86400) {
+        std::cerr << "Invalid arguments, at most 86400 activities per day (one per second)" << std::endl;
+        return -1;
+    }
+
+    ActivityOptions activity;
+    activity.records = cargs["records"].i();
+    activity.interval = cargs["interval"].i();
+    activity.developerFields = cargs["developer-fields"].i();
+    activity.redefineEvery = cargs["redefine-every"].i();
+    activity.compressedTimestamps = cargs["compressed"].b();
+    activity.bigEndian = cargs["big-endian"].b();
+    activity.gpsNoise = cargs["noise"].d();
+    activity.seed = cargs["seed"].i();
+    activity.product = cargs["product"].i();
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+
+        if (cargs["files"].i() == 0) {
+            ActivityGenerator generator(activity);
+            generator.saveFit(cargs["output"].s());
+
+            if (!cargs["gpx"].s().empty()) {
+                generator.saveGpx(cargs["gpx"].s());
+            }
+
+            std::cout << "Written " << cargs["output"].s() << ", " << fs::file_size(cargs["output"].s()) << " bytes" << std::endl;
+        } else {
+            ArchiveOptions options;
+            options.files = cargs["files"].i();
+            options.routes = cargs["routes"].i();
+            options.activitiesPerDay = cargs["per-day"].i();
+            options.activity = activity;
+
+            uint32_t jobs = cargs["jobs"].i() > 0 ? cargs["jobs"].i() : std::max(1U, std::thread::hardware_concurrency());
+            uint64_t bytes = ArchiveGenerator(options).generate(cargs["output"].s(), jobs);
+
+            std::cout << "Written " << options.files << " files, " << bytes << " bytes into " << cargs["output"].s() << std::endl;
+        }
+
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        std::cout << "Done in " << duration.count() << " s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error generating: " << e.what() << std::endl;
+        return -2;
+    }
+}
@@ -5,8 +5,10 @@
 #include "bounding-box.hpp"
 #include "command-args.hpp"
 #include "convert.hpp"
+#include "logger.hpp"
 #include "single-point.hpp"
 #include "single-summary.hpp"
+#include "trace.hpp"
 
 constexpr auto VERSION = "1.1.0";
 
@@ -14,6 +16,7 @@ using namespace darauble;
 
 int main(int argc, char *argv[]) {
     std::cout << "Points visited in Garmin FIT files version " << VERSION << std::endl;
+    TraceSession trace("garmin-points-visited");
 
     CommandArgsParser cargs;
 
@@ -25,6 +28,7 @@ int main(int argc, char *argv[]) {
     cargs.define('i', "input", "Set the path to a directory to search or a signle file to parse", "");
     cargs.define('d', "distance", "Distance in meters to the searching square side, default 15", 15);
     cargs.define('s', "sport", "Read only files with the given sport: running, cycling, hiking, walking, fitness_equipment etc. Default \"all\"", "all");
+    cargs.define('v', "verbose", "List every file searched");
 
     cargs.parse(argc, argv);
 
@@ -33,6 +37,8 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    LogSession logging(cargs["verbose"].b() ? "info" : "warning");
+
     if (std::isnan(cargs["latitude"].d()) || std::isnan(cargs["longitude"].d())) {
         std::cerr << "Please specify latitude and longitude" << std::endl;
         cargs.showHelp();
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
+#include "logger.hpp"
 #include "rename-files.hpp"
+#include "trace.hpp"
 
 constexpr auto VERSION = "1.0.0";
 
@@ -8,6 +10,8 @@ using namespace darauble;
 
 int main(int argc, char *argv[]) {
     std::cout << "Rename Garmin FIT files with a creation date utility version " << VERSION << std::endl;
+    TraceSession trace("garmin-rename-files");
+    LogSession logging; // GFU_LOG=info lists every file
 
     if (argc != 2) {
         std::cerr << "Provide a file name or a directory for the renaming operation" << std::endl;
@@ -18,6 +22,9 @@ int main(int argc, char *argv[]) {
         FitFileHandler handler;
         DirectoryScanner scanner {handler, { ".fit" }};
         scanner.scan(argv[1]);
+
+        std::cout << "Files: " << handler.files << ", renamed: " << handler.renamed
+            << ", skipped: " << handler.skipped << ", failed: " << handler.failed << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Error scanning directory/reading the file: " << e.what() << std::endl;
         return -2;
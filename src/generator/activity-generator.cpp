@@ -0,0 +1,385 @@
+#include "activity-generator.hpp"
+#include "convert.hpp"
+#include "file-id-scanner.hpp"
+#include "fit-writer.hpp"
+#include "formulae.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <numbers>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include <fit_profile.hpp>
+#include <fit_activity_mesg.hpp>
+#include <fit_developer_data_id_mesg.hpp>
+#include <fit_device_info_mesg.hpp>
+#include <fit_field_description_mesg.hpp>
+#include <fit_file_id_mesg.hpp>
+#include <fit_record_mesg.hpp>
+#include <fit_session_mesg.hpp>
+#include <fit_sport_mesg.hpp>
+
+namespace darauble {
+
+namespace {
+
+enum LocalType : uint8_t {
+    LOCAL_RECORD = 0,               // Compressed timestamp headers need local types 0-3
+    LOCAL_COMPRESSED_RECORD,
+    LOCAL_RECORD_CHURN,
+    LOCAL_FILE_ID = 4,
+    LOCAL_DEVICE_INFO,
+    LOCAL_SPORT,
+    LOCAL_SESSION,
+    LOCAL_ACTIVITY,
+    LOCAL_DEVELOPER_DATA_ID,
+    LOCAL_FIELD_DESCRIPTION
+};
+
+struct DeveloperField {
+    const char* name;
+    const char* units;
+    uint8_t scale;
+    double base;       // Value in units, a sine wave around it
+    double amplitude;
+};
+
+// Running power metrics, as a Connect IQ data field records them
+constexpr DeveloperField DEVELOPER_FIELDS[] = {
+    {"Power", "Watts", 1, 250.0, 40.0},
+    {"Form Power", "Watts", 1, 70.0, 8.0},
+    {"Air Power", "Watts", 1, 4.0, 2.0},
+    {"Leg Spring Stiffness", "KN/m", 10, 10.5, 1.0},
+};
+
+constexpr uint8_t DEVELOPER_DATA_INDEX = 0;
+
+std::vector<FitWriterField> recordFields(bool timestamp) {
+    std::vector<FitWriterField> fields;
+
+    if (timestamp) {
+        fields.push_back({fit::RecordMesg::FieldDefNum::Timestamp, 4, FIT_BASE_TYPE_UINT32});
+    }
+
+    fields.insert(fields.end(), {
+        {fit::RecordMesg::FieldDefNum::PositionLat, 4, FIT_BASE_TYPE_SINT32},
+        {fit::RecordMesg::FieldDefNum::PositionLong, 4, FIT_BASE_TYPE_SINT32},
+        {fit::RecordMesg::FieldDefNum::Altitude, 2, FIT_BASE_TYPE_UINT16},
+        {fit::RecordMesg::FieldDefNum::HeartRate, 1, FIT_BASE_TYPE_UINT8},
+        {fit::RecordMesg::FieldDefNum::Distance, 4, FIT_BASE_TYPE_UINT32},
+        {fit::RecordMesg::FieldDefNum::Speed, 2, FIT_BASE_TYPE_UINT16},
+    });
+
+    return fields;
+}
+
+} // namespace
+
+ActivityGenerator::ActivityGenerator(const ActivityOptions& _options) :
+    options {_options}
+{
+    if (options.records == 0 || options.interval == 0) {
+        throw std::runtime_error("ActivityGenerator error: records and interval must be positive");
+    }
+
+    if (options.compressedTimestamps && options.interval > MAX_COMPRESSED_INTERVAL) {
+        throw std::runtime_error("ActivityGenerator error: compressed timestamps need an interval up to 31 s");
+    }
+
+    if (options.developerFields > MAX_DEVELOPER_FIELDS) {
+        throw std::runtime_error("ActivityGenerator error: at most 4 developer fields");
+    }
+
+    // Record and session times are 32 bits, the elapsed time in milliseconds too
+    uint64_t elapsed = static_cast<uint64_t>(options.records - 1) * options.interval;
+
+    if (options.startTime + elapsed >= FIT_DATE_TIME_INVALID) {
+        throw std::runtime_error("ActivityGenerator error: the activity would end after FIT time runs out");
+    }
+
+    if (elapsed * 1000 >= FIT_UINT32_INVALID) {
+        throw std::runtime_error("ActivityGenerator error: the activity is too long for the session's elapsed time");
+    }
+
+    route();
+}
+
+void ActivityGenerator::route() {
+    // The route shape and the GPS noise come from different generators, so activities
+    // sharing a route seed follow the same path
+    std::mt19937 shape(options.routeSeed ? options.routeSeed : options.seed);
+    std::mt19937 noise(options.seed);
+    std::normal_distribution<double> turn(0.0, 0.15);
+    std::normal_distribution<double> error(0.0, options.gpsNoise > 0 ? options.gpsNoise : 1.0);
+
+    double lat = radiansFromDegrees(options.latitude);
+    double lon = radiansFromDegrees(options.longitude);
+    double bearing = std::uniform_real_distribution<double>(-std::numbers::pi, std::numbers::pi)(shape);
+    double step = options.speed * options.interval;
+
+    latitudes.reserve(options.records);
+    longitudes.reserve(options.records);
+    distances.reserve(options.records);
+
+    for (uint32_t i = 0; i < options.records; i++) {
+        double pointLat = lat;
+        double pointLon = lon;
+
+        if (options.gpsNoise > 0) {
+            // Separate statements: the order of evaluating arguments is unspecified
+            double north = error(noise);
+            double east = error(noise);
+            coordinates::next_point_radians(lat, lon, std::atan2(east, north),
+                                            std::hypot(north, east), pointLat, pointLon);
+        }
+
+        latitudes.push_back(pointLat * 180.0 / std::numbers::pi);
+        longitudes.push_back(pointLon * 180.0 / std::numbers::pi);
+        distances.push_back(i * step);
+
+        double nextLat, nextLon;
+        bearing += turn(shape);
+        coordinates::next_point_radians(lat, lon, bearing, step, nextLat, nextLon);
+        lat = nextLat;
+        lon = nextLon;
+    }
+}
+
+std::vector<uint8_t> ActivityGenerator::fit() const {
+    FitWriter writer;
+    uint8_t architecture = options.bigEndian ? 1 : 0;
+    uint32_t endTime = options.startTime + (options.records - 1) * options.interval;
+    double elapsed = static_cast<double>(endTime - options.startTime);
+
+    writer.define(LOCAL_FILE_ID, FIT_MESG_NUM_FILE_ID, {
+        {fit::FileIdMesg::FieldDefNum::Type, 1, FIT_BASE_TYPE_ENUM},
+        {fit::FileIdMesg::FieldDefNum::Manufacturer, 2, FIT_BASE_TYPE_UINT16},
+        {fit::FileIdMesg::FieldDefNum::Product, 2, FIT_BASE_TYPE_UINT16},
+        {fit::FileIdMesg::FieldDefNum::SerialNumber, 4, FIT_BASE_TYPE_UINT32Z},
+        {fit::FileIdMesg::FieldDefNum::TimeCreated, 4, FIT_BASE_TYPE_UINT32},
+    }, architecture);
+    writer.message(LOCAL_FILE_ID);
+    writer.put(FIT_FILE_ACTIVITY, 1);
+    writer.put(FIT_MANUFACTURER_GARMIN, 2);
+    writer.put(options.product, 2);
+    writer.put(3900000000U + options.seed, 4);
+    writer.put(options.startTime, 4);
+
+    std::vector<FitWriterField> developerFields;
+
+    if (options.developerFields > 0) {
+        writer.define(LOCAL_DEVELOPER_DATA_ID, FIT_MESG_NUM_DEVELOPER_DATA_ID, {
+            {fit::DeveloperDataIdMesg::FieldDefNum::ApplicationId, 16, FIT_BASE_TYPE_BYTE},
+            {fit::DeveloperDataIdMesg::FieldDefNum::DeveloperDataIndex, 1, FIT_BASE_TYPE_UINT8},
+            {fit::DeveloperDataIdMesg::FieldDefNum::ApplicationVersion, 4, FIT_BASE_TYPE_UINT32},
+        }, architecture);
+        writer.message(LOCAL_DEVELOPER_DATA_ID);
+
+        for (int i = 0; i < 16; i++) {
+            writer.put(0x10 + i, 1);
+        }
+
+        writer.put(DEVELOPER_DATA_INDEX, 1);
+        writer.put(100, 4);
+
+        writer.define(LOCAL_FIELD_DESCRIPTION, FIT_MESG_NUM_FIELD_DESCRIPTION, {
+            {fit::FieldDescriptionMesg::FieldDefNum::DeveloperDataIndex, 1, FIT_BASE_TYPE_UINT8},
+            {fit::FieldDescriptionMesg::FieldDefNum::FieldDefinitionNumber, 1, FIT_BASE_TYPE_UINT8},
+            {fit::FieldDescriptionMesg::FieldDefNum::FitBaseTypeId, 1, FIT_BASE_TYPE_UINT8},
+            {fit::FieldDescriptionMesg::FieldDefNum::FieldName, 32, FIT_BASE_TYPE_STRING},
+            {fit::FieldDescriptionMesg::FieldDefNum::Scale, 1, FIT_BASE_TYPE_UINT8},
+            {fit::FieldDescriptionMesg::FieldDefNum::Offset, 1, FIT_BASE_TYPE_SINT8},
+            {fit::FieldDescriptionMesg::FieldDefNum::Units, 16, FIT_BASE_TYPE_STRING},
+            {fit::FieldDescriptionMesg::FieldDefNum::NativeMesgNum, 2, FIT_BASE_TYPE_UINT16},
+        }, architecture);
+
+        for (uint8_t i = 0; i < options.developerFields; i++) {
+            writer.message(LOCAL_FIELD_DESCRIPTION);
+            writer.put(DEVELOPER_DATA_INDEX, 1);
+            writer.put(i, 1);
+            writer.put(FIT_BASE_TYPE_UINT16, 1);
+            writer.putString(DEVELOPER_FIELDS[i].name, 32);
+            writer.put(DEVELOPER_FIELDS[i].scale, 1);
+            writer.put(0, 1);
+            writer.putString(DEVELOPER_FIELDS[i].units, 16);
+            writer.put(FIT_MESG_NUM_RECORD, 2);
+
+            developerFields.push_back({i, 2, DEVELOPER_DATA_INDEX});
+        }
+    }
+
+    writer.define(LOCAL_DEVICE_INFO, FIT_MESG_NUM_DEVICE_INFO, {
+        {fit::DeviceInfoMesg::FieldDefNum::Timestamp, 4, FIT_BASE_TYPE_UINT32},
+        {fit::DeviceInfoMesg::FieldDefNum::DeviceIndex, 1, FIT_BASE_TYPE_UINT8},
+        {fit::DeviceInfoMesg::FieldDefNum::Manufacturer, 2, FIT_BASE_TYPE_UINT16},
+        {fit::DeviceInfoMesg::FieldDefNum::Product, 2, FIT_BASE_TYPE_UINT16},
+    }, architecture);
+    writer.message(LOCAL_DEVICE_INFO);
+    writer.put(options.startTime, 4);
+    writer.put(0, 1); // Creator
+    writer.put(FIT_MANUFACTURER_GARMIN, 2);
+    writer.put(options.product, 2);
+
+    writer.define(LOCAL_SPORT, FIT_MESG_NUM_SPORT, {
+        {fit::SportMesg::FieldDefNum::Sport, 1, FIT_BASE_TYPE_ENUM},
+        {fit::SportMesg::FieldDefNum::SubSport, 1, FIT_BASE_TYPE_ENUM},
+    }, architecture);
+    writer.message(LOCAL_SPORT);
+    writer.put(options.sport, 1);
+    writer.put(0, 1);
+
+    uint8_t recordType = LOCAL_RECORD;
+    bool recordDefined = false;
+    bool compressedDefined = false;
+
+    for (uint32_t i = 0; i < options.records; i++) {
+        uint32_t timestamp = options.startTime + i * options.interval;
+        double altitude = 120.0 + 20.0 * std::sin(i / 300.0);
+        double heartRate = 140.0 + 15.0 * std::sin(i / 120.0);
+
+        // Churn: every switch of the local type comes with a new definition
+        if (options.redefineEvery > 0 && i > 0 && i % options.redefineEvery == 0) {
+            recordType = recordType == LOCAL_RECORD ? LOCAL_RECORD_CHURN : LOCAL_RECORD;
+            recordDefined = false;
+            compressedDefined = false;
+        }
+
+        // The first record carries the full timestamp the compressed ones count from
+        if (options.compressedTimestamps && i > 0) {
+            if (!compressedDefined) {
+                writer.define(LOCAL_COMPRESSED_RECORD, FIT_MESG_NUM_RECORD, recordFields(false), architecture, developerFields);
+                compressedDefined = true;
+            }
+
+            writer.compressedMessage(LOCAL_COMPRESSED_RECORD, timestamp & 0x1F);
+        } else {
+            if (!recordDefined) {
+                writer.define(recordType, FIT_MESG_NUM_RECORD, recordFields(true), architecture, developerFields);
+                recordDefined = true;
+            }
+
+            writer.message(recordType);
+            writer.put(timestamp, 4);
+        }
+
+        writer.put(static_cast<uint32_t>(fromDouble(latitudes[i])), 4);
+        writer.put(static_cast<uint32_t>(fromDouble(longitudes[i])), 4);
+        writer.put(static_cast<uint16_t>((altitude + 500.0) * 5.0), 2);
+        writer.put(static_cast<uint8_t>(heartRate), 1);
+        writer.put(static_cast<uint32_t>(distances[i] * 100.0), 4);
+        writer.put(static_cast<uint16_t>(options.speed * 1000.0), 2);
+
+        for (uint8_t f = 0; f < options.developerFields; f++) {
+            const auto& field = DEVELOPER_FIELDS[f];
+            double value = field.base + field.amplitude * std::sin(i / (60.0 + 10.0 * f));
+            writer.put(static_cast<uint16_t>(value * field.scale), 2);
+        }
+    }
+
+    auto [swcLat, necLat] = std::minmax_element(latitudes.begin(), latitudes.end());
+    auto [swcLong, necLong] = std::minmax_element(longitudes.begin(), longitudes.end());
+
+    writer.define(LOCAL_SESSION, FIT_MESG_NUM_SESSION, {
+        {fit::SessionMesg::FieldDefNum::Timestamp, 4, FIT_BASE_TYPE_UINT32},
+        {fit::SessionMesg::FieldDefNum::StartTime, 4, FIT_BASE_TYPE_UINT32},
+        {fit::SessionMesg::FieldDefNum::Sport, 1, FIT_BASE_TYPE_ENUM},
+        {fit::SessionMesg::FieldDefNum::SubSport, 1, FIT_BASE_TYPE_ENUM},
+        {fit::SessionMesg::FieldDefNum::TotalElapsedTime, 4, FIT_BASE_TYPE_UINT32},
+        {fit::SessionMesg::FieldDefNum::TotalTimerTime, 4, FIT_BASE_TYPE_UINT32},
+        {fit::SessionMesg::FieldDefNum::TotalDistance, 4, FIT_BASE_TYPE_UINT32},
+        {fit::SessionMesg::FieldDefNum::AvgSpeed, 2, FIT_BASE_TYPE_UINT16},
+        {fit::SessionMesg::FieldDefNum::AvgHeartRate, 1, FIT_BASE_TYPE_UINT8},
+        {fit::SessionMesg::FieldDefNum::NecLat, 4, FIT_BASE_TYPE_SINT32},
+        {fit::SessionMesg::FieldDefNum::NecLong, 4, FIT_BASE_TYPE_SINT32},
+        {fit::SessionMesg::FieldDefNum::SwcLat, 4, FIT_BASE_TYPE_SINT32},
+        {fit::SessionMesg::FieldDefNum::SwcLong, 4, FIT_BASE_TYPE_SINT32},
+    }, architecture);
+    writer.message(LOCAL_SESSION);
+    writer.put(endTime, 4);
+    writer.put(options.startTime, 4);
+    writer.put(options.sport, 1);
+    writer.put(0, 1);
+    writer.put(static_cast<uint32_t>(elapsed * 1000.0), 4);
+    writer.put(static_cast<uint32_t>(elapsed * 1000.0), 4);
+    writer.put(static_cast<uint32_t>(distances.back() * 100.0), 4);
+    writer.put(static_cast<uint16_t>(options.speed * 1000.0), 2);
+    writer.put(140, 1);
+    writer.put(static_cast<uint32_t>(fromDouble(*necLat)), 4);
+    writer.put(static_cast<uint32_t>(fromDouble(*necLong)), 4);
+    writer.put(static_cast<uint32_t>(fromDouble(*swcLat)), 4);
+    writer.put(static_cast<uint32_t>(fromDouble(*swcLong)), 4);
+
+    writer.define(LOCAL_ACTIVITY, FIT_MESG_NUM_ACTIVITY, {
+        {fit::ActivityMesg::FieldDefNum::Timestamp, 4, FIT_BASE_TYPE_UINT32},
+        {fit::ActivityMesg::FieldDefNum::TotalTimerTime, 4, FIT_BASE_TYPE_UINT32},
+        {fit::ActivityMesg::FieldDefNum::NumSessions, 2, FIT_BASE_TYPE_UINT16},
+        {fit::ActivityMesg::FieldDefNum::Type, 1, FIT_BASE_TYPE_ENUM},
+        {fit::ActivityMesg::FieldDefNum::Event, 1, FIT_BASE_TYPE_ENUM},
+        {fit::ActivityMesg::FieldDefNum::EventType, 1, FIT_BASE_TYPE_ENUM},
+    }, architecture);
+    writer.message(LOCAL_ACTIVITY);
+    writer.put(endTime, 4);
+    writer.put(static_cast<uint32_t>(elapsed * 1000.0), 4);
+    writer.put(1, 2);
+    writer.put(FIT_ACTIVITY_MANUAL, 1);
+    writer.put(FIT_EVENT_ACTIVITY, 1);
+    writer.put(FIT_EVENT_TYPE_STOP, 1);
+
+    return writer.finish();
+}
+
+std::string ActivityGenerator::gpx() const {
+    std::ostringstream oss;
+
+    oss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<gpx version=\"1.1\" creator=\"garmin-fit-utilities\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n"
+        << "  <trk>\n"
+        << "    <name>Synthetic activity " << options.seed << "</name>\n"
+        << "    <trkseg>\n"
+        << std::fixed;
+
+    for (uint32_t i = 0; i < options.records; i++) {
+        std::time_t unixTs = options.startTime + i * options.interval + FileIdScanner::FIT_EPOCH;
+        std::tm utc = *std::gmtime(&unixTs);
+
+        oss << "      <trkpt lat=\"" << std::setprecision(7) << latitudes[i]
+            << "\" lon=\"" << longitudes[i] << "\">"
+            << "<ele>" << std::setprecision(1) << 120.0 + 20.0 * std::sin(i / 300.0) << "</ele>"
+            << "<time>" << std::put_time(&utc, "%Y-%m-%dT%H:%M:%SZ") << "</time>"
+            << "</trkpt>\n";
+    }
+
+    oss << "    </trkseg>\n"
+        << "  </trk>\n"
+        << "</gpx>\n";
+
+    return oss.str();
+}
+
+void ActivityGenerator::saveFit(const fs::path& filename) const {
+    auto data = fit();
+    std::ofstream outFile(filename, std::ios::binary | std::ios::trunc);
+
+    outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    if (!outFile) {
+        throw std::runtime_error("ActivityGenerator error: cannot write file " + filename.string());
+    }
+}
+
+void ActivityGenerator::saveGpx(const fs::path& filename) const {
+    std::ofstream outFile(filename, std::ios::trunc);
+
+    outFile << gpx();
+
+    if (!outFile) {
+        throw std::runtime_error("ActivityGenerator error: cannot write file " + filename.string());
+    }
+}
+
+} // namespace darauble
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace darauble {
+
+struct ActivityOptions {
+    uint32_t records {3600};
+    uint32_t interval {1};            // Seconds between records
+    uint32_t startTime {1100000000};  // FIT time of the first record (2024-11-08)
+    double latitude {54.6872};        // Start of the route, degrees
+    double longitude {25.2797};
+    double speed {3.0};               // m/s
+    uint16_t product {3113};
+    uint8_t sport {1};                // FIT_SPORT_RUNNING
+    uint32_t seed {1};                // Same seed, same file
+
+    /*
+      Activities with the same route seed follow the same route, each with its own
+      GPS noise; 0 takes the seed, i.e. a route of its own.
+     */
+    uint32_t routeSeed {0};
+    double gpsNoise {0.0};            // Standard deviation of the GPS error, meters
+
+    uint8_t developerFields {0};      // Developer fields in every record, up to MAX_DEVELOPER_FIELDS
+    uint32_t redefineEvery {0};       // Switch the record's local type (a new definition) every N records, 0 never
+    bool compressedTimestamps {false};// Records after the first one use compressed timestamp headers
+    bool bigEndian {false};           // Big-endian definitions
+};
+
+/*
+  A synthetic activity: a random walk from the start point, recorded at a fixed interval.
+  Produces a valid FIT activity file (File ID, Device Info, Sport, Records, Session,
+  Activity) and the same route as a GPX track.
+ */
+class ActivityGenerator {
+private:
+    ActivityOptions options;
+    std::vector<double> latitudes;  // Degrees, one per record
+    std::vector<double> longitudes;
+    std::vector<double> distances;  // Cumulative, meters
+
+    void route();
+public:
+    static const uint8_t MAX_DEVELOPER_FIELDS = 4;
+
+    // Compressed timestamps can only count up to 31 seconds between records
+    static const uint32_t MAX_COMPRESSED_INTERVAL = 31;
+
+    ActivityGenerator(const ActivityOptions& _options);
+
+    std::vector<uint8_t> fit() const;
+    std::string gpx() const;
+
+    void saveFit(const fs::path& filename) const;
+    void saveGpx(const fs::path& filename) const;
+};
+
+} // namespace darauble
@@ -0,0 +1,129 @@
+#include "archive-generator.hpp"
+#include "file-id-scanner.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace darauble {
+
+namespace {
+
+constexpr uint32_t DAY = 86400;
+
+} // namespace
+
+ArchiveGenerator::ArchiveGenerator(const ArchiveOptions& _options) :
+    options {_options}
+{
+    if (options.activitiesPerDay == 0) {
+        throw std::runtime_error("ArchiveGenerator error: at least one activity per day");
+    }
+
+    // Files are named by the second they start at
+    if (options.activitiesPerDay > DAY) {
+        throw std::runtime_error("ArchiveGenerator error: at most one activity per second (86400 a day)");
+    }
+
+    // The last activity must end before FIT time runs out
+    if (options.files > 0) {
+        uint64_t lastStart = options.activity.startTime + offset(options.files - 1);
+        uint64_t lastEnd = lastStart + static_cast<uint64_t>(options.activity.records) * options.activity.interval;
+
+        if (lastEnd > UINT32_MAX) {
+            throw std::runtime_error("ArchiveGenerator error: too many files for the start time, FIT time would overflow");
+        }
+    }
+}
+
+uint64_t ArchiveGenerator::offset(uint32_t index) const {
+    return static_cast<uint64_t>(index) * DAY / options.activitiesPerDay;
+}
+
+ActivityOptions ArchiveGenerator::activity(uint32_t index) const {
+    ActivityOptions activity = options.activity;
+
+    activity.seed = options.activity.seed + index;
+    activity.routeSeed = options.routes ? options.activity.seed + index % options.routes : 0;
+    activity.startTime += static_cast<uint32_t>(offset(index));
+
+    return activity;
+}
+
+fs::path ArchiveGenerator::path(const ActivityOptions& activity) const {
+    std::time_t created = static_cast<std::time_t>(activity.startTime) + FileIdScanner::FIT_EPOCH;
+    std::tm ts = *std::gmtime(&created);
+
+    std::ostringstream directory, filename;
+    directory << std::put_time(&ts, "%Y/%m");
+    filename << std::put_time(&ts, "%Y-%m-%d-%H-%M-%S") << ".fit";
+
+    return fs::path(directory.str()) / filename.str();
+}
+
+uint64_t ArchiveGenerator::generate(const fs::path& directory, uint32_t jobs) const {
+    // Names and directories are prepared up front: std::gmtime is not reentrant
+    std::vector<ActivityOptions> activities;
+    std::vector<fs::path> paths;
+
+    activities.reserve(options.files);
+    paths.reserve(options.files);
+
+    for (uint32_t i = 0; i < options.files; i++) {
+        activities.push_back(activity(i));
+        paths.push_back(directory / path(activities.back()));
+        fs::create_directories(paths.back().parent_path());
+    }
+
+    std::atomic<uint32_t> next {0};
+    std::atomic<uint64_t> bytes {0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        for (uint32_t i = next++; i < options.files; i = next++) {
+            try {
+                GFU_TRACE_SCOPE("generate.file", "generate");
+                ActivityGenerator generator(activities[i]);
+                generator.saveFit(paths[i]);
+                bytes += fs::file_size(paths[i]);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+
+                if (!error) {
+                    error = std::current_exception();
+                }
+
+                next = options.files;
+            }
+        }
+    };
+
+    jobs = std::clamp<uint32_t>(jobs, 1, std::max<uint32_t>(options.files, 1));
+    std::vector<std::thread> threads;
+
+    for (uint32_t j = 1; j < jobs; j++) {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    return bytes;
+}
+
+} // namespace darauble
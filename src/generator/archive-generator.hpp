@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "activity-generator.hpp"
+
+namespace fs = std::filesystem;
+namespace darauble {
+
+struct ArchiveOptions {
+    uint32_t files {1000};
+    uint32_t routes {0};              // Distinct routes the activities repeat, 0 for a route per activity
+    uint32_t activitiesPerDay {2};    // 1 to 86400, files are named by the second they start at
+    ActivityOptions activity;         // Template of every activity; seed and start time vary per file
+};
+
+/*
+  A synthetic activity archive laid out like a watch export sorted by date:
+  YYYY/MM/YYYY-MM-DD-HH-MM-SS.fit, named after the (UTC) start time the way
+  garmin-rename-files would. Deterministic: the same options give the same files,
+  no matter how many jobs write them.
+ */
+class ArchiveGenerator {
+private:
+    ArchiveOptions options;
+
+    uint64_t offset(uint32_t index) const; // Seconds from the first start
+    ActivityOptions activity(uint32_t index) const;
+    fs::path path(const ActivityOptions& activity) const;
+public:
+    ArchiveGenerator(const ArchiveOptions& _options);
+
+    /*
+      Write the archive into the directory, returns the number of bytes written.
+     */
+    uint64_t generate(const fs::path& directory, uint32_t jobs = 1) const;
+};
+
+} // namespace darauble
@@ -0,0 +1,143 @@
+#include "fit-writer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fit_crc.hpp>
+
+namespace darauble {
+
+FitWriter::FitWriter() :
+    buffer(HEADER_SIZE, 0), architecture {0}, finished {false}
+{
+    std::fill(std::begin(architectures), std::end(architectures), 0);
+}
+
+void FitWriter::define(uint8_t localType, uint16_t globalMessageNumber, const std::vector<FitWriterField>& fields,
+                       uint8_t _architecture, const std::vector<FitWriterField>& developerFields) {
+    if (finished) {
+        throw std::runtime_error("FitWriter error: the file is finished");
+    }
+
+    architectures[localType & 0x0F] = _architecture;
+    architecture = _architecture;
+
+    buffer.push_back(0x40 | (developerFields.empty() ? 0 : 0x20) | (localType & 0x0F));
+    buffer.push_back(0); // Reserved
+    buffer.push_back(_architecture);
+    put(globalMessageNumber, 2);
+    buffer.push_back(static_cast<uint8_t>(fields.size()));
+
+    for (const auto& f : fields) {
+        buffer.push_back(f.fieldNumber);
+        buffer.push_back(f.size);
+        buffer.push_back(f.baseType);
+    }
+
+    if (!developerFields.empty()) {
+        buffer.push_back(static_cast<uint8_t>(developerFields.size()));
+
+        for (const auto& f : developerFields) {
+            buffer.push_back(f.fieldNumber);
+            buffer.push_back(f.size);
+            buffer.push_back(f.baseType);
+        }
+    }
+}
+
+void FitWriter::message(uint8_t localType) {
+    if (finished) {
+        throw std::runtime_error("FitWriter error: the file is finished");
+    }
+
+    architecture = architectures[localType & 0x0F];
+    buffer.push_back(localType & 0x0F);
+}
+
+void FitWriter::compressedMessage(uint8_t localType, uint8_t timeOffset) {
+    if (finished) {
+        throw std::runtime_error("FitWriter error: the file is finished");
+    }
+
+    if (localType > 3) {
+        throw std::runtime_error("FitWriter error: compressed timestamp messages can use local types 0-3 only");
+    }
+
+    architecture = architectures[localType];
+    buffer.push_back(0x80 | (localType << 5) | (timeOffset & 0x1F));
+}
+
+void FitWriter::put(uint64_t value, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) {
+        uint8_t shift = architecture == 0 ? i : size - 1 - i;
+        buffer.push_back(static_cast<uint8_t>(value >> (8 * shift)));
+    }
+}
+
+void FitWriter::putString(const std::string& value, uint8_t size) {
+    // Zero padded, always zero terminated
+    size_t length = std::min(value.size(), static_cast<size_t>(size - 1));
+
+    buffer.insert(buffer.end(), value.begin(), value.begin() + length);
+    buffer.insert(buffer.end(), size - length, 0);
+}
+
+const std::vector<uint8_t>& FitWriter::finish() {
+    if (finished) {
+        return buffer;
+    }
+
+    uint32_t dataSize = buffer.size() - HEADER_SIZE;
+
+    buffer[0] = HEADER_SIZE;
+    buffer[1] = PROTOCOL_VERSION;
+    buffer[2] = PROFILE_VERSION & 0xFF;
+    buffer[3] = PROFILE_VERSION >> 8;
+
+    for (int i = 0; i < 4; i++) {
+        buffer[4 + i] = (dataSize >> (8 * i)) & 0xFF;
+    }
+
+    std::memcpy(&buffer[8], ".FIT", 4);
+
+    uint16_t crc {0};
+
+    for (int i = 0; i < 12; i++) {
+        crc = fit::CRC::Get16(crc, buffer[i]);
+    }
+
+    buffer[12] = crc & 0xFF;
+    buffer[13] = crc >> 8;
+
+    crc = 0;
+
+    for (auto byte : buffer) {
+        crc = fit::CRC::Get16(crc, byte);
+    }
+
+    buffer.push_back(crc & 0xFF);
+    buffer.push_back(crc >> 8);
+
+    finished = true;
+    return buffer;
+}
+
+void FitWriter::save(const fs::path& filename) {
+    finish();
+
+    std::ofstream outFile(filename, std::ios::binary | std::ios::trunc);
+
+    if (!outFile) {
+        throw std::runtime_error("FitWriter error: cannot open file " + filename.string());
+    }
+
+    outFile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+
+    if (!outFile) {
+        throw std::runtime_error("FitWriter error: cannot write file " + filename.string());
+    }
+}
+
+} // namespace darauble
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace darauble {
+
+struct FitWriterField {
+    uint8_t fieldNumber; // As per fit_<message>_mesg.hpp
+    uint8_t size;        // Number of bytes
+    uint8_t baseType;    // FIT_BASE_TYPE_*
+};
+
+/*
+  Assembles a FIT file in memory: definition and data messages, then the header
+  and both CRCs on finish(). Values of a data message are put in the order of
+  the fields of its definition, in the definition's byte order.
+ */
+class FitWriter {
+private:
+    static const uint8_t HEADER_SIZE = 14;
+    static const uint8_t PROTOCOL_VERSION = 0x20; // 2.0
+    static const uint16_t PROFILE_VERSION = 21171;
+
+    std::vector<uint8_t> buffer;
+    uint8_t architectures[16]; // Byte order of each local message type's definition
+    uint8_t architecture;      // Byte order of the message being written
+    bool finished;
+
+public:
+    FitWriter();
+
+    /*
+      Define a local message type; a later definition of the same local type replaces it.
+      Architecture 0 is little-endian, 1 big-endian. Developer fields carry the developer
+      data index in place of the base type and follow the normal fields in the data.
+     */
+    void define(uint8_t localType, uint16_t globalMessageNumber, const std::vector<FitWriterField>& fields,
+                uint8_t _architecture = 0, const std::vector<FitWriterField>& developerFields = {});
+
+    /*
+      Start a data message with a normal header.
+     */
+    void message(uint8_t localType);
+
+    /*
+      Start a data message with a compressed timestamp header (local types 0-3 only);
+      the message's definition must not contain the timestamp field.
+     */
+    void compressedMessage(uint8_t localType, uint8_t timeOffset);
+
+    void put(uint64_t value, uint8_t size);
+    void putString(const std::string& value, uint8_t size);
+
+    size_t size() const { return buffer.size(); }
+
+    /*
+      Fill in the header and append the file CRC. Nothing can be written afterwards.
+     */
+    const std::vector<uint8_t>& finish();
+
+    void save(const fs::path& filename);
+};
+
+} // namespace darauble
@@ -10,10 +10,32 @@
 #include "panels/PointsPanel.hpp"
 #include "panels/RenamePanel.hpp"
 #include "panels/MapPanel.hpp"
+#include "panels/MapRenderer.hpp"
+#include "panels/LazyPanelHost.hpp"
 #include "dialogs/SettingsDialog.hpp"
+#include "utils/JobScheduler.hpp"
+#include "utils/StartupTrace.hpp"
 #include "icon/garmin-disconnect-icon.h"
 #include <wx/stream.h>
 #include <wx/mstream.h>
+#include <algorithm>
+
+namespace {
+
+// Activities parsed ahead on each side of the selection
+constexpr int PREFETCH_WINDOW = 2;
+
+// Map data rendered by Mapnik, as opposed to pre-rendered MBTiles
+bool UsesMapnik() {
+    SettingsManager& settings = SettingsManager::Instance();
+    wxString osmFile = settings.GetString("map_osm_file", "");
+    if (!osmFile.IsEmpty()) {
+        return !osmFile.EndsWith(".mbtiles");
+    }
+    return !settings.GetString("map_stylesheet", "").IsEmpty();
+}
+
+} // namespace
 
 wxBEGIN_EVENT_TABLE(MainFrame, wxFrame)
     EVT_MENU(ID_Exit, MainFrame::OnExit)
@@ -67,6 +89,21 @@ MainFrame::MainFrame()
     if (x == -1 || y == -1) {
         Center();
     }
+
+    // Mapnik scans its plugins and fonts on first use, done while the user looks at the list
+    if (UsesMapnik()) {
+        JobScheduler::Instance().Submit(JobLane::Bulk, [](JobContext&) {
+            MapnikRenderer::InitializeLibrary();
+        });
+    }
+
+    // Runs once the frame has been shown and handles events
+    CallAfter([this]() {
+        StartupTrace::MarkInteractive();
+        if (!m_dataLoaded) {
+            StartupTrace::Finish("no directory to load");
+        }
+    });
 }
 
 void MainFrame::CreateMenuBar() {
@@ -131,37 +168,33 @@ void MainFrame::CreateMainLayout() {
     m_notebook = new wxNotebook(rightPanel, wxID_ANY);
     
     // Create panels
-    m_activitiesPanel = std::make_unique<ActivitiesPanel>(m_notebook);
+    m_activityModel = std::make_unique<ActivityDataModel>();
+    m_activitiesPanel = std::make_unique<ActivitiesPanel>(m_notebook, m_activityModel.get());
     m_activityDetailsPanel = std::make_unique<ActivityDetailsPanel>(m_notebook);
-    m_fileTreePanel = std::make_unique<FileTreePanel>(m_splitter);
-    m_productEditorPanel = std::make_unique<ProductEditorPanel>(m_notebook);
-    m_timestampEditorPanel = std::make_unique<TimestampEditorPanel>(m_notebook);
-    m_gpxEditorPanel = std::make_unique<GpxEditorPanel>(m_notebook);
-    m_rawEditorPanel = std::make_unique<RawEditorPanel>(m_notebook);
-    m_pointsPanel = std::make_unique<PointsPanel>(m_notebook);
-    m_renamePanel = std::make_unique<RenamePanel>(m_notebook);
-    m_mapPanel = std::make_unique<MapPanel>(m_notebook);
+    m_fileTreePanel = std::make_unique<FileTreePanel>(m_splitter, m_activityModel.get());
+
+    m_prefetcher = std::make_unique<ActivityPrefetcher>([this](const std::string& path) {
+        // Map tiles only matter while the map is shown
+        if (m_mapPanel && m_notebook->GetPage(m_currentTabIndex) == m_mapPanel->GetParent()) {
+            m_mapPanel->PrefetchTrack(path);
+        }
+    });
     
     // Add pages to notebook
     m_notebook->AddPage(m_activitiesPanel.get(), "Activities", true);
     m_notebook->AddPage(m_activityDetailsPanel.get(), "Details");
-    m_notebook->AddPage(m_mapPanel.get(), "Map");
-    m_notebook->AddPage(m_productEditorPanel.get(), "Product Editor");
-    m_notebook->AddPage(m_timestampEditorPanel.get(), "Timestamp Editor");
-    m_notebook->AddPage(m_gpxEditorPanel.get(), "GPX Editor");
-    m_notebook->AddPage(m_rawEditorPanel.get(), "Raw Editor");
-    m_notebook->AddPage(m_pointsPanel.get(), "Points & Mapping");
-    m_notebook->AddPage(m_renamePanel.get(), "File Rename");
-    
-
-    // Register panels that implement IActivityPanel interface
-    m_activityPanels[m_productEditorPanel.get()] = m_productEditorPanel.get();
-    m_activityPanels[m_timestampEditorPanel.get()] = m_timestampEditorPanel.get();
-    m_activityPanels[m_gpxEditorPanel.get()] = m_gpxEditorPanel.get();
-    m_activityPanels[m_rawEditorPanel.get()] = m_rawEditorPanel.get();
-    m_activityPanels[m_pointsPanel.get()] = m_pointsPanel.get();
-    m_activityPanels[m_renamePanel.get()] = m_renamePanel.get();
-    m_activityPanels[m_mapPanel.get()] = m_mapPanel.get();
+    AddLazyPage<MapPanel>(m_mapPanel, "Map", [this](MapPanel& panel) {
+        // Extracts OSM data around the archived activities
+        if (!m_currentDirectory.IsEmpty()) {
+            panel.SetArchiveDirectory(m_currentDirectory.ToStdString());
+        }
+    });
+    AddLazyPage(m_productEditorPanel, "Product Editor");
+    AddLazyPage(m_timestampEditorPanel, "Timestamp Editor");
+    AddLazyPage(m_gpxEditorPanel, "GPX Editor");
+    AddLazyPage(m_rawEditorPanel, "Raw Editor");
+    AddLazyPage(m_pointsPanel, "Points & Mapping");
+    AddLazyPage(m_renamePanel, "File Rename");
     
     // Layout right panel
     rightSizer->Add(navSizer, 0, wxEXPAND | wxALL, 2);
@@ -173,6 +206,22 @@ void MainFrame::CreateMainLayout() {
     m_splitter->SetMinimumPaneSize(200);
 }
 
+template <typename Panel>
+void MainFrame::AddLazyPage(std::unique_ptr<Panel>& panel, const wxString& title,
+                            std::function<void(Panel&)> setup) {
+    // The panel is owned here like the eager ones, so it goes before its host
+    auto* host = new LazyPanelHost(m_notebook, [&panel, setup](wxWindow* parent) {
+        panel = std::make_unique<Panel>(parent);
+        if (setup) {
+            setup(*panel);
+        }
+        return LazyPanelHost::Created{panel.get(), panel.get()};
+    });
+
+    m_notebook->AddPage(host, title);
+    m_activityPanels[host] = host;
+}
+
 void MainFrame::OnExit(wxCommandEvent& WXUNUSED(event)) {
     Close(true);
 }
@@ -233,14 +282,15 @@ void MainFrame::OnSettings(wxCommandEvent& WXUNUSED(event)) {
 
 void MainFrame::OnRefresh(wxCommandEvent& WXUNUSED(event)) {
     if (!m_currentDirectory.IsEmpty()) {
-        LoadDirectory(m_currentDirectory);
+        // Watched changes are applied as they come, this only flushes the pending ones
+        m_activityModel->Refresh();
     } else {
         wxMessageBox("No directory selected. Use File > Open Directory first.", 
                      "Refresh", wxOK | wxICON_INFORMATION);
     }
 }
 
-void MainFrame::LoadDirectory(const wxString& path) {
+void MainFrame::LoadDirectory(const wxString& path, bool restoreSnapshot) {
     if (path.IsEmpty()) return;
     
     SetStatusText("Loading: " + path, 1);
@@ -259,7 +309,7 @@ void MainFrame::LoadDirectory(const wxString& path) {
     SettingsManager::Instance().SetLastDirectory(path);
     
     // Update panels with new directory
-    RefreshAllPanels();
+    RefreshAllPanels(restoreSnapshot);
     
     // Update UI state
     m_dataLoaded = true;
@@ -267,8 +317,15 @@ void MainFrame::LoadDirectory(const wxString& path) {
     SetStatusText("Directory: " + path, 1);
 }
 
-void MainFrame::RefreshAllPanels() {
+void MainFrame::RefreshAllPanels(bool restoreSnapshot) {
     if (m_currentDirectory.IsEmpty()) return;
+
+    // Load the catalog once, the tree and the list show it as it fills in
+    if (restoreSnapshot) {
+        m_activityModel->Restore(m_currentDirectory);
+    } else {
+        m_activityModel->Load(m_currentDirectory);
+    }
     
     // Update file tree panel
     if (m_fileTreePanel) {
@@ -279,6 +336,11 @@ void MainFrame::RefreshAllPanels() {
     if (m_activitiesPanel) {
         m_activitiesPanel->SetDirectory(m_currentDirectory);
     }
+
+    // Map panel extracts OSM data around the archived activities, once it has been created
+    if (m_mapPanel) {
+        m_mapPanel->SetArchiveDirectory(m_currentDirectory.ToStdString());
+    }
     
     // Other panels don't need directory updates for basic functionality
 }
@@ -296,10 +358,10 @@ void MainFrame::LoadSettings() {
         SetPosition(wxPoint(x, y));
     }
     
-    // Restore last directory if it exists
+    // Restore last directory if it exists, showing the catalog of the last session right away
     wxString lastDir = settings.GetLastDirectory();
     if (!lastDir.IsEmpty() && wxDirExists(lastDir)) {
-        LoadDirectory(lastDir);
+        LoadDirectory(lastDir, true);
     }
     
     // Restore view mode and granularity settings
@@ -378,6 +440,12 @@ void MainFrame::OnPreviousActivity(wxCommandEvent& WXUNUSED(event)) {
     // Get total number of activities
     int activityCount = m_activitiesPanel->GetActivityCount();
     if (activityCount == 0) return;
+
+    // Rows arriving from a running scan shift the selected row
+    int selected = m_activitiesPanel->GetSelection();
+    if (selected != -1) {
+        m_selectedActivityIndex = selected;
+    }
     
     if (m_selectedActivityIndex == -1) {
         // No selection, select the first item
@@ -400,6 +468,12 @@ void MainFrame::OnNextActivity(wxCommandEvent& WXUNUSED(event)) {
     // Get total number of activities
     int activityCount = m_activitiesPanel->GetActivityCount();
     if (activityCount == 0) return;
+
+    // Rows arriving from a running scan shift the selected row
+    int selected = m_activitiesPanel->GetSelection();
+    if (selected != -1) {
+        m_selectedActivityIndex = selected;
+    }
     
     if (m_selectedActivityIndex == -1) {
         // No selection, select the first item
@@ -417,8 +491,12 @@ void MainFrame::OnNextActivity(wxCommandEvent& WXUNUSED(event)) {
 }
 
 void MainFrame::OnActivitySelected(wxCommandEvent& event) {
-    // Get the selected index from the event
+    // Get the selected index from the event, rows may have moved since it was posted
     m_selectedActivityIndex = event.GetInt();
+    int selected = m_activitiesPanel->GetSelection();
+    if (selected != -1) {
+        m_selectedActivityIndex = selected;
+    }
 
     // Update the details panel
     if (m_activityDetailsPanel) {
@@ -435,6 +513,8 @@ void MainFrame::OnActivitySelected(wxCommandEvent& event) {
             // Enable navigation buttons
             m_prevButton->Enable(true);
             m_nextButton->Enable(true);
+
+            PrefetchNeighbours();
         } else {
             m_activityDetailsPanel->ClearSelection();
 
@@ -468,6 +548,8 @@ void MainFrame::UpdateActivitySelection() {
         // Enable navigation buttons
         m_prevButton->Enable(true);
         m_nextButton->Enable(true);
+
+        PrefetchNeighbours();
     } else {
         // Clear selection
         m_selectedActivityIndex = -1;
@@ -482,13 +564,43 @@ void MainFrame::UpdateActivitySelection() {
     }
 }
 
+void MainFrame::PrefetchNeighbours() {
+    int count = m_activitiesPanel->GetActivityCount();
+    if (count <= 1 || m_selectedActivityIndex < 0) {
+        m_prefetcher->Cancel();
+        return;
+    }
+
+    // Nearest first on both sides, wrapping around like the navigation buttons
+    std::vector<std::string> paths;
+    for (int distance = 1; distance <= PREFETCH_WINDOW && 2 * distance <= count; ++distance) {
+        for (int index : {m_selectedActivityIndex + distance, m_selectedActivityIndex - distance}) {
+            ActivityDisplayData activityData;
+            if (m_activitiesPanel->GetActivityData((index + count) % count, activityData)) {
+                std::string path = activityData.fullPath.ToStdString();
+                if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+                    paths.push_back(path);
+                }
+            }
+        }
+    }
+
+    m_prefetcher->Prefetch(paths);
+}
+
 std::string MainFrame::GetCurrentActivityFilePath() const {
     if (m_selectedActivityIndex < 0 || !m_activitiesPanel) {
         return "";
     }
 
+    // The list may have re-sorted or filtered since the selection was made
+    int index = m_activitiesPanel->GetSelection();
+    if (index == -1) {
+        index = m_selectedActivityIndex;
+    }
+
     ActivityDisplayData activityData;
-    bool hasData = m_activitiesPanel->GetActivityData(m_selectedActivityIndex, activityData);
+    bool hasData = m_activitiesPanel->GetActivityData(index, activityData);
 
     return hasData ? activityData.fullPath.ToStdString() : "";
 }
@@ -537,6 +649,9 @@ void MainFrame::OnTabChanged(wxBookCtrlEvent& event) {
 }
 
 MainFrame::~MainFrame() {
+    // No more prefetch notifications while the panels go away
+    m_prefetcher.reset();
+
     // Manually remove all pages from the notebook before unique_ptr destructors run
     // This prevents the segfault that occurs when wxNotebook tries to delete already-destroyed panels
     if (m_notebook) {
@@ -6,10 +6,13 @@
 #endif
 #include <wx/notebook.h>
 #include <wx/splitter.h>
+#include <functional>
 #include <memory>
 #include <unordered_map>
 #include "utils/SettingsManager.hpp"
 #include "interfaces/IActivityPanel.hpp"
+#include "models/ActivityDataModel.hpp"
+#include "utils/ActivityPrefetcher.hpp"
 
 // Forward declarations for panels
 class ActivitiesPanel;
@@ -60,13 +63,24 @@ private:
     void CreateStatusBar();
     void CreateMainLayout();
 
+    /**
+     * Add a tab whose panel is created when the tab is first activated.
+     * @param setup Called once the panel exists, may be empty
+     */
+    template <typename Panel>
+    void AddLazyPage(std::unique_ptr<Panel>& panel, const wxString& title,
+                     std::function<void(Panel&)> setup = {});
+
     // Main UI components
     wxNotebook* m_notebook;
     wxSplitterWindow* m_splitter;
     wxButton* m_prevButton;
     wxButton* m_nextButton;
     
-    // Panels
+    // Catalog of the opened directory, shared by the panels below (declared first: outlives them)
+    std::unique_ptr<ActivityDataModel> m_activityModel;
+
+    // Panels; all but the activity list, its details and the tree are created on first use
     std::unique_ptr<ActivitiesPanel> m_activitiesPanel;
     std::unique_ptr<ActivityDetailsPanel> m_activityDetailsPanel;
     std::unique_ptr<FileTreePanel> m_fileTreePanel;
@@ -78,6 +92,9 @@ private:
     std::unique_ptr<RenamePanel> m_renamePanel;
     std::unique_ptr<MapPanel> m_mapPanel;
 
+    // Parses the neighbours of the selection in the background (declared last: stopped first)
+    std::unique_ptr<ActivityPrefetcher> m_prefetcher;
+
     // Application state
     wxString m_currentDirectory;
     bool m_dataLoaded;
@@ -88,11 +105,12 @@ private:
     std::unordered_map<wxWindow*, IActivityPanel*> m_activityPanels;
     
     // Internal methods
-    void LoadDirectory(const wxString& path);
-    void RefreshAllPanels();
+    void LoadDirectory(const wxString& path, bool restoreSnapshot = false);
+    void RefreshAllPanels(bool restoreSnapshot = false);
     void LoadSettings();
     void SaveSettings();
     void UpdateActivitySelection();
+    void PrefetchNeighbours();
     void NotifyTabActivation(int tabIndex, const std::string& activityFilePath);
     std::string GetCurrentActivityFilePath() const;
 
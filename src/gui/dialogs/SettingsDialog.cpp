@@ -22,7 +22,7 @@ void SettingsDialog::CreateLayout() {
     
     // OSM File setting
     wxBoxSizer* osmSizer = new wxBoxSizer(wxHORIZONTAL);
-    wxStaticText* osmLabel = new wxStaticText(this, wxID_ANY, "OSM PBF File:");
+    wxStaticText* osmLabel = new wxStaticText(this, wxID_ANY, "Map File:");
     m_osmFileCtrl = new wxTextCtrl(this, wxID_ANY, "", wxDefaultPosition, wxSize(300, -1));
     wxButton* browseButton = new wxButton(this, ID_BROWSE_OSM, "Browse...");
     
@@ -31,7 +31,7 @@ void SettingsDialog::CreateLayout() {
     osmSizer->Add(browseButton, 0, wxALIGN_CENTER_VERTICAL);
     
     wxStaticText* osmHelp = new wxStaticText(this, wxID_ANY, 
-        "Select an OpenStreetMap PBF file for displaying maps with tracks.\nLeave empty to show tracks only.");
+        "Select an OpenStreetMap PBF file or an MBTiles raster tile pack for displaying\nmaps with tracks. Leave empty to show tracks only.");
     osmHelp->SetFont(osmHelp->GetFont().Smaller());
     
     mapSizer->Add(osmSizer, 0, wxEXPAND | wxALL, 5);
@@ -53,8 +53,10 @@ void SettingsDialog::CreateLayout() {
 }
 
 void SettingsDialog::OnBrowseOSM(wxCommandEvent& event) {
-    wxFileDialog fileDialog(this, "Select OSM PBF File", "", "",
-                           "OpenStreetMap PBF files (*.osm.pbf)|*.osm.pbf|All files (*.*)|*.*",
+    wxFileDialog fileDialog(this, "Select Map File", "", "",
+                           "Map files (*.osm.pbf;*.mbtiles)|*.osm.pbf;*.mbtiles|"
+                           "OpenStreetMap PBF files (*.osm.pbf)|*.osm.pbf|"
+                           "MBTiles tile packs (*.mbtiles)|*.mbtiles|All files (*.*)|*.*",
                            wxFD_OPEN | wxFD_FILE_MUST_EXIST);
     
     if (fileDialog.ShowModal() == wxID_OK) {
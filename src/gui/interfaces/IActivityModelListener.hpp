@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <wx/string.h>
+
+/**
+ * Interface for views of the shared activity catalog (ActivityDataModel).
+ * All notifications are delivered on the UI thread.
+ */
+class IActivityModelListener {
+public:
+    virtual ~IActivityModelListener() = default;
+
+    /**
+     * The catalog was emptied and a new directory is being loaded.
+     */
+    virtual void OnCatalogCleared() = 0;
+
+    /**
+     * Rows [firstRow, firstRow + count) were appended to the catalog.
+     */
+    virtual void OnActivitiesAdded(size_t firstRow, size_t count) = 0;
+
+    /**
+     * Files checked so far while loading, including those already in the catalog.
+     */
+    virtual void OnCatalogProgress(size_t done, size_t total) {}
+
+    /**
+     * Loading finished or was cancelled, no more rows will be added.
+     */
+    virtual void OnCatalogLoaded() = 0;
+
+    /**
+     * A row was edited in place (e.g. renamed, or its file was modified).
+     * Its time and sort values may have changed.
+     */
+    virtual void OnActivityChanged(size_t row) {}
+
+    /**
+     * The file of a row was deleted or moved out of the directory. The row number
+     * stays reserved, the table reports it as removed.
+     */
+    virtual void OnActivityRemoved(size_t row) {}
+
+    /**
+     * A directory below the loaded one was created, deleted or renamed.
+     */
+    virtual void OnFolderChanged(const wxString& path) {}
+};
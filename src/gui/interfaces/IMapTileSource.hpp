@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include "../panels/MapTiles.hpp"
+
+/**
+ * Interface for providers of MAP_TILE_SIZE slippy map tiles.
+ *
+ * Implemented by MapnikRenderer (renders vector OSM data) and MBTilesSource
+ * (reads a pre-rendered raster tile pack). Instances are not thread-safe: the
+ * tile worker creates its own instance on its thread, the UI thread keeps one
+ * only to validate the source.
+ */
+class IMapTileSource {
+public:
+    virtual ~IMapTileSource() = default;
+
+    /**
+     * Check whether the source was opened successfully and can produce tiles.
+     */
+    virtual bool isValid() const = 0;
+
+    /**
+     * Hash identifying the tile contents, used to key cached tiles.
+     * Must change whenever the source would produce different pixels.
+     */
+    virtual uint64_t styleHash() const = 0;
+
+    /**
+     * Produce a single tile.
+     * @return Tile or nullptr if the source is not valid or the tile failed
+     */
+    virtual MapTilePtr renderTile(int z, int x, int y) = 0;
+
+    /**
+     * Whether produced tiles are worth storing in the on-disk tile cache.
+     * Sources that already read tiles from local storage don't need a second copy.
+     */
+    virtual bool persistTiles() const { return true; }
+};
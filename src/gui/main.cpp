@@ -3,15 +3,26 @@
     #include <wx/wx.h>
 #endif
 #include <locale>
+#include <memory>
 
 #include "MainFrame.hpp"
+#include "utils/JobScheduler.hpp"
+#include "utils/StartupTrace.hpp"
+#include "trace/trace.hpp"
 
 class GarminSportsManagerApp : public wxApp {
 public:
     virtual bool OnInit() override;
+    virtual int OnExit() override;
+
+private:
+    // Tracing of the whole session, written out on exit (GFU_TRACE=<file.json>)
+    std::unique_ptr<darauble::TraceSession> m_trace;
 };
 
 bool GarminSportsManagerApp::OnInit() {
+    StartupTrace::Begin();
+    m_trace = std::make_unique<darauble::TraceSession>("garmin-disconnect");
     if (!wxApp::OnInit()) {
         return false;
     }
@@ -25,11 +36,22 @@ bool GarminSportsManagerApp::OnInit() {
     // Ensure wxWidgets uses UTF-8 encoding
     wxLocale::AddCatalogLookupPathPrefix(".");
 
+    // Background work of all panels runs on the shared workers
+    JobScheduler::Instance().Start();
+
     // Create and show the main frame
     MainFrame* frame = new MainFrame();
+    StartupTrace::Mark("main frame created");
     frame->Show(true);
 
     return true;
 }
 
+int GarminSportsManagerApp::OnExit() {
+    // The main frame is gone, its jobs are cancelled and only need to return
+    JobScheduler::Instance().Shutdown();
+    m_trace.reset();
+    return wxApp::OnExit();
+}
+
 wxIMPLEMENT_APP(GarminSportsManagerApp);
\ No newline at end of file
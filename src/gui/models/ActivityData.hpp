@@ -14,4 +14,23 @@ struct ActivityDisplayData {
     wxString filePath;     // Display path (relative, for showing in UI)
     wxString fullPath;     // Full absolute path (for file operations)
     uint32_t timestamp;
+
+    // Typed values behind the formatted strings, the activity list sorts and formats from these
+    enum class Status : uint8_t { Parsed, NoData, ParseError };
+    Status status = Status::Parsed;
+    uint8_t sportId = 0;
+    uint8_t subSportId = 0;
+    uint16_t sessionCount = 0;
+    double elapsedTime = 0.0;   // seconds
+    double totalDistance = 0.0; // meters
+    uint16_t avgSpeed = 0;      // m/s * 1000
+    uint16_t avgHeartRate = 0;  // bpm
+    uint16_t totalSets = 0;
+
+    // Bounding box of all sessions in degrees, used to plan map extracts
+    bool hasBounds = false;
+    double minLat = 0.0;
+    double minLon = 0.0;
+    double maxLat = 0.0;
+    double maxLon = 0.0;
 };
\ No newline at end of file
@@ -1,3 +1,812 @@
 #include "ActivityDataModel.hpp"
+#include "../interfaces/IActivityModelListener.hpp"
+#include "../utils/ActivityLoader.hpp"
+#include "../utils/ParsedFileCache.hpp"
+#include "../utils/StartupTrace.hpp"
+#include "activity-cache/activity-cache.hpp"
+#include <wx/datetime.h>
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
+#include <fit_date_time.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 
-// Stub implementation for ActivityDataModel
\ No newline at end of file
+namespace {
+
+// Changes are applied once the file system has been quiet for a moment,
+// but a steady stream (e.g. a long copy) is still applied every few seconds
+constexpr int CHANGE_QUIET_MS = 500;
+constexpr auto CHANGE_MAX_DELAY = std::chrono::seconds(3);
+
+// Not wxFSW_EVENT_ALL: access events would fire for every file the loaders read
+constexpr int WATCHED_EVENTS = wxFSW_EVENT_CREATE | wxFSW_EVENT_DELETE | wxFSW_EVENT_RENAME
+                             | wxFSW_EVENT_MODIFY | wxFSW_EVENT_WARNING | wxFSW_EVENT_ERROR;
+
+bool IsFitFile(const wxString& path) {
+    return path.EndsWith(".fit");
+}
+
+// FNV-1a over the values the catalog keeps of an activity, to spot restored rows that changed
+uint64_t Fingerprint(const ActivityDisplayData& data) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](const void* bytes, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<const unsigned char*>(bytes)[i];
+            hash *= 0x100000001b3ULL;
+        }
+    };
+    auto mixValue = [&mix](const auto& value) { mix(&value, sizeof(value)); };
+
+    mixValue(data.timestamp);
+    mixValue(data.status);
+    mixValue(data.sportId);
+    mixValue(data.subSportId);
+    mixValue(data.sessionCount);
+    mixValue(data.elapsedTime);
+    mixValue(data.totalDistance);
+    mixValue(data.avgSpeed);
+    mixValue(data.avgHeartRate);
+    mixValue(data.totalSets);
+    mixValue(data.hasBounds);
+    mixValue(data.minLat);
+    mixValue(data.minLon);
+    mixValue(data.maxLat);
+    mixValue(data.maxLon);
+
+    wxScopedCharBuffer name = data.name.utf8_str();
+    mix(name.data(), name.length());
+    return hash;
+}
+
+} // namespace
+
+ActivityDataModel::ActivityDataModel()
+    : m_changeTimer(this),
+      m_rescanNeeded(false),
+      m_restoring(false),
+      m_generation(0) {
+    Bind(wxEVT_FSWATCHER, &ActivityDataModel::OnFileSystemEvent, this);
+    Bind(wxEVT_TIMER, &ActivityDataModel::OnChangeTimer, this, m_changeTimer.GetId());
+}
+
+ActivityDataModel::~ActivityDataModel() {
+    m_changeTimer.Stop();
+    m_watcher.reset();
+
+    // Loader threads post to this model, they must be gone before it is
+    m_restoreJob.Cancel();
+    if (m_loader) {
+        m_loader->Cancel();
+    }
+    if (m_updater) {
+        m_updater->Cancel();
+    }
+    m_loader.reset();
+    m_updater.reset();
+    m_retiredLoaders.clear();
+}
+
+void ActivityDataModel::AddListener(IActivityModelListener* listener) {
+    if (listener && std::find(m_listeners.begin(), m_listeners.end(), listener) == m_listeners.end()) {
+        m_listeners.push_back(listener);
+    }
+}
+
+void ActivityDataModel::RemoveListener(IActivityModelListener* listener) {
+    m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), listener), m_listeners.end());
+}
+
+template <typename Notify>
+void ActivityDataModel::NotifyListeners(Notify notify) {
+    // Copy: a listener may unregister while being notified
+    auto listeners = m_listeners;
+    for (auto* listener : listeners) {
+        notify(listener);
+    }
+}
+
+void ActivityDataModel::Load(const wxString& directory) {
+    if (Reset(directory)) {
+        StartLoader();
+    }
+}
+
+void ActivityDataModel::Restore(const wxString& directory) {
+    if (!Reset(directory)) {
+        return;
+    }
+
+    struct Result {
+        std::vector<ActivityDisplayData> rows;
+        std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    };
+    auto result = std::make_shared<Result>();
+    auto cache = m_cache;
+    uint64_t generation = m_generation;
+
+    // Reading the snapshot costs a lookup in the memory-mapped cache per activity, no file
+    // is touched; still done off the UI thread, so the first frame never waits for it
+    m_restoring = true;
+    m_restoreJob = JobScheduler::Instance().Submit(JobLane::Interactive,
+        [result, cache, directory](JobContext& job) {
+            std::ifstream file(SnapshotPath());
+            std::string line;
+            if (!std::getline(file, line) || wxString::FromUTF8(line) != directory) {
+                return; // Taken of another directory
+            }
+
+            wxString prefix = directory + wxFileName::GetPathSeparator();
+            while (std::getline(file, line) && !job.IsCancelled()) {
+                if (line.empty()) {
+                    continue;
+                }
+
+                ActivityDisplayData data;
+                data.filePath = wxString::FromUTF8(line);
+                data.fullPath = prefix + data.filePath;
+
+                // Files without a cache entry are left to the loader
+                darauble::CachedActivity activity;
+                if (!cache->peek(std::filesystem::path(data.fullPath.ToStdString()), activity)) {
+                    continue;
+                }
+                ActivityLoader::FromCachedActivity(activity, data);
+
+                (*result->snapshot)[data.fullPath].fingerprint = Fingerprint(data);
+                result->rows.push_back(std::move(data));
+            }
+        },
+        [this, result, generation]() {
+            OnSnapshotRestored(generation, result->rows, result->snapshot);
+        });
+}
+
+bool ActivityDataModel::Reset(const wxString& directory) {
+    StopLoaders();
+    m_restoreJob.Cancel();
+    m_restoring = false;
+    m_snapshot.reset();
+    ++m_generation;
+
+    m_directory = directory;
+    m_table.Clear();
+    m_localHour.clear();
+    m_timeIndex.clear();
+    m_sportIndex.clear();
+    m_rowByPath.clear();
+
+    // The full load sees every change made so far
+    m_changeTimer.Stop();
+    m_pendingChanges.clear();
+    m_rescanNeeded = false;
+
+    NotifyListeners([](IActivityModelListener* listener) { listener->OnCatalogCleared(); });
+
+    if (directory.IsEmpty()) {
+        NotifyListeners([](IActivityModelListener* listener) { listener->OnCatalogLoaded(); });
+        return false;
+    }
+
+    // A subdirectory of an archive shares the cache of the archive
+    std::filesystem::path root = darauble::ActivityCache::findRoot(directory.ToStdString());
+    if (!m_cache || m_cache->root() != root) {
+        m_cache = std::make_shared<darauble::ActivityCache>(root);
+    }
+
+    // Watchers need a running event loop, at startup it isn't running yet
+    CallAfter(&ActivityDataModel::StartWatching);
+    return true;
+}
+
+void ActivityDataModel::StartLoader() {
+    uint64_t generation = m_generation;
+
+    // Restored activities that are unchanged are only marked as seen, not reported again
+    ActivityLoader::Filter filter;
+    if (m_snapshot) {
+        filter = [snapshot = m_snapshot](const ActivityDisplayData& data) {
+            auto it = snapshot->find(data.fullPath);
+            if (it == snapshot->end()) {
+                return true;
+            }
+            it->second.seen = true;
+            return it->second.fingerprint != Fingerprint(data);
+        };
+    }
+
+    m_loader = std::make_unique<ActivityLoader>(m_directory, m_cache, std::move(filter),
+        [this, generation](std::vector<ActivityDisplayData>&& batch, size_t done, size_t total, bool finished) {
+            CallAfter([this, generation, batch = std::move(batch), done, total, finished]() mutable {
+                OnLoaderBatch(generation, batch, done, total, finished);
+            });
+        });
+    m_loader->Start();
+}
+
+void ActivityDataModel::OnSnapshotRestored(uint64_t generation, std::vector<ActivityDisplayData>& rows,
+                                           std::shared_ptr<Snapshot> snapshot) {
+    if (generation != m_generation) {
+        return;
+    }
+    m_restoring = false;
+
+    if (!rows.empty()) {
+        m_table.Reserve(rows.size());
+        for (const auto& data : rows) {
+            m_table.Append(data);
+        }
+        IndexRows(0);
+
+        size_t count = rows.size();
+        NotifyListeners([count](IActivityModelListener* listener) { listener->OnActivitiesAdded(0, count); });
+        m_snapshot = std::move(snapshot);
+    }
+    StartupTrace::Mark(wxString::Format("catalog snapshot restored (%zu activities)", rows.size()));
+
+    StartLoader();
+}
+
+void ActivityDataModel::RemoveUnseen() {
+    for (const auto& entry : *m_snapshot) {
+        if (entry.second.seen) {
+            continue;
+        }
+
+        // Deleted since the snapshot was taken; a row the watcher removed already is gone
+        auto it = m_rowByPath.find(entry.first);
+        if (it != m_rowByPath.end()) {
+            uint32_t row = it->second;
+            UnindexRow(row);
+            m_table.Remove(row);
+            NotifyListeners([row](IActivityModelListener* listener) { listener->OnActivityRemoved(row); });
+        }
+    }
+}
+
+std::filesystem::path ActivityDataModel::SnapshotPath() {
+    wxString cacheDir = wxStandardPaths::Get().GetUserDir(wxStandardPaths::Dir_Cache);
+    return std::filesystem::path(cacheDir.ToStdString()) / "garmin-disconnect" / "catalog.snapshot";
+}
+
+void ActivityDataModel::SaveSnapshot() {
+    // The directory, then the display paths of its activities, one per line
+    auto lines = std::make_shared<std::vector<std::string>>();
+    lines->reserve(m_rowByPath.size() + 1);
+    lines->push_back(m_directory.ToStdString(wxConvUTF8));
+    for (uint32_t row : m_timeIndex) {
+        lines->push_back(m_table.GetFilePath(row).ToStdString(wxConvUTF8));
+    }
+
+    JobScheduler::Instance().Submit(JobLane::Bulk, [lines](JobContext&) {
+        std::filesystem::path path = SnapshotPath();
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+
+        // Written aside and renamed, a concurrent start never reads half a snapshot
+        std::filesystem::path temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::trunc);
+            for (const auto& line : *lines) {
+                file << line << '\n';
+            }
+            if (!file) {
+                return;
+            }
+        }
+        std::filesystem::rename(temporary, path, error);
+    });
+}
+
+void ActivityDataModel::CancelLoad() {
+    if (!IsLoading()) {
+        return;
+    }
+
+    // Restored activities not validated yet stay as they are
+    StopLoaders();
+    m_restoreJob.Cancel();
+    m_restoring = false;
+    m_snapshot.reset();
+    ++m_generation;
+    NotifyListeners([](IActivityModelListener* listener) { listener->OnCatalogLoaded(); });
+}
+
+void ActivityDataModel::Refresh() {
+    if (!m_watcher || m_rescanNeeded) {
+        Load(m_directory);
+        return;
+    }
+
+    m_changeTimer.Stop();
+    ProcessChanges();
+}
+
+void ActivityDataModel::StopLoaders() {
+    for (auto* loader : {&m_loader, &m_updater}) {
+        if (*loader) {
+            (*loader)->Cancel();
+            m_retiredLoaders.push_back(std::move(*loader));
+        }
+    }
+
+    // Destroy only loaders whose threads are done, so the UI never waits on a file
+    m_retiredLoaders.erase(
+        std::remove_if(m_retiredLoaders.begin(), m_retiredLoaders.end(),
+                       [](const std::unique_ptr<ActivityLoader>& loader) { return loader->IsFinished(); }),
+        m_retiredLoaders.end());
+}
+
+void ActivityDataModel::OnLoaderBatch(uint64_t generation, std::vector<ActivityDisplayData>& batch,
+                                      size_t done, size_t total, bool finished) {
+    if (generation != m_generation) {
+        return;
+    }
+
+    if (m_snapshot) {
+        // Validating a restored catalog: only changed and new activities are reported
+        ApplyBatch(batch);
+    } else if (!batch.empty()) {
+        size_t firstRow = m_table.Size();
+        m_table.Reserve(firstRow + batch.size());
+        for (const auto& data : batch) {
+            m_table.Append(data);
+        }
+        IndexRows(firstRow);
+
+        size_t count = batch.size();
+        NotifyListeners([firstRow, count](IActivityModelListener* listener) {
+            listener->OnActivitiesAdded(firstRow, count);
+        });
+    }
+
+    if (finished) {
+        if (m_snapshot) {
+            RemoveUnseen();
+            m_snapshot.reset();
+        }
+
+        // Finished loaders are retired without waiting, their thread is just returning
+        StopLoaders();
+        m_cache->flush();
+        SaveSnapshot();
+        NotifyListeners([](IActivityModelListener* listener) { listener->OnCatalogLoaded(); });
+        StartupTrace::Finish(wxString::Format("catalog loaded (%zu activities)", m_rowByPath.size()));
+    } else {
+        NotifyListeners([done, total](IActivityModelListener* listener) {
+            listener->OnCatalogProgress(done, total);
+        });
+    }
+}
+
+uint32_t ActivityDataModel::LocalHour(uint32_t timestamp) {
+    if (timestamp == 0) {
+        return 0;
+    }
+
+    // Converted once here, period queries compare the packed values
+    fit::DateTime fitDateTime(timestamp);
+    wxDateTime activityTime(fitDateTime.GetTimeT());
+    return PackPeriod(activityTime.GetYear(), activityTime.GetMonth() + 1,
+                      activityTime.GetDay(), activityTime.GetHour());
+}
+
+bool ActivityDataModel::TimeLess(uint32_t a, uint32_t b) const {
+    uint32_t ta = m_table.GetTimestamp(a), tb = m_table.GetTimestamp(b);
+    return ta != tb ? ta < tb : a < b;
+}
+
+void ActivityDataModel::IndexRows(size_t firstRow) {
+    std::vector<uint32_t> added;
+    added.reserve(m_table.Size() - firstRow);
+
+    for (size_t row = firstRow; row < m_table.Size(); ++row) {
+        m_localHour.push_back(LocalHour(m_table.GetTimestamp(row)));
+        m_rowByPath[m_table.GetFullPath(row)] = static_cast<uint32_t>(row);
+        added.push_back(static_cast<uint32_t>(row));
+    }
+
+    auto byTime = [this](uint32_t a, uint32_t b) { return TimeLess(a, b); };
+    std::sort(added.begin(), added.end(), byTime);
+
+    // Merge the sorted batch in, a linear pass instead of sorting everything again
+    size_t middle = m_timeIndex.size();
+    m_timeIndex.insert(m_timeIndex.end(), added.begin(), added.end());
+    std::inplace_merge(m_timeIndex.begin(), m_timeIndex.begin() + middle, m_timeIndex.end(), byTime);
+
+    for (uint32_t row : added) {
+        uint16_t key = static_cast<uint16_t>(m_table.GetSport(row) << 8 | m_table.GetSubSport(row));
+        auto& index = m_sportIndex[key];
+        // The batch is in time order, so usually it only extends the index
+        if (!index.empty() && byTime(row, index.back())) {
+            index.insert(std::upper_bound(index.begin(), index.end(), row, byTime), row);
+        } else {
+            index.push_back(row);
+        }
+    }
+}
+
+void ActivityDataModel::IndexRow(uint32_t row) {
+    auto byTime = [this](uint32_t a, uint32_t b) { return TimeLess(a, b); };
+
+    m_localHour[row] = LocalHour(m_table.GetTimestamp(row));
+    m_rowByPath[m_table.GetFullPath(row)] = row;
+    m_timeIndex.insert(std::upper_bound(m_timeIndex.begin(), m_timeIndex.end(), row, byTime), row);
+
+    auto& index = m_sportIndex[static_cast<uint16_t>(m_table.GetSport(row) << 8 | m_table.GetSubSport(row))];
+    index.insert(std::upper_bound(index.begin(), index.end(), row, byTime), row);
+}
+
+void ActivityDataModel::UnindexRow(uint32_t row) {
+    // Must run before the row's values change, the indexes are ordered by them
+    auto byTime = [this](uint32_t a, uint32_t b) { return TimeLess(a, b); };
+    auto erase = [&](std::vector<uint32_t>& index) {
+        auto it = std::lower_bound(index.begin(), index.end(), row, byTime);
+        if (it != index.end() && *it == row) {
+            index.erase(it);
+        }
+    };
+
+    erase(m_timeIndex);
+
+    uint16_t key = static_cast<uint16_t>(m_table.GetSport(row) << 8 | m_table.GetSubSport(row));
+    auto sport = m_sportIndex.find(key);
+    if (sport != m_sportIndex.end()) {
+        erase(sport->second);
+        if (sport->second.empty()) {
+            m_sportIndex.erase(sport);
+        }
+    }
+
+    m_rowByPath.erase(m_table.GetFullPath(row));
+}
+
+void ActivityDataModel::StartWatching() {
+    if (m_directory.IsEmpty() || (m_watcher && m_watchedDirectory == m_directory)) {
+        return;
+    }
+
+    m_watcher = std::make_unique<wxFileSystemWatcher>();
+    m_watcher->SetOwner(this);
+    m_watchedDirectory = m_directory;
+
+    // Without a watch (e.g. out of inotify watches) Refresh() falls back to loading everything
+    if (!m_watcher->AddTree(wxFileName::DirName(m_directory), WATCHED_EVENTS)) {
+        wxLogWarning("Changes in %s are not tracked, use Refresh to see them", m_directory);
+        m_watcher.reset();
+        m_watchedDirectory.Clear();
+    }
+}
+
+void ActivityDataModel::OnFileSystemEvent(wxFileSystemWatcherEvent& event) {
+    switch (event.GetChangeType()) {
+        case wxFSW_EVENT_CREATE:
+        case wxFSW_EVENT_DELETE:
+        case wxFSW_EVENT_MODIFY:
+            QueueChange(event.GetPath().GetFullPath());
+            break;
+        case wxFSW_EVENT_RENAME:
+            // A move within the tree is a removal and an addition
+            QueueChange(event.GetPath().GetFullPath());
+            QueueChange(event.GetNewPath().GetFullPath());
+            break;
+        case wxFSW_EVENT_WARNING:
+            if (event.GetWarningType() == wxFSW_WARNING_OVERFLOW) {
+                // The kernel dropped events, only a full load is reliable now
+                m_rescanNeeded = true;
+                m_changeTimer.StartOnce(CHANGE_QUIET_MS);
+            }
+            break;
+        case wxFSW_EVENT_ERROR:
+            wxLogDebug("File system watcher error: %s", event.GetErrorDescription());
+            break;
+        default:
+            break;
+    }
+}
+
+void ActivityDataModel::QueueChange(wxString path) {
+    if (path.length() > 1 && path.EndsWith(wxFileName::GetPathSeparator())) {
+        path.RemoveLast();
+    }
+
+    // Our own cache is written while loading; a previous directory may still report changes
+    if (wxFileName(path).GetFullName() == darauble::ActivityCache::FILE_NAME
+        || !path.StartsWith(m_directory + wxFileName::GetPathSeparator())) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (m_pendingChanges.empty()) {
+        m_firstPendingChange = now;
+    }
+    m_pendingChanges.insert(path);
+
+    // Coalesce bursts by waiting for a quiet moment, but not forever
+    if (now - m_firstPendingChange < CHANGE_MAX_DELAY || !m_changeTimer.IsRunning()) {
+        m_changeTimer.StartOnce(CHANGE_QUIET_MS);
+    }
+}
+
+void ActivityDataModel::OnChangeTimer(wxTimerEvent& WXUNUSED(event)) {
+    ProcessChanges();
+}
+
+void ActivityDataModel::ProcessChanges() {
+    if (m_rescanNeeded) {
+        Load(m_directory);
+        return;
+    }
+
+    // Changes during a load or an update are applied after it
+    if (IsLoading() || m_updater) {
+        if (!m_pendingChanges.empty()) {
+            m_changeTimer.StartOnce(CHANGE_QUIET_MS);
+        }
+        return;
+    }
+
+    std::set<wxString> changes;
+    changes.swap(m_pendingChanges);
+
+    std::vector<ActivityLoader::FileEntry> files;
+    std::vector<wxString> folders;
+
+    for (const auto& path : changes) {
+        if (IsFitFile(path)) {
+            ParsedFileCache::Instance().Invalidate(path.ToStdString());
+        }
+
+        if (wxFileExists(path)) {
+            // Added or modified; other files in the tree don't matter
+            if (IsFitFile(path)) {
+                files.push_back(ActivityLoader::FileEntry{path, GetDisplayPath(path)});
+            }
+        } else if (wxDirExists(path)) {
+            // A directory created or moved in, e.g. by extracting an archive
+            folders.push_back(path);
+            if (m_watcher) {
+                wxLogNull noLog;
+                m_watcher->AddTree(wxFileName::DirName(path), WATCHED_EVENTS);
+            }
+
+            wxArrayString found;
+            wxDir::GetAllFiles(path, &found, "*.fit");
+            for (const auto& file : found) {
+                if (changes.count(file) == 0) {
+                    files.push_back(ActivityLoader::FileEntry{file, GetDisplayPath(file)});
+                }
+            }
+        } else {
+            // Deleted or moved away, a file or a whole directory
+            RemoveRows(path);
+            if (!IsFitFile(path)) {
+                folders.push_back(path);
+            }
+        }
+    }
+
+    for (const auto& folder : folders) {
+        NotifyListeners([&folder](IActivityModelListener* listener) { listener->OnFolderChanged(folder); });
+    }
+
+    if (files.empty()) {
+        return;
+    }
+
+    uint64_t generation = m_generation;
+    m_updater = std::make_unique<ActivityLoader>(std::move(files), m_cache, ActivityLoader::Filter(),
+        [this, generation](std::vector<ActivityDisplayData>&& batch, size_t, size_t, bool finished) {
+            CallAfter([this, generation, batch = std::move(batch), finished]() mutable {
+                OnUpdateBatch(generation, batch, finished);
+            });
+        });
+    m_updater->Start();
+}
+
+void ActivityDataModel::OnUpdateBatch(uint64_t generation, std::vector<ActivityDisplayData>& batch, bool finished) {
+    if (generation != m_generation) {
+        return;
+    }
+
+    ApplyBatch(batch);
+
+    if (finished) {
+        StopLoaders();
+        m_cache->flush();
+
+        // More changes came in while these were loading
+        if (!m_pendingChanges.empty() && !m_changeTimer.IsRunning()) {
+            m_changeTimer.StartOnce(CHANGE_QUIET_MS);
+        }
+    }
+}
+
+void ActivityDataModel::ApplyBatch(const std::vector<ActivityDisplayData>& batch) {
+    size_t firstRow = m_table.Size();
+    for (const auto& data : batch) {
+        auto it = m_rowByPath.find(data.fullPath);
+        if (it == m_rowByPath.end()) {
+            m_table.Append(data);
+            continue;
+        }
+
+        // Modified file: same row, new values
+        uint32_t row = it->second;
+        UnindexRow(row);
+        m_table.Update(row, data);
+        IndexRow(row);
+        NotifyListeners([row](IActivityModelListener* listener) { listener->OnActivityChanged(row); });
+    }
+
+    if (m_table.Size() > firstRow) {
+        IndexRows(firstRow);
+
+        size_t count = m_table.Size() - firstRow;
+        NotifyListeners([firstRow, count](IActivityModelListener* listener) {
+            listener->OnActivitiesAdded(firstRow, count);
+        });
+    }
+}
+
+bool ActivityDataModel::RemoveRows(const wxString& path) {
+    std::vector<uint32_t> rows;
+
+    auto it = m_rowByPath.find(path);
+    if (it != m_rowByPath.end()) {
+        rows.push_back(it->second);
+    } else {
+        // A removed directory takes all activities below it
+        wxString prefix = path + wxFileName::GetPathSeparator();
+        for (const auto& entry : m_rowByPath) {
+            if (entry.first.StartsWith(prefix)) {
+                rows.push_back(entry.second);
+            }
+        }
+    }
+
+    for (uint32_t row : rows) {
+        UnindexRow(row);
+        m_table.Remove(row);
+        NotifyListeners([row](IActivityModelListener* listener) { listener->OnActivityRemoved(row); });
+    }
+
+    return !rows.empty();
+}
+
+wxString ActivityDataModel::GetDisplayPath(const wxString& fullPath) const {
+    wxString prefix = m_directory + wxFileName::GetPathSeparator();
+    return fullPath.StartsWith(prefix) ? fullPath.Mid(prefix.length()) : fullPath;
+}
+
+void ActivityDataModel::SetActivityName(size_t row, const wxString& name) {
+    if (row >= m_table.Size()) {
+        return;
+    }
+
+    m_table.SetName(row, name);
+
+    // Every row was loaded through the cache, so it has an entry to keep the name in
+    const wxString& fullPath = m_table.GetFullPath(row);
+    if (!m_cache || !m_cache->rename(fullPath.ToStdString(), name.ToStdString(wxConvUTF8))) {
+        wxLogWarning("The new name of %s could not be saved, the activity cache is read-only.", fullPath);
+    }
+
+    NotifyListeners([row](IActivityModelListener* listener) { listener->OnActivityChanged(row); });
+}
+
+const std::vector<uint32_t>& ActivityDataModel::GetSportIndex(uint8_t sport, uint8_t subSport) const {
+    static const std::vector<uint32_t> empty;
+    auto it = m_sportIndex.find(static_cast<uint16_t>(sport << 8 | subSport));
+    return it != m_sportIndex.end() ? it->second : empty;
+}
+
+std::vector<std::pair<uint8_t, uint8_t>> ActivityDataModel::GetSports() const {
+    std::vector<std::pair<uint8_t, uint8_t>> sports;
+    sports.reserve(m_sportIndex.size());
+    for (const auto& entry : m_sportIndex) {
+        sports.emplace_back(static_cast<uint8_t>(entry.first >> 8), static_cast<uint8_t>(entry.first & 0xFF));
+    }
+    return sports;
+}
+
+uint32_t ActivityDataModel::PackPeriod(int year, int month, int day, int hour) {
+    return ((static_cast<uint32_t>(year) * 100 + month) * 100 + day) * 100 + hour;
+}
+
+ActivityDataModel::Period ActivityDataModel::GetPeriod(size_t row) const {
+    Period period;
+    uint32_t hour = m_localHour[row];
+    if (hour == 0) {
+        return period;
+    }
+
+    period.year = static_cast<int>(hour / 1000000);
+    period.month = static_cast<int>(hour / 10000 % 100);
+    period.day = static_cast<int>(hour / 100 % 100);
+    period.hour = static_cast<int>(hour % 100);
+    return period;
+}
+
+std::pair<uint32_t, uint32_t> ActivityDataModel::PeriodKeys(const Period& period) {
+    // Unused levels span their whole range: 00..99 covers every month, day and hour
+    uint32_t first = PackPeriod(period.year,
+                                period.month == -1 ? 0 : period.month,
+                                period.day == -1 ? 0 : period.day,
+                                period.hour == -1 ? 0 : period.hour);
+    uint32_t last = PackPeriod(period.year,
+                               period.month == -1 ? 99 : period.month,
+                               period.day == -1 ? 99 : period.day,
+                               period.hour == -1 ? 99 : period.hour);
+    return {first, last};
+}
+
+std::pair<size_t, size_t> ActivityDataModel::FindPeriod(const Period& period) const {
+    if (period.year == -1) {
+        return {0, m_timeIndex.size()};
+    }
+
+    // Local hours never decrease along the time index, even across DST changes,
+    // so the period is a contiguous range of it
+    auto keys = PeriodKeys(period);
+    auto first = std::partition_point(m_timeIndex.begin(), m_timeIndex.end(),
+                                      [&](uint32_t row) { return m_localHour[row] < keys.first; });
+    auto last = std::partition_point(first, m_timeIndex.end(),
+                                     [&](uint32_t row) { return m_localHour[row] <= keys.second; });
+    return {static_cast<size_t>(first - m_timeIndex.begin()), static_cast<size_t>(last - m_timeIndex.begin())};
+}
+
+bool ActivityDataModel::IsInPeriod(size_t row, const Period& period) const {
+    if (period.year == -1) {
+        return true;
+    }
+    auto keys = PeriodKeys(period);
+    return m_localHour[row] >= keys.first && m_localHour[row] <= keys.second;
+}
+
+std::vector<ActivityDataModel::PeriodCount> ActivityDataModel::GetChildPeriods(const Period& parent) const {
+    // Level of the children and the divisor dropping the levels below it from a packed hour
+    static const uint32_t divisors[] = {1000000, 10000, 100, 1};
+    int level = parent.year == -1 ? 0 : parent.month == -1 ? 1 : parent.day == -1 ? 2 : 3;
+    uint32_t divisor = divisors[level];
+
+    std::vector<PeriodCount> children;
+    if (parent.hour != -1) {
+        return children;
+    }
+
+    auto range = FindPeriod(parent);
+    auto it = m_timeIndex.begin() + range.first;
+    auto end = m_timeIndex.begin() + range.second;
+
+    // Activities without a timestamp sort first and belong to no period
+    it = std::partition_point(it, end, [&](uint32_t row) { return m_localHour[row] == 0; });
+
+    while (it != end) {
+        uint32_t hour = m_localHour[*it];
+        uint32_t key = hour / divisor;
+        auto next = std::partition_point(it, end, [&](uint32_t row) { return m_localHour[row] / divisor <= key; });
+
+        PeriodCount child;
+        child.period = parent;
+        switch (level) {
+            case 0: child.period.year = static_cast<int>(hour / 1000000); break;
+            case 1: child.period.month = static_cast<int>(hour / 10000 % 100); break;
+            case 2: child.period.day = static_cast<int>(hour / 100 % 100); break;
+            default: child.period.hour = static_cast<int>(hour % 100); break;
+        }
+        child.count = static_cast<size_t>(next - it);
+        children.push_back(child);
+
+        it = next;
+    }
+    return children;
+}
+
+size_t ActivityDataModel::GetUndatedCount() const {
+    auto it = std::partition_point(m_timeIndex.begin(), m_timeIndex.end(),
+                                   [&](uint32_t row) { return m_localHour[row] == 0; });
+    return static_cast<size_t>(it - m_timeIndex.begin());
+}
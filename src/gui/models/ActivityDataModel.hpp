@@ -1,12 +1,226 @@
 #pragma once
 
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+#include <wx/fswatcher.h>
+#include <wx/hashmap.h>
+#include <wx/timer.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
 #include <vector>
-#include <string>
+#include "ActivityData.hpp"
+#include "ActivityTable.hpp"
+#include "../utils/JobScheduler.hpp"
 
-class ActivityDataModel {
+class ActivityLoader;
+class IActivityModelListener;
+
+namespace darauble {
+class ActivityCache;
+}
+
+/**
+ * The in-memory catalog of all activities in the opened directory.
+ *
+ * Loads the directory once in the background (ActivityLoader) and keeps the
+ * rows in an ActivityTable, together with a time-sorted index, per-sport
+ * indexes and the local calendar hour of every activity. The activity list,
+ * the file tree and the main frame all read from this catalog, so selecting a
+ * folder or a time period never parses a FIT file again. Parsed summaries and
+ * edited names persist in the activity cache of the archive (darauble::ActivityCache).
+ *
+ * At start-up the catalog of the last session is restored from a snapshot (the
+ * paths of its activities, summaries taken from the activity cache without
+ * touching the files) and validated by a regular load in the background, which
+ * only reports the activities that changed.
+ *
+ * Once loaded, the directory tree is watched (inotify on Linux). Changes are
+ * queued and applied in coalesced bursts: only the added, modified, moved or
+ * deleted files are loaded again, and listeners get per-row notifications.
+ *
+ * Must only be used from the UI thread; listeners are notified there as well.
+ */
+class ActivityDataModel : public wxEvtHandler {
 public:
-    ActivityDataModel() = default;
-    virtual ~ActivityDataModel() = default;
-    
-    // TODO: Implement data model for activities
-};
\ No newline at end of file
+    /**
+     * A calendar period in local time, month is 1-based, -1 marks unused levels.
+     */
+    struct Period {
+        int year = -1;
+        int month = -1;
+        int day = -1;
+        int hour = -1;
+    };
+
+    ActivityDataModel();
+    ~ActivityDataModel() override;
+
+    ActivityDataModel(const ActivityDataModel&) = delete;
+    ActivityDataModel& operator=(const ActivityDataModel&) = delete;
+
+    /**
+     * Empty the catalog and load the activities of a directory tree in the background.
+     */
+    void Load(const wxString& directory);
+
+    /**
+     * Like Load(), but show the activities of the last session's snapshot first if
+     * it was taken of the same directory. The snapshot is validated in the background:
+     * changed files are updated, new ones added and missing ones removed.
+     */
+    void Restore(const wxString& directory);
+
+    /**
+     * Stop loading, the activities loaded so far stay in the catalog.
+     */
+    void CancelLoad();
+
+    /**
+     * Apply the queued file changes now. Loads the whole directory again only when
+     * it isn't watched or the watcher lost events.
+     */
+    void Refresh();
+
+    bool IsLoading() const { return m_loader != nullptr || m_restoring; }
+    const wxString& GetDirectory() const { return m_directory; }
+
+    void AddListener(IActivityModelListener* listener);
+    void RemoveListener(IActivityModelListener* listener);
+
+    size_t Size() const { return m_table.Size(); }
+    const ActivityTable& GetTable() const { return m_table; }
+    ActivityDisplayData GetActivity(size_t row) const { return m_table.GetRow(row); }
+
+    /**
+     * Rename an activity; the name is kept in the activity cache.
+     */
+    void SetActivityName(size_t row, const wxString& name);
+
+    /**
+     * All rows, oldest first. Files without a timestamp come first.
+     */
+    const std::vector<uint32_t>& GetTimeIndex() const { return m_timeIndex; }
+
+    /**
+     * Rows of one sport (sport and sub sport), oldest first.
+     */
+    const std::vector<uint32_t>& GetSportIndex(uint8_t sport, uint8_t subSport) const;
+
+    /**
+     * Sport and sub sport pairs present in the catalog.
+     */
+    std::vector<std::pair<uint8_t, uint8_t>> GetSports() const;
+
+    /**
+     * Positions [first, last) in GetTimeIndex() of the activities within a period.
+     */
+    std::pair<size_t, size_t> FindPeriod(const Period& period) const;
+
+    /**
+     * Check whether an activity falls within a period, without converting any time.
+     */
+    bool IsInPeriod(size_t row, const Period& period) const;
+
+    /**
+     * Local calendar period of an activity down to the hour, year is -1 without a timestamp.
+     */
+    Period GetPeriod(size_t row) const;
+
+    struct PeriodCount {
+        Period period;
+        size_t count; // Activities within the period
+    };
+
+    /**
+     * Periods one level below the given one that contain activities, oldest first:
+     * years for an empty period, months of a year and so on. Found by binary search
+     * over the time index, so the cost depends on the number of periods returned,
+     * not on the number of activities.
+     */
+    std::vector<PeriodCount> GetChildPeriods(const Period& parent) const;
+
+    /**
+     * Number of activities without a timestamp.
+     */
+    size_t GetUndatedCount() const;
+
+private:
+    // Local time packed as YYYYMMDDHH, ordered like the time itself; 0 if unknown
+    static uint32_t PackPeriod(int year, int month, int day, int hour);
+    static std::pair<uint32_t, uint32_t> PeriodKeys(const Period& period);
+
+    static uint32_t LocalHour(uint32_t timestamp);
+
+    // Activities restored from the snapshot, by full path, until the load validated them
+    struct SnapshotEntry {
+        uint64_t fingerprint = 0;
+        std::atomic<bool> seen{false};
+    };
+    using Snapshot = std::unordered_map<wxString, SnapshotEntry, wxStringHash, wxStringEqual>;
+
+    static std::filesystem::path SnapshotPath();
+
+    bool Reset(const wxString& directory);
+    void StartLoader();
+    void OnSnapshotRestored(uint64_t generation, std::vector<ActivityDisplayData>& rows,
+                            std::shared_ptr<Snapshot> snapshot);
+    void RemoveUnseen();
+    void SaveSnapshot();
+
+    void StopLoaders();
+    void OnLoaderBatch(uint64_t generation, std::vector<ActivityDisplayData>& batch,
+                       size_t done, size_t total, bool finished);
+    void IndexRows(size_t firstRow);
+    bool TimeLess(uint32_t a, uint32_t b) const;
+    void IndexRow(uint32_t row);
+    void UnindexRow(uint32_t row);
+
+    void StartWatching();
+    void OnFileSystemEvent(wxFileSystemWatcherEvent& event);
+    void QueueChange(wxString path);
+    void OnChangeTimer(wxTimerEvent& event);
+    void ProcessChanges();
+    void OnUpdateBatch(uint64_t generation, std::vector<ActivityDisplayData>& batch, bool finished);
+    void ApplyBatch(const std::vector<ActivityDisplayData>& batch);
+    bool RemoveRows(const wxString& path);
+    wxString GetDisplayPath(const wxString& fullPath) const;
+
+    template <typename Notify>
+    void NotifyListeners(Notify notify);
+
+    wxString m_directory;
+    std::shared_ptr<darauble::ActivityCache> m_cache; // Shared with the loaders
+    ActivityTable m_table;
+    std::vector<uint32_t> m_localHour; // PackPeriod() of every row
+
+    std::vector<uint32_t> m_timeIndex;
+    std::map<uint16_t, std::vector<uint32_t>> m_sportIndex; // sport << 8 | sub sport
+    std::unordered_map<wxString, uint32_t, wxStringHash, wxStringEqual> m_rowByPath; // Rows not removed
+
+    std::unique_ptr<wxFileSystemWatcher> m_watcher;
+    wxString m_watchedDirectory;
+    wxTimer m_changeTimer;
+    std::set<wxString> m_pendingChanges; // Full paths of changed files and directories
+    std::chrono::steady_clock::time_point m_firstPendingChange;
+    bool m_rescanNeeded; // The watcher overflowed, some changes are unknown
+
+    JobHandle m_restoreJob;
+    bool m_restoring; // Reading the snapshot, the loader starts afterwards
+    std::shared_ptr<Snapshot> m_snapshot; // Shared with the validating loader
+
+    std::unique_ptr<ActivityLoader> m_loader;
+    std::unique_ptr<ActivityLoader> m_updater; // Loads the changed files
+    std::vector<std::unique_ptr<ActivityLoader>> m_retiredLoaders; // Cancelled, threads still winding down
+    uint64_t m_generation; // Batches from older loads are dropped
+
+    std::vector<IActivityModelListener*> m_listeners;
+};
@@ -0,0 +1,241 @@
+#include "ActivityTable.hpp"
+#include <wx/datetime.h>
+#include "parsers/session-scanner.hpp"
+#include <fit_date_time.hpp>
+
+namespace {
+
+// Same three-way order for every column, ties fall back to the row number
+template <typename T>
+int Compare(const T& a, const T& b) {
+    return (a < b) ? -1 : (b < a) ? 1 : 0;
+}
+
+} // namespace
+
+void ActivityTable::Clear() {
+    m_timestamp.clear();
+    m_status.clear();
+    m_sport.clear();
+    m_subSport.clear();
+    m_sessionCount.clear();
+    m_elapsedTime.clear();
+    m_totalDistance.clear();
+    m_avgSpeed.clear();
+    m_avgHeartRate.clear();
+    m_totalSets.clear();
+    m_name.clear();
+    m_filePath.clear();
+    m_fullPath.clear();
+    m_hasBounds.clear();
+    m_bounds.clear();
+    m_removed.clear();
+}
+
+void ActivityTable::Reserve(size_t rows) {
+    m_timestamp.reserve(rows);
+    m_status.reserve(rows);
+    m_sport.reserve(rows);
+    m_subSport.reserve(rows);
+    m_sessionCount.reserve(rows);
+    m_elapsedTime.reserve(rows);
+    m_totalDistance.reserve(rows);
+    m_avgSpeed.reserve(rows);
+    m_avgHeartRate.reserve(rows);
+    m_totalSets.reserve(rows);
+    m_name.reserve(rows);
+    m_filePath.reserve(rows);
+    m_fullPath.reserve(rows);
+    m_hasBounds.reserve(rows);
+    m_bounds.reserve(rows);
+    m_removed.reserve(rows);
+}
+
+size_t ActivityTable::Append(const ActivityDisplayData& data) {
+    m_timestamp.push_back(data.timestamp);
+    m_status.push_back(data.status);
+    m_sport.push_back(data.sportId);
+    m_subSport.push_back(data.subSportId);
+    m_sessionCount.push_back(data.sessionCount);
+    m_elapsedTime.push_back(static_cast<float>(data.elapsedTime));
+    m_totalDistance.push_back(static_cast<float>(data.totalDistance));
+    m_avgSpeed.push_back(data.avgSpeed);
+    m_avgHeartRate.push_back(data.avgHeartRate);
+    m_totalSets.push_back(data.totalSets);
+    m_name.push_back(data.name);
+    m_filePath.push_back(data.filePath);
+    m_fullPath.push_back(data.fullPath);
+    m_hasBounds.push_back(data.hasBounds);
+    m_bounds.push_back(Bounds{data.minLat, data.minLon, data.maxLat, data.maxLon});
+    m_removed.push_back(false);
+    return m_timestamp.size() - 1;
+}
+
+void ActivityTable::Update(size_t row, const ActivityDisplayData& data) {
+    m_timestamp[row] = data.timestamp;
+    m_status[row] = data.status;
+    m_sport[row] = data.sportId;
+    m_subSport[row] = data.subSportId;
+    m_sessionCount[row] = data.sessionCount;
+    m_elapsedTime[row] = static_cast<float>(data.elapsedTime);
+    m_totalDistance[row] = static_cast<float>(data.totalDistance);
+    m_avgSpeed[row] = data.avgSpeed;
+    m_avgHeartRate[row] = data.avgHeartRate;
+    m_totalSets[row] = data.totalSets;
+    m_name[row] = data.name;
+    m_filePath[row] = data.filePath;
+    m_fullPath[row] = data.fullPath;
+    m_hasBounds[row] = data.hasBounds;
+    m_bounds[row] = Bounds{data.minLat, data.minLon, data.maxLat, data.maxLon};
+    m_removed[row] = false;
+}
+
+wxString ActivityTable::FormatCell(size_t row, int column) const {
+    if (row >= Size()) {
+        return wxEmptyString;
+    }
+
+    if (column == COL_DATE) {
+        return FormatDate(row);
+    } else if (column == COL_NAME) {
+        return m_name[row];
+    } else if (column == COL_SPORT) {
+        return FormatSport(row);
+    } else if (column == COL_FILE) {
+        return m_filePath[row];
+    }
+
+    // Files that couldn't be parsed have no values to show
+    if (m_status[row] != ActivityDisplayData::Status::Parsed) {
+        switch (column) {
+            case COL_DURATION: return "--:--";
+            case COL_WORK: return "-- km";
+            default: return "--";
+        }
+    }
+
+    darauble::SessionData session;
+    session.totalElapsedTime = m_elapsedTime[row];
+    session.totalDistance = m_totalDistance[row];
+    session.avgSpeed = m_avgSpeed[row];
+    session.avgHeartRate = m_avgHeartRate[row];
+    session.totalSets = m_totalSets[row];
+
+    switch (column) {
+        case COL_DURATION:
+            return wxString::FromUTF8(session.getFormattedDuration());
+        case COL_WORK:
+            return wxString::FromUTF8(session.getFormattedDistance(m_sport[row], m_subSport[row]));
+        case COL_RESULT:
+            return wxString::FromUTF8(session.getFormattedSpeed(m_sport[row], m_subSport[row]));
+        case COL_HEART_RATE:
+            return wxString::FromUTF8(session.getFormattedHeartRate());
+        default:
+            return wxEmptyString;
+    }
+}
+
+wxString ActivityTable::FormatDate(size_t row) const {
+    if (m_status[row] != ActivityDisplayData::Status::Parsed) {
+        return "Parse Error";
+    }
+    if (m_timestamp[row] == 0) {
+        return "Unknown Date";
+    }
+
+    // Convert FIT timestamp to UNIX timestamp using FIT SDK
+    fit::DateTime fitDateTime(m_timestamp[row]);
+    wxDateTime activityTime(fitDateTime.GetTimeT());
+    return activityTime.Format("%Y-%m-%d %H:%M");
+}
+
+wxString ActivityTable::FormatSport(size_t row) const {
+    switch (m_status[row]) {
+        case ActivityDisplayData::Status::NoData: return "Unknown";
+        case ActivityDisplayData::Status::ParseError: return "Error";
+        default: break;
+    }
+
+    darauble::ActivityData activity;
+    activity.primarySport = m_sport[row];
+    activity.primarySubSport = m_subSport[row];
+
+    wxString sport = wxString::FromUTF8(activity.getPrimarySportName());
+    if (activity.isMultisport()) {
+        sport += wxString::Format(" (%u sessions)", static_cast<unsigned>(m_sessionCount[row]));
+    }
+    return sport;
+}
+
+ActivityDisplayData ActivityTable::GetRow(size_t row) const {
+    ActivityDisplayData data;
+    if (row >= Size()) {
+        return data;
+    }
+
+    data.date = FormatDate(row);
+    data.name = m_name[row];
+    data.sport = FormatSport(row);
+    data.duration = FormatCell(row, COL_DURATION);
+    data.distance = FormatCell(row, COL_WORK);
+    data.speedPace = FormatCell(row, COL_RESULT);
+    data.heartRate = FormatCell(row, COL_HEART_RATE);
+    data.filePath = m_filePath[row];
+    data.fullPath = m_fullPath[row];
+    data.timestamp = m_timestamp[row];
+
+    data.status = m_status[row];
+    data.sportId = m_sport[row];
+    data.subSportId = m_subSport[row];
+    data.sessionCount = m_sessionCount[row];
+    data.elapsedTime = m_elapsedTime[row];
+    data.totalDistance = m_totalDistance[row];
+    data.avgSpeed = m_avgSpeed[row];
+    data.avgHeartRate = m_avgHeartRate[row];
+    data.totalSets = m_totalSets[row];
+
+    data.hasBounds = m_hasBounds[row];
+    data.minLat = m_bounds[row].minLat;
+    data.minLon = m_bounds[row].minLon;
+    data.maxLat = m_bounds[row].maxLat;
+    data.maxLon = m_bounds[row].maxLon;
+    return data;
+}
+
+bool ActivityTable::Less(int column, size_t a, size_t b) const {
+    int result = 0;
+
+    switch (column) {
+        case COL_DATE:
+            result = Compare(m_timestamp[a], m_timestamp[b]);
+            break;
+        case COL_NAME:
+            result = m_name[a].CmpNoCase(m_name[b]);
+            break;
+        case COL_SPORT:
+            result = Compare(m_sport[a], m_sport[b]);
+            if (result == 0) result = Compare(m_subSport[a], m_subSport[b]);
+            break;
+        case COL_DURATION:
+            result = Compare(m_elapsedTime[a], m_elapsedTime[b]);
+            break;
+        case COL_WORK:
+            // Strength sessions count sets in this column, they sort apart from distances
+            result = Compare(m_totalSets[a], m_totalSets[b]);
+            if (result == 0) result = Compare(m_totalDistance[a], m_totalDistance[b]);
+            break;
+        case COL_RESULT:
+            result = Compare(m_avgSpeed[a], m_avgSpeed[b]);
+            break;
+        case COL_HEART_RATE:
+            result = Compare(m_avgHeartRate[a], m_avgHeartRate[b]);
+            break;
+        case COL_FILE:
+            result = m_filePath[a].Cmp(m_filePath[b]);
+            break;
+        default:
+            break;
+    }
+
+    return result != 0 ? result < 0 : a < b;
+}
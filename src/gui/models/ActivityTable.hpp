@@ -0,0 +1,102 @@
+#pragma once
+
+#include <wx/string.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ActivityData.hpp"
+
+/**
+ * Column-oriented store of the activities shown in the activities list.
+ *
+ * Every field lives in its own typed vector, so sorting and filtering only touch
+ * the values they compare, and a 100k activity archive takes a few megabytes.
+ * Display text is not stored: it is formatted for a single cell when the list
+ * asks for a visible row.
+ *
+ * Rows are appended, updated in place or marked as removed, but never moved,
+ * so a row number stays valid until Clear().
+ */
+class ActivityTable {
+public:
+    enum Column {
+        COL_DATE = 0,
+        COL_NAME,
+        COL_SPORT,
+        COL_DURATION,
+        COL_WORK,
+        COL_RESULT,
+        COL_HEART_RATE,
+        COL_FILE,
+        COLUMN_COUNT
+    };
+
+    size_t Size() const { return m_timestamp.size(); }
+    void Clear();
+    void Reserve(size_t rows);
+
+    /**
+     * Append an activity, the formatted strings of the data are not kept.
+     * @return Row number of the new activity
+     */
+    size_t Append(const ActivityDisplayData& data);
+
+    /**
+     * Replace the values of a row, e.g. after its file was modified.
+     */
+    void Update(size_t row, const ActivityDisplayData& data);
+
+    /**
+     * Mark a row as removed, its slot is reused only after Clear().
+     */
+    void Remove(size_t row) { m_removed[row] = true; }
+    bool IsRemoved(size_t row) const { return m_removed[row]; }
+
+    /**
+     * Format one cell the way the list shows it.
+     */
+    wxString FormatCell(size_t row, int column) const;
+
+    /**
+     * Rebuild the full display record of a row, including all formatted strings.
+     */
+    ActivityDisplayData GetRow(size_t row) const;
+
+    /**
+     * Strict weak ordering of two rows by a column, ascending.
+     * Equal values are ordered by row number, so sorting is deterministic.
+     */
+    bool Less(int column, size_t a, size_t b) const;
+
+    uint32_t GetTimestamp(size_t row) const { return m_timestamp[row]; }
+    uint8_t GetSport(size_t row) const { return m_sport[row]; }
+    uint8_t GetSubSport(size_t row) const { return m_subSport[row]; }
+    const wxString& GetFilePath(size_t row) const { return m_filePath[row]; }
+    const wxString& GetFullPath(size_t row) const { return m_fullPath[row]; }
+    void SetName(size_t row, const wxString& name) { m_name[row] = name; }
+
+private:
+    struct Bounds {
+        double minLat, minLon, maxLat, maxLon;
+    };
+
+    wxString FormatDate(size_t row) const;
+    wxString FormatSport(size_t row) const;
+
+    std::vector<uint32_t> m_timestamp;
+    std::vector<ActivityDisplayData::Status> m_status;
+    std::vector<uint8_t> m_sport;
+    std::vector<uint8_t> m_subSport;
+    std::vector<uint16_t> m_sessionCount;
+    std::vector<float> m_elapsedTime;   // seconds
+    std::vector<float> m_totalDistance; // meters
+    std::vector<uint16_t> m_avgSpeed;   // m/s * 1000
+    std::vector<uint16_t> m_avgHeartRate;
+    std::vector<uint16_t> m_totalSets;
+    std::vector<wxString> m_name;
+    std::vector<wxString> m_filePath;
+    std::vector<wxString> m_fullPath;
+    std::vector<bool> m_hasBounds;
+    std::vector<Bounds> m_bounds;
+    std::vector<bool> m_removed;
+};
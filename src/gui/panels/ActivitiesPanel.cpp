@@ -1,14 +1,11 @@
 #include "ActivitiesPanel.hpp"
-#include <wx/dir.h>
 #include <wx/filename.h>
 #include <wx/datetime.h>
 #include <wx/textdlg.h>
-#include "parsers/session-scanner.hpp"
-#include "parsers/binary-mapper.hpp"
-#include "utils/MetadataCache.hpp"
-#include <fit_date_time.hpp>
-#include <filesystem>
+#include "models/ActivityDataModel.hpp"
 #include <algorithm>
+#include <iterator>
+#include <numeric>
 
 // Event table for DragDropListCtrl
 wxBEGIN_EVENT_TABLE(DragDropListCtrl, wxListCtrl)
@@ -24,15 +21,21 @@ wxBEGIN_EVENT_TABLE(ActivitiesPanel, wxPanel)
     EVT_BUTTON(wxID_ANY, ActivitiesPanel::OnRefreshClicked)
     EVT_MENU(ID_CONTEXT_OPEN_CONTAINING_FOLDER, ActivitiesPanel::OnContextOpenContainingFolder)
     EVT_LIST_END_LABEL_EDIT(wxID_ANY, ActivitiesPanel::OnEndLabelEdit)
+    EVT_LIST_COL_CLICK(wxID_ANY, ActivitiesPanel::OnColumnClicked)
 wxEND_EVENT_TABLE()
 
 // DragDropListCtrl implementation
 DragDropListCtrl::DragDropListCtrl(ActivitiesPanel* parent, wxWindowID id)
-    : wxListCtrl(parent, id, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_SINGLE_SEL | wxLC_EDIT_LABELS),
+    : wxListCtrl(parent, id, wxDefaultPosition, wxDefaultSize,
+                 wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL | wxLC_EDIT_LABELS),
       m_activitiesPanel(parent) {
     // wxLC_EDIT_LABELS enables in-place editing
 }
 
+wxString DragDropListCtrl::OnGetItemText(long item, long column) const {
+    return m_activitiesPanel ? m_activitiesPanel->GetListItemText(item, column) : wxString();
+}
+
 void DragDropListCtrl::OnBeginDrag(wxListEvent& event) {
     long itemIndex = event.GetIndex();
     bool shiftPressed = wxGetKeyState(WXK_SHIFT);
@@ -92,18 +95,27 @@ void DragDropListCtrl::StartEditing(long item, int column) {
     }
 }
 
-ActivitiesPanel::ActivitiesPanel(wxWindow* parent)
+ActivitiesPanel::ActivitiesPanel(wxWindow* parent, ActivityDataModel* model)
     : wxPanel(parent, wxID_ANY),
+      m_model(model),
       m_listCtrl(nullptr),
       m_refreshButton(nullptr),
       m_detailsButton(nullptr),
-      m_useTimeFilter(false),
-      m_filterYear(-1),
-      m_filterMonth(-1),
-      m_filterDay(-1),
-      m_filterHour(-1) {
+      m_scanGauge(nullptr),
+      m_scanStatus(nullptr),
+      m_cancelScanButton(nullptr),
+      m_sortColumn(ActivityTable::COL_DATE),
+      m_sortAscending(false),
+      m_showPlaceholder(false),
+      m_restoringSelection(false),
+      m_useTimeFilter(false) {
     
     CreateLayout();
+    m_model->AddListener(this);
+}
+
+ActivitiesPanel::~ActivitiesPanel() {
+    m_model->RemoveListener(this);
 }
 
 void ActivitiesPanel::CreateLayout() {
@@ -118,6 +130,16 @@ void ActivitiesPanel::CreateLayout() {
     buttonSizer->Add(m_refreshButton, 0, wxRIGHT, 5);
     buttonSizer->Add(m_detailsButton, 0, wxLEFT, 5);
     buttonSizer->AddStretchSpacer();
+
+    m_scanStatus = new wxStaticText(this, wxID_ANY, "");
+    m_scanGauge = new wxGauge(this, wxID_ANY, 100, wxDefaultPosition, wxSize(150, -1));
+    m_cancelScanButton = new wxButton(this, wxID_ANY, "Cancel");
+    // Bound on the button itself: the panel's EVT_BUTTON handler refreshes on any button
+    m_cancelScanButton->Bind(wxEVT_BUTTON, &ActivitiesPanel::OnCancelScanClicked, this);
+
+    buttonSizer->Add(m_scanStatus, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    buttonSizer->Add(m_scanGauge, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    buttonSizer->Add(m_cancelScanButton, 0);
     
     // Activity list with drag & drop support
     m_listCtrl = new DragDropListCtrl(this, wxID_ANY);
@@ -132,25 +154,21 @@ void ActivitiesPanel::CreateLayout() {
     m_listCtrl->AppendColumn("Avg HR", wxLIST_FORMAT_LEFT, 60);
     m_listCtrl->AppendColumn("File", wxLIST_FORMAT_LEFT, 200);
     
-    // Add sample data for demonstration
-    long index = m_listCtrl->InsertItem(0, "2025-01-15");
-    m_listCtrl->SetItem(index, 1, "Morning Run");
-    m_listCtrl->SetItem(index, 2, "Running");
-    m_listCtrl->SetItem(index, 3, "45:32");
-    m_listCtrl->SetItem(index, 4, "8.5 km");
-    m_listCtrl->SetItem(index, 5, "5:21 /km");
-    m_listCtrl->SetItem(index, 6, "145");
-    m_listCtrl->SetItem(index, 7, "sample-activity.fit");
-    
     // Layout
     mainSizer->Add(buttonSizer, 0, wxEXPAND | wxALL, 5);
     mainSizer->Add(m_listCtrl, 1, wxEXPAND | wxALL, 5);
     
     SetSizer(mainSizer);
+    ShowScanProgress(false);
 }
 
 void ActivitiesPanel::OnItemSelected(wxListEvent& event) {
     m_detailsButton->Enable(true);
+
+    // Same activity, only its row moved
+    if (m_restoringSelection) {
+        return;
+    }
     
     // Notify parent about selection change
     long selectedIndex = event.GetIndex();
@@ -179,230 +197,266 @@ void ActivitiesPanel::OnItemDoubleClicked(wxListEvent& event) {
 void ActivitiesPanel::SetDirectory(const wxString& path) {
     m_currentDirectory = path;
     m_filterPath.Clear(); // Clear any existing filter when setting new directory
-    LoadActivitiesFromDirectory();
+    RebuildView();
 }
 
-void ActivitiesPanel::LoadActivitiesFromDirectory() {
-    if (m_currentDirectory.IsEmpty()) return;
-    
-    // Clear existing data
-    m_listCtrl->DeleteAllItems();
-    m_activityData.clear();
-    
-    // Determine which directory to scan
-    wxString scanPath = m_currentDirectory;
-    if (!m_filterPath.IsEmpty()) {
-        scanPath = m_filterPath;
+void ActivitiesPanel::OnCatalogCleared() {
+    m_order.clear();
+    m_view.clear();
+    m_showPlaceholder = false;
+    m_listCtrl->SetItemCount(0);
+    m_listCtrl->Refresh();
+    m_detailsButton->Enable(false);
+
+    m_scanGauge->SetValue(0);
+    m_scanStatus->SetLabel("Scanning...");
+    ShowScanProgress(true);
+}
+
+void ActivitiesPanel::OnActivitiesAdded(size_t firstRow, size_t count) {
+    long selectedRow = GetSelectedRow();
+
+    std::vector<uint32_t> added(count);
+    std::iota(added.begin(), added.end(), static_cast<uint32_t>(firstRow));
+    auto less = [this](uint32_t a, uint32_t b) { return RowLess(a, b); };
+    std::sort(added.begin(), added.end(), less);
+
+    // Merge the sorted rows in, a linear pass instead of sorting everything again
+    size_t middle = m_order.size();
+    m_order.insert(m_order.end(), added.begin(), added.end());
+    std::inplace_merge(m_order.begin(), m_order.begin() + middle, m_order.end(), less);
+
+    middle = m_view.size();
+    std::copy_if(added.begin(), added.end(), std::back_inserter(m_view),
+                 [this](uint32_t row) { return PassesFilter(row); });
+    std::inplace_merge(m_view.begin(), m_view.begin() + middle, m_view.end(), less);
+
+    // Files can arrive after loading, into an empty list
+    if (!m_view.empty()) {
+        m_showPlaceholder = false;
     }
-    
-    // Start recursive scan to collect data
-    ScanDirectoryRecursive(scanPath);
-    
-    // Sort and populate the list
-    PopulateListFromData();
+    UpdateListView(selectedRow);
 }
 
-void ActivitiesPanel::ScanDirectoryRecursive(const wxString& path, const wxString& relativePath) {
-    wxDir dir(path);
-    if (!dir.IsOpened()) return;
-    
-    wxString filename;
-    
-    // First, scan for FIT files in current directory
-    bool cont = dir.GetFirst(&filename, "*.fit", wxDIR_FILES);
-    while (cont) {
-        wxString fullPath = path + wxFileName::GetPathSeparator() + filename;
-        wxString displayPath = relativePath.IsEmpty() ? filename : 
-                              relativePath + wxFileName::GetPathSeparator() + filename;
-        
-        // Try to load from cache first
-        ActivityDisplayData displayData;
-        displayData.filePath = displayPath;
-        displayData.fullPath = fullPath;
-
-        bool loadedFromCache = false;
-        if (MetadataCache::IsCacheValid(fullPath)) {
-            if (MetadataCache::LoadFromCache(fullPath, displayData)) {
-                loadedFromCache = true;
-            }
-        }
+void ActivitiesPanel::OnCatalogProgress(size_t done, size_t total) {
+    m_scanGauge->SetRange(static_cast<int>(std::max<size_t>(total, 1)));
+    m_scanGauge->SetValue(static_cast<int>(done));
+    m_scanStatus->SetLabel(wxString::Format("Loading %zu of %zu", done, total));
+    Layout();
+}
 
-        // Parse FIT file if not loaded from cache
-        if (!loadedFromCache) {
-            try {
-                std::filesystem::path fitPath(fullPath.ToStdString());
-                darauble::BinaryMapper mapper(fitPath);
-                darauble::SessionScanner scanner(filename.ToStdString(), mapper);
-
-                scanner.scan();
-            
-            if (scanner.hasData()) {
-                const auto& activityData = scanner.getData();
-                auto aggregated = activityData.getAggregatedData();
-                
-                // Store timestamp for sorting
-                displayData.timestamp = aggregated.timestamp;
-                
-                // Format timestamp as date
-                if (aggregated.timestamp > 0) {
-                    // Convert FIT timestamp to UNIX timestamp using FIT SDK
-                    fit::DateTime fitDateTime(aggregated.timestamp);
-                    wxDateTime activityTime(fitDateTime.GetTimeT());
-                    displayData.date = activityTime.Format("%Y-%m-%d %H:%M");
-                } else {
-                    displayData.date = "Unknown Date";
-                }
-                
-                displayData.name = wxString::FromUTF8(activityData.activityName);
-                displayData.sport = wxString::FromUTF8(activityData.getPrimarySportName());
-                if (activityData.isMultisport()) {
-                    displayData.sport += wxString::Format(" (%zu sessions)", activityData.sessions.size());
-                }
-
-                displayData.duration = wxString::FromUTF8(aggregated.getFormattedDuration());
-                displayData.distance = wxString::FromUTF8(aggregated.getFormattedDistance(activityData.primarySport, activityData.primarySubSport));
-                displayData.speedPace = wxString::FromUTF8(aggregated.getFormattedSpeed(activityData.primarySport, activityData.primarySubSport));
-                displayData.heartRate = wxString::FromUTF8(aggregated.getFormattedHeartRate());
-
-                // Save to cache (preserveName=true if cache already existed, to not overwrite user edits)
-                MetadataCache::SaveToCache(fullPath, displayData, wxFileExists(MetadataCache::GetMetaFilePath(fullPath)));
-                } else {
-                    // Fallback for files that couldn't be parsed
-                    displayData.timestamp = 0;
-                    displayData.date = "Parse Error";
-                    displayData.name = "";
-                    displayData.sport = "Unknown";
-                    displayData.duration = "--:--";
-                    displayData.distance = "-- km";
-                    displayData.speedPace = "--";
-                    displayData.heartRate = "--";
-                }
-
-            } catch (const std::exception& e) {
-                // Handle parsing errors gracefully
-                displayData.timestamp = 0;
-                displayData.date = "Parse Error";
-                displayData.name = "";
-                displayData.sport = "Error";
-                displayData.duration = "--:--";
-                displayData.distance = "-- km";
-                displayData.speedPace = "--";
-                displayData.heartRate = "--";
-            }
-        }
+void ActivitiesPanel::OnCatalogLoaded() {
+    ShowScanProgress(false);
+    FinishList();
+}
 
-        // Apply time filtering (for both cached and freshly parsed data)
-        if (m_useTimeFilter && displayData.timestamp > 0) {
-            fit::DateTime fitDateTime(displayData.timestamp);
-            wxDateTime activityTime(fitDateTime.GetTimeT());
-
-            bool passesFilter = true;
-
-            // Year filter (required)
-            if (m_filterYear != -1 && activityTime.GetYear() != m_filterYear) {
-                passesFilter = false;
-            }
-
-            // Month filter (1-based, optional)
-            if (passesFilter && m_filterMonth != -1 && (activityTime.GetMonth() + 1) != m_filterMonth) {
-                passesFilter = false;
-            }
-
-            // Day filter (optional)
-            if (passesFilter && m_filterDay != -1 && activityTime.GetDay() != m_filterDay) {
-                passesFilter = false;
-            }
-
-            // Hour filter (optional)
-            if (passesFilter && m_filterHour != -1 && activityTime.GetHour() != m_filterHour) {
-                passesFilter = false;
-            }
-
-            // Skip this file if it doesn't pass the time filter
-            if (!passesFilter) {
-                cont = dir.GetNext(&filename);
-                continue;
-            }
-        }
+void ActivitiesPanel::OnActivityChanged(size_t row) {
+    long selectedRow = GetSelectedRow();
+    uint32_t changed = static_cast<uint32_t>(row);
+    auto less = [this](uint32_t a, uint32_t b) { return RowLess(a, b); };
 
-        m_activityData.push_back(displayData);
-        
-        cont = dir.GetNext(&filename);
+    // The sort value may have changed, put the row back at its place
+    m_order.erase(std::remove(m_order.begin(), m_order.end(), changed), m_order.end());
+    m_order.insert(std::upper_bound(m_order.begin(), m_order.end(), changed, less), changed);
+
+    m_view.erase(std::remove(m_view.begin(), m_view.end(), changed), m_view.end());
+    if (PassesFilter(changed)) {
+        m_view.insert(std::upper_bound(m_view.begin(), m_view.end(), changed, less), changed);
     }
-    
-    // Always scan subdirectories recursively 
-    // (This ensures clicking any folder shows all files from that folder and below)
-    cont = dir.GetFirst(&filename, "", wxDIR_DIRS);
-    while (cont) {
-        wxString subPath = path + wxFileName::GetPathSeparator() + filename;
-        wxString newRelativePath = relativePath.IsEmpty() ? filename : 
-                                 relativePath + wxFileName::GetPathSeparator() + filename;
-        ScanDirectoryRecursive(subPath, newRelativePath);
-        cont = dir.GetNext(&filename);
+
+    if (!m_model->IsLoading()) {
+        m_showPlaceholder = m_view.empty();
+    }
+    UpdateListView(selectedRow);
+}
+
+void ActivitiesPanel::OnActivityRemoved(size_t row) {
+    long selectedRow = GetSelectedRow();
+    uint32_t removed = static_cast<uint32_t>(row);
+
+    m_order.erase(std::remove(m_order.begin(), m_order.end(), removed), m_order.end());
+    m_view.erase(std::remove(m_view.begin(), m_view.end(), removed), m_view.end());
+
+    if (!m_model->IsLoading()) {
+        m_showPlaceholder = m_view.empty();
     }
+    UpdateListView(selectedRow);
+}
+
+void ActivitiesPanel::OnCancelScanClicked(wxCommandEvent& WXUNUSED(event)) {
+    // Activities loaded so far stay in the list
+    m_model->CancelLoad();
+}
+
+void ActivitiesPanel::ShowScanProgress(bool show) {
+    m_scanStatus->Show(show);
+    m_scanGauge->Show(show);
+    m_cancelScanButton->Show(show);
+    Layout();
 }
 
 void ActivitiesPanel::SetFilterPath(const wxString& filterPath) {
     m_filterPath = filterPath;
-    LoadActivitiesFromDirectory();
+    RebuildView();
 }
 
 void ActivitiesPanel::SetTimeFilter(int year, int month, int day, int hour) {
     m_useTimeFilter = true;
-    m_filterYear = year;
-    m_filterMonth = month;
-    m_filterDay = day;
-    m_filterHour = hour;
+    m_filterPeriod.year = year;
+    m_filterPeriod.month = month;
+    m_filterPeriod.day = day;
+    m_filterPeriod.hour = hour;
     
     // Clear path filter when using time filter
     m_filterPath.Clear();
     
-    LoadActivitiesFromDirectory();
+    RebuildView();
 }
 
 void ActivitiesPanel::ClearTimeFilter() {
     m_useTimeFilter = false;
-    m_filterYear = -1;
-    m_filterMonth = -1;
-    m_filterDay = -1;
-    m_filterHour = -1;
-    LoadActivitiesFromDirectory();
-}
-
-void ActivitiesPanel::PopulateListFromData() {
-    // Sort by timestamp descending (newest first)
-    std::sort(m_activityData.begin(), m_activityData.end(), 
-              [](const ActivityDisplayData& a, const ActivityDisplayData& b) {
-                  return a.timestamp > b.timestamp;  // Descending order
-              });
-    
-    // Populate the list control
-    for (const auto& data : m_activityData) {
-        int itemIndex = m_listCtrl->GetItemCount();
-        long index = m_listCtrl->InsertItem(itemIndex, data.date);
-        m_listCtrl->SetItem(index, 1, data.name);
-        m_listCtrl->SetItem(index, 2, data.sport);
-        m_listCtrl->SetItem(index, 3, data.duration);
-        m_listCtrl->SetItem(index, 4, data.distance);
-        m_listCtrl->SetItem(index, 5, data.speedPace);
-        m_listCtrl->SetItem(index, 6, data.heartRate);
-        m_listCtrl->SetItem(index, 7, data.filePath);
+    m_filterPeriod = ActivityDataModel::Period();
+    RebuildView();
+}
+
+bool ActivitiesPanel::RowLess(uint32_t a, uint32_t b) const {
+    const ActivityTable& table = m_model->GetTable();
+    return m_sortAscending ? table.Less(m_sortColumn, a, b) : table.Less(m_sortColumn, b, a);
+}
+
+bool ActivitiesPanel::PassesFilter(uint32_t row) const {
+    // Folder filter: the activity is in the selected folder or below it
+    if (!m_filterPath.IsEmpty() && m_filterPath != m_currentDirectory) {
+        wxString prefix = m_filterPath;
+        if (!prefix.EndsWith(wxFileName::GetPathSeparator())) {
+            prefix += wxFileName::GetPathSeparator();
+        }
+        if (!m_model->GetTable().GetFullPath(row).StartsWith(prefix)) {
+            return false;
+        }
     }
-    
-    // If no files found, show message
-    if (m_activityData.empty()) {
-        long index = m_listCtrl->InsertItem(0, "No FIT files found");
-        m_listCtrl->SetItem(index, 1, "");
-        m_listCtrl->SetItem(index, 2, "");
-        m_listCtrl->SetItem(index, 3, "");
-        m_listCtrl->SetItem(index, 4, "");
-        m_listCtrl->SetItem(index, 5, "");
-        m_listCtrl->SetItem(index, 6, m_filterPath.IsEmpty() ? 
-                            "Try opening a different directory" : 
-                            "No files in selected folder");
+
+    // Time filter, files without a timestamp stay visible
+    if (!m_useTimeFilter || m_model->GetTable().GetTimestamp(row) == 0) {
+        return true;
     }
-    
-    // Auto-size columns to fit content
+    return m_model->IsInPeriod(row, m_filterPeriod);
+}
+
+void ActivitiesPanel::SortRows() {
+    // Date order is the catalog's time index, other columns are sorted here
+    if (m_sortColumn == ActivityTable::COL_DATE) {
+        const auto& timeIndex = m_model->GetTimeIndex();
+        if (m_sortAscending) {
+            m_order.assign(timeIndex.begin(), timeIndex.end());
+        } else {
+            m_order.assign(timeIndex.rbegin(), timeIndex.rend());
+        }
+        return;
+    }
+
+    const ActivityTable& table = m_model->GetTable();
+    m_order.clear();
+    m_order.reserve(table.Size());
+    for (uint32_t row = 0; row < table.Size(); ++row) {
+        if (!table.IsRemoved(row)) {
+            m_order.push_back(row);
+        }
+    }
+    std::sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) { return RowLess(a, b); });
+}
+
+void ActivitiesPanel::RebuildView() {
+    long selectedRow = GetSelectedRow();
+
+    // Selection vector over the sorted rows, nothing is re-read or re-sorted
+    m_view.clear();
+    for (uint32_t row : m_order) {
+        if (PassesFilter(row)) {
+            m_view.push_back(row);
+        }
+    }
+
+    m_showPlaceholder = !m_model->IsLoading() && m_view.empty();
+    UpdateListView(selectedRow);
+}
+
+long ActivitiesPanel::GetSelectedRow() const {
+    long selected = m_listCtrl->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+    if (m_showPlaceholder || selected < 0 || selected >= static_cast<long>(m_view.size())) {
+        return -1;
+    }
+    return m_view[selected];
+}
+
+void ActivitiesPanel::UpdateListView(long selectedRow) {
+    long selected = m_listCtrl->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+
+    m_listCtrl->SetItemCount(m_showPlaceholder ? 1 : static_cast<long>(m_view.size()));
+
+    // Move the selection along with its activity, without announcing a new selection
+    long target = -1;
+    if (selectedRow >= 0) {
+        auto it = std::find(m_view.begin(), m_view.end(), static_cast<uint32_t>(selectedRow));
+        if (it != m_view.end()) {
+            target = static_cast<long>(it - m_view.begin());
+        }
+    }
+
+    if (target != selected) {
+        m_restoringSelection = true;
+        if (selected >= 0 && selected < m_listCtrl->GetItemCount()) {
+            m_listCtrl->SetItemState(selected, 0, wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+        }
+        if (target >= 0) {
+            m_listCtrl->SetItemState(target, wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
+                                     wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+        }
+        m_restoringSelection = false;
+    }
+
+    m_listCtrl->Refresh();
+}
+
+wxString ActivitiesPanel::GetListItemText(long item, long column) const {
+    if (m_showPlaceholder) {
+        if (column == ActivityTable::COL_DATE) {
+            return "No FIT files found";
+        } else if (column == ActivityTable::COL_HEART_RATE) {
+            return m_filterPath.IsEmpty() ? "Try opening a different directory" : "No files in selected folder";
+        }
+        return wxEmptyString;
+    }
+
+    if (item < 0 || item >= static_cast<long>(m_view.size())) {
+        return wxEmptyString;
+    }
+    return m_model->GetTable().FormatCell(m_view[item], static_cast<int>(column));
+}
+
+void ActivitiesPanel::OnColumnClicked(wxListEvent& event) {
+    int column = event.GetColumn();
+    if (column < 0 || column >= ActivityTable::COLUMN_COUNT) {
+        return;
+    }
+
+    // Same column flips the direction, dates start newest first and the rest ascending
+    if (column == m_sortColumn) {
+        m_sortAscending = !m_sortAscending;
+    } else {
+        m_sortColumn = column;
+        m_sortAscending = column != ActivityTable::COL_DATE;
+    }
+
+    SortRows();
+    RebuildView();
+}
+
+void ActivitiesPanel::FinishList() {
+    m_showPlaceholder = m_view.empty();
+    UpdateListView(GetSelectedRow());
+
+    // Auto-size columns to fit content (virtual lists measure the visible rows)
     for (int col = 0; col < m_listCtrl->GetColumnCount(); col++) {
         m_listCtrl->SetColumnWidth(col, wxLIST_AUTOSIZE);
         
@@ -416,19 +470,22 @@ void ActivitiesPanel::PopulateListFromData() {
 }
 
 void ActivitiesPanel::OnRefreshClicked(wxCommandEvent& event) {
-    LoadActivitiesFromDirectory();
+    if (!m_currentDirectory.IsEmpty()) {
+        // Only what changed on disk is loaded again
+        m_model->Refresh();
+    }
 }
 
 int ActivitiesPanel::GetActivityCount() const {
-    return static_cast<int>(m_activityData.size());
+    return static_cast<int>(m_view.size());
 }
 
 bool ActivitiesPanel::GetActivityData(int index, ActivityDisplayData& data) const {
-    if (index < 0 || index >= static_cast<int>(m_activityData.size())) {
+    if (index < 0 || index >= static_cast<int>(m_view.size())) {
         return false;
     }
     
-    data = m_activityData[index];
+    data = m_model->GetActivity(m_view[index]);
     return true;
 }
 
@@ -453,13 +510,21 @@ void ActivitiesPanel::SetSelection(int index) {
     m_listCtrl->EnsureVisible(index); // Scroll to make the item visible
 }
 
+int ActivitiesPanel::GetSelection() const {
+    long selected = m_listCtrl->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+    if (selected < 0 || selected >= static_cast<long>(m_view.size())) {
+        return -1;
+    }
+    return static_cast<int>(selected);
+}
+
 void ActivitiesPanel::StartDragDrop(long itemIndex, bool moveOperation) {
     // Validate item index
-    if (itemIndex < 0 || itemIndex >= static_cast<long>(m_activityData.size())) {
+    if (itemIndex < 0 || itemIndex >= static_cast<long>(m_view.size())) {
         return;
     }
     
-    const ActivityDisplayData& data = m_activityData[itemIndex];
+    ActivityDisplayData data = m_model->GetActivity(m_view[itemIndex]);
     
     // Create a file data object with the FIT file path
     wxFileDataObject fileData;
@@ -474,15 +539,14 @@ void ActivitiesPanel::StartDragDrop(long itemIndex, bool moveOperation) {
     
     // Handle the result if needed
     if (result == wxDragMove && moveOperation) {
-        // File was moved successfully - could update UI if needed
-        // For now, just refresh the list to reflect any changes
-        LoadActivitiesFromDirectory();
+        // The watcher notices the move, this only applies it right away
+        m_model->Refresh();
     }
 }
 
 void ActivitiesPanel::ShowContextMenu(long itemIndex) {
     // Validate item index
-    if (itemIndex < 0 || itemIndex >= static_cast<long>(m_activityData.size())) {
+    if (itemIndex < 0 || itemIndex >= static_cast<long>(m_view.size())) {
         return;
     }
     
@@ -497,11 +561,11 @@ void ActivitiesPanel::ShowContextMenu(long itemIndex) {
 void ActivitiesPanel::OnContextOpenContainingFolder(wxCommandEvent& event) {
     // Get the currently selected item
     long selectedIndex = m_listCtrl->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-    if (selectedIndex < 0 || selectedIndex >= static_cast<long>(m_activityData.size())) {
+    if (selectedIndex < 0 || selectedIndex >= static_cast<long>(m_view.size())) {
         return;
     }
     
-    const ActivityDisplayData& data = m_activityData[selectedIndex];
+    ActivityDisplayData data = m_model->GetActivity(m_view[selectedIndex]);
     
     // Extract directory and filename
     wxFileName fileName(data.fullPath);
@@ -514,11 +578,11 @@ void ActivitiesPanel::OnContextOpenContainingFolder(wxCommandEvent& event) {
 
 void ActivitiesPanel::StartEditingName(long itemIndex) {
     // Validate item index
-    if (itemIndex < 0 || itemIndex >= static_cast<long>(m_activityData.size())) {
+    if (itemIndex < 0 || itemIndex >= static_cast<long>(m_view.size())) {
         return;
     }
 
-    const ActivityDisplayData& data = m_activityData[itemIndex];
+    ActivityDisplayData data = m_model->GetActivity(m_view[itemIndex]);
     wxString currentName = data.name;
 
     // Show a text entry dialog for editing the name
@@ -538,34 +602,12 @@ void ActivitiesPanel::StartEditingName(long itemIndex) {
 
 void ActivitiesPanel::SaveEditedName(long itemIndex, const wxString& newName) {
     // Validate item index
-    if (itemIndex < 0 || itemIndex >= static_cast<long>(m_activityData.size())) {
+    if (itemIndex < 0 || itemIndex >= static_cast<long>(m_view.size())) {
         return;
     }
 
-    // Update the activity data
-    m_activityData[itemIndex].name = newName;
-
-    // Update the list control display
-    m_listCtrl->SetItem(itemIndex, 1, newName);
-
-    // Update the metadata cache file - only update the name field
-    const ActivityDisplayData& data = m_activityData[itemIndex];
-
-    // Read existing metadata
-    wxString metaPath = MetadataCache::GetMetaFilePath(data.fullPath);
-    if (wxFileExists(metaPath)) {
-        // Load existing metadata
-        ActivityDisplayData tempData;
-        if (MetadataCache::LoadFromCache(data.fullPath, tempData)) {
-            // Update only the name
-            tempData.name = newName;
-            // Save back with all existing fields but updated name
-            MetadataCache::SaveToCache(data.fullPath, tempData, false);
-        }
-    } else {
-        // Create new metadata file
-        MetadataCache::SaveToCache(data.fullPath, data, false);
-    }
+    // Catalog updates the activity cache and notifies the views
+    m_model->SetActivityName(m_view[itemIndex], newName);
 }
 
 void ActivitiesPanel::OnEndLabelEdit(wxListEvent& event) {
@@ -6,20 +6,29 @@
 #endif
 #include <wx/listctrl.h>
 #include <wx/dnd.h>
+#include <wx/gauge.h>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include "../models/ActivityData.hpp"
+#include "../models/ActivityDataModel.hpp"
 #include "../interfaces/IFileOperations.hpp"
+#include "../interfaces/IActivityModelListener.hpp"
 
 // Forward declaration
 class ActivitiesPanel;
 
-// Custom list control with drag & drop and editing support
+// Custom list control with drag & drop and editing support.
+// Virtual: rows are not stored in the control, their text is asked from the panel.
 class DragDropListCtrl : public wxListCtrl {
 public:
     DragDropListCtrl(ActivitiesPanel* parent, wxWindowID id = wxID_ANY);
 
     void StartEditing(long item, int column);
 
+protected:
+    wxString OnGetItemText(long item, long column) const override;
+
 private:
     void OnBeginDrag(wxListEvent& event);
     void OnRightClick(wxListEvent& event);
@@ -31,10 +40,10 @@ private:
     wxDECLARE_EVENT_TABLE();
 };
 
-class ActivitiesPanel : public wxPanel, public IFileOperations {
+class ActivitiesPanel : public wxPanel, public IFileOperations, public IActivityModelListener {
 public:
-    ActivitiesPanel(wxWindow* parent);
-    virtual ~ActivitiesPanel() = default;
+    ActivitiesPanel(wxWindow* parent, ActivityDataModel* model);
+    virtual ~ActivitiesPanel();
     
     void SetDirectory(const wxString& path);
     void SetFilterPath(const wxString& filterPath); // Filter to specific subdirectory
@@ -45,6 +54,7 @@ public:
     int GetActivityCount() const;
     bool GetActivityData(int index, ActivityDisplayData& data) const;
     void SetSelection(int index);
+    int GetSelection() const; // -1 if nothing is selected
     
     // Drag & drop support
     void StartDragDrop(long itemIndex, bool moveOperation = false);
@@ -56,6 +66,17 @@ public:
     void StartEditingName(long itemIndex);
     void SaveEditedName(long itemIndex, const wxString& newName);
 
+    // Text of a list cell, formatted when the row becomes visible
+    wxString GetListItemText(long item, long column) const;
+
+    // IActivityModelListener
+    void OnCatalogCleared() override;
+    void OnActivitiesAdded(size_t firstRow, size_t count) override;
+    void OnCatalogProgress(size_t done, size_t total) override;
+    void OnCatalogLoaded() override;
+    void OnActivityChanged(size_t row) override;
+    void OnActivityRemoved(size_t row) override;
+
 private:
     enum {
         ID_CONTEXT_OPEN_CONTAINING_FOLDER = 1100
@@ -67,25 +88,45 @@ private:
     void OnRefreshClicked(wxCommandEvent& event);
     void OnContextOpenContainingFolder(wxCommandEvent& event);
     void OnEndLabelEdit(wxListEvent& event);
+    void OnCancelScanClicked(wxCommandEvent& event);
+    void OnColumnClicked(wxListEvent& event);
 
+    ActivityDataModel* m_model; // Shared catalog, owned by MainFrame
     DragDropListCtrl* m_listCtrl;
     wxButton* m_refreshButton;
     wxButton* m_detailsButton;
+
+    // Scan progress, shown while the background scan runs
+    wxGauge* m_scanGauge;
+    wxStaticText* m_scanStatus;
+    wxButton* m_cancelScanButton;
     
     wxString m_currentDirectory;
     wxString m_filterPath; // Current filter path for tree selection
-    std::vector<ActivityDisplayData> m_activityData; // Collected activity data for sorting
+
+    // The list shows a sorted, filtered view of catalog rows
+    std::vector<uint32_t> m_order; // All rows, sorted by the current column
+    std::vector<uint32_t> m_view;  // Rows of m_order passing the filters, in the same order
+    int m_sortColumn;
+    bool m_sortAscending;
+    bool m_showPlaceholder;      // Single "No FIT files found" row
+    bool m_restoringSelection;   // Selection moved by the view, not by the user
     
     // Time filtering
     bool m_useTimeFilter;
-    int m_filterYear;
-    int m_filterMonth; // -1 means no month filter
-    int m_filterDay;   // -1 means no day filter  
-    int m_filterHour;  // -1 means no hour filter
-    
-    void LoadActivitiesFromDirectory();
-    void ScanDirectoryRecursive(const wxString& path, const wxString& relativePath = "");
-    void PopulateListFromData();
+    ActivityDataModel::Period m_filterPeriod;
+
+    void ShowScanProgress(bool show);
+    void FinishList();
+
+    bool RowLess(uint32_t a, uint32_t b) const;
+    bool PassesFilter(uint32_t row) const;
+    void SortRows();
+    void RebuildView();
+
+    // Keep the selected activity selected while rows move around it
+    long GetSelectedRow() const;
+    void UpdateListView(long selectedRow);
 
     wxDECLARE_EVENT_TABLE();
 };
\ No newline at end of file
@@ -3,14 +3,9 @@
 #include <wx/filename.h>
 #include <wx/datetime.h>
 #include <algorithm>
+#include <set>
 #include <vector>
-#include <map>
-#include <filesystem>
-#include "parsers/session-scanner.hpp"
-#include "parsers/binary-mapper.hpp"
-#include "utils/MetadataCache.hpp"
-#include "models/ActivityData.hpp"
-#include <fit_date_time.hpp>
+#include "models/ActivityDataModel.hpp"
 
 // Import ID_TreeSelection constant
 enum { ID_TreeSelection = 2000 };
@@ -19,13 +14,15 @@ wxBEGIN_EVENT_TABLE(FileTreePanel, wxPanel)
     EVT_CHOICE(ID_VIEW_MODE_CHOICE, FileTreePanel::OnViewModeChanged)
     EVT_CHOICE(ID_TIME_GRANULARITY_CHOICE, FileTreePanel::OnTimeGranularityChanged)
     EVT_TREE_SEL_CHANGED(wxID_ANY, FileTreePanel::OnTreeItemSelected)
+    EVT_TREE_ITEM_EXPANDING(wxID_ANY, FileTreePanel::OnTreeItemExpanding)
     EVT_TREE_ITEM_RIGHT_CLICK(wxID_ANY, FileTreePanel::OnTreeRightClick)
     EVT_MENU(ID_CONTEXT_OPEN_FOLDER, FileTreePanel::OnContextOpenFolder)
     EVT_BUTTON(wxID_ANY, FileTreePanel::OnSortClicked)
 wxEND_EVENT_TABLE()
 
-FileTreePanel::FileTreePanel(wxWindow* parent)
+FileTreePanel::FileTreePanel(wxWindow* parent, ActivityDataModel* model)
     : wxPanel(parent, wxID_ANY),
+      m_model(model),
       m_viewModeChoice(nullptr),
       m_timeGranularityChoice(nullptr),
       m_sortButton(nullptr),
@@ -35,6 +32,102 @@ FileTreePanel::FileTreePanel(wxWindow* parent)
       m_sortAscending(true) {
     
     CreateLayout();
+    m_model->AddListener(this);
+}
+
+FileTreePanel::~FileTreePanel() {
+    m_model->RemoveListener(this);
+}
+
+void FileTreePanel::OnCatalogCleared() {
+    if (m_currentMode == VIEW_TIME) {
+        m_infoLabel->SetLabel("Loading activities...");
+    }
+}
+
+void FileTreePanel::OnActivitiesAdded(size_t firstRow, size_t count) {
+    // Time hierarchy is built once the catalog is complete, later files only add their nodes
+    if (m_currentMode != VIEW_TIME || m_model->IsLoading() || !m_treeCtrl->GetRootItem().IsOk()) {
+        return;
+    }
+
+    for (size_t row = firstRow; row < firstRow + count; ++row) {
+        AddPeriodNodes(row);
+    }
+}
+
+void FileTreePanel::OnCatalogLoaded() {
+    if (m_currentMode == VIEW_TIME) {
+        RebuildTree();
+    }
+}
+
+void FileTreePanel::OnActivityChanged(size_t row) {
+    if (m_currentMode != VIEW_TIME || m_model->IsLoading() || !m_treeCtrl->GetRootItem().IsOk()) {
+        return;
+    }
+
+    // A modified file may have moved to another period
+    AddPeriodNodes(row);
+    PruneTimeNodes(m_treeCtrl->GetRootItem());
+}
+
+void FileTreePanel::OnActivityRemoved(size_t row) {
+    if (m_currentMode != VIEW_TIME || m_model->IsLoading() || !m_treeCtrl->GetRootItem().IsOk()) {
+        return;
+    }
+
+    PruneTimeNodes(m_treeCtrl->GetRootItem());
+}
+
+void FileTreePanel::OnFolderChanged(const wxString& path) {
+    wxString prefix = m_currentDirectory + wxFileName::GetPathSeparator();
+    if (m_currentMode != VIEW_FOLDER || !path.StartsWith(prefix) || !m_treeCtrl->GetRootItem().IsOk()) {
+        return;
+    }
+
+    wxArrayString parts = wxSplit(path.Mid(prefix.length()), wxFileName::GetPathSeparator(), '\0');
+    if (parts.empty()) {
+        return;
+    }
+
+    // Only folders that were expanded have their children in the tree
+    wxTreeItemId parent = m_treeCtrl->GetRootItem();
+    if (!GetNodeData(parent)) {
+        return;
+    }
+    for (size_t i = 0; i + 1 < parts.size(); ++i) {
+        if (!GetNodeData(parent)->populated) {
+            return;
+        }
+        parent = FindChild(parent, parts[i]);
+        if (!parent.IsOk()) {
+            return;
+        }
+    }
+
+    NodeData* parentData = GetNodeData(parent);
+    if (!parentData->populated) {
+        if (wxDirExists(path)) {
+            m_treeCtrl->SetItemHasChildren(parent, true);
+        }
+        return;
+    }
+
+    wxTreeItemId existing = FindChild(parent, parts.back());
+    if (wxDirExists(path)) {
+        if (!existing.IsOk()) {
+            NodeData* data = new NodeData();
+            data->path = path;
+            wxTreeItemId item = InsertChild(parent, parts.back(), data);
+            m_treeCtrl->SetItemHasChildren(item, wxDir(path).HasSubDirs());
+        }
+    } else if (existing.IsOk()) {
+        m_treeCtrl->Delete(existing);
+        if (m_treeCtrl->GetChildrenCount(parent, false) == 0) {
+            m_treeCtrl->SetItemHasChildren(parent, false);
+        }
+    }
 }
 
 void FileTreePanel::CreateLayout() {
@@ -109,33 +202,18 @@ void FileTreePanel::OnTreeItemSelected(wxTreeEvent& event) {
     wxTreeItemId item = event.GetItem();
     if (item.IsOk()) {
         wxString text = m_treeCtrl->GetItemText(item);
-        m_infoLabel->SetLabel("Selected: " + text);
+        NodeData* data = GetNodeData(item);
+        if (m_currentMode == VIEW_TIME && data && data->count > 0) {
+            m_infoLabel->SetLabel(wxString::Format("Selected: %s (%zu activities)", text, data->count));
+        } else {
+            m_infoLabel->SetLabel("Selected: " + text);
+        }
         
         // Build full path from selected item
         if (m_currentMode == VIEW_FOLDER) {
-            // For folder mode, build path from tree hierarchy
-            wxString fullPath;
-            wxTreeItemId current = item;
-            wxString pathParts;
-            
-            // Build path by going up the tree (excluding root)
-            while (current.IsOk() && current != m_treeCtrl->GetRootItem()) {
-                wxString itemText = m_treeCtrl->GetItemText(current);
-                if (!itemText.StartsWith("FIT Files:") && !itemText.EndsWith(".fit")) {
-                    if (pathParts.IsEmpty()) {
-                        pathParts = itemText;
-                    } else {
-                        pathParts = itemText + wxFileName::GetPathSeparator() + pathParts;
-                    }
-                }
-                current = m_treeCtrl->GetItemParent(current);
-            }
-            
-            if (!pathParts.IsEmpty()) {
-                m_selectedPath = m_currentDirectory + wxFileName::GetPathSeparator() + pathParts;
-            } else {
-                m_selectedPath = m_currentDirectory;
-            }
+            // Folder nodes carry their path
+            NodeData* data = GetNodeData(item);
+            m_selectedPath = data ? data->path : m_currentDirectory;
         } else {
             // For time mode, parse the tree hierarchy to build time filter
             wxString timeFilterData = "";
@@ -202,6 +280,7 @@ void FileTreePanel::OnTreeItemSelected(wxTreeEvent& event) {
     }
 }
 
+
 wxString FileTreePanel::GetSelectedPath() const {
     return m_selectedPath;
 }
@@ -212,37 +291,38 @@ void FileTreePanel::SetDirectory(const wxString& path) {
 }
 
 void FileTreePanel::RebuildTree() {
+    std::set<wxString> expanded;
+    RebuildTree(expanded);
+}
+
+void FileTreePanel::RebuildTree(const std::set<wxString>& expanded) {
     if (m_currentDirectory.IsEmpty()) return;
-    
+
+    m_treeCtrl->Freeze();
     m_treeCtrl->DeleteAllItems();
-    
-    wxTreeItemId root = m_treeCtrl->AddRoot("FIT Files: " + m_currentDirectory);
-    
-    if (m_currentMode == VIEW_FOLDER) {
-        // Build folder hierarchy recursively
-        BuildFolderHierarchy(root, m_currentDirectory, 0);
-    } else {
-        // Build time hierarchy using real FIT file timestamps
-        BuildTimeHierarchy(root);
-    }
-    
+
+    // Only the first level is built here, deeper levels when they are expanded
+    NodeData* rootData = new NodeData();
+    rootData->path = m_currentDirectory;
+    wxTreeItemId root = m_treeCtrl->AddRoot("FIT Files: " + m_currentDirectory, -1, -1, rootData);
+    PopulateNode(root);
     m_treeCtrl->Expand(root);
-    
-    // Sort the tree after building it (only for folder mode)
-    if (m_currentMode == VIEW_FOLDER) {
-        SortTreeRecursively(root);
+
+    if (expanded.empty()) {
+        // Expand year nodes for better visibility when granularity > 0
+        if (m_currentMode == VIEW_TIME && m_timeGranularityChoice->GetSelection() > 0) {
+            wxTreeItemIdValue cookie;
+            for (wxTreeItemId child = m_treeCtrl->GetFirstChild(root, cookie); child.IsOk();
+                 child = m_treeCtrl->GetNextChild(root, cookie)) {
+                ExpandNode(child);
+            }
+        }
+    } else {
+        RestoreExpanded(root, wxEmptyString, expanded);
     }
-    
-    // Force complete refresh of the tree control
-    m_treeCtrl->Freeze();
+
     m_treeCtrl->Thaw();
-    m_treeCtrl->Refresh();
-    m_treeCtrl->Update();
-    
-    // Also force repaint of the parent window
-    this->Refresh();
-    this->Update();
-    
+
     m_infoLabel->SetLabel(wxString::Format("Found FIT files in: %s", m_currentDirectory));
 }
 
@@ -253,90 +333,35 @@ void FileTreePanel::OnSortClicked(wxCommandEvent& event) {
     // Update button text
     m_sortButton->SetLabel(m_sortAscending ? "Sort A-Z" : "Sort Z-A");
     
-    // Sort the tree
+    // Children are sorted before they are inserted, so rebuild what was open in the new order
     if (m_treeCtrl->GetRootItem().IsOk()) {
-        SortTreeRecursively(m_treeCtrl->GetRootItem());
+        std::set<wxString> expanded;
+        CollectExpanded(m_treeCtrl->GetRootItem(), wxEmptyString, expanded);
+        RebuildTree(expanded);
     }
 }
 
-void FileTreePanel::SortTreeRecursively(wxTreeItemId item) {
-    if (!item.IsOk()) return;
-    
-    // Collect all children with their text and subtree information
-    std::vector<std::pair<wxString, wxTreeItemId>> children;
+void FileTreePanel::CollectExpanded(wxTreeItemId item, const wxString& key, std::set<wxString>& expanded) const {
     wxTreeItemIdValue cookie;
-    wxTreeItemId child = m_treeCtrl->GetFirstChild(item, cookie);
-    while (child.IsOk()) {
-        children.push_back(std::make_pair(m_treeCtrl->GetItemText(child), child));
-        child = m_treeCtrl->GetNextChild(item, cookie);
-    }
-    
-    // If no children, nothing to sort
-    if (children.empty()) return;
-    
-    // First recursively sort all children's subtrees
-    for (const auto& child : children) {
-        SortTreeRecursively(child.second);
-    }
-    
-    // Sort the children by name
-    if (m_sortAscending) {
-        std::sort(children.begin(), children.end());
-    } else {
-        std::sort(children.begin(), children.end(), std::greater<std::pair<wxString, wxTreeItemId>>());
-    }
-    
-    // Now reorder the children in the tree while preserving their subtrees
-    // We'll do this by creating a temporary mapping and rebuilding
-    std::vector<TreeNodeInfo> sortedNodes;
-    
-    // Collect complete node information including subtrees
-    for (const auto& child : children) {
-        TreeNodeInfo nodeInfo;
-        nodeInfo.text = child.first;
-        nodeInfo.itemId = child.second;
-        CopySubtree(child.second, nodeInfo);
-        sortedNodes.push_back(nodeInfo);
-    }
-    
-    // Remove all children
-    m_treeCtrl->DeleteChildren(item);
-    
-    // Recreate children in sorted order with their subtrees
-    for (const auto& nodeInfo : sortedNodes) {
-        wxTreeItemId newChild = m_treeCtrl->AppendItem(item, nodeInfo.text);
-        RecreateSubtree(newChild, nodeInfo);
+    for (wxTreeItemId child = m_treeCtrl->GetFirstChild(item, cookie); child.IsOk();
+         child = m_treeCtrl->GetNextChild(item, cookie)) {
+        if (m_treeCtrl->IsExpanded(child)) {
+            wxString childKey = key + "/" + m_treeCtrl->GetItemText(child);
+            expanded.insert(childKey);
+            CollectExpanded(child, childKey, expanded);
+        }
     }
 }
 
-void FileTreePanel::CopySubtree(wxTreeItemId source, TreeNodeInfo& nodeInfo) {
-    if (!source.IsOk()) return;
-    
-    // Copy all children recursively
+void FileTreePanel::RestoreExpanded(wxTreeItemId item, const wxString& key, const std::set<wxString>& expanded) {
     wxTreeItemIdValue cookie;
-    wxTreeItemId child = m_treeCtrl->GetFirstChild(source, cookie);
-    while (child.IsOk()) {
-        TreeNodeInfo childInfo;
-        childInfo.text = m_treeCtrl->GetItemText(child);
-        childInfo.itemId = child;
-        
-        // Recursively copy the child's subtree
-        CopySubtree(child, childInfo);
-        
-        nodeInfo.children.push_back(childInfo);
-        child = m_treeCtrl->GetNextChild(source, cookie);
-    }
-}
-
-void FileTreePanel::RecreateSubtree(wxTreeItemId parent, const TreeNodeInfo& nodeInfo) {
-    if (!parent.IsOk()) return;
-    
-    // Recreate all children
-    for (const auto& childInfo : nodeInfo.children) {
-        wxTreeItemId newChild = m_treeCtrl->AppendItem(parent, childInfo.text);
-        
-        // Recursively recreate the child's subtree
-        RecreateSubtree(newChild, childInfo);
+    for (wxTreeItemId child = m_treeCtrl->GetFirstChild(item, cookie); child.IsOk();
+         child = m_treeCtrl->GetNextChild(item, cookie)) {
+        wxString childKey = key + "/" + m_treeCtrl->GetItemText(child);
+        if (expanded.count(childKey)) {
+            ExpandNode(child);
+            RestoreExpanded(child, childKey, expanded);
+        }
     }
 }
 
@@ -375,178 +400,245 @@ void FileTreePanel::OnContextOpenFolder(wxCommandEvent& event) {
 }
 
 
-void FileTreePanel::BuildTimeHierarchy(wxTreeItemId root) {
-    if (m_currentDirectory.IsEmpty()) return;
-    
-    // Map to organize files by time hierarchy
-    std::map<wxString, std::map<wxString, std::map<wxString, std::map<wxString, std::vector<wxString>>>>> timeTree;
-    
-    // Get granularity level
-    int granularity = m_timeGranularityChoice->GetSelection(); // 0=Year, 1=Month, 2=Day, 3=Hour
-    
-    // Scan directory recursively for FIT files
-    ScanDirectoryForTimeHierarchy(m_currentDirectory, "", timeTree, granularity);
-    
-    // Build tree from organized data
-    for (const auto& yearEntry : timeTree) {
-        wxTreeItemId yearNode = m_treeCtrl->AppendItem(root, yearEntry.first);
-        
-        if (granularity > 0) { // Month level
-            for (const auto& monthEntry : yearEntry.second) {
-                wxTreeItemId monthNode = m_treeCtrl->AppendItem(yearNode, monthEntry.first);
-                
-                if (granularity > 1) { // Day level
-                    for (const auto& dayEntry : monthEntry.second) {
-                        wxTreeItemId dayNode = m_treeCtrl->AppendItem(monthNode, dayEntry.first);
-                        
-                        if (granularity > 2) { // Hour level
-                            for (const auto& hourEntry : dayEntry.second) {
-                                // Only add hour nodes if they contain files
-                                if (!hourEntry.second.empty()) {
-                                    m_treeCtrl->AppendItem(dayNode, hourEntry.first);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        
-        // Expand year nodes for better visibility when granularity > 0
-        if (granularity > 0) {
-            m_treeCtrl->Expand(yearNode);
-        }
+
+void FileTreePanel::OnTreeItemExpanding(wxTreeEvent& event) {
+    PopulateNode(event.GetItem());
+}
+
+FileTreePanel::NodeData* FileTreePanel::GetNodeData(wxTreeItemId item) const {
+    return item.IsOk() ? static_cast<NodeData*>(m_treeCtrl->GetItemData(item)) : nullptr;
+}
+
+void FileTreePanel::ExpandNode(wxTreeItemId item) {
+    // Programmatic expansion doesn't send EVT_TREE_ITEM_EXPANDING on every platform
+    PopulateNode(item);
+    m_treeCtrl->Expand(item);
+}
+
+void FileTreePanel::PopulateNode(wxTreeItemId item) {
+    NodeData* data = GetNodeData(item);
+    if (!data || data->populated) {
+        return;
+    }
+    data->populated = true;
+
+    if (m_currentMode == VIEW_FOLDER) {
+        PopulateFolder(item, data);
+    } else {
+        PopulateTime(item, data);
+    }
+
+    if (m_treeCtrl->GetChildrenCount(item, false) == 0) {
+        m_treeCtrl->SetItemHasChildren(item, false);
     }
 }
 
-void FileTreePanel::BuildFolderHierarchy(wxTreeItemId parentItem, const wxString& path, int depth) {
-    wxDir dir(path);
+void FileTreePanel::PopulateFolder(wxTreeItemId item, NodeData* data) {
+    wxDir dir(data->path);
     if (!dir.IsOpened()) {
         return;
     }
-    
+
+    std::vector<wxString> names;
     wxString filename;
-    
-    // Add subdirectories recursively
     bool cont = dir.GetFirst(&filename, "", wxDIR_DIRS);
     while (cont) {
-        // Create tree item for this subdirectory
-        wxTreeItemId folderItem = m_treeCtrl->AppendItem(parentItem, filename);
-        
-        // Recursively build hierarchy for this subdirectory (limit depth to 3 levels)
-        if (depth < 3) {
-            wxString subPath = path + wxFileName::GetPathSeparator() + filename;
-            BuildFolderHierarchy(folderItem, subPath, depth + 1);
-        }
-        
+        names.push_back(filename);
         cont = dir.GetNext(&filename);
     }
+
+    if (m_sortAscending) {
+        std::sort(names.begin(), names.end());
+    } else {
+        std::sort(names.begin(), names.end(), std::greater<wxString>());
+    }
+
+    for (const auto& name : names) {
+        NodeData* childData = new NodeData();
+        childData->path = data->path + wxFileName::GetPathSeparator() + name;
+        wxTreeItemId child = m_treeCtrl->AppendItem(item, name, -1, -1, childData);
+
+        // One directory read per visible folder tells whether it can be expanded
+        m_treeCtrl->SetItemHasChildren(child, wxDir(childData->path).HasSubDirs());
+    }
 }
 
-void FileTreePanel::ScanDirectoryForTimeHierarchy(const wxString& path, const wxString& relativePath,
-    std::map<wxString, std::map<wxString, std::map<wxString, std::map<wxString, std::vector<wxString>>>>>& timeTree,
-    int granularity) {
-    
-    wxDir dir(path);
-    if (!dir.IsOpened()) return;
-    
-    wxString filename;
-    
-    // Scan for FIT files
-    bool cont = dir.GetFirst(&filename, "*.fit", wxDIR_FILES);
-    while (cont) {
-        wxString fullPath = path + wxFileName::GetPathSeparator() + filename;
-        wxString displayPath = relativePath.IsEmpty() ? filename : 
-                              relativePath + wxFileName::GetPathSeparator() + filename;
-        
-        // Try to load timestamp from cache first
-        uint32_t timestamp = 0;
-        bool loadedFromCache = false;
-
-        if (MetadataCache::IsCacheValid(fullPath)) {
-            ActivityDisplayData cachedData;
-            if (MetadataCache::LoadFromCache(fullPath, cachedData)) {
-                timestamp = cachedData.timestamp;
-                loadedFromCache = true;
-            }
+void FileTreePanel::PopulateTime(wxTreeItemId item, NodeData* data) {
+    if (m_model->IsLoading()) {
+        return; // The tree is rebuilt once the catalog is complete
+    }
+
+    int granularity = m_timeGranularityChoice->GetSelection(); // 0=Year, 1=Month, 2=Day, 3=Hour
+    int level = data->level + 1;
+    if (level > granularity) {
+        return;
+    }
+
+    // Periods and their activity counts come from the catalog index; nothing is parsed here
+    auto periods = m_model->GetChildPeriods(data->period);
+    if (!m_sortAscending) {
+        std::reverse(periods.begin(), periods.end());
+    }
+
+    // Files without a valid timestamp sort after the years
+    bool root = data->level == -1;
+    size_t undated = root ? m_model->GetUndatedCount() : 0;
+    if (undated > 0 && !m_sortAscending) {
+        AppendUndatedNode(item, undated);
+    }
+
+    for (const auto& child : periods) {
+        NodeData* childData = new NodeData();
+        childData->period = child.period;
+        childData->level = level;
+        childData->count = child.count;
+
+        wxTreeItemId childItem = m_treeCtrl->AppendItem(item, FormatPeriodLevel(level, PeriodValue(child.period, level)),
+                                                        -1, -1, childData);
+        m_treeCtrl->SetItemHasChildren(childItem, level < granularity);
+    }
+
+    if (undated > 0 && m_sortAscending) {
+        AppendUndatedNode(item, undated);
+    }
+}
+
+void FileTreePanel::AppendUndatedNode(wxTreeItemId root, size_t count) {
+    NodeData* data = new NodeData();
+    data->level = 0;
+    data->count = count;
+    data->populated = true;
+    m_treeCtrl->AppendItem(root, "Unknown", -1, -1, data);
+}
+
+wxString FileTreePanel::FormatPeriodLevel(int level, int value) {
+    switch (level) {
+        case 0: return wxString::Format("%d", value);
+        case 1: return wxString::Format("%02d - %s", value,
+                    wxDateTime::GetMonthName(static_cast<wxDateTime::Month>(value - 1)));
+        case 2: return wxString::Format("%02d", value);
+        default: return wxString::Format("%02d:00", value);
+    }
+}
+
+int FileTreePanel::PeriodValue(const ActivityDataModel::Period& period, int level) {
+    switch (level) {
+        case 0: return period.year;
+        case 1: return period.month;
+        case 2: return period.day;
+        default: return period.hour;
+    }
+}
+
+wxTreeItemId FileTreePanel::FindChild(wxTreeItemId parent, const wxString& text) const {
+    wxTreeItemIdValue cookie;
+    for (wxTreeItemId child = m_treeCtrl->GetFirstChild(parent, cookie); child.IsOk();
+         child = m_treeCtrl->GetNextChild(parent, cookie)) {
+        if (m_treeCtrl->GetItemText(child) == text) {
+            return child;
         }
+    }
+    return wxTreeItemId();
+}
 
-        // If not in cache, parse FIT file
-        if (!loadedFromCache) {
-            try {
-                std::filesystem::path fitPath(fullPath.ToStdString());
-                darauble::BinaryMapper mapper(fitPath);
-                darauble::SessionScanner scanner(filename.ToStdString(), mapper);
-
-                scanner.scan();
-
-                if (scanner.hasData()) {
-                    const auto& activityData = scanner.getData();
-                    auto aggregated = activityData.getAggregatedData();
-                    timestamp = aggregated.timestamp;
-
-                    // Create cache entry for faster subsequent scans
-                    ActivityDisplayData displayData;
-                    displayData.timestamp = timestamp;
-                    displayData.fullPath = fullPath;
-                    displayData.filePath = displayPath;
-
-                    if (timestamp > 0) {
-                        fit::DateTime fitDateTime(timestamp);
-                        wxDateTime activityTime(fitDateTime.GetTimeT());
-                        displayData.date = activityTime.Format("%Y-%m-%d %H:%M");
-                    }
+wxTreeItemId FileTreePanel::InsertChild(wxTreeItemId parent, const wxString& text, NodeData* data) {
+    // Keep the order the children were inserted in
+    size_t position = 0;
+    wxTreeItemIdValue cookie;
+    for (wxTreeItemId child = m_treeCtrl->GetFirstChild(parent, cookie); child.IsOk();
+         child = m_treeCtrl->GetNextChild(parent, cookie), ++position) {
+        wxString childText = m_treeCtrl->GetItemText(child);
+        if (m_sortAscending ? childText > text : childText < text) {
+            return m_treeCtrl->InsertItem(parent, position, text, -1, -1, data);
+        }
+    }
+    return m_treeCtrl->AppendItem(parent, text, -1, -1, data);
+}
 
-                    displayData.name = wxString::FromUTF8(activityData.activityName);
-                    displayData.sport = wxString::FromUTF8(activityData.getPrimarySportName());
-                    displayData.duration = wxString::FromUTF8(aggregated.getFormattedDuration());
-                    displayData.distance = wxString::FromUTF8(aggregated.getFormattedDistance(activityData.primarySport, activityData.primarySubSport));
-                    displayData.speedPace = wxString::FromUTF8(aggregated.getFormattedSpeed(activityData.primarySport, activityData.primarySubSport));
-                    displayData.heartRate = wxString::FromUTF8(aggregated.getFormattedHeartRate());
+void FileTreePanel::AddPeriodNodes(size_t row) {
+    wxTreeItemId root = m_treeCtrl->GetRootItem();
+    NodeData* rootData = GetNodeData(root);
+    if (!rootData || !rootData->populated) {
+        return;
+    }
 
-                    // Save to cache
-                    MetadataCache::SaveToCache(fullPath, displayData, false);
-                }
-            } catch (const std::exception& e) {
-                // Parsing failed - timestamp remains 0
-            }
+    ActivityDataModel::Period period = m_model->GetPeriod(row);
+    if (period.year == -1) {
+        wxTreeItemId unknown = FindChild(root, "Unknown");
+        if (unknown.IsOk()) {
+            GetNodeData(unknown)->count++;
+        } else {
+            NodeData* data = new NodeData();
+            data->level = 0;
+            data->count = 1;
+            data->populated = true;
+            InsertChild(root, "Unknown", data);
         }
+        return;
+    }
 
-        // Add to time tree if we have a valid timestamp
-        if (timestamp > 0) {
-            try {
-                // Convert FIT timestamp to UNIX timestamp using FIT SDK
-                fit::DateTime fitDateTime(timestamp);
-                wxDateTime activityTime(fitDateTime.GetTimeT());
-
-                // Build hierarchy keys
-                wxString year = wxString::Format("%d", activityTime.GetYear());
-                wxString month = wxString::Format("%02d - %s", activityTime.GetMonth() + 1,
-                                                activityTime.GetMonthName(activityTime.GetMonth()));
-                wxString day = wxString::Format("%02d", activityTime.GetDay());
-                wxString hour = wxString::Format("%02d:00", activityTime.GetHour());
-
-                // Add to time tree
-                timeTree[year][month][day][hour].push_back(displayPath);
-            } catch (const std::exception& e) {
-                // Fallback to Unknown
-                timeTree["Unknown"]["Unknown"]["Unknown"]["Unknown"].push_back(displayPath);
-            }
+    int granularity = m_timeGranularityChoice->GetSelection();
+
+    // Down to the first node that wasn't expanded yet, it lists its children when it is
+    wxTreeItemId node = root;
+    ActivityDataModel::Period nodePeriod;
+    for (int level = 0; level <= granularity && level < 4; ++level) {
+        NodeData* parentData = GetNodeData(node);
+        if (!parentData->populated) {
+            m_treeCtrl->SetItemHasChildren(node, true);
+            return;
+        }
+
+        switch (level) {
+            case 0: nodePeriod.year = period.year; break;
+            case 1: nodePeriod.month = period.month; break;
+            case 2: nodePeriod.day = period.day; break;
+            default: nodePeriod.hour = period.hour; break;
+        }
+
+        wxString text = FormatPeriodLevel(level, PeriodValue(period, level));
+        wxTreeItemId child = FindChild(node, text);
+        if (!child.IsOk()) {
+            NodeData* data = new NodeData();
+            data->period = nodePeriod;
+            data->level = level;
+            child = InsertChild(node, text, data);
+        }
+
+        auto range = m_model->FindPeriod(nodePeriod);
+        GetNodeData(child)->count = range.second - range.first;
+        node = child;
+    }
+}
+
+void FileTreePanel::PruneTimeNodes(wxTreeItemId parent) {
+    std::vector<wxTreeItemId> empty;
+
+    wxTreeItemIdValue cookie;
+    for (wxTreeItemId child = m_treeCtrl->GetFirstChild(parent, cookie); child.IsOk();
+         child = m_treeCtrl->GetNextChild(parent, cookie)) {
+        NodeData* data = GetNodeData(child);
+        if (!data) {
+            continue;
+        }
+
+        size_t count = 0;
+        if (data->period.year == -1) {
+            count = m_model->GetUndatedCount(); // "Unknown"
         } else {
-            // No valid timestamp - add to Unknown
-            timeTree["Unknown"]["Unknown"]["Unknown"]["Unknown"].push_back(displayPath);
+            auto range = m_model->FindPeriod(data->period);
+            count = range.second - range.first;
+        }
+
+        data->count = count;
+        if (count == 0) {
+            empty.push_back(child);
+        } else if (data->populated) {
+            PruneTimeNodes(child);
         }
-        
-        cont = dir.GetNext(&filename);
     }
-    
-    // Recursively scan subdirectories
-    cont = dir.GetFirst(&filename, "", wxDIR_DIRS);
-    while (cont) {
-        wxString subPath = path + wxFileName::GetPathSeparator() + filename;
-        wxString newRelativePath = relativePath.IsEmpty() ? filename : 
-                                 relativePath + wxFileName::GetPathSeparator() + filename;
-        ScanDirectoryForTimeHierarchy(subPath, newRelativePath, timeTree, granularity);
-        cont = dir.GetNext(&filename);
+
+    for (const auto& item : empty) {
+        m_treeCtrl->Delete(item);
     }
-}
\ No newline at end of file
+}
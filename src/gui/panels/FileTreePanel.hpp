@@ -6,14 +6,24 @@
 #endif
 #include <wx/treectrl.h>
 #include <wx/choice.h>
-#include <map>
+#include <set>
 #include <vector>
 #include "../interfaces/IFileOperations.hpp"
+#include "../interfaces/IActivityModelListener.hpp"
+#include "../models/ActivityDataModel.hpp"
 
-class FileTreePanel : public wxPanel, public IFileOperations {
+class FileTreePanel : public wxPanel, public IFileOperations, public IActivityModelListener {
 public:
-    FileTreePanel(wxWindow* parent);
-    virtual ~FileTreePanel() = default;
+    FileTreePanel(wxWindow* parent, ActivityDataModel* model);
+    virtual ~FileTreePanel();
+
+    // IActivityModelListener
+    void OnCatalogCleared() override;
+    void OnActivitiesAdded(size_t firstRow, size_t count) override;
+    void OnCatalogLoaded() override;
+    void OnActivityChanged(size_t row) override;
+    void OnActivityRemoved(size_t row) override;
+    void OnFolderChanged(const wxString& path) override;
 
 private:
     enum {
@@ -31,6 +41,7 @@ private:
     void OnViewModeChanged(wxCommandEvent& event);
     void OnTimeGranularityChanged(wxCommandEvent& event);
     void OnTreeItemSelected(wxTreeEvent& event);
+    void OnTreeItemExpanding(wxTreeEvent& event);
     void OnTreeRightClick(wxTreeEvent& event);
     void OnContextOpenFolder(wxCommandEvent& event);
     void OnSortClicked(wxCommandEvent& event);
@@ -40,25 +51,37 @@ public:
     wxString GetSelectedPath() const;
     
 private:
-    // Structure to store tree node information for sorting
-    struct TreeNodeInfo {
-        wxString text;
-        wxTreeItemId itemId;
-        std::vector<TreeNodeInfo> children;
+    // What a tree node stands for; its children are added when it is first expanded
+    struct NodeData : public wxTreeItemData {
+        wxString path;                      // Folder view: full path of the directory
+        ActivityDataModel::Period period;   // Time view: year -1 for the root and "Unknown"
+        int level = -1;                     // Time view: 0 = year .. 3 = hour, -1 for the root
+        size_t count = 0;                   // Time view: activities within the period
+        bool populated = false;
     };
-    
+
     void RebuildTree();
-    void SortTreeRecursively(wxTreeItemId item);
-    void BuildTimeHierarchy(wxTreeItemId root);
-    void BuildFolderHierarchy(wxTreeItemId parentItem, const wxString& path, int depth = 0);
-    void ScanDirectoryForTimeHierarchy(const wxString& path, const wxString& relativePath,
-        std::map<wxString, std::map<wxString, std::map<wxString, std::map<wxString, std::vector<wxString>>>>>& timeTree,
-        int granularity);
-    
-    // Helper methods for sorting with hierarchy preservation
-    void CopySubtree(wxTreeItemId source, TreeNodeInfo& nodeInfo);
-    void RecreateSubtree(wxTreeItemId parent, const TreeNodeInfo& nodeInfo);
+    void RebuildTree(const std::set<wxString>& expanded);
+    void CollectExpanded(wxTreeItemId item, const wxString& key, std::set<wxString>& expanded) const;
+    void RestoreExpanded(wxTreeItemId item, const wxString& key, const std::set<wxString>& expanded);
+
+    // Lazy population, children are sorted before they are inserted
+    NodeData* GetNodeData(wxTreeItemId item) const;
+    void ExpandNode(wxTreeItemId item);
+    void PopulateNode(wxTreeItemId item);
+    void PopulateFolder(wxTreeItemId item, NodeData* data);
+    void PopulateTime(wxTreeItemId item, NodeData* data);
+    void AppendUndatedNode(wxTreeItemId root, size_t count);
+
+    // Incremental updates of the tree while the directory is watched
+    static wxString FormatPeriodLevel(int level, int value);
+    static int PeriodValue(const ActivityDataModel::Period& period, int level);
+    wxTreeItemId FindChild(wxTreeItemId parent, const wxString& text) const;
+    wxTreeItemId InsertChild(wxTreeItemId parent, const wxString& text, NodeData* data);
+    void AddPeriodNodes(size_t row);
+    void PruneTimeNodes(wxTreeItemId parent);
 
+    ActivityDataModel* m_model; // Shared catalog, owned by MainFrame
     wxChoice* m_viewModeChoice;
     wxChoice* m_timeGranularityChoice;
     wxButton* m_sortButton;
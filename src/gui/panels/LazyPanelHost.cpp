@@ -0,0 +1,32 @@
+#include "LazyPanelHost.hpp"
+
+LazyPanelHost::LazyPanelHost(wxWindow* parent, Factory factory)
+    : wxPanel(parent, wxID_ANY),
+      m_factory(std::move(factory)),
+      m_panel(nullptr) {
+    SetSizer(new wxBoxSizer(wxVERTICAL));
+}
+
+IActivityPanel* LazyPanelHost::EnsureCreated() {
+    if (m_panel) {
+        return m_panel;
+    }
+
+    Created created = m_factory(this);
+    m_panel = created.panel;
+
+    GetSizer()->Add(created.window, 1, wxEXPAND);
+    Layout();
+    return m_panel;
+}
+
+void LazyPanelHost::OnTabActivated(const std::string& activityFilePath) {
+    EnsureCreated()->OnTabActivated(activityFilePath);
+}
+
+void LazyPanelHost::OnTabDeactivated() {
+    // A panel never shown has nothing to clean up
+    if (m_panel) {
+        m_panel->OnTabDeactivated();
+    }
+}
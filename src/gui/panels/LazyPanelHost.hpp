@@ -0,0 +1,49 @@
+#pragma once
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+#include <functional>
+#include "../interfaces/IActivityPanel.hpp"
+
+/**
+ * Notebook page that creates its real panel when the tab is first activated.
+ *
+ * Most tabs are never opened in a session, and some (the map, the editors) are
+ * expensive to set up, so the main frame adds hosts instead and the start-up only
+ * pays for the visible tab. Tab notifications are passed on to the hosted panel.
+ */
+class LazyPanelHost : public wxPanel, public IActivityPanel {
+public:
+    /**
+     * The created panel: its window and its tab interface, usually the same object.
+     */
+    struct Created {
+        wxWindow* window;
+        IActivityPanel* panel;
+    };
+
+    /**
+     * Creates the panel as a child of the given host. The caller owns the panel,
+     * it must be destroyed before the host.
+     */
+    using Factory = std::function<Created(wxWindow* host)>;
+
+    LazyPanelHost(wxWindow* parent, Factory factory);
+
+    bool IsCreated() const { return m_panel != nullptr; }
+
+    /**
+     * Create the hosted panel unless it exists already.
+     */
+    IActivityPanel* EnsureCreated();
+
+    // IActivityPanel
+    void OnTabActivated(const std::string& activityFilePath) override;
+    void OnTabDeactivated() override;
+
+private:
+    Factory m_factory;
+    IActivityPanel* m_panel;
+};
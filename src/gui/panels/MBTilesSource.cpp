@@ -0,0 +1,227 @@
+#include "MBTilesSource.hpp"
+#include <wx/image.h>
+#include <wx/log.h>
+#include <wx/mstream.h>
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+// Source tiles kept decoded, enough for the parents of a full screen of overzoomed tiles
+constexpr size_t DECODED_TILE_CACHE = 32;
+
+// Areas outside of the tile pack, OSM land colour
+constexpr unsigned char EMPTY_TILE_RGB[3] = {242, 239, 233};
+
+int QueryInt(sqlite3* db, const char* sql, int fallback) {
+    sqlite3_stmt* statement = nullptr;
+    int value = fallback;
+    if (sqlite3_prepare_v2(db, sql, -1, &statement, nullptr) == SQLITE_OK
+        && sqlite3_step(statement) == SQLITE_ROW
+        && sqlite3_column_type(statement, 0) != SQLITE_NULL) {
+        value = sqlite3_column_int(statement, 0);
+    }
+    sqlite3_finalize(statement);
+    return value;
+}
+
+} // namespace
+
+MBTilesSource::MBTilesSource(const std::string& path)
+    : m_db(nullptr), m_statement(nullptr), m_styleHash(0), m_minZoom(-1), m_maxZoom(-1) {
+
+    if (sqlite3_open_v2(path.c_str(), &m_db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        m_error = m_db ? sqlite3_errmsg(m_db) : "Out of memory";
+        return;
+    }
+
+    if (!readMetadata()) {
+        return;
+    }
+
+    if (sqlite3_prepare_v2(m_db,
+            "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?",
+            -1, &m_statement, nullptr) != SQLITE_OK) {
+        m_error = sqlite3_errmsg(m_db);
+        m_statement = nullptr;
+        return;
+    }
+
+    // Tiles are keyed by the pack's path and file state: a replaced pack never reuses old tiles
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : path) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (!ec) {
+        auto time = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+        hash ^= (static_cast<uint64_t>(size) * 0x9E3779B97F4A7C15ULL) ^ static_cast<uint64_t>(time);
+    }
+    m_styleHash = hash;
+}
+
+MBTilesSource::~MBTilesSource() {
+    sqlite3_finalize(m_statement);
+    sqlite3_close(m_db);
+}
+
+bool MBTilesSource::readMetadata() {
+    sqlite3_stmt* statement = nullptr;
+    if (sqlite3_prepare_v2(m_db, "SELECT name, value FROM metadata", -1, &statement, nullptr) != SQLITE_OK) {
+        m_error = std::string("Not an MBTiles file: ") + sqlite3_errmsg(m_db);
+        sqlite3_finalize(statement);
+        return false;
+    }
+
+    std::string format;
+    while (sqlite3_step(statement) == SQLITE_ROW) {
+        const char* name = reinterpret_cast<const char*>(sqlite3_column_text(statement, 0));
+        const char* value = reinterpret_cast<const char*>(sqlite3_column_text(statement, 1));
+        if (!name || !value) continue;
+
+        if (std::strcmp(name, "minzoom") == 0) {
+            m_minZoom = std::atoi(value);
+        } else if (std::strcmp(name, "maxzoom") == 0) {
+            m_maxZoom = std::atoi(value);
+        } else if (std::strcmp(name, "format") == 0) {
+            format = value;
+        }
+    }
+    sqlite3_finalize(statement);
+
+    if (format == "pbf") {
+        m_error = "Vector MBTiles are not supported, a raster (PNG or JPEG) tile pack is needed";
+        return false;
+    }
+
+    // Zoom range is optional metadata; MIN/MAX are answered from the tiles index
+    if (m_minZoom < 0) {
+        m_minZoom = QueryInt(m_db, "SELECT MIN(zoom_level) FROM tiles", 0);
+    }
+    if (m_maxZoom < 0) {
+        m_maxZoom = QueryInt(m_db, "SELECT MAX(zoom_level) FROM tiles", MAP_MAX_ZOOM);
+    }
+    m_minZoom = std::clamp(m_minZoom, 0, MAP_MAX_ZOOM);
+    m_maxZoom = std::clamp(m_maxZoom, m_minZoom, MAP_MAX_ZOOM);
+
+    return true;
+}
+
+MapTilePtr MBTilesSource::renderTile(int z, int x, int y) {
+    if (!isValid()) {
+        return nullptr;
+    }
+
+    if (z < m_minZoom) {
+        return emptyTile();
+    }
+
+    if (z <= m_maxZoom) {
+        MapTilePtr tile = sourceTile(z, x, y);
+        return tile ? tile : emptyTile();
+    }
+
+    // Deeper than the pack: upscale the matching part of the deepest tile
+    int dz = z - m_maxZoom;
+    MapTilePtr parent = sourceTile(m_maxZoom, x >> dz, y >> dz);
+    if (!parent) {
+        return emptyTile();
+    }
+
+    int span = std::max(1, parent->size >> dz);
+    int sub_x = (x & ((1 << dz) - 1)) * parent->size >> dz;
+    int sub_y = (y & ((1 << dz) - 1)) * parent->size >> dz;
+
+    // Static data: wraps the shared pixels without copying, GetSubImage() copies the part
+    wxImage parentImage(parent->size, parent->size, const_cast<unsigned char*>(parent->rgb.data()), true);
+    wxImage part = parentImage.GetSubImage(wxRect(sub_x, sub_y, span, span))
+                              .Scale(MAP_TILE_SIZE, MAP_TILE_SIZE, wxIMAGE_QUALITY_BILINEAR);
+
+    auto tile = std::make_shared<MapTileImage>(MAP_TILE_SIZE);
+    std::memcpy(tile->rgb.data(), part.GetData(), tile->rgb.size());
+    return tile;
+}
+
+MapTilePtr MBTilesSource::sourceTile(int z, int x, int y) {
+    for (auto it = m_decoded.begin(); it != m_decoded.end(); ++it) {
+        if (it->z == z && it->x == x && it->y == y) {
+            m_decoded.splice(m_decoded.begin(), m_decoded, it);
+            return it->tile;
+        }
+    }
+
+    // MBTiles rows follow the TMS scheme, counted from the south
+    int row = MapProjection::TileCount(z) - 1 - y;
+
+    MapTilePtr tile;
+    sqlite3_reset(m_statement);
+    sqlite3_bind_int(m_statement, 1, z);
+    sqlite3_bind_int(m_statement, 2, x);
+    sqlite3_bind_int(m_statement, 3, row);
+
+    if (sqlite3_step(m_statement) == SQLITE_ROW) {
+        tile = decodeTile(sqlite3_column_blob(m_statement, 0), sqlite3_column_bytes(m_statement, 0));
+    }
+    sqlite3_reset(m_statement);
+
+    // Missing tiles are remembered as well, so empty areas aren't looked up again
+    m_decoded.push_front(DecodedTile{z, x, y, tile});
+    if (m_decoded.size() > DECODED_TILE_CACHE) {
+        m_decoded.pop_back();
+    }
+
+    return tile;
+}
+
+MapTilePtr MBTilesSource::decodeTile(const void* data, int size) const {
+    if (!data || size <= 0) {
+        return nullptr;
+    }
+
+    wxLogNull noLog; // Corrupt tiles are shown as empty, not as error popups
+    wxMemoryInputStream stream(data, size);
+    wxImage image;
+    if (!image.LoadFile(stream, wxBITMAP_TYPE_ANY)) {
+        return nullptr;
+    }
+
+    // 512 px "retina" packs and other sizes are scaled to the tile grid
+    if (image.GetWidth() != MAP_TILE_SIZE || image.GetHeight() != MAP_TILE_SIZE) {
+        image.Rescale(MAP_TILE_SIZE, MAP_TILE_SIZE, wxIMAGE_QUALITY_BILINEAR);
+    }
+
+    auto tile = std::make_shared<MapTileImage>(MAP_TILE_SIZE);
+    const unsigned char* src = image.GetData();
+    unsigned char* dst = tile->rgb.data();
+
+    if (!image.HasAlpha()) {
+        std::memcpy(dst, src, tile->rgb.size());
+        return tile;
+    }
+
+    // Flatten onto white: tiles are stored without alpha
+    const unsigned char* alpha = image.GetAlpha();
+    const size_t pixels = static_cast<size_t>(MAP_TILE_SIZE) * MAP_TILE_SIZE;
+    for (size_t i = 0; i < pixels; ++i, src += 3, dst += 3) {
+        unsigned int a = alpha[i];
+        dst[0] = static_cast<unsigned char>((src[0] * a + 255 * (255 - a)) / 255);
+        dst[1] = static_cast<unsigned char>((src[1] * a + 255 * (255 - a)) / 255);
+        dst[2] = static_cast<unsigned char>((src[2] * a + 255 * (255 - a)) / 255);
+    }
+    return tile;
+}
+
+MapTilePtr MBTilesSource::emptyTile() const {
+    auto tile = std::make_shared<MapTileImage>(MAP_TILE_SIZE);
+    for (size_t i = 0; i < tile->rgb.size(); i += 3) {
+        tile->rgb[i] = EMPTY_TILE_RGB[0];
+        tile->rgb[i + 1] = EMPTY_TILE_RGB[1];
+        tile->rgb[i + 2] = EMPTY_TILE_RGB[2];
+    }
+    return tile;
+}
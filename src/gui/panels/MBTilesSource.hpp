@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include "MapTiles.hpp"
+#include "../interfaces/IMapTileSource.hpp"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/**
+ * Raster tiles from a local MBTiles file (SQLite database of PNG/JPEG tiles).
+ *
+ * A pre-rendered tile pack needs neither Mapnik nor OSM data and every tile is a
+ * single indexed lookup. MBTiles stores rows in TMS order, so y is flipped on lookup.
+ * Zoom levels above the pack's maxzoom are served by upscaling the matching part
+ * of the deepest available tile; recently decoded source tiles are kept so one
+ * parent tile is decoded only once for all of its children.
+ *
+ * The connection is opened read-only and belongs to the thread using the instance.
+ */
+class MBTilesSource : public IMapTileSource {
+public:
+    explicit MBTilesSource(const std::string& path);
+    ~MBTilesSource() override;
+
+    MBTilesSource(const MBTilesSource&) = delete;
+    MBTilesSource& operator=(const MBTilesSource&) = delete;
+
+    bool isValid() const override { return m_statement != nullptr; }
+    uint64_t styleHash() const override { return m_styleHash; }
+    MapTilePtr renderTile(int z, int x, int y) override;
+
+    // Tiles are read from local storage already
+    bool persistTiles() const override { return false; }
+
+    // Reason the file could not be opened, empty if valid
+    const std::string& error() const { return m_error; }
+
+    int minZoom() const { return m_minZoom; }
+    int maxZoom() const { return m_maxZoom; }
+
+private:
+    struct DecodedTile {
+        int z, x, y;
+        MapTilePtr tile;
+    };
+
+    bool readMetadata();
+    MapTilePtr sourceTile(int z, int x, int y);
+    MapTilePtr decodeTile(const void* data, int size) const;
+    MapTilePtr emptyTile() const;
+
+    sqlite3* m_db;
+    sqlite3_stmt* m_statement;
+    std::string m_error;
+    uint64_t m_styleHash;
+    int m_minZoom, m_maxZoom;
+
+    // Recently decoded source tiles, most recent first
+    std::list<DecodedTile> m_decoded;
+};
@@ -1,22 +1,33 @@
 #include "MapPanel.hpp"
 #include "MapRenderer.hpp"
+#include "MBTilesSource.hpp"
+#include "MapTileCache.hpp"
+#include "MapTileWorker.hpp"
 #include "utils/SettingsManager.hpp"
 #include "utils/DataDirectoryResolver.hpp"
-#include "parsers/coordinates-scanner.hpp"
-#include "parsers/binary-mapper.hpp"
+#include "utils/ParsedFileCache.hpp"
+#include "utils/JobScheduler.hpp"
+#include "trace/trace.hpp"
 #include <wx/msgdlg.h>
 #include <wx/menu.h>
-#include <wx/progdlg.h>
+#include <wx/dcbuffer.h>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 
+// Tiles kept in memory, 256 tiles of 256x256 RGB is about 48 MiB
+constexpr size_t MAP_TILE_MEMORY_CACHE = 256;
+
 enum {
     ID_ZOOM_IN = 3000,
     ID_ZOOM_OUT,
     ID_ZOOM_TO_TRACK,
-    ID_RESET_VIEW
+    ID_RESET_VIEW,
+    ID_CANCEL_EXTRACT
 };
 
 wxBEGIN_EVENT_TABLE(MapPanel, wxPanel)
@@ -32,15 +43,26 @@ wxEND_EVENT_TABLE()
 MapPanel::MapPanel(wxWindow* parent)
     : wxPanel(parent, wxID_ANY),
       m_osmLoaded(false),
+      m_mapInitialized(false),
+      m_styleHash(0),
+      m_tileGeneration(0),
+      m_extractSuspended(false),
+      m_extractProgress(0.0),
       m_cacheValid(false),
+      m_previousOriginX(0),
+      m_previousOriginY(0),
+      m_previousZoom(-1),
+      m_projectedZoom(-1),
       m_centerLat(54.9),
       m_centerLon(23.9),
-      m_zoomLevel(10.0),
+      m_zoomLevel(10),
       m_dragging(false),
       m_renderPending(false),
+      m_composePending(false),
       m_lastRenderTime(0) {
 
     SetBackgroundColour(*wxWHITE);
+    SetBackgroundStyle(wxBG_STYLE_PAINT);
 
     // Load map data path from settings
     SettingsManager& settings = SettingsManager::Instance();
@@ -57,12 +79,31 @@ MapPanel::MapPanel(wxWindow* parent)
         }
     }
 
-    // Initialize renderer as nullptr - will be created on demand
-    m_renderer = nullptr;
+    // The map source is opened on first render
+    m_tileCache = std::make_unique<MapTileCache>(MAP_TILE_MEMORY_CACHE, MapTileCache::DefaultDirectory());
+    m_tileWorker = std::make_unique<MapTileWorker>(*m_tileCache, [this](uint64_t generation) {
+        // Worker thread: hand over to the UI thread
+        CallAfter([this, generation]() { OnTileReady(generation); });
+    });
+
+    m_extractor = std::make_unique<OsmRegionExtractor>(
+        [this](double fraction, const wxString& status) {
+            m_extractProgress = fraction;
+            m_extractStatus = status;
+            Refresh();
+        },
+        [this](bool success, const std::string& sqlite_path) {
+            OnExtractFinished(success, sqlite_path);
+        });
 }
 
 MapPanel::~MapPanel() {
-    // Smart pointers will handle cleanup
+    // Smart pointers will handle the rest; the extractor kills a running ogr2ogr
+    StopArchiveScan();
+    m_trackJob.Cancel();
+    for (auto& job : m_prefetchJobs) {
+        job.Cancel();
+    }
 }
 
 void MapPanel::OnTabActivated(const std::string& activityFilePath) {
@@ -80,100 +121,104 @@ void MapPanel::OnTabDeactivated() {
 void MapPanel::SetTrack(const std::vector<GPSPoint>& track, const std::string& activityName) {
     m_currentTrack = track;
     m_activityName = activityName;
+    m_projectedZoom = -1;
     
     InvalidateCache();
     
     if (!track.empty()) {
         ZoomToTrack();
+        // Activities from a new area get their map region extracted right away
+        UpdateExtract();
     }
     
     Refresh();
 }
 
 void MapPanel::LoadTrack(const std::string& fitFilePath) {
-    try {
-        // Use the pattern from MapRenderer.cpp
-        std::vector<int32_t> latitudes, longitudes;
-        
-        darauble::BinaryMapper mapper{std::filesystem::path(fitFilePath)};
-        darauble::CoordinatesScanner scanner{mapper, FIT_SPORT_ALL, latitudes, longitudes};
-        scanner.scan();
-        
-        // Convert to GPSPoint vector
+    // Extract activity name from file path (just filename without extension)
+    std::string activityName = fitFilePath;
+    size_t lastSlash = activityName.find_last_of("/\\");
+    if (lastSlash != std::string::npos) {
+        activityName = activityName.substr(lastSlash + 1);
+    }
+    size_t lastDot = activityName.find_last_of(".");
+    if (lastDot != std::string::npos) {
+        activityName = activityName.substr(0, lastDot);
+    }
+
+    // Parsed once for all panels on a worker; a newer selection supersedes this one
+    struct Result {
         std::vector<GPSPoint> track;
-        track.reserve(latitudes.size());
-        
-        for (size_t i = 0; i < latitudes.size() && i < longitudes.size(); ++i) {
-            if (latitudes[i] != FIT_SINT32_INVALID && longitudes[i] != FIT_SINT32_INVALID) {
-                GPSPoint point;
-                point.latitude = latitudes[i] / 11930464.7111; // Convert from semicircles to degrees
-                point.longitude = longitudes[i] / 11930464.7111;
-                track.push_back(point);
+        bool loaded = false;
+    };
+    auto result = std::make_shared<Result>();
+
+    m_trackJob = JobScheduler::Instance().Submit(JobLane::Interactive,
+        [fitFilePath, result](JobContext& job) {
+            if (job.IsCancelled()) return;
+            try {
+                result->track = TrackPoints(ParsedFileCache::Instance().Get(fitFilePath)->GetTrack());
+                result->loaded = true;
+            } catch (const std::exception& e) {
+                // Handled on the UI thread - clear track
             }
-        }
-        
-        // Extract activity name from file path (just filename without extension)
-        std::string activityName = fitFilePath;
-        size_t lastSlash = activityName.find_last_of("/\\");
-        if (lastSlash != std::string::npos) {
-            activityName = activityName.substr(lastSlash + 1);
-        }
-        size_t lastDot = activityName.find_last_of(".");
-        if (lastDot != std::string::npos) {
-            activityName = activityName.substr(0, lastDot);
-        }
-        
-        SetTrack(track, activityName);
-    } catch (const std::exception& e) {
-        // Handle error - clear track
-        ClearMap();
-    }
+        },
+        [this, result, activityName]() {
+            if (result->loaded) {
+                SetTrack(result->track, activityName);
+            } else {
+                ClearMap();
+            }
+        },
+        {}, "map-track");
 }
 
 void MapPanel::SetOSMFile(const std::string& stylesheet_path) {
     if (m_osmFilePath == stylesheet_path) return; // No change
 
     m_osmFilePath = stylesheet_path;
-    m_osmLoaded = false;
+    m_extractor->Abort();
+    m_extractSuspended = false;
+    StopTileSource();
 
     // Save to settings
     SettingsManager& settings = SettingsManager::Instance();
     settings.SetString("map_osm_file", stylesheet_path);
 
-    // Check if this is a PBF file - if so, trigger conversion check
-    if (stylesheet_path.ends_with(".pbf") || stylesheet_path.ends_with(".osm.pbf")) {
-        // This is a PBF file, need to convert to Spatialite
-        CheckAndConvertPBFToSpatialite(stylesheet_path);
-        return; // CheckAndConvertPBFToSpatialite handles initialization
-    }
-
-    // Check if this is a Spatialite file - generate stylesheet for it
-    if (stylesheet_path.ends_with(".sqlite")) {
-        std::string generated_stylesheet = GenerateStylesheetForSpatialite(stylesheet_path);
-        if (!generated_stylesheet.empty() && m_renderer) {
-            m_osmLoaded = m_renderer->initialize(generated_stylesheet);
-            InvalidateCache();
-            if (HasTrack()) {
-                CallAfter([this]() { RenderMap(); });
-            }
-        }
-        return;
+    if (IsPbfSource()) {
+        // PBF regions around the archived activities are extracted to Spatialite
+        StartArchiveScan();
+    } else if (!stylesheet_path.ends_with(".sqlite") && !stylesheet_path.ends_with(".mbtiles")) {
+        // Otherwise assume it's a stylesheet XML file - use it directly
+        settings.SetString("map_stylesheet", stylesheet_path);
     }
 
-    // Otherwise assume it's a stylesheet XML file - use it directly
-    settings.SetString("map_stylesheet", stylesheet_path);
-    if (m_renderer) {
-        m_osmLoaded = m_renderer->initialize(stylesheet_path);
+    if (m_mapInitialized) {
+        OpenMapSource();
         InvalidateCache();
 
         if (HasTrack()) {
             CallAfter([this]() { RenderMap(); });
         }
+    } else if (IsPbfSource()) {
+        // Start extracting without waiting for the map tab to be shown
+        CheckAndConvertPBFToSpatialite(stylesheet_path);
+    }
+}
+
+void MapPanel::SetArchiveDirectory(const std::string& directory) {
+    m_archiveDirectory = directory;
+    m_extractSuspended = false;
+
+    // Activity bounds are only needed to extract regions from a PBF
+    if (IsPbfSource()) {
+        StartArchiveScan();
     }
 }
 
 void MapPanel::ClearMap() {
     m_currentTrack.clear();
+    m_projectedTrack.clear();
     m_activityName.clear();
     InvalidateCache();
     Refresh();
@@ -182,46 +227,94 @@ void MapPanel::ClearMap() {
 void MapPanel::ZoomToTrack() {
     if (m_currentTrack.empty()) return;
 
-    BoundingBox bounds = CalculateTrackBounds();
-    if (!bounds.isValid()) return;
+    if (!FitFrame(CalculateTrackBounds(), GetSize(), m_zoomLevel, m_centerLat, m_centerLon)) return;
+
+    InvalidateCache();
+    RenderMap();
+}
+
+bool MapPanel::FitFrame(BoundingBox bounds, const wxSize& size, int& zoom, double& center_lat, double& center_lon) {
+    if (!bounds.isValid()) return false;
 
     bounds.addPadding(0.15); // 15% padding
 
-    m_centerLat = (bounds.min_lat + bounds.max_lat) / 2.0;
-    m_centerLon = (bounds.min_lon + bounds.max_lon) / 2.0;
+    // Pick the deepest zoom level at which the padded track still fits the panel
+    zoom = MAP_MIN_ZOOM;
+    if (size.x > 0 && size.y > 0) {
+        for (int z = MAP_MAX_ZOOM; z >= MAP_MIN_ZOOM; --z) {
+            double width_px = MapProjection::LonToWorldX(bounds.max_lon, z) - MapProjection::LonToWorldX(bounds.min_lon, z);
+            double height_px = MapProjection::LatToWorldY(bounds.min_lat, z) - MapProjection::LatToWorldY(bounds.max_lat, z);
+            if (width_px <= size.x && height_px <= size.y) {
+                zoom = z;
+                break;
+            }
+        }
+    }
+
+    // Center in projected space so the track is centered on screen, not in degrees
+    double center_x = (MapProjection::LonToWorldX(bounds.min_lon, zoom) + MapProjection::LonToWorldX(bounds.max_lon, zoom)) / 2.0;
+    double center_y = (MapProjection::LatToWorldY(bounds.min_lat, zoom) + MapProjection::LatToWorldY(bounds.max_lat, zoom)) / 2.0;
+    center_lon = MapProjection::WorldXToLon(center_x, zoom);
+    center_lat = MapProjection::WorldYToLat(center_y, zoom);
+    return true;
+}
 
-    // Calculate zoom level to fit bounds
+void MapPanel::PrefetchTrack(const std::string& fitFilePath) {
     wxSize size = GetSize();
-    if (size.x > 0 && size.y > 0) {
-        // Calculate the required scale to fit the track
-        double width_deg = bounds.max_lon - bounds.min_lon;
-        double height_deg = bounds.max_lat - bounds.min_lat;
+    if (!m_mapInitialized || !IsTileMode() || size.x <= 0 || size.y <= 0) return;
+
+    // The frame and its tiles are worked out on a worker: the file may have been
+    // dropped from the cache or changed since it was prefetched, and is parsed again
+    auto tiles = std::make_shared<std::vector<TileKey>>();
+    uint64_t styleHash = m_styleHash;
+
+    std::erase_if(m_prefetchJobs, [](const JobHandle& job) { return job.IsFinished(); });
+    m_prefetchJobs.push_back(JobScheduler::Instance().Submit(JobLane::Bulk,
+        [fitFilePath, size, styleHash, tiles](JobContext& job) {
+            if (job.IsCancelled()) return;
+
+            std::vector<GPSPoint> track;
+            try {
+                track = TrackPoints(ParsedFileCache::Instance().Get(fitFilePath)->GetTrack());
+            } catch (const std::exception& e) {
+                return;
+            }
 
-        // Avoid division by zero
-        if (width_deg <= 0) width_deg = 0.001;
-        if (height_deg <= 0) height_deg = 0.001;
+            // The frame ZoomToTrack() will show when the activity is selected
+            int zoom;
+            double center_lat, center_lon;
+            if (!FitFrame(TrackBounds(track), size, zoom, center_lat, center_lon)) return;
 
-        // Calculate zoom level based on degrees per pixel
-        // zoom_level * 111000 = pixels per degree (approximately)
-        double zoom_x = size.x / (width_deg * 111000.0);
-        double zoom_y = size.y / (height_deg * 111000.0);
+            const double origin_x = MapProjection::LonToWorldX(center_lon, zoom) - size.x / 2.0;
+            const double origin_y = MapProjection::LatToWorldY(center_lat, zoom) - size.y / 2.0;
+            const int tile_count = MapProjection::TileCount(zoom);
 
-        m_zoomLevel = std::min(zoom_x, zoom_y);
-        m_zoomLevel = std::max(0.000001, std::min(1.0, m_zoomLevel));
-    }
+            for (int ty = static_cast<int>(std::floor(origin_y / MAP_TILE_SIZE)); ty * MAP_TILE_SIZE < origin_y + size.y; ++ty) {
+                if (ty < 0 || ty >= tile_count) continue;
 
-    InvalidateCache();
-    RenderMap();
+                for (int tx = static_cast<int>(std::floor(origin_x / MAP_TILE_SIZE)); tx * MAP_TILE_SIZE < origin_x + size.x; ++tx) {
+                    tiles->push_back(TileKey{styleHash, zoom, MapProjection::WrapTileX(tx, zoom), ty});
+                }
+            }
+        },
+        [this, tiles, styleHash]() {
+            // Tiles of a style replaced meanwhile are not wanted anymore
+            if (m_tileWorker && styleHash == m_styleHash && !tiles->empty()) {
+                m_tileWorker->Prefetch(*tiles);
+            }
+        }));
 }
 
 void MapPanel::ZoomIn() {
-    m_zoomLevel *= 1.5;
+    if (m_zoomLevel >= MAP_MAX_ZOOM) return;
+    m_zoomLevel++;
     InvalidateCache();
     RenderMap();
 }
 
 void MapPanel::ZoomOut() {
-    m_zoomLevel /= 1.5;
+    if (m_zoomLevel <= MAP_MIN_ZOOM) return;
+    m_zoomLevel--;
     InvalidateCache();
     RenderMap();
 }
@@ -232,17 +325,20 @@ void MapPanel::ResetView() {
     } else {
         m_centerLat = 0.0;
         m_centerLon = 0.0;
-        m_zoomLevel = 1.0;
+        m_zoomLevel = MAP_MIN_ZOOM;
         InvalidateCache();
         RenderMap();
     }
 }
 
 void MapPanel::OnPaint(wxPaintEvent& event) {
-    wxPaintDC dc(this);
-    
+    GFU_TRACE_SCOPE("map.paint", "render");
+    wxAutoBufferedPaintDC dc(this);
+
     if (m_cachedBitmap.IsOk()) {
         dc.DrawBitmap(m_cachedBitmap, 0, 0);
+        DrawOverlays(dc);
+        DrawExtractProgress(dc);
     } else {
         // No cached bitmap - render on demand
         dc.SetBackground(*wxLIGHT_GREY_BRUSH);
@@ -289,22 +385,24 @@ void MapPanel::OnMouseMove(wxMouseEvent& event) {
         wxPoint currentPos = event.GetPosition();
         wxPoint delta = currentPos - m_lastMousePos;
 
-        // Convert screen delta to degrees
-        double degrees_per_pixel = 1.0 / (m_zoomLevel * 111000.0);
+        // Move the center in world pixels (drag right = pan left)
+        double center_x = MapProjection::LonToWorldX(m_centerLon, m_zoomLevel) - delta.x;
+        double center_y = MapProjection::LatToWorldY(m_centerLat, m_zoomLevel) - delta.y;
+        double world_size = MapProjection::WorldSize(m_zoomLevel);
 
-        // Apply delta (negative for x because drag right = pan left)
-        m_centerLon -= delta.x * degrees_per_pixel;
-        m_centerLat += delta.y * degrees_per_pixel; // Positive because screen Y is inverted
+        center_x = std::fmod(std::fmod(center_x, world_size) + world_size, world_size);
+        center_y = std::clamp(center_y, 0.0, world_size);
 
-        m_lastMousePos = currentPos;
+        m_centerLon = MapProjection::WorldXToLon(center_x, m_zoomLevel);
+        m_centerLat = MapProjection::WorldYToLat(center_y, m_zoomLevel);
 
-        InvalidateCache();
+        m_lastMousePos = currentPos;
 
-        // Throttle rendering during drag - only render if not already pending
+        // Throttle rendering during drag - only shift if not already pending
         if (!m_renderPending) {
             m_renderPending = true;
             CallAfter([this]() {
-                RenderMap();
+                ShiftFrame();
                 m_renderPending = false;
             });
         }
@@ -317,6 +415,10 @@ void MapPanel::OnMouseUp(wxMouseEvent& event) {
         if (HasCapture()) {
             ReleaseMouse();
         }
+
+        // Commit a full frame: exact tile alignment and prefetch of the new neighbourhood
+        InvalidateCache();
+        RenderMap();
     }
 }
 
@@ -331,6 +433,11 @@ void MapPanel::OnRightClick(wxMouseEvent& event) {
     contextMenu.Append(ID_ZOOM_IN, "Zoom In");
     contextMenu.Append(ID_ZOOM_OUT, "Zoom Out");
     contextMenu.Append(ID_RESET_VIEW, "Reset View");
+
+    if (m_extractor->IsRunning()) {
+        contextMenu.AppendSeparator();
+        contextMenu.Append(ID_CANCEL_EXTRACT, "Cancel Map Extract");
+    }
     
     contextMenu.Bind(wxEVT_COMMAND_MENU_SELECTED, [this](wxCommandEvent& evt) {
         switch (evt.GetId()) {
@@ -338,6 +445,7 @@ void MapPanel::OnRightClick(wxMouseEvent& event) {
             case ID_ZOOM_OUT: ZoomOut(); break;
             case ID_ZOOM_TO_TRACK: ZoomToTrack(); break;
             case ID_RESET_VIEW: ResetView(); break;
+            case ID_CANCEL_EXTRACT: m_extractor->Cancel(); break;
         }
     });
     
@@ -348,97 +456,415 @@ void MapPanel::RenderMap() {
     wxSize size = GetSize();
     if (size.x <= 0 || size.y <= 0) return;
 
-    // Show busy cursor during rendering
-    wxBusyCursor wait;
+    // Open the map source on first render
+    if (!m_mapInitialized) {
+        m_mapInitialized = true;
+        OpenMapSource();
+    }
 
-    // Create and initialize renderer if needed
-    if (!m_renderer) {
-        m_renderer = std::make_unique<MapnikRenderer>(size.x, size.y);
+    if (!IsTileMode()) {
+        // Fallback to track-only rendering
+        RenderTrackOnly();
+        return;
+    }
+
+    double origin_x, origin_y;
+    GetViewOrigin(size, origin_x, origin_y);
+
+    // Background only - the track and the scale indicator are drawn in OnPaint.
+    // Missing tiles are rendered by the worker and composed in as they arrive.
+    m_cachedBitmap = ComposeTiles(size, static_cast<int>(std::lround(origin_x)), static_cast<int>(std::lround(origin_y)));
+    m_cacheValid = true;
+
+    Refresh();
+    Update();
+}
+
+bool MapPanel::OpenMapSource() {
+    if (m_osmFilePath.empty()) return false;
+
+    if (IsPbfSource()) {
+        // Loads the extracted regions and extracts missing ones in the background
+        return CheckAndConvertPBFToSpatialite(m_osmFilePath);
+    }
+
+    if (m_osmFilePath.ends_with(".mbtiles")) {
+        return LoadMBTiles(m_osmFilePath);
+    }
+
+    if (m_osmFilePath.ends_with(".sqlite")) {
+        std::string generated_stylesheet = GenerateStylesheetForSpatialite(m_osmFilePath);
+        return !generated_stylesheet.empty() && LoadStylesheet(generated_stylesheet, m_osmFilePath);
+    }
+
+    if (!LoadStylesheet(m_osmFilePath)) {
+        wxLogError("Failed to load Mapnik stylesheet from: %s", m_osmFilePath);
+        return false;
+    }
+    return true;
+}
+
+bool MapPanel::LoadStylesheet(const std::string& stylesheet_path, const std::string& data_path) {
+    namespace fs = std::filesystem;
 
-        // Initialize with stylesheet if available
-        if (!m_osmFilePath.empty()) {
-            // Check if this is a PBF file that needs conversion
-            if (m_osmFilePath.ends_with(".pbf") || m_osmFilePath.ends_with(".osm.pbf")) {
-                // Trigger conversion check (this will initialize the renderer if successful)
-                CheckAndConvertPBFToSpatialite(m_osmFilePath);
+    auto renderer = std::make_unique<MapnikRenderer>(MAP_TILE_SIZE, MAP_TILE_SIZE);
+    if (!renderer->initialize(stylesheet_path)) {
+        StopTileSource();
+        return false;
+    }
+
+    // Tiles are keyed by stylesheet contents and by the state of the map data,
+    // so regenerated Spatialite data never reuses tiles of the old one
+    uint64_t style_hash = renderer->styleHash();
+    std::error_code ec;
+    fs::path data_file = data_path.empty() ? fs::path(stylesheet_path) : fs::path(data_path);
+    auto data_size = fs::file_size(data_file, ec);
+    if (!ec) {
+        auto data_time = fs::last_write_time(data_file, ec).time_since_epoch().count();
+        style_hash ^= (static_cast<uint64_t>(data_size) * 0x9E3779B97F4A7C15ULL) ^ static_cast<uint64_t>(data_time);
+    }
+
+    StartTileSource(std::move(renderer), style_hash, [stylesheet_path]() -> std::unique_ptr<IMapTileSource> {
+        auto worker_renderer = std::make_unique<MapnikRenderer>(MAP_TILE_SIZE, MAP_TILE_SIZE);
+        if (!worker_renderer->initialize(stylesheet_path)) {
+            return nullptr;
+        }
+        return worker_renderer;
+    });
+    return true;
+}
+
+bool MapPanel::LoadMBTiles(const std::string& mbtiles_path) {
+    auto source = std::make_unique<MBTilesSource>(mbtiles_path);
+    if (!source->isValid()) {
+        wxLogError("Failed to open MBTiles file %s: %s", mbtiles_path, source->error());
+        StopTileSource();
+        return false;
+    }
+
+    uint64_t style_hash = source->styleHash();
+    StartTileSource(std::move(source), style_hash, [mbtiles_path]() -> std::unique_ptr<IMapTileSource> {
+        return std::make_unique<MBTilesSource>(mbtiles_path);
+    });
+    return true;
+}
+
+void MapPanel::StartTileSource(std::unique_ptr<IMapTileSource> source, uint64_t style_hash,
+                               MapTileWorker::TileSourceFactory create_worker_source) {
+    m_tileSource = std::move(source);
+    m_styleHash = style_hash;
+    m_osmLoaded = true;
+
+    m_tileCache->ClearMemory();
+    m_previousFrame = wxBitmap();
+    m_tileWorker->Start(std::move(create_worker_source));
+}
+
+void MapPanel::StopTileSource() {
+    m_tileWorker->Stop();
+    m_tileSource.reset();
+    m_osmLoaded = false;
+}
+
+bool MapPanel::IsTileMode() const {
+    return m_tileSource && m_tileSource->isValid();
+}
+
+void MapPanel::GetViewOrigin(const wxSize& size, double& origin_x, double& origin_y) const {
+    origin_x = MapProjection::LonToWorldX(m_centerLon, m_zoomLevel) - size.x / 2.0;
+    origin_y = MapProjection::LatToWorldY(m_centerLat, m_zoomLevel) - size.y / 2.0;
+}
+
+namespace {
+
+// Copy a tile into the viewport image at (dst_x, dst_y), clipping to the image
+void BlitTile(const MapTileImage& tile, int dst_x, int dst_y, wxImage& image) {
+    const int width = image.GetWidth();
+    const int height = image.GetHeight();
+
+    int src_x = std::max(0, -dst_x);
+    int src_y = std::max(0, -dst_y);
+    int copy_w = std::min(tile.size - src_x, width - std::max(0, dst_x));
+    int copy_h = std::min(tile.size - src_y, height - std::max(0, dst_y));
+    if (copy_w <= 0 || copy_h <= 0) return;
+
+    unsigned char* dst = image.GetData();
+    for (int row = 0; row < copy_h; ++row) {
+        const unsigned char* src_row = tile.rgb.data() + ((src_y + row) * tile.size + src_x) * 3;
+        unsigned char* dst_row = dst + ((std::max(0, dst_y) + row) * width + std::max(0, dst_x)) * 3;
+        std::memcpy(dst_row, src_row, copy_w * 3);
+    }
+}
+
+} // namespace
+
+wxBitmap MapPanel::ComposeTiles(const wxSize& size, int origin_x, int origin_y) {
+    wxImage image = PreviousFrameImage(size, origin_x, origin_y);
+
+    const int tile_count = MapProjection::TileCount(m_zoomLevel);
+    const int first_x = static_cast<int>(std::floor(origin_x / static_cast<double>(MAP_TILE_SIZE)));
+    const int first_y = static_cast<int>(std::floor(origin_y / static_cast<double>(MAP_TILE_SIZE)));
+    const int last_x = static_cast<int>(std::floor((origin_x + size.x - 1) / static_cast<double>(MAP_TILE_SIZE)));
+    const int last_y = static_cast<int>(std::floor((origin_y + size.y - 1) / static_cast<double>(MAP_TILE_SIZE)));
+
+    // Only tiles already in memory are used here; everything else goes to the worker
+    std::vector<TileKey> missing;
+    m_missingTiles.clear();
+    for (int ty = first_y; ty <= last_y; ++ty) {
+        if (ty < 0 || ty >= tile_count) continue;
+
+        for (int tx = first_x; tx <= last_x; ++tx) {
+            TileKey key{m_styleHash, m_zoomLevel, MapProjection::WrapTileX(tx, m_zoomLevel), ty};
+
+            if (MapTilePtr tile = m_tileCache->GetFromMemory(key)) {
+                BlitTile(*tile, tx * MAP_TILE_SIZE - origin_x, ty * MAP_TILE_SIZE - origin_y, image);
             } else {
-                m_osmLoaded = m_renderer->initialize(m_osmFilePath);
-                if (!m_osmLoaded) {
-                    wxLogError("Failed to load Mapnik stylesheet from: %s", m_osmFilePath);
-                }
+                missing.push_back(key);
+                m_missingTiles.push_back(MissingTile{key, tx * MAP_TILE_SIZE, ty * MAP_TILE_SIZE});
             }
         }
-    } else {
-        // Update size if changed
-        m_renderer->setSize(size.x, size.y);
     }
 
-    if (!m_renderer->isValid()) {
-        // Fallback to track-only rendering
-        RenderTrackOnly();
+    m_tileGeneration = m_tileWorker->Request(missing, NeighbourRing(first_x, first_y, last_x, last_y));
+
+    wxBitmap bitmap(image);
+    m_previousFrame = bitmap;
+    m_previousOriginX = origin_x;
+    m_previousOriginY = origin_y;
+    m_previousZoom = m_zoomLevel;
+
+    return bitmap;
+}
+
+wxImage MapPanel::PreviousFrameImage(const wxSize& size, int origin_x, int origin_y) {
+    wxBitmap frame(size.x, size.y, 24);
+    wxMemoryDC dc(frame);
+    dc.SetBackground(wxBrush(wxColour(0xE0, 0xE0, 0xE0)));
+    dc.Clear();
+
+    // Beyond a few zoom levels the old frame is just a blur or a dot - not worth showing
+    int zoom_delta = m_zoomLevel - m_previousZoom;
+    if (m_previousFrame.IsOk() && m_previousZoom >= 0 && std::abs(zoom_delta) <= 3) {
+        double scale = std::ldexp(1.0, zoom_delta);
+        int dst_x = static_cast<int>(std::lround(m_previousOriginX * scale - origin_x));
+        int dst_y = static_cast<int>(std::lround(m_previousOriginY * scale - origin_y));
+        int dst_w = static_cast<int>(std::lround(m_previousFrame.GetWidth() * scale));
+        int dst_h = static_cast<int>(std::lround(m_previousFrame.GetHeight() * scale));
+
+        wxMemoryDC previous(m_previousFrame);
+        dc.StretchBlit(dst_x, dst_y, dst_w, dst_h, &previous,
+                       0, 0, m_previousFrame.GetWidth(), m_previousFrame.GetHeight());
+        previous.SelectObject(wxNullBitmap);
+    }
+
+    dc.SelectObject(wxNullBitmap);
+    return frame.ConvertToImage();
+}
+
+std::vector<TileKey> MapPanel::NeighbourRing(int first_x, int first_y, int last_x, int last_y) const {
+    const int tile_count = MapProjection::TileCount(m_zoomLevel);
+    std::vector<TileKey> ring;
+
+    for (int ty = first_y - 1; ty <= last_y + 1; ++ty) {
+        if (ty < 0 || ty >= tile_count) continue;
+
+        for (int tx = first_x - 1; tx <= last_x + 1; ++tx) {
+            bool visible = tx >= first_x && tx <= last_x && ty >= first_y && ty <= last_y;
+            if (!visible) {
+                ring.push_back(TileKey{m_styleHash, m_zoomLevel, MapProjection::WrapTileX(tx, m_zoomLevel), ty});
+            }
+        }
+    }
+
+    return ring;
+}
+
+void MapPanel::OnTileReady(uint64_t generation) {
+    if (generation != m_tileGeneration) return; // Tile of a viewport we already left
+
+    // Tiles tend to arrive in bursts - recompose once after the burst is drained
+    if (m_composePending) return;
+    m_composePending = true;
+
+    CallAfter([this]() {
+        m_composePending = false;
+        if (!m_cacheValid || !m_cachedBitmap.IsOk()) return;
+
+        // Paint the arrived tiles over their placeholders instead of recomposing the frame
+        wxMemoryDC dc(m_cachedBitmap);
+        DrawMissingTiles(dc, m_previousOriginX, m_previousOriginY);
+        dc.SelectObject(wxNullBitmap);
+        Refresh();
+    });
+}
+
+void MapPanel::ShiftFrame() {
+    wxSize size = GetSize();
+    double view_x, view_y;
+    GetViewOrigin(size, view_x, view_y);
+    const int origin_x = static_cast<int>(std::lround(view_x));
+    const int origin_y = static_cast<int>(std::lround(view_y));
+
+    // Pixel offset of the existing frame within the new viewport
+    const int dx = m_previousOriginX - origin_x;
+    const int dy = m_previousOriginY - origin_y;
+
+    bool can_shift = IsTileMode() && m_cacheValid && m_cachedBitmap.IsOk()
+        && m_previousZoom == m_zoomLevel
+        && m_cachedBitmap.GetWidth() == size.x && m_cachedBitmap.GetHeight() == size.y
+        && std::abs(dx) < size.x && std::abs(dy) < size.y;
+
+    if (!can_shift) {
+        InvalidateCache();
+        RenderMap();
         return;
     }
 
-    // Calculate bounds for rendering based on current view state
-    // The zoom level represents a scale where we calculate degrees per pixel
-    // This is simplified - a more accurate approach would use the Mercator scale factor
+    if (dx == 0 && dy == 0) return;
+
+    wxBitmap frame(size.x, size.y, 24);
+    wxMemoryDC dc(frame);
+    dc.SetBackground(wxBrush(wxColour(0xE0, 0xE0, 0xE0)));
+    dc.Clear();
+    dc.DrawBitmap(m_cachedBitmap, dx, dy);
+
+    // Newly exposed strips along the edges, in world pixels
+    if (dx > 0) {
+        AddMissingTiles(origin_x, origin_y, origin_x + dx, origin_y + size.y);
+    } else if (dx < 0) {
+        AddMissingTiles(origin_x + size.x + dx, origin_y, origin_x + size.x, origin_y + size.y);
+    }
+    if (dy > 0) {
+        AddMissingTiles(origin_x, origin_y, origin_x + size.x, origin_y + dy);
+    } else if (dy < 0) {
+        AddMissingTiles(origin_x, origin_y + size.y + dy, origin_x + size.x, origin_y + size.y);
+    }
+
+    // Forget placeholders which scrolled out of view
+    m_missingTiles.erase(std::remove_if(m_missingTiles.begin(), m_missingTiles.end(),
+        [&](const MissingTile& tile) {
+            return tile.world_x + MAP_TILE_SIZE <= origin_x || tile.world_x >= origin_x + size.x
+                || tile.world_y + MAP_TILE_SIZE <= origin_y || tile.world_y >= origin_y + size.y;
+        }), m_missingTiles.end());
+
+    std::vector<TileKey> missing = DrawMissingTiles(dc, origin_x, origin_y);
+    dc.SelectObject(wxNullBitmap);
+
+    // The ring is prefetched when the drag ends and the full frame is committed
+    m_tileGeneration = m_tileWorker->Request(missing, {});
+
+    m_cachedBitmap = frame;
+    m_previousFrame = frame;
+    m_previousOriginX = origin_x;
+    m_previousOriginY = origin_y;
+
+    Refresh();
+}
 
-    // Calculate degrees per pixel based on zoom level
-    // At equator: 1 degree ≈ 111 km, and screen coordinates relate to world via zoom
-    double degrees_per_pixel = 1.0 / (m_zoomLevel * 111000.0); // rough approximation
+void MapPanel::AddMissingTiles(int world_left, int world_top, int world_right, int world_bottom) {
+    const int tile_count = MapProjection::TileCount(m_zoomLevel);
+    const int first_x = static_cast<int>(std::floor(world_left / static_cast<double>(MAP_TILE_SIZE)));
+    const int first_y = static_cast<int>(std::floor(world_top / static_cast<double>(MAP_TILE_SIZE)));
+    const int last_x = static_cast<int>(std::floor((world_right - 1) / static_cast<double>(MAP_TILE_SIZE)));
+    const int last_y = static_cast<int>(std::floor((world_bottom - 1) / static_cast<double>(MAP_TILE_SIZE)));
 
-    // Calculate bounds in lat/lon
-    double half_width_deg = (size.x / 2.0) * degrees_per_pixel;
-    double half_height_deg = (size.y / 2.0) * degrees_per_pixel;
+    for (int ty = std::max(first_y, 0); ty <= std::min(last_y, tile_count - 1); ++ty) {
+        for (int tx = first_x; tx <= last_x; ++tx) {
+            int world_x = tx * MAP_TILE_SIZE;
+            int world_y = ty * MAP_TILE_SIZE;
 
-    double min_lon = m_centerLon - half_width_deg;
-    double max_lon = m_centerLon + half_width_deg;
-    double min_lat = m_centerLat - half_height_deg;
-    double max_lat = m_centerLat + half_height_deg;
+            bool known = std::any_of(m_missingTiles.begin(), m_missingTiles.end(), [&](const MissingTile& tile) {
+                return tile.world_x == world_x && tile.world_y == world_y;
+            });
+            if (!known) {
+                TileKey key{m_styleHash, m_zoomLevel, MapProjection::WrapTileX(tx, m_zoomLevel), ty};
+                m_missingTiles.push_back(MissingTile{key, world_x, world_y});
+            }
+        }
+    }
+}
+
+std::vector<TileKey> MapPanel::DrawMissingTiles(wxDC& dc, int origin_x, int origin_y) {
+    std::vector<TileKey> still_missing;
+
+    auto it = m_missingTiles.begin();
+    while (it != m_missingTiles.end()) {
+        MapTilePtr tile = m_tileCache->GetFromMemory(it->key);
+        if (!tile) {
+            still_missing.push_back(it->key);
+            ++it;
+            continue;
+        }
+
+        // Static image data: the tile buffer outlives the conversion below
+        wxImage image(tile->size, tile->size, const_cast<unsigned char*>(tile->rgb.data()), true);
+        dc.DrawBitmap(wxBitmap(image), it->world_x - origin_x, it->world_y - origin_y);
+        it = m_missingTiles.erase(it);
+    }
+
+    return still_missing;
+}
+
+void MapPanel::ProjectTrack() {
+    if (m_projectedZoom == m_zoomLevel) return;
+
+    m_projectedTrack.clear();
+    m_projectedTrack.reserve(m_currentTrack.size());
+    for (const auto& point : m_currentTrack) {
+        m_projectedTrack.emplace_back(MapProjection::LonToWorldX(point.longitude, m_zoomLevel),
+                                      MapProjection::LatToWorldY(point.latitude, m_zoomLevel));
+    }
+    m_projectedZoom = m_zoomLevel;
+}
 
-    // Set view bounds (renderer will convert to Mercator internally)
-    m_renderer->setBounds(min_lon, min_lat, max_lon, max_lat);
+void MapPanel::DrawOverlays(wxDC& dc) {
+    if (!IsTileMode()) return; // Track-only rendering draws everything into the bitmap
 
-    // Render map with Mapnik
-    wxBitmap mapBitmap = m_renderer->render();
+    wxSize size = GetSize();
+    double origin_x, origin_y;
+    GetViewOrigin(size, origin_x, origin_y);
 
     // Overlay GPS track if we have one
     if (HasTrack()) {
-        m_renderer->renderTrackOverlay(mapBitmap, m_currentTrack,
-                                       min_lon, min_lat, max_lon, max_lat);
+        ProjectTrack();
+
+        std::vector<wxPoint> points;
+        points.reserve(m_projectedTrack.size());
+        for (const auto& p : m_projectedTrack) {
+            points.emplace_back(static_cast<int>(p.m_x - origin_x), static_cast<int>(p.m_y - origin_y));
+        }
+
+        dc.SetPen(wxPen(*wxRED, 3));
+        if (points.size() > 1) {
+            dc.DrawLines(static_cast<int>(points.size()), points.data());
+        }
+
+        // Draw start/end markers
+        dc.SetBrush(*wxGREEN_BRUSH);
+        dc.DrawCircle(points.front(), 6);
+
+        dc.SetBrush(*wxRED_BRUSH);
+        dc.DrawCircle(points.back(), 6);
     }
 
     // Draw zoom level indicator
-    {
-        wxMemoryDC dc(mapBitmap);
-        dc.SetFont(wxFont(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD));
-
-        // Calculate approximate map scale denominator (similar to Mapnik's scale)
-        // At the current latitude, calculate meters per pixel
-        double lat_rad = m_centerLat * M_PI / 180.0;
-        double meters_per_degree_lon = 111320.0 * cos(lat_rad);
-        double meters_per_pixel = degrees_per_pixel * meters_per_degree_lon;
-        double scale_denominator = meters_per_pixel * 90.7; // 90.7 is DPI factor (72 / 0.0254 * 0.0254)
-
-        wxString zoomText = wxString::Format("Scale: 1:%.0f (zoom: %.6f)", scale_denominator, m_zoomLevel);
-
-        // Draw semi-transparent background
-        wxSize textSize = dc.GetTextExtent(zoomText);
-        dc.SetBrush(wxBrush(wxColor(255, 255, 255, 200)));
-        dc.SetPen(*wxTRANSPARENT_PEN);
-        dc.DrawRectangle(10, 10, textSize.x + 10, textSize.y + 6);
-
-        // Draw text
-        dc.SetTextForeground(*wxBLACK);
-        dc.DrawText(zoomText, 15, 13);
-        dc.SelectObject(wxNullBitmap);
-    }
+    dc.SetFont(wxFont(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD));
 
-    m_cachedBitmap = mapBitmap;
-    m_cacheValid = true;
+    // Map scale denominator at the center latitude, assuming 0.28 mm pixels like Mapnik does
+    double meters_per_pixel = MapProjection::MetersPerPixel(m_centerLat, m_zoomLevel);
+    double scale_denominator = meters_per_pixel / 0.00028;
 
-    Refresh();
-    Update();
+    wxString zoomText = wxString::Format("Scale: 1:%.0f (zoom: %d)", scale_denominator, m_zoomLevel);
+
+    // Draw semi-transparent background
+    wxSize textSize = dc.GetTextExtent(zoomText);
+    dc.SetBrush(wxBrush(wxColor(255, 255, 255, 200)));
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    dc.DrawRectangle(10, 10, textSize.x + 10, textSize.y + 6);
+
+    // Draw text
+    dc.SetTextForeground(*wxBLACK);
+    dc.DrawText(zoomText, 15, 13);
 }
 
 void MapPanel::RenderTrackOnly() {
@@ -524,9 +950,13 @@ void MapPanel::InvalidateCache() {
 }
 
 BoundingBox MapPanel::CalculateTrackBounds() const {
+    return TrackBounds(m_currentTrack);
+}
+
+BoundingBox MapPanel::TrackBounds(const std::vector<GPSPoint>& track) {
     BoundingBox bounds;
     
-    for (const auto& point : m_currentTrack) {
+    for (const auto& point : track) {
         if (point.latitude != 0.0 || point.longitude != 0.0) {
             bounds.extend(point.latitude, point.longitude);
         }
@@ -535,19 +965,40 @@ BoundingBox MapPanel::CalculateTrackBounds() const {
     return bounds;
 }
 
+std::vector<GPSPoint> MapPanel::TrackPoints(const ParsedFile::Track& coordinates) {
+    const auto& latitudes = coordinates.latitudes;
+    const auto& longitudes = coordinates.longitudes;
+
+    std::vector<GPSPoint> track;
+    track.reserve(latitudes.size());
+
+    for (size_t i = 0; i < latitudes.size() && i < longitudes.size(); ++i) {
+        if (latitudes[i] != FIT_SINT32_INVALID && longitudes[i] != FIT_SINT32_INVALID) {
+            GPSPoint point;
+            point.latitude = latitudes[i] / 11930464.7111; // Convert from semicircles to degrees
+            point.longitude = longitudes[i] / 11930464.7111;
+            track.push_back(point);
+        }
+    }
+
+    return track;
+}
+
 std::pair<double, double> MapPanel::ScreenToWorld(int screen_x, int screen_y) const {
-    // Simple implementation - could be improved
-    wxSize size = GetSize();
-    double world_x = m_centerLon + (screen_x - size.x / 2.0) / m_zoomLevel * 0.001;
-    double world_y = m_centerLat - (screen_y - size.y / 2.0) / m_zoomLevel * 0.001;
-    return {world_x, world_y};
+    double origin_x, origin_y;
+    GetViewOrigin(GetSize(), origin_x, origin_y);
+
+    double lon = MapProjection::WorldXToLon(origin_x + screen_x, m_zoomLevel);
+    double lat = MapProjection::WorldYToLat(origin_y + screen_y, m_zoomLevel);
+    return {lon, lat};
 }
 
 std::pair<int, int> MapPanel::WorldToScreen(double world_x, double world_y) const {
-    // Simple implementation - could be improved
-    wxSize size = GetSize();
-    int screen_x = static_cast<int>((world_x - m_centerLon) * m_zoomLevel * 1000 + size.x / 2.0);
-    int screen_y = static_cast<int>((m_centerLat - world_y) * m_zoomLevel * 1000 + size.y / 2.0);
+    double origin_x, origin_y;
+    GetViewOrigin(GetSize(), origin_x, origin_y);
+
+    int screen_x = static_cast<int>(MapProjection::LonToWorldX(world_x, m_zoomLevel) - origin_x);
+    int screen_y = static_cast<int>(MapProjection::LatToWorldY(world_y, m_zoomLevel) - origin_y);
     return {screen_x, screen_y};
 }
 
@@ -560,116 +1011,123 @@ bool MapPanel::CheckAndConvertPBFToSpatialite(const std::string& pbf_path) {
         return false;
     }
 
-    // Generate Spatialite path (same directory, same name, .sqlite extension)
-    fs::path pbf_file(pbf_path);
-    fs::path sqlite_path = pbf_file.parent_path() / (pbf_file.stem().string() + ".sqlite");
-
-    // Check if Spatialite file already exists
-    if (fs::exists(sqlite_path)) {
-        // Check if it's newer than PBF file
-        auto pbf_time = fs::last_write_time(pbf_path);
-        auto sqlite_time = fs::last_write_time(sqlite_path);
+    // Render whatever is extracted already, missing regions are added in the background
+    OsmExtractState state = OsmRegionExtractor::LoadState(pbf_path);
+    bool usable = state.complete || !state.cells.empty();
 
-        if (sqlite_time >= pbf_time) {
-            // Generate and load stylesheet
-            std::string stylesheet = GenerateStylesheetForSpatialite(sqlite_path.string());
-            if (!stylesheet.empty() && m_renderer) {
-                m_osmLoaded = m_renderer->initialize(stylesheet);
-            }
-            return true;
+    if (usable) {
+        std::string sqlite_path = OsmRegionExtractor::SpatialitePath(pbf_path);
+        std::string stylesheet = GenerateStylesheetForSpatialite(sqlite_path);
+        if (!stylesheet.empty() && m_mapInitialized) {
+            LoadStylesheet(stylesheet, sqlite_path);
         }
     }
 
-    // Ask user if they want to convert
-    wxString message = wxString::Format(
-        "To improve map rendering performance, the PBF file needs to be converted to Spatialite format.\n\n"
-        "Source: %s\n"
-        "Output: %s\n\n"
-        "This is a one-time process and may take several minutes depending on file size.\n\n"
-        "Convert now?",
-        pbf_path, sqlite_path.string());
+    UpdateExtract();
+    return usable;
+}
 
-    int response = wxMessageBox(message, "Map Data Conversion Required",
-                                wxYES_NO | wxICON_QUESTION, this);
+bool MapPanel::IsPbfSource() const {
+    return m_osmFilePath.ends_with(".pbf");
+}
 
-    if (response != wxYES) {
-        return false;
-    }
+void MapPanel::StartArchiveScan() {
+    StopArchiveScan();
+    m_activityBounds.clear();
+
+    if (m_archiveDirectory.empty()) return;
+
+    // Bounds come from the activity cache where possible, but a fresh archive means parsing every file
+    auto bounds = std::make_shared<std::vector<OsmRegion>>();
+    m_boundsJob = JobScheduler::Instance().Submit(JobLane::Bulk,
+        [directory = m_archiveDirectory, bounds](JobContext& job) {
+            *bounds = OsmRegionExtractor::CollectArchiveBounds(directory, job.CancelFlag());
+        },
+        [this, bounds]() {
+            m_activityBounds = std::move(*bounds);
+            UpdateExtract();
+        });
+}
 
-    // Create progress dialog
-    wxProgressDialog progress("Converting Map Data",
-                             "Converting PBF to Spatialite format...\nThis may take several minutes.",
-                             100, this,
-                             wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT);
+void MapPanel::StopArchiveScan() {
+    // The job only touches its own results, it may finish in the background
+    m_boundsJob.Cancel();
+}
 
-    // Build ogr2ogr command with custom osmconf for POI and route support
-    // Find custom osmconf.ini using DataDirectoryResolver
-    wxString osmconfWx = DataDirectoryResolver::FindDataFile("osmconf.ini");
-    std::string osmconf_path = osmconfWx.ToStdString();
+void MapPanel::UpdateExtract() {
+    // A running extract calls back here when it finishes and picks up what came in meanwhile
+    if (!IsPbfSource() || m_extractSuspended || m_extractor->IsRunning()) return;
 
-    std::string cmd = "ogr2ogr -f SQLite \"" + sqlite_path.string() + "\" \"" + pbf_path + "\" ";
-    cmd += "-dsco SPATIALITE=YES ";
-    cmd += "--config OSM_USE_CUSTOM_INDEXING NO ";
+    OsmExtractState state = OsmRegionExtractor::LoadState(m_osmFilePath);
+    if (state.complete) return;
 
-    if (!osmconf_path.empty()) {
-        cmd += "--config OSM_CONFIG_FILE \"" + osmconf_path + "\" ";
+    std::set<OsmCell> wanted;
+    for (const auto& bounds : m_activityBounds) {
+        OsmRegionExtractor::AddCells(bounds, wanted);
     }
 
-    cmd += "-progress 2>&1";
-
-    wxLogMessage("Running conversion: %s", cmd);
-    progress.Pulse("Running ogr2ogr conversion...");
-
-    // Run conversion
-    FILE* pipe = popen(cmd.c_str(), "r");
-    if (!pipe) {
-        wxLogError("Failed to start ogr2ogr conversion");
-        return false;
+    BoundingBox track = CalculateTrackBounds();
+    if (track.isValid()) {
+        OsmRegionExtractor::AddCells(OsmRegion{track.min_lat, track.min_lon, track.max_lat, track.max_lon}, wanted);
     }
 
-    char buffer[256];
-    bool user_cancelled = false;
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        // Update progress dialog
-        if (!progress.Pulse(wxString(buffer))) {
-            user_cancelled = true;
-            break;
-        }
-        wxYield(); // Allow UI to update
+    std::set<OsmCell> missing;
+    std::set_difference(wanted.begin(), wanted.end(), state.cells.begin(), state.cells.end(),
+                        std::inserter(missing, missing.end()));
+    if (missing.empty()) return;
+
+    m_extractProgress = 0.0;
+    m_extractStatus = "Preparing map extract";
+    if (m_extractor->Start(m_osmFilePath, state, missing)) {
+        Refresh();
+    } else {
+        m_extractSuspended = true;
     }
+}
 
-    int result = pclose(pipe);
+void MapPanel::OnExtractFinished(bool success, const std::string& sqlite_path) {
+    m_extractStatus.clear();
 
-    if (user_cancelled) {
-        wxLogMessage("Conversion cancelled by user");
-        // Clean up partial file
-        if (fs::exists(sqlite_path)) {
-            fs::remove(sqlite_path);
-        }
-        return false;
+    if (!success) {
+        m_extractSuspended = true;
+        Refresh();
+        return;
     }
 
-    if (result != 0) {
-        wxLogError("Conversion failed with error code: %d", result);
-        return false;
+    // The new database has a different size and time, so the style hash and tiles change with it
+    std::string stylesheet = GenerateStylesheetForSpatialite(sqlite_path);
+    if (!stylesheet.empty() && m_mapInitialized) {
+        LoadStylesheet(stylesheet, sqlite_path);
+        InvalidateCache();
+        RenderMap();
     }
 
-    // Verify the output file was created
-    if (!fs::exists(sqlite_path)) {
-        wxLogError("Conversion completed but output file not found");
-        return false;
-    }
+    UpdateExtract();
+    Refresh();
+}
 
-    wxMessageBox("Map data conversion completed successfully!",
-                 "Conversion Complete", wxOK | wxICON_INFORMATION, this);
+void MapPanel::DrawExtractProgress(wxDC& dc) {
+    if (!m_extractor->IsRunning()) return;
 
-    // Generate and load stylesheet
-    std::string stylesheet = GenerateStylesheetForSpatialite(sqlite_path.string());
-    if (!stylesheet.empty() && m_renderer) {
-        m_osmLoaded = m_renderer->initialize(stylesheet);
-    }
+    wxSize size = GetSize();
+    wxString text = wxString::Format("%s - %.0f%%", m_extractStatus, m_extractProgress * 100.0);
 
-    return true;
+    dc.SetFont(wxFont(10, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL));
+    wxSize textSize = dc.GetTextExtent(text);
+
+    int bar_height = textSize.y + 8;
+    wxRect bar(10, size.y - bar_height - 10, size.x - 20, bar_height);
+
+    dc.SetPen(*wxGREY_PEN);
+    dc.SetBrush(wxBrush(wxColor(255, 255, 255, 200)));
+    dc.DrawRectangle(bar);
+
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    dc.SetBrush(wxBrush(wxColor(120, 190, 120)));
+    dc.DrawRectangle(bar.x + 1, bar.y + 1, static_cast<int>((bar.width - 2) * std::clamp(m_extractProgress, 0.0, 1.0)), bar.height - 2);
+
+    dc.SetTextForeground(*wxBLACK);
+    dc.DrawText(text, bar.x + 6, bar.y + 4);
 }
 
 std::string MapPanel::GenerateStylesheetForSpatialite(const std::string& sqlite_path) {
@@ -7,13 +7,20 @@
 
 #include <wx/panel.h>
 #include <wx/bitmap.h>
+#include <wx/geometry.h>
 #include <vector>
 #include <string>
 #include <memory>
 #include "../interfaces/IActivityPanel.hpp"
+#include "../utils/OsmRegionExtractor.hpp"
+#include "../utils/ParsedFileCache.hpp"
+#include "../utils/JobScheduler.hpp"
+#include "MapTiles.hpp"
+#include "MapTileWorker.hpp"
 
 // Forward declarations
-class MapnikRenderer;
+class IMapTileSource;
+class MapTileCache;
 
 struct GPSPoint {
     double latitude;
@@ -62,7 +69,14 @@ public:
     // Main interface
     void SetTrack(const std::vector<GPSPoint>& track, const std::string& activityName = "");
     void LoadTrack(const std::string& fitFilePath);
+
+    /**
+     * Queue the tiles of the frame an activity would open with, behind the visible ones.
+     * Called for the neighbours of the selection so that stepping to them shows a ready map.
+     */
+    void PrefetchTrack(const std::string& fitFilePath);
     void SetOSMFile(const std::string& pbf_path);
+    void SetArchiveDirectory(const std::string& directory);
     void ClearMap();
     
     // Navigation
@@ -90,31 +104,97 @@ private:
     void RenderTrackOnly();
     void InvalidateCache();
     BoundingBox CalculateTrackBounds() const;
+    static BoundingBox TrackBounds(const std::vector<GPSPoint>& track);
+    static std::vector<GPSPoint> TrackPoints(const ParsedFile::Track& coordinates);
+    static bool FitFrame(BoundingBox bounds, const wxSize& size, int& zoom, double& center_lat, double& center_lon);
+    bool OpenMapSource();
+    bool LoadStylesheet(const std::string& stylesheet_path, const std::string& data_path = "");
+    bool LoadMBTiles(const std::string& mbtiles_path);
+    void StartTileSource(std::unique_ptr<IMapTileSource> source, uint64_t style_hash,
+                         MapTileWorker::TileSourceFactory create_worker_source);
+    void StopTileSource();
+    bool IsTileMode() const;
+
+    // Tile composition
+    void GetViewOrigin(const wxSize& size, double& origin_x, double& origin_y) const;
+    wxBitmap ComposeTiles(const wxSize& size, int origin_x, int origin_y);
+    wxImage PreviousFrameImage(const wxSize& size, int origin_x, int origin_y);
+    std::vector<TileKey> NeighbourRing(int first_x, int first_y, int last_x, int last_y) const;
+    void OnTileReady(uint64_t generation);
+
+    // Drag panning: shift the current frame and fill in only the exposed strips
+    void ShiftFrame();
+    void AddMissingTiles(int world_left, int world_top, int world_right, int world_bottom);
+    std::vector<TileKey> DrawMissingTiles(wxDC& dc, int origin_x, int origin_y);
+
+    // Overlays drawn on top of the tile background
+    void ProjectTrack();
+    void DrawOverlays(wxDC& dc);
 
     // Map data conversion
     bool CheckAndConvertPBFToSpatialite(const std::string& pbf_path);
     std::string GenerateStylesheetForSpatialite(const std::string& sqlite_path);
+    bool IsPbfSource() const;
+
+    // Region-clipped PBF extract, built in the background around archived activities
+    void StartArchiveScan();
+    void StopArchiveScan();
+    void UpdateExtract();
+    void OnExtractFinished(bool success, const std::string& sqlite_path);
+    void DrawExtractProgress(wxDC& dc);
     
-    // Coordinate conversion
+    // Coordinate conversion (lon/lat <-> panel pixels)
     std::pair<double, double> ScreenToWorld(int screen_x, int screen_y) const;
     std::pair<int, int> WorldToScreen(double world_x, double world_y) const;
     
     // Data members
+    JobHandle m_trackJob; // Parses the selected activity
+    std::vector<JobHandle> m_prefetchJobs; // Frames of the neighbours, see PrefetchTrack()
     std::vector<GPSPoint> m_currentTrack;
     std::string m_activityName;
     std::string m_osmFilePath;
     bool m_osmLoaded;
     
     // Rendering components
-    std::unique_ptr<MapnikRenderer> m_renderer;
-    
+    bool m_mapInitialized; // Map source opened, happens on first render
+    std::unique_ptr<IMapTileSource> m_tileSource; // Validates the source; tiles are rendered by m_tileWorker
+    std::unique_ptr<MapTileCache> m_tileCache;
+    std::unique_ptr<MapTileWorker> m_tileWorker; // Declared after the cache: stopped before it is destroyed
+    uint64_t m_styleHash;
+    uint64_t m_tileGeneration; // Generation of the last viewport requested from the worker
+
+    // Map extract state
+    std::unique_ptr<OsmRegionExtractor> m_extractor;
+    std::string m_archiveDirectory;
+    std::vector<OsmRegion> m_activityBounds;
+    JobHandle m_boundsJob;
+    bool m_extractSuspended; // Cancelled or failed - not retried until the map source or archive changes
+    double m_extractProgress;
+    wxString m_extractStatus;
+
     // Display state
     wxBitmap m_cachedBitmap;
     bool m_cacheValid;
-    
+
+    // Last composed frame, scaled or shifted as a placeholder until new tiles arrive
+    wxBitmap m_previousFrame;
+    int m_previousOriginX, m_previousOriginY;
+    int m_previousZoom;
+
+    // Tiles of the current frame still showing a placeholder, at world pixel positions
+    struct MissingTile {
+        TileKey key;
+        int world_x, world_y;
+    };
+    std::vector<MissingTile> m_missingTiles;
+
+    // Track projected to world pixels at m_projectedZoom
+    std::vector<wxPoint2DDouble> m_projectedTrack;
+    int m_projectedZoom;
+
     // View state
     double m_centerLat, m_centerLon;
-    double m_zoomLevel;
+    int m_zoomLevel; // Slippy map zoom level, MAP_MIN_ZOOM..MAP_MAX_ZOOM
     BoundingBox m_viewBounds;
     
     // Interaction state
@@ -123,6 +203,7 @@ private:
 
     // Rendering throttle
     bool m_renderPending;
+    bool m_composePending;
     wxLongLong m_lastRenderTime;
 
     wxDECLARE_EVENT_TABLE();
@@ -1,17 +1,52 @@
 #include "MapRenderer.hpp"
-#include "MapPanel.hpp"
+#include "trace/trace.hpp"
 #include <wx/wx.h>
 #include <wx/rawbmp.h>
 #include <wx/dcmemory.h>
 #include <cmath>
 #include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
 
 #ifdef HAVE_MAPNIK
 #include <mapnik/version.hpp>
 #endif
 
+namespace {
+
+// FNV-1a over the stylesheet bytes - cheap and stable between runs
+uint64_t HashFileContents(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#ifdef HAVE_MAPNIK
+// Fonts the stylesheets refer to (DejaVu, Noto, Liberation) on the usual distributions
+const char* const FONT_DIRECTORIES[] = {
+    "/usr/share/fonts/truetype/dejavu/",
+    "/usr/share/fonts/truetype/noto/",
+    "/usr/share/fonts/truetype/liberation/",
+    "/usr/share/fonts/dejavu-sans-fonts/",
+    "/usr/share/fonts/google-noto/",
+    "/usr/share/fonts/liberation-sans/",
+    "/usr/share/fonts/TTF/",
+    "/usr/share/fonts/noto/",
+};
+#endif
+
+} // namespace
+
 MapnikRenderer::MapnikRenderer(int width, int height)
-    : m_width(width), m_height(height)
+    : m_width(width), m_height(height), m_styleHash(0)
 #ifdef HAVE_MAPNIK
       , m_initialized(false)
       , m_mercator_minx(0), m_mercator_miny(0), m_mercator_maxx(0), m_mercator_maxy(0)
@@ -24,20 +59,31 @@ MapnikRenderer::~MapnikRenderer() {
 }
 
 void MapnikRenderer::ensureMapnikInitialized() {
+    InitializeLibrary();
+}
+
+void MapnikRenderer::InitializeLibrary() {
 #ifdef HAVE_MAPNIK
-    static bool mapnik_registered = false;
-    if (!mapnik_registered) {
+    // Tile workers create their own renderers, so registration must happen exactly once
+    static std::once_flag mapnik_registered;
+    std::call_once(mapnik_registered, []() {
         // Register datasource plugins
         mapnik::datasource_cache::instance().register_datasources("/usr/lib/mapnik/3.1/input/");
 
-        // Register fonts
-        mapnik::freetype_engine::register_fonts("/usr/share/fonts/", true);
+        // Register the common font families only, scanning every font of the system takes seconds
+        bool registered = false;
+        for (const char* directory : FONT_DIRECTORIES) {
+            if (std::filesystem::is_directory(directory)) {
+                registered |= mapnik::freetype_engine::register_fonts(directory, true);
+            }
+        }
+        if (!registered) {
+            mapnik::freetype_engine::register_fonts("/usr/share/fonts/", true);
+        }
 
         printf("Mapnik initialized - version %d.%d.%d\n",
                MAPNIK_MAJOR_VERSION, MAPNIK_MINOR_VERSION, MAPNIK_PATCH_VERSION);
-
-        mapnik_registered = true;
-    }
+    });
 #endif
 }
 
@@ -48,6 +94,7 @@ bool MapnikRenderer::initialize(const std::string& stylesheet_path, const std::s
         m_map = std::make_unique<mapnik::Map>(m_width, m_height);
 
         mapnik::load_map(*m_map, stylesheet_path);
+        m_styleHash = HashFileContents(stylesheet_path);
 
         m_initialized = true;
         return true;
@@ -138,6 +185,7 @@ void MapnikRenderer::setCenter(double center_lon, double center_lat, double zoom
 }
 
 wxBitmap MapnikRenderer::render() {
+    GFU_TRACE_SCOPE("map.render", "render");
 #ifdef HAVE_MAPNIK
     if (!isValid()) {
         // Return empty bitmap
@@ -212,79 +260,46 @@ wxBitmap MapnikRenderer::render() {
 #endif
 }
 
-void MapnikRenderer::renderTrackOverlay(wxBitmap& bitmap, const std::vector<GPSPoint>& track,
-                                        double min_lon, double min_lat, double max_lon, double max_lat) {
-    if (track.empty()) return;
-
-    wxMemoryDC dc(bitmap);
-
+MapTilePtr MapnikRenderer::renderTile(int z, int x, int y) {
 #ifdef HAVE_MAPNIK
-    // Use the stored Mercator bounds from the map (set by setBounds)
-    double min_x = m_mercator_minx;
-    double max_x = m_mercator_maxx;
-    double min_y = m_mercator_miny;
-    double max_y = m_mercator_maxy;
-#else
-    // Fallback if no Mapnik: use simple lat/lon bounds
-    double min_x = min_lon;
-    double max_x = max_lon;
-    double min_y = min_lat;
-    double max_y = max_lat;
-#endif
-
-    // Calculate scale for Mercator coordinate conversion
-    double x_range = max_x - min_x;
-    double y_range = max_y - min_y;
-
-    if (x_range <= 0 || y_range <= 0) return;
-
-    double scale_x = m_width / x_range;
-    double scale_y = m_height / y_range;
-
-    // Draw track
-    dc.SetPen(wxPen(*wxRED, 3));
-
-    for (size_t i = 1; i < track.size(); ++i) {
-        // Convert each GPS point to Web Mercator
-        double x1_merc = track[i-1].longitude * 20037508.34 / 180.0;
-        double y1_merc = log(tan((90.0 + track[i-1].latitude) * M_PI / 360.0)) / (M_PI / 180.0) * 20037508.34 / 180.0;
-
-        double x2_merc = track[i].longitude * 20037508.34 / 180.0;
-        double y2_merc = log(tan((90.0 + track[i].latitude) * M_PI / 360.0)) / (M_PI / 180.0) * 20037508.34 / 180.0;
-
-        // Convert to screen coordinates
-        int x1 = static_cast<int>((x1_merc - min_x) * scale_x);
-        int y1 = static_cast<int>(m_height - ((y1_merc - min_y) * scale_y));
-
-        int x2 = static_cast<int>((x2_merc - min_x) * scale_x);
-        int y2 = static_cast<int>(m_height - ((y2_merc - min_y) * scale_y));
-
-        dc.DrawLine(x1, y1, x2, y2);
+    if (!isValid()) {
+        return nullptr;
     }
 
-    // Draw start/end markers
-    if (!track.empty()) {
-        // Convert start point to Mercator
-        double start_x_merc = track.front().longitude * 20037508.34 / 180.0;
-        double start_y_merc = log(tan((90.0 + track.front().latitude) * M_PI / 360.0)) / (M_PI / 180.0) * 20037508.34 / 180.0;
-
-        // Convert end point to Mercator
-        double end_x_merc = track.back().longitude * 20037508.34 / 180.0;
-        double end_y_merc = log(tan((90.0 + track.back().latitude) * M_PI / 360.0)) / (M_PI / 180.0) * 20037508.34 / 180.0;
+    try {
+        if (m_width != MAP_TILE_SIZE || m_height != MAP_TILE_SIZE) {
+            setSize(MAP_TILE_SIZE, MAP_TILE_SIZE);
+            // Render a margin around the tile so labels and symbols crossing tile edges line up
+            m_map->set_buffer_size(MAP_TILE_SIZE / 2);
+        }
 
-        // Convert to screen coordinates
-        int start_x = static_cast<int>((start_x_merc - min_x) * scale_x);
-        int start_y = static_cast<int>(m_height - ((start_y_merc - min_y) * scale_y));
+        double min_x, min_y, max_x, max_y;
+        MapProjection::TileMercatorBounds(z, x, y, min_x, min_y, max_x, max_y);
+        m_map->zoom_to_box(mapnik::box2d<double>(min_x, min_y, max_x, max_y));
 
-        int end_x = static_cast<int>((end_x_merc - min_x) * scale_x);
-        int end_y = static_cast<int>(m_height - ((end_y_merc - min_y) * scale_y));
+        mapnik::image_rgba8 image(MAP_TILE_SIZE, MAP_TILE_SIZE);
+        mapnik::agg_renderer<mapnik::image_rgba8> renderer(*m_map, image);
+        renderer.apply();
 
-        dc.SetBrush(*wxGREEN_BRUSH);
-        dc.DrawCircle(start_x, start_y, 6);
+        // Flatten onto white: tiles are stored without alpha
+        auto tile = std::make_shared<MapTileImage>(MAP_TILE_SIZE);
+        const unsigned char* src = image.bytes();
+        unsigned char* dst = tile->rgb.data();
+        const size_t pixels = static_cast<size_t>(MAP_TILE_SIZE) * MAP_TILE_SIZE;
+
+        for (size_t i = 0; i < pixels; ++i, src += 4, dst += 3) {
+            unsigned int alpha = src[3];
+            dst[0] = static_cast<unsigned char>((src[0] * alpha + 255 * (255 - alpha)) / 255);
+            dst[1] = static_cast<unsigned char>((src[1] * alpha + 255 * (255 - alpha)) / 255);
+            dst[2] = static_cast<unsigned char>((src[2] * alpha + 255 * (255 - alpha)) / 255);
+        }
 
-        dc.SetBrush(*wxRED_BRUSH);
-        dc.DrawCircle(end_x, end_y, 6);
+        return tile;
+    } catch (const std::exception& e) {
+        printf("Error rendering tile %d/%d/%d: %s\n", z, x, y, e.what());
+        return nullptr;
     }
-
-    dc.SelectObject(wxNullBitmap);
-}
\ No newline at end of file
+#else
+    return nullptr;
+#endif
+}
@@ -3,7 +3,10 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <cstdint>
 #include "fit.hpp"
+#include "MapTiles.hpp"
+#include "../interfaces/IMapTileSource.hpp"
 
 #ifdef HAVE_MAPNIK
 #include <mapnik/map.hpp>
@@ -20,10 +23,7 @@
 
 #include <wx/bitmap.h>
 
-// Forward declarations
-struct GPSPoint;
-
-class MapnikRenderer {
+class MapnikRenderer : public IMapTileSource {
 private:
 #ifdef HAVE_MAPNIK
     std::unique_ptr<mapnik::Map> m_map;
@@ -32,24 +32,34 @@ private:
     double m_mercator_minx, m_mercator_miny, m_mercator_maxx, m_mercator_maxy;
 #endif
     int m_width, m_height;
+    uint64_t m_styleHash;
 
 public:
     MapnikRenderer(int width, int height);
-    ~MapnikRenderer();
+    ~MapnikRenderer() override;
+
+    // Register the datasource plugins and fonts, once per process; slow, call it
+    // on a worker thread before the first renderer is needed
+    static void InitializeLibrary();
 
     // Setup
     bool initialize(const std::string& stylesheet_path, const std::string& fonts_dir = "");
-    bool isValid() const;
+    bool isValid() const override;
     void setSize(int width, int height);
 
+    // Hash of the loaded stylesheet contents, used to key cached tiles
+    uint64_t styleHash() const override { return m_styleHash; }
+
     // View control
     void setBounds(double min_lon, double min_lat, double max_lon, double max_lat);
     void setCenter(double center_lon, double center_lat, double zoom_level);
 
     // Rendering
     wxBitmap render();
-    void renderTrackOverlay(wxBitmap& bitmap, const std::vector<GPSPoint>& track,
-                           double min_lon, double min_lat, double max_lon, double max_lat);
+
+    // Render a single MAP_TILE_SIZE slippy map tile; resizes the map to the tile size.
+    // Returns nullptr if the renderer is not initialized or rendering fails.
+    MapTilePtr renderTile(int z, int x, int y) override;
 
 private:
     void ensureMapnikInitialized();
@@ -0,0 +1,151 @@
+#include "MapTileCache.hpp"
+#include <wx/image.h>
+#include <wx/log.h>
+#include <wx/stdpaths.h>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+MapTileCache::MapTileCache(size_t memoryCapacity, const std::filesystem::path& diskDirectory)
+    : m_capacity(memoryCapacity), m_diskDirectory(diskDirectory) {
+}
+
+MapTilePtr MapTileCache::Get(const TileKey& key) {
+    if (MapTilePtr tile = GetFromMemory(key)) {
+        return tile;
+    }
+
+    MapTilePtr tile = LoadFromDisk(key);
+    if (tile) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        InsertLocked(key, tile);
+    }
+    return tile;
+}
+
+MapTilePtr MapTileCache::GetFromMemory(const TileKey& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return nullptr;
+    }
+
+    // Move to the front of the LRU list
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->second;
+}
+
+bool MapTileCache::Contains(const TileKey& key) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_index.count(key)) {
+            return true;
+        }
+    }
+
+    if (m_diskDirectory.empty()) {
+        return false;
+    }
+
+    std::error_code ec;
+    return std::filesystem::exists(TilePath(key), ec);
+}
+
+void MapTileCache::Put(const TileKey& key, MapTilePtr tile, bool persist) {
+    if (!tile) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        InsertLocked(key, tile);
+    }
+
+    if (persist) {
+        SaveToDisk(key, *tile);
+    }
+}
+
+void MapTileCache::ClearMemory() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_index.clear();
+}
+
+std::filesystem::path MapTileCache::DefaultDirectory() {
+    wxString cacheDir = wxStandardPaths::Get().GetUserDir(wxStandardPaths::Dir_Cache);
+    return std::filesystem::path(cacheDir.ToStdString()) / "garmin-disconnect" / "tiles";
+}
+
+std::filesystem::path MapTileCache::TilePath(const TileKey& key) const {
+    char styleDir[17];
+    snprintf(styleDir, sizeof(styleDir), "%016llx", static_cast<unsigned long long>(key.styleHash));
+
+    return m_diskDirectory / styleDir / std::to_string(key.z) / std::to_string(key.x)
+        / (std::to_string(key.y) + ".png");
+}
+
+void MapTileCache::InsertLocked(const TileKey& key, MapTilePtr tile) {
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        it->second->second = tile;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return;
+    }
+
+    m_lru.emplace_front(key, tile);
+    m_index[key] = m_lru.begin();
+
+    while (m_lru.size() > m_capacity) {
+        m_index.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+}
+
+MapTilePtr MapTileCache::LoadFromDisk(const TileKey& key) const {
+    if (m_diskDirectory.empty()) {
+        return nullptr;
+    }
+
+    std::filesystem::path path = TilePath(key);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return nullptr;
+    }
+
+    wxLogNull noLog; // A truncated tile is simply re-rendered
+    wxImage image;
+    if (!image.LoadFile(wxString::FromUTF8(path.string()), wxBITMAP_TYPE_PNG)
+        || image.GetWidth() != MAP_TILE_SIZE || image.GetHeight() != MAP_TILE_SIZE) {
+        return nullptr;
+    }
+
+    auto tile = std::make_shared<MapTileImage>(MAP_TILE_SIZE);
+    std::memcpy(tile->rgb.data(), image.GetData(), tile->rgb.size());
+    return tile;
+}
+
+void MapTileCache::SaveToDisk(const TileKey& key, const MapTileImage& tile) const {
+    if (m_diskDirectory.empty()) {
+        return;
+    }
+
+    std::filesystem::path path = TilePath(key);
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec) {
+        return;
+    }
+
+    // Write to a temporary name first so a concurrent reader never sees a partial PNG
+    std::ostringstream suffix;
+    suffix << ".tmp-" << std::this_thread::get_id();
+    std::filesystem::path tempPath = path;
+    tempPath += suffix.str();
+
+    wxLogNull noLog;
+    wxImage image(tile.size, tile.size, const_cast<unsigned char*>(tile.rgb.data()), true);
+    if (image.SaveFile(wxString::FromUTF8(tempPath.string()), wxBITMAP_TYPE_PNG)) {
+        std::filesystem::rename(tempPath, path, ec);
+    }
+    std::filesystem::remove(tempPath, ec); // No-op after a successful rename
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "MapTiles.hpp"
+
+/**
+ * Two level cache of rendered map tiles.
+ *
+ * Tiles are kept in an in-memory LRU bounded by tile count and persisted as PNG
+ * files under <cache dir>/<style hash>/<z>/<x>/<y>.png. The style hash changes
+ * whenever the stylesheet or the map data changes, so stale tiles are never reused.
+ *
+ * All methods are thread-safe: the UI thread composes the viewport while the
+ * tile worker fills the cache in the background.
+ */
+class MapTileCache {
+public:
+    /**
+     * @param memoryCapacity Maximum number of tiles kept in memory
+     * @param diskDirectory Root of the on-disk tile store, empty to disable it
+     */
+    MapTileCache(size_t memoryCapacity, const std::filesystem::path& diskDirectory);
+
+    /**
+     * Look up a tile in memory, then on disk. Tiles loaded from disk are promoted to memory.
+     * @return Tile or nullptr if it has not been rendered yet
+     */
+    MapTilePtr Get(const TileKey& key);
+
+    /**
+     * Look up a tile in memory only, never touching the disk.
+     */
+    MapTilePtr GetFromMemory(const TileKey& key);
+
+    /**
+     * Check whether a tile is available in memory or on disk without decoding it.
+     */
+    bool Contains(const TileKey& key);
+
+    /**
+     * Store a freshly rendered tile in memory and, if persist is set, on disk.
+     */
+    void Put(const TileKey& key, MapTilePtr tile, bool persist = true);
+
+    /**
+     * Drop all in-memory tiles. The disk store is left untouched.
+     */
+    void ClearMemory();
+
+    /**
+     * Default disk location, ~/.cache/garmin-disconnect/tiles on Linux.
+     */
+    static std::filesystem::path DefaultDirectory();
+
+private:
+    std::filesystem::path TilePath(const TileKey& key) const;
+    void InsertLocked(const TileKey& key, MapTilePtr tile);
+    MapTilePtr LoadFromDisk(const TileKey& key) const;
+    void SaveToDisk(const TileKey& key, const MapTileImage& tile) const;
+
+    using LruList = std::list<std::pair<TileKey, MapTilePtr>>;
+
+    std::mutex m_mutex;
+    size_t m_capacity;
+    std::filesystem::path m_diskDirectory;
+    LruList m_lru;
+    std::unordered_map<TileKey, LruList::iterator, TileKeyHash> m_index;
+};
@@ -0,0 +1,100 @@
+#include "MapTileWorker.hpp"
+#include "MapTileCache.hpp"
+#include "../interfaces/IMapTileSource.hpp"
+#include "trace/trace.hpp"
+
+MapTileWorker::MapTileWorker(MapTileCache& cache, TileReadyCallback onTileReady)
+    : m_cache(cache), m_onTileReady(std::move(onTileReady)), m_generation(0), m_stopping(false) {
+}
+
+MapTileWorker::~MapTileWorker() {
+    Stop();
+}
+
+void MapTileWorker::Start(TileSourceFactory createSource) {
+    Stop();
+
+    m_stopping = false;
+    m_thread = std::thread(&MapTileWorker::Run, this, std::move(createSource));
+}
+
+void MapTileWorker::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_queue.clear();
+    }
+    m_wakeup.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+uint64_t MapTileWorker::Request(const std::vector<TileKey>& visible, const std::vector<TileKey>& prefetch) {
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        generation = ++m_generation;
+
+        m_queue.clear();
+        for (const auto& key : visible) {
+            m_queue.push_back(Job{key, generation, true});
+        }
+        for (const auto& key : prefetch) {
+            m_queue.push_back(Job{key, generation, false});
+        }
+    }
+    m_wakeup.notify_one();
+
+    return generation;
+}
+
+void MapTileWorker::Prefetch(const std::vector<TileKey>& tiles) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t generation = m_generation.load();
+        for (const auto& key : tiles) {
+            m_queue.push_back(Job{key, generation, false});
+        }
+    }
+    m_wakeup.notify_one();
+}
+
+void MapTileWorker::Run(TileSourceFactory createSource) {
+    std::unique_ptr<IMapTileSource> source = createSource();
+    if (!source || !source->isValid()) {
+        return;
+    }
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+
+            if (m_stopping) {
+                return;
+            }
+
+            job = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        // Disk hits are promoted to memory here, off the UI thread
+        MapTilePtr tile = m_cache.Get(job.key);
+        if (!tile) {
+            GFU_TRACE_COUNT("map.tile-miss", 1);
+            GFU_TRACE_SCOPE("map.render-tile", "render");
+            tile = source->renderTile(job.key.z, job.key.x, job.key.y);
+            m_cache.Put(job.key, tile, source->persistTiles());
+        } else {
+            GFU_TRACE_COUNT("map.tile-hit", 1);
+        }
+
+        // A newer viewport was requested meanwhile - the tile stays cached but nobody is waiting for it
+        if (tile && job.visible && job.generation == m_generation.load() && m_onTileReady) {
+            m_onTileReady(job.generation);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MapTiles.hpp"
+
+class MapTileCache;
+class IMapTileSource;
+
+/**
+ * Background tile renderer.
+ *
+ * Owns its own tile source (a MapnikRenderer with its own mapnik::Map, or an
+ * MBTiles connection) on a dedicated thread, so rendering never runs on the UI
+ * thread. Tiles are loaded from the disk store or rendered into the shared MapTileCache.
+ *
+ * Every request bumps a generation counter and replaces the pending queue, so
+ * tiles of viewports the user has already left are never rendered. Visible tiles
+ * are reported through the ready callback only if their generation is still current.
+ */
+class MapTileWorker {
+public:
+    /**
+     * Called on the worker thread when a visible tile of the given generation is
+     * available in the cache. Must only hand the notification over to the UI thread.
+     */
+    using TileReadyCallback = std::function<void(uint64_t generation)>;
+
+    /**
+     * Creates the worker's tile source, called on the worker thread.
+     * Returns nullptr if the source cannot be opened.
+     */
+    using TileSourceFactory = std::function<std::unique_ptr<IMapTileSource>()>;
+
+    MapTileWorker(MapTileCache& cache, TileReadyCallback onTileReady);
+    ~MapTileWorker();
+
+    /**
+     * (Re)start the worker with a new tile source. Pending requests are discarded.
+     */
+    void Start(TileSourceFactory createSource);
+
+    /**
+     * Stop the worker thread and drop pending requests.
+     */
+    void Stop();
+
+    /**
+     * Replace the pending queue with a new viewport: visible tiles first, then
+     * the prefetch ring. Tiles already in memory are reported or skipped cheaply.
+     * @return Generation of this request
+     */
+    uint64_t Request(const std::vector<TileKey>& visible, const std::vector<TileKey>& prefetch);
+
+    /**
+     * Append tiles that may be needed soon behind the pending queue, without starting
+     * a new generation. Dropped by the next Request().
+     */
+    void Prefetch(const std::vector<TileKey>& tiles);
+
+private:
+    struct Job {
+        TileKey key;
+        uint64_t generation;
+        bool visible;
+    };
+
+    void Run(TileSourceFactory createSource);
+
+    MapTileCache& m_cache;
+    TileReadyCallback m_onTileReady;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::deque<Job> m_queue;
+    std::atomic<uint64_t> m_generation;
+    bool m_stopping;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Slippy map tile geometry shared by the tile renderer, the tile cache and MapPanel.
+// World pixel coordinates follow the usual Web Mercator tiling scheme: at zoom z the
+// whole world is (MAP_TILE_SIZE << z) pixels wide, with (0, 0) at the north-west corner.
+
+constexpr int MAP_TILE_SIZE = 256;
+constexpr int MAP_MIN_ZOOM = 1;
+constexpr int MAP_MAX_ZOOM = 19;
+constexpr double WEB_MERCATOR_EXTENT = 20037508.34;
+constexpr double WEB_MERCATOR_MAX_LAT = 85.05112878;
+
+struct TileKey {
+    uint64_t styleHash;
+    int z;
+    int x;
+    int y;
+
+    bool operator==(const TileKey& other) const {
+        return styleHash == other.styleHash && z == other.z && x == other.x && y == other.y;
+    }
+};
+
+struct TileKeyHash {
+    size_t operator()(const TileKey& key) const {
+        uint64_t h = key.styleHash;
+        h ^= (static_cast<uint64_t>(key.z) << 58) ^ (static_cast<uint64_t>(key.x) << 29) ^ static_cast<uint64_t>(key.y);
+        h *= 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+};
+
+// Decoded tile pixels, RGB without alpha. Kept outside of wxImage so tiles can be
+// shared between the worker threads and the UI thread without wx reference counting.
+struct MapTileImage {
+    int size;
+    std::vector<unsigned char> rgb;
+
+    explicit MapTileImage(int _size) : size(_size), rgb(static_cast<size_t>(_size) * _size * 3, 0) {}
+};
+
+using MapTilePtr = std::shared_ptr<const MapTileImage>;
+
+namespace MapProjection {
+
+inline double WorldSize(int zoom) {
+    return static_cast<double>(MAP_TILE_SIZE) * static_cast<double>(1 << zoom);
+}
+
+inline int TileCount(int zoom) {
+    return 1 << zoom;
+}
+
+inline double LonToWorldX(double lon, int zoom) {
+    return (lon + 180.0) / 360.0 * WorldSize(zoom);
+}
+
+inline double LatToWorldY(double lat, int zoom) {
+    lat = std::clamp(lat, -WEB_MERCATOR_MAX_LAT, WEB_MERCATOR_MAX_LAT);
+    double lat_rad = lat * M_PI / 180.0;
+    return (1.0 - std::log(std::tan(lat_rad) + 1.0 / std::cos(lat_rad)) / M_PI) / 2.0 * WorldSize(zoom);
+}
+
+inline double WorldXToLon(double x, int zoom) {
+    return x / WorldSize(zoom) * 360.0 - 180.0;
+}
+
+inline double WorldYToLat(double y, int zoom) {
+    double n = M_PI - 2.0 * M_PI * y / WorldSize(zoom);
+    return 180.0 / M_PI * std::atan(std::sinh(n));
+}
+
+// Ground resolution at the given latitude, used for the scale indicator
+inline double MetersPerPixel(double lat, int zoom) {
+    return 2.0 * WEB_MERCATOR_EXTENT * std::cos(lat * M_PI / 180.0) / WorldSize(zoom);
+}
+
+// Web Mercator (EPSG:3857) extent of a tile, as expected by mapnik::Map::zoom_to_box()
+inline void TileMercatorBounds(int z, int x, int y, double& min_x, double& min_y, double& max_x, double& max_y) {
+    double span = 2.0 * WEB_MERCATOR_EXTENT / TileCount(z);
+    min_x = -WEB_MERCATOR_EXTENT + x * span;
+    max_x = min_x + span;
+    max_y = WEB_MERCATOR_EXTENT - y * span;
+    min_y = max_y - span;
+}
+
+// Tile x index wrapped around the antimeridian
+inline int WrapTileX(int x, int zoom) {
+    int n = TileCount(zoom);
+    return ((x % n) + n) % n;
+}
+
+} // namespace MapProjection
@@ -1,5 +1,7 @@
 #include "ProductEditorPanel.hpp"
 #include "../utils/SettingsManager.hpp"
+#include "../utils/ParsedFileCache.hpp"
+#include "../utils/JobScheduler.hpp"
 #include "../../parsers/binary-mapper.hpp"
 #include "../../parsers/product-scanner.hpp"
 #include <fit.hpp>
@@ -45,6 +47,12 @@ ProductEditorPanel::ProductEditorPanel(wxWindow* parent)
     ClearSelection();
 }
 
+ProductEditorPanel::~ProductEditorPanel() {
+    // A running apply still saves its file, only the message is dropped
+    m_loadJob.Cancel();
+    m_applyJob.Cancel();
+}
+
 void ProductEditorPanel::CreateLayout() {
     m_mainSizer = new wxBoxSizer(wxVERTICAL);
     
@@ -134,41 +142,49 @@ void ProductEditorPanel::CreateLayout() {
 }
 
 void ProductEditorPanel::LoadFile(const std::string& filePath) {
-    try {
-        m_currentFilePath = filePath;
-        m_hasSelection = true;
-        
-        // Use BinaryMapper and ProductScanner to read current product ID
-        darauble::BinaryMapper mapper(filePath.c_str());
-        mapper.parse();
-        
-        if (mapper.isParsed()) {
-            darauble::ProductScanner scanner(mapper);
-            scanner.scan();
-            
-            // Get the first product ID found (from file_id message)
-            const auto& productIds = scanner.productIds();
-            if (!productIds.empty()) {
-                // Read the product ID from the first offset (need mutable copy for readU16)
-                uint64_t offset = productIds[0].offset;
-                uint16_t productId = mapper.readU16(offset, productIds[0].architecture);
-                m_currentProductId = productId;
-            } else {
-                m_currentProductId = -1;
+    m_currentFilePath = filePath;
+    m_hasSelection = true;
+    m_currentProductId = -1;
+    UpdateCurrentProductDisplay();
+    m_currentProductValue->SetLabel("Reading...");
+
+    // Product offsets come from the shared cache, the file is parsed once for all panels
+    struct Result {
+        int productId = -1;
+        std::string error;
+    };
+    auto result = std::make_shared<Result>();
+
+    m_loadJob = JobScheduler::Instance().Submit(JobLane::Interactive,
+        [filePath, result](JobContext& job) {
+            if (job.IsCancelled()) return;
+            try {
+                auto file = ParsedFileCache::Instance().Get(filePath);
+
+                // Get the first product ID found (from file_id message)
+                const auto& productIds = file->GetProductIds();
+                if (!productIds.empty()) {
+                    // Read the product ID from the first offset (need mutable copy for readU16)
+                    uint64_t offset = productIds[0].offset;
+                    result->productId = file->GetMapper().readU16(offset, productIds[0].architecture);
+                }
+            } catch (const std::exception& e) {
+                result->error = e.what();
             }
-        } else {
-            m_currentProductId = -1;
-        }
-        
-        UpdateCurrentProductDisplay();
-        
-    } catch (const std::exception& e) {
-        m_currentProductId = -1;
-        m_hasSelection = false;
-        wxMessageBox(wxString::Format("Error reading file: %s", e.what()), 
-                    "Error", wxOK | wxICON_ERROR, this);
-        ClearSelection();
-    }
+        },
+        [this, result]() {
+            if (!result->error.empty()) {
+                m_hasSelection = false;
+                wxMessageBox(wxString::Format("Error reading file: %s", result->error),
+                            "Error", wxOK | wxICON_ERROR, this);
+                ClearSelection();
+                return;
+            }
+
+            m_currentProductId = result->productId;
+            UpdateCurrentProductDisplay();
+        },
+        {}, "product-file");
 }
 
 void ProductEditorPanel::OnTabActivated(const std::string& activityFilePath) {
@@ -245,40 +261,60 @@ void ProductEditorPanel::OnApply(wxCommandEvent& event) {
     }
     
     std::string outputPath = saveDialog.GetPath().ToStdString();
-    
-    try {
-        // Use the same logic as ProductCommand::replace
-        darauble::BinaryMapper mapper(m_currentFilePath.c_str());
-        mapper.parse();
-        
-        if (mapper.isParsed()) {
-            uint16_t oldProductId = static_cast<uint16_t>(m_currentProductId);
-            uint16_t newProductIdU16 = static_cast<uint16_t>(newProductId);
-            
-            darauble::ProductScanner scanner(mapper, oldProductId);
-            scanner.scan();
-            
-            // Modify all matching product IDs
-            for (const auto& productId : scanner.productIds()) {
-                uint64_t offset = productId.offset;
-                mapper.write(offset, newProductIdU16, productId.architecture);
+    std::string inputPath = m_currentFilePath;
+    uint16_t oldProductId = static_cast<uint16_t>(m_currentProductId);
+    uint16_t newProductIdU16 = static_cast<uint16_t>(newProductId);
+
+    struct Result {
+        bool parsed = false;
+        std::string error;
+    };
+    auto result = std::make_shared<Result>();
+
+    m_applyButton->Enable(false);
+    m_applyJob = JobScheduler::Instance().Submit(JobLane::Bulk,
+        [inputPath, outputPath, oldProductId, newProductIdU16, result](JobContext&) {
+            try {
+                // Use the same logic as ProductCommand::replace, on a private copy: the cached mapper is shared
+                darauble::BinaryMapper::recover(inputPath.c_str());
+                darauble::BinaryMapper mapper(inputPath.c_str());
+                mapper.parse();
+
+                if (!mapper.isParsed()) {
+                    return;
+                }
+                result->parsed = true;
+
+                darauble::ProductScanner scanner(mapper, oldProductId);
+                scanner.scan();
+
+                // Modify all matching product IDs
+                for (const auto& productId : scanner.productIds()) {
+                    uint64_t offset = productId.offset;
+                    mapper.write(offset, newProductIdU16, productId.architecture);
+                }
+
+                mapper.writeCRC();
+                mapper.save(outputPath.c_str());
+                ParsedFileCache::Instance().Invalidate(outputPath);
+            } catch (const std::exception& e) {
+                result->error = e.what();
             }
-            
-            mapper.writeCRC();
-            mapper.save(outputPath.c_str());
-            
-            wxMessageBox(wxString::Format("Product ID successfully changed from %d to %d\nSaved to: %s", 
-                        oldProductId, newProductId, outputPath), 
-                        "Success", wxOK | wxICON_INFORMATION, this);
-            
-        } else {
-            wxMessageBox("Failed to parse FIT file", "Error", wxOK | wxICON_ERROR, this);
-        }
-        
-    } catch (const std::exception& e) {
-        wxMessageBox(wxString::Format("Error processing file: %s", e.what()), 
-                    "Error", wxOK | wxICON_ERROR, this);
-    }
+        },
+        [this, result, oldProductId, newProductId, outputPath]() {
+            m_applyButton->Enable(m_hasSelection);
+
+            if (!result->error.empty()) {
+                wxMessageBox(wxString::Format("Error processing file: %s", result->error),
+                            "Error", wxOK | wxICON_ERROR, this);
+            } else if (!result->parsed) {
+                wxMessageBox("Failed to parse FIT file", "Error", wxOK | wxICON_ERROR, this);
+            } else {
+                wxMessageBox(wxString::Format("Product ID successfully changed from %d to %d\nSaved to: %s",
+                            oldProductId, newProductId, outputPath),
+                            "Success", wxOK | wxICON_INFORMATION, this);
+            }
+        });
 }
 
 void ProductEditorPanel::OnAddFavorite(wxCommandEvent& event) {
@@ -9,6 +9,7 @@
 #include <vector>
 #include <string>
 #include "../interfaces/IActivityPanel.hpp"
+#include "../utils/JobScheduler.hpp"
 
 struct FavoriteProduct {
     int id;
@@ -18,7 +19,7 @@ struct FavoriteProduct {
 class ProductEditorPanel : public wxPanel, public IActivityPanel {
 public:
     ProductEditorPanel(wxWindow* parent);
-    virtual ~ProductEditorPanel() = default;
+    virtual ~ProductEditorPanel();
 
     // IActivityPanel interface
     void OnTabActivated(const std::string& activityFilePath) override;
@@ -56,6 +57,10 @@ private:
     int m_currentProductId;
     bool m_hasSelection;
     std::vector<FavoriteProduct> m_favoriteProducts;
+
+    // Background work, cancelled with the panel
+    JobHandle m_loadJob;
+    JobHandle m_applyJob;
     
     // Events
     wxDECLARE_EVENT_TABLE();
@@ -0,0 +1,248 @@
+#include "ActivityLoader.hpp"
+#include "JobScheduler.hpp"
+#include "activity-cache/activity-cache.hpp"
+#include "parsers/session-scanner.hpp"
+#include "coordinates/convert.hpp"
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/datetime.h>
+#include <fit_date_time.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+namespace {
+
+// Results are handed to the UI at least this often, or when a batch is full
+constexpr size_t LOADER_BATCH_SIZE = 64;
+constexpr auto LOADER_BATCH_INTERVAL = std::chrono::milliseconds(100);
+
+void SetPlaceholder(ActivityDisplayData& displayData, ActivityDisplayData::Status status, const wxString& sport) {
+    displayData.status = status;
+    displayData.timestamp = 0;
+    displayData.date = "Parse Error";
+    displayData.name = "";
+    displayData.sport = sport;
+    displayData.duration = "--:--";
+    displayData.distance = "-- km";
+    displayData.speedPace = "--";
+    displayData.heartRate = "--";
+}
+
+} // namespace
+
+ActivityLoader::ActivityLoader(const wxString& rootPath, std::shared_ptr<darauble::ActivityCache> cache,
+                               Filter filter, BatchCallback onBatch)
+    : m_rootPath(rootPath),
+      m_cache(std::move(cache)),
+      m_filter(std::move(filter)),
+      m_onBatch(std::move(onBatch)),
+      m_nextFile(0),
+      m_doneFiles(0),
+      m_activeWorkers(0),
+      m_cancelled(false),
+      m_finished(false),
+      m_runningJobs(0) {
+}
+
+ActivityLoader::ActivityLoader(std::vector<FileEntry> files, std::shared_ptr<darauble::ActivityCache> cache,
+                               Filter filter, BatchCallback onBatch)
+    : ActivityLoader(wxEmptyString, std::move(cache), std::move(filter), std::move(onBatch)) {
+    m_files = std::move(files);
+}
+
+ActivityLoader::~ActivityLoader() {
+    Cancel();
+
+    std::unique_lock<std::mutex> lock(m_jobsMutex);
+    m_jobsDone.wait(lock, [this]() { return m_runningJobs == 0; });
+}
+
+void ActivityLoader::Start() {
+    SubmitJob(&ActivityLoader::Run);
+}
+
+void ActivityLoader::Cancel() {
+    m_cancelled = true;
+}
+
+void ActivityLoader::SubmitJob(void (ActivityLoader::*run)()) {
+    {
+        std::lock_guard<std::mutex> lock(m_jobsMutex);
+        ++m_runningJobs;
+    }
+
+    // Every submitted job runs, also when the scheduler stops, so the count always drops back
+    JobScheduler::Instance().Submit(JobLane::Bulk, [this, run](JobContext&) {
+        (this->*run)();
+
+        std::lock_guard<std::mutex> lock(m_jobsMutex);
+        if (--m_runningJobs == 0) {
+            m_finished = true;
+            m_jobsDone.notify_all();
+        }
+    });
+}
+
+void ActivityLoader::Run() {
+    // Without a root the files were given up front
+    if (!m_rootPath.IsEmpty()) {
+        CollectFiles(m_rootPath, "");
+    }
+
+    if (m_cancelled) {
+        return;
+    }
+
+    // One job per bulk worker of the scheduler, more would only wait in its queue
+    size_t workerCount = std::min(JobScheduler::BulkWorkers(), std::max<size_t>(m_files.size(), 1));
+
+    m_activeWorkers = workerCount;
+    for (size_t i = 0; i < workerCount; ++i) {
+        SubmitJob(&ActivityLoader::RunWorker);
+    }
+}
+
+void ActivityLoader::CollectFiles(const wxString& path, const wxString& relativePath) {
+    wxDir dir(path);
+    if (!dir.IsOpened() || m_cancelled) return;
+
+    wxString filename;
+
+    // First, FIT files in the current directory
+    bool cont = dir.GetFirst(&filename, "*.fit", wxDIR_FILES);
+    while (cont) {
+        wxString fullPath = path + wxFileName::GetPathSeparator() + filename;
+        wxString displayPath = relativePath.IsEmpty() ? filename :
+                              relativePath + wxFileName::GetPathSeparator() + filename;
+        m_files.push_back(FileEntry{fullPath, displayPath});
+        cont = dir.GetNext(&filename);
+    }
+
+    // Always scan subdirectories recursively
+    // (This ensures clicking any folder shows all files from that folder and below)
+    cont = dir.GetFirst(&filename, "", wxDIR_DIRS);
+    while (cont && !m_cancelled) {
+        wxString subPath = path + wxFileName::GetPathSeparator() + filename;
+        wxString newRelativePath = relativePath.IsEmpty() ? filename :
+                                 relativePath + wxFileName::GetPathSeparator() + filename;
+        CollectFiles(subPath, newRelativePath);
+        cont = dir.GetNext(&filename);
+    }
+}
+
+void ActivityLoader::RunWorker() {
+    std::vector<ActivityDisplayData> batch;
+    auto lastFlush = std::chrono::steady_clock::now();
+    const size_t total = m_files.size();
+
+    while (!m_cancelled) {
+        size_t index = m_nextFile++;
+        if (index >= total) break;
+
+        ActivityDisplayData displayData = LoadActivity(m_files[index].fullPath, m_files[index].displayPath, *m_cache);
+        size_t done = ++m_doneFiles;
+
+        if (!m_filter || m_filter(displayData)) {
+            batch.push_back(std::move(displayData));
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (batch.size() >= LOADER_BATCH_SIZE || now - lastFlush >= LOADER_BATCH_INTERVAL) {
+            // Progress is reported even when everything was filtered out
+            m_onBatch(std::move(batch), done, total, false);
+            batch.clear();
+            lastFlush = now;
+        }
+    }
+
+    if (m_cancelled) {
+        --m_activeWorkers;
+        return;
+    }
+
+    // Last batch before leaving, so the finishing call is ordered after it
+    if (!batch.empty()) {
+        m_onBatch(std::move(batch), m_doneFiles, total, false);
+    }
+
+    if (--m_activeWorkers == 0) {
+        m_onBatch({}, m_doneFiles, total, true);
+    }
+}
+
+ActivityDisplayData ActivityLoader::LoadActivity(const wxString& fullPath, const wxString& displayPath,
+                                                 darauble::ActivityCache& cache) {
+    ActivityDisplayData displayData;
+    displayData.filePath = displayPath;
+    displayData.fullPath = fullPath;
+
+    // One stat() when cached, otherwise the file is parsed and the cache updated
+    darauble::CachedActivity activity = cache.load(std::filesystem::path(fullPath.ToStdString()));
+    FromCachedActivity(activity, displayData);
+    return displayData;
+}
+
+void ActivityLoader::FromCachedActivity(const darauble::CachedActivity& activity, ActivityDisplayData& displayData) {
+    if (activity.status == darauble::CachedActivity::STATUS_NO_DATA) {
+        // Fallback for files that couldn't be parsed
+        SetPlaceholder(displayData, ActivityDisplayData::Status::NoData, "Unknown");
+        return;
+    }
+    if (activity.status != darauble::CachedActivity::STATUS_PARSED) {
+        SetPlaceholder(displayData, ActivityDisplayData::Status::ParseError, "Error");
+        return;
+    }
+
+    displayData.status = ActivityDisplayData::Status::Parsed;
+    displayData.timestamp = activity.timestamp;
+
+    // Format timestamp as date
+    if (activity.timestamp > 0) {
+        // Convert FIT timestamp to UNIX timestamp using FIT SDK
+        fit::DateTime fitDateTime(activity.timestamp);
+        wxDateTime activityTime(fitDateTime.GetTimeT());
+        displayData.date = activityTime.Format("%Y-%m-%d %H:%M");
+    } else {
+        displayData.date = "Unknown Date";
+    }
+
+    darauble::ActivityData sport;
+    sport.primarySport = activity.sport;
+    sport.primarySubSport = activity.subSport;
+
+    displayData.name = wxString::FromUTF8(activity.getName());
+    displayData.sport = wxString::FromUTF8(sport.getPrimarySportName());
+    if (sport.isMultisport()) {
+        displayData.sport += wxString::Format(" (%u sessions)", static_cast<unsigned>(activity.sessionCount));
+    }
+
+    darauble::SessionData aggregated;
+    aggregated.totalElapsedTime = activity.elapsedTime;
+    aggregated.totalDistance = activity.totalDistance;
+    aggregated.avgSpeed = activity.avgSpeed;
+    aggregated.avgHeartRate = activity.avgHeartRate;
+    aggregated.totalSets = activity.totalSets;
+
+    displayData.duration = wxString::FromUTF8(aggregated.getFormattedDuration());
+    displayData.distance = wxString::FromUTF8(aggregated.getFormattedDistance(activity.sport, activity.subSport));
+    displayData.speedPace = wxString::FromUTF8(aggregated.getFormattedSpeed(activity.sport, activity.subSport));
+    displayData.heartRate = wxString::FromUTF8(aggregated.getFormattedHeartRate());
+
+    displayData.sportId = activity.sport;
+    displayData.subSportId = activity.subSport;
+    displayData.sessionCount = activity.sessionCount;
+    displayData.elapsedTime = activity.elapsedTime;
+    displayData.totalDistance = activity.totalDistance;
+    displayData.avgSpeed = activity.avgSpeed;
+    displayData.avgHeartRate = activity.avgHeartRate;
+    displayData.totalSets = activity.totalSets;
+
+    if (activity.hasBounds()) {
+        displayData.hasBounds = true;
+        displayData.minLat = darauble::fromInt32(activity.swcLat);
+        displayData.minLon = darauble::fromInt32(activity.swcLong);
+        displayData.maxLat = darauble::fromInt32(activity.necLat);
+        displayData.maxLon = darauble::fromInt32(activity.necLong);
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../models/ActivityData.hpp"
+
+namespace darauble {
+class ActivityCache;
+struct CachedActivity;
+}
+
+/**
+ * Loads the activities of a directory tree as bulk jobs of the JobScheduler.
+ *
+ * One job walks the tree for *.fit files, then a few more jobs load them in parallel:
+ * from the archive's activity cache when the entry is valid, otherwise by parsing
+ * the FIT file (which also refreshes the cache). Results are handed out in batches,
+ * so the list fills in while the scan is still running.
+ *
+ * Cancelling only raises a flag; jobs notice it before their next file, so
+ * a new scan can be started immediately. The destructor waits for the jobs.
+ */
+class ActivityLoader {
+public:
+    struct FileEntry {
+        wxString fullPath;
+        wxString displayPath;
+    };
+
+    /**
+     * Decides on the worker thread whether a loaded activity is reported.
+     */
+    using Filter = std::function<bool(const ActivityDisplayData&)>;
+
+    /**
+     * Called on a worker thread with the next batch of activities and the
+     * overall progress. Called exactly once with finished set, after all other
+     * batches, unless the scan was cancelled. Must only hand the batch over to the UI thread.
+     */
+    using BatchCallback = std::function<void(std::vector<ActivityDisplayData>&& batch,
+                                             size_t done, size_t total, bool finished)>;
+
+    /**
+     * @param rootPath Directory to scan recursively
+     * @param cache Activity cache of the archive the directory belongs to
+     * @param filter Activities rejected by the filter are not reported, may be empty
+     * @param onBatch Receives results, see BatchCallback
+     */
+    ActivityLoader(const wxString& rootPath, std::shared_ptr<darauble::ActivityCache> cache,
+                   Filter filter, BatchCallback onBatch);
+
+    /**
+     * Load the given files only, e.g. the ones that changed since the directory was loaded.
+     */
+    ActivityLoader(std::vector<FileEntry> files, std::shared_ptr<darauble::ActivityCache> cache,
+                   Filter filter, BatchCallback onBatch);
+    ~ActivityLoader();
+
+    ActivityLoader(const ActivityLoader&) = delete;
+    ActivityLoader& operator=(const ActivityLoader&) = delete;
+
+    void Start();
+
+    /**
+     * Stop reporting and loading further files. Does not wait for the threads.
+     */
+    void Cancel();
+
+    /**
+     * Check whether all jobs are done, so destroying the loader won't block.
+     */
+    bool IsFinished() const { return m_finished; }
+
+    /**
+     * Load a single activity from the cache, or parse the FIT file and update the cache.
+     * Files that can't be parsed are returned with placeholder values. Thread-safe.
+     * @param fullPath Absolute path of the FIT file
+     * @param displayPath Path shown in the list, relative to the scanned directory
+     * @param cache Activity cache of the archive
+     */
+    static ActivityDisplayData LoadActivity(const wxString& fullPath, const wxString& displayPath,
+                                            darauble::ActivityCache& cache);
+
+    /**
+     * Fill the display record of an activity from its cached summary.
+     */
+    static void FromCachedActivity(const darauble::CachedActivity& activity, ActivityDisplayData& displayData);
+
+private:
+    void Run();
+    void RunWorker();
+    void CollectFiles(const wxString& path, const wxString& relativePath);
+    void SubmitJob(void (ActivityLoader::*run)());
+
+    wxString m_rootPath;
+    std::shared_ptr<darauble::ActivityCache> m_cache;
+    Filter m_filter;
+    BatchCallback m_onBatch;
+
+    std::vector<FileEntry> m_files;
+    std::atomic<size_t> m_nextFile;
+    std::atomic<size_t> m_doneFiles;
+    std::atomic<size_t> m_activeWorkers;
+    std::atomic<bool> m_cancelled;
+    std::atomic<bool> m_finished;
+
+    // Jobs still referring to this loader; the destructor waits for none
+    size_t m_runningJobs;
+    std::mutex m_jobsMutex;
+    std::condition_variable m_jobsDone;
+};
@@ -0,0 +1,37 @@
+#include "ActivityPrefetcher.hpp"
+#include "ParsedFileCache.hpp"
+
+ActivityPrefetcher::ActivityPrefetcher(ReadyCallback onReady)
+    : m_onReady(std::move(onReady)) {
+}
+
+ActivityPrefetcher::~ActivityPrefetcher() {
+    Cancel();
+}
+
+void ActivityPrefetcher::Prefetch(const std::vector<std::string>& paths) {
+    Cancel();
+
+    for (const auto& path : paths) {
+        m_jobs.push_back(JobScheduler::Instance().Submit(JobLane::Bulk,
+            [path](JobContext& job) {
+                if (job.IsCancelled()) {
+                    return;
+                }
+                // Parsing and the coordinate scan are what a selection waits for
+                ParsedFileCache::Instance().Get(path)->GetTrack();
+            },
+            [this, path]() {
+                if (m_onReady) {
+                    m_onReady(path);
+                }
+            }));
+    }
+}
+
+void ActivityPrefetcher::Cancel() {
+    for (auto& job : m_jobs) {
+        job.Cancel();
+    }
+    m_jobs.clear();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "JobScheduler.hpp"
+
+/**
+ * Parses the activities around the selection as bulk jobs, so that stepping to
+ * one of them finds it in the ParsedFileCache.
+ *
+ * Every Prefetch() cancels the previous window: only the neighbours of the latest
+ * selection are worked on, nearest first.
+ */
+class ActivityPrefetcher {
+public:
+    /**
+     * Called on the UI thread once a file is parsed and its track scanned.
+     */
+    using ReadyCallback = std::function<void(const std::string& path)>;
+
+    explicit ActivityPrefetcher(ReadyCallback onReady);
+    ~ActivityPrefetcher();
+
+    ActivityPrefetcher(const ActivityPrefetcher&) = delete;
+    ActivityPrefetcher& operator=(const ActivityPrefetcher&) = delete;
+
+    void Prefetch(const std::vector<std::string>& paths);
+    void Cancel();
+
+private:
+    ReadyCallback m_onReady;
+    std::vector<JobHandle> m_jobs;
+};
@@ -0,0 +1,194 @@
+#include "JobScheduler.hpp"
+#include <algorithm>
+
+void JobContext::ReportProgress(double fraction, const wxString& status) {
+    if (!m_state->onProgress || m_state->cancelled) {
+        return;
+    }
+
+    std::shared_ptr<JobState> state = m_state;
+    JobScheduler::Instance().PostToUi(state, [state, fraction, status]() {
+        state->onProgress(fraction, status);
+    });
+}
+
+JobScheduler& JobScheduler::Instance() {
+    static JobScheduler instance;
+    return instance;
+}
+
+JobScheduler::JobScheduler()
+    : m_stopping(false), m_uiQueue(nullptr) {
+}
+
+JobScheduler::~JobScheduler() {
+    Shutdown();
+}
+
+size_t JobScheduler::BulkWorkers() {
+    // Parsing is mostly I/O and page faults, a few workers per core are not wasted
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+}
+
+void JobScheduler::Start() {
+    if (!m_workers.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+    }
+
+    // The first worker is reserved for interactive jobs
+    m_workers.emplace_back(&JobScheduler::RunWorker, this, true);
+    for (size_t i = 0; i < BulkWorkers(); ++i) {
+        m_workers.emplace_back(&JobScheduler::RunWorker, this, false);
+    }
+
+    if (wxTheApp) {
+        wxTheApp->Bind(wxEVT_IDLE, &JobScheduler::OnIdle, this);
+    }
+}
+
+void JobScheduler::Shutdown() {
+    if (m_workers.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    if (wxTheApp) {
+        wxTheApp->Unbind(wxEVT_IDLE, &JobScheduler::OnIdle, this);
+    }
+    DrainUiQueue(false);
+}
+
+JobHandle JobScheduler::Submit(JobLane lane, JobState::Work work, JobState::DoneCallback onDone,
+                               JobState::ProgressCallback onProgress, const std::string& key) {
+    auto job = std::make_shared<JobState>();
+    job->lane = lane;
+    job->key = key;
+    job->work = std::move(work);
+    job->onDone = std::move(onDone);
+    job->onProgress = std::move(onProgress);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!key.empty()) {
+            // Only the latest request of a kind matters, e.g. the last selected activity
+            auto it = m_keyed.find(key);
+            if (it != m_keyed.end()) {
+                it->second->cancelled = true;
+            }
+            m_keyed[key] = job;
+        }
+
+        if (m_stopping) {
+            job->cancelled = true;
+        }
+        (lane == JobLane::Interactive ? m_interactive : m_bulk).push_back(job);
+    }
+    m_wakeup.notify_all();
+
+    return JobHandle(job);
+}
+
+void JobScheduler::RunWorker(bool interactiveOnly) {
+    while (true) {
+        std::shared_ptr<JobState> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait(lock, [this, interactiveOnly]() {
+                return m_stopping || !m_interactive.empty() || (!interactiveOnly && !m_bulk.empty());
+            });
+
+            if (!m_interactive.empty()) {
+                job = std::move(m_interactive.front());
+                m_interactive.pop_front();
+            } else if (!interactiveOnly && !m_bulk.empty()) {
+                job = std::move(m_bulk.front());
+                m_bulk.pop_front();
+            } else {
+                return; // Stopping and nothing left for this worker
+            }
+
+            if (m_stopping) {
+                job->cancelled = true;
+            }
+        }
+
+        RunJob(job);
+    }
+}
+
+void JobScheduler::RunJob(const std::shared_ptr<JobState>& job) {
+    JobContext context(job);
+    try {
+        job->work(context);
+    } catch (...) {
+        // A job's owner hears about failures through its own results, never by an exception
+        job->cancelled = true;
+    }
+    job->finished = true;
+
+    if (job->onDone && !job->cancelled) {
+        PostToUi(job, job->onDone);
+    }
+
+    if (!job->key.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_keyed.find(job->key);
+        if (it != m_keyed.end() && it->second == job) {
+            m_keyed.erase(it);
+        }
+    }
+}
+
+void JobScheduler::PostToUi(std::shared_ptr<JobState> job, std::function<void()> function) {
+    UiMessage* message = new UiMessage{std::move(job), std::move(function), nullptr};
+
+    message->next = m_uiQueue.load(std::memory_order_relaxed);
+    while (!m_uiQueue.compare_exchange_weak(message->next, message,
+                                            std::memory_order_release, std::memory_order_relaxed)) {
+    }
+
+    wxWakeUpIdle();
+}
+
+void JobScheduler::OnIdle(wxIdleEvent& event) {
+    DrainUiQueue(true);
+    event.Skip();
+}
+
+void JobScheduler::DrainUiQueue(bool deliver) {
+    UiMessage* stack = m_uiQueue.exchange(nullptr, std::memory_order_acquire);
+
+    // The stack holds the newest message first
+    UiMessage* queue = nullptr;
+    while (stack) {
+        UiMessage* next = stack->next;
+        stack->next = queue;
+        queue = stack;
+        stack = next;
+    }
+
+    while (queue) {
+        UiMessage* next = queue->next;
+        if (deliver && !queue->job->cancelled) {
+            queue->function();
+        }
+        delete queue;
+        queue = next;
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class JobLane {
+    Interactive, // The user is waiting for it: the selected activity, the tab just opened
+    Bulk         // Directory scans, prefetching, batch edits
+};
+
+class JobContext;
+
+/**
+ * Shared state of a submitted job.
+ */
+struct JobState {
+    using Work = std::function<void(JobContext& job)>;
+    using DoneCallback = std::function<void()>;
+    using ProgressCallback = std::function<void(double fraction, const wxString& status)>;
+
+    JobLane lane = JobLane::Bulk;
+    std::string key;
+    Work work;
+    DoneCallback onDone;
+    ProgressCallback onProgress;
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> finished{false};
+};
+
+/**
+ * Handed to the work function of a running job.
+ */
+class JobContext {
+public:
+    bool IsCancelled() const { return m_state->cancelled; }
+
+    /**
+     * For code that polls a plain flag, like OsmRegionExtractor::CollectArchiveBounds().
+     */
+    const std::atomic<bool>& CancelFlag() const { return m_state->cancelled; }
+
+    /**
+     * Report progress to the job's progress callback, which runs on the UI thread.
+     */
+    void ReportProgress(double fraction, const wxString& status = wxEmptyString);
+
+private:
+    friend class JobScheduler;
+    explicit JobContext(std::shared_ptr<JobState> state) : m_state(std::move(state)) {}
+
+    std::shared_ptr<JobState> m_state;
+};
+
+/**
+ * Owner's reference to a submitted job. An empty handle refers to no job.
+ */
+class JobHandle {
+public:
+    JobHandle() = default;
+
+    /**
+     * Ask the job to stop; its done and progress callbacks are not called anymore.
+     * Does not wait for a running job.
+     */
+    void Cancel() { if (m_state) m_state->cancelled = true; }
+
+    bool IsCancelled() const { return m_state && m_state->cancelled; }
+    bool IsFinished() const { return !m_state || m_state->finished; }
+
+private:
+    friend class JobScheduler;
+    explicit JobHandle(std::shared_ptr<JobState> state) : m_state(std::move(state)) {}
+
+    std::shared_ptr<JobState> m_state;
+};
+
+/**
+ * Process-wide pool of worker threads for the GUI.
+ *
+ * Jobs are queued in two lanes. Interactive jobs are always taken first, and one
+ * worker takes nothing else, so a running directory scan never delays the activity
+ * the user just selected. Jobs submitted with a key supersede the previous job with
+ * the same key, which is cancelled whether it is still queued or already running.
+ *
+ * Every submitted job runs its work function exactly once, a cancelled one just sees
+ * IsCancelled() and should return early. So owners counting their jobs always see
+ * them finish. The work function must not touch windows: progress and completion
+ * are passed to the UI thread through a lock-free queue drained on idle, and are
+ * dropped once the job is cancelled. Panels cancel their jobs when destroyed.
+ */
+class JobScheduler {
+public:
+    static JobScheduler& Instance();
+
+    /**
+     * Number of workers taking bulk jobs, i.e. how many of them can run at once.
+     */
+    static size_t BulkWorkers();
+
+    /**
+     * Start the workers and hook the UI queue into the application's idle events.
+     * Called on the UI thread once the application exists.
+     */
+    void Start();
+
+    /**
+     * Run the pending jobs cancelled, stop the workers and drop undelivered callbacks.
+     */
+    void Shutdown();
+
+    /**
+     * Queue a job. Can be called from any thread, also from a running job.
+     * @param lane Interactive or Bulk
+     * @param work Runs on a worker thread
+     * @param onDone Runs on the UI thread after work returned, unless cancelled; may be empty
+     * @param onProgress Runs on the UI thread for ReportProgress(), unless cancelled; may be empty
+     * @param key Coalescing key, empty for none
+     */
+    JobHandle Submit(JobLane lane, JobState::Work work, JobState::DoneCallback onDone = {},
+                     JobState::ProgressCallback onProgress = {}, const std::string& key = {});
+
+private:
+    friend class JobContext;
+
+    // Intrusive node of the UI queue: a lock-free stack reversed when drained
+    struct UiMessage {
+        std::shared_ptr<JobState> job;
+        std::function<void()> function;
+        UiMessage* next = nullptr;
+    };
+
+    JobScheduler();
+    ~JobScheduler();
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    void RunWorker(bool interactiveOnly);
+    void RunJob(const std::shared_ptr<JobState>& job);
+    void PostToUi(std::shared_ptr<JobState> job, std::function<void()> function);
+    void OnIdle(wxIdleEvent& event);
+    void DrainUiQueue(bool deliver);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::deque<std::shared_ptr<JobState>> m_interactive;
+    std::deque<std::shared_ptr<JobState>> m_bulk;
+    std::unordered_map<std::string, std::shared_ptr<JobState>> m_keyed; // Latest job of every key
+    bool m_stopping;
+
+    std::atomic<UiMessage*> m_uiQueue;
+};
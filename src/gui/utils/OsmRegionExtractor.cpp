@@ -0,0 +1,473 @@
+#include "OsmRegionExtractor.hpp"
+#include "DataDirectoryResolver.hpp"
+#include "activity-cache/activity-cache.hpp"
+#include "coordinates/convert.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// A single activity spanning more cells than this is a flight or a bad GPS fix;
+// extracting it would bring back the whole-country database
+constexpr int MAX_ACTIVITY_CELLS_PER_AXIS = 40;
+
+// Identifies the PBF an extract was made from, so a replaced PBF triggers a rebuild
+std::string SourceSignature(const std::string& pbfPath) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    auto size = fs::file_size(pbfPath, ec);
+    if (ec) return "";
+    auto time = fs::last_write_time(pbfPath, ec).time_since_epoch().count();
+    if (ec) return "";
+    return std::to_string(size) + ":" + std::to_string(time);
+}
+
+std::string FormatCoordinate(double value) {
+    // Locale independent, ogr2ogr expects a decimal point
+    return wxString::FromCDouble(value, 6).ToStdString();
+}
+
+bool Overlaps(const OsmRegion& a, const OsmRegion& b) {
+    return a.min_lat < b.max_lat && b.min_lat < a.max_lat
+        && a.min_lon < b.max_lon && b.min_lon < a.max_lon;
+}
+
+} // namespace
+
+// Reports termination to the extractor and deletes itself, as wxWidgets expects
+// from processes without a parent handler
+class OsmRegionExtractor::ExtractProcess : public wxProcess {
+public:
+    explicit ExtractProcess(OsmRegionExtractor* owner)
+        : wxProcess(wxPROCESS_REDIRECT), m_owner(owner) {
+    }
+
+    // The extractor is going away; let the process finish on its own
+    void Orphan() { m_owner = nullptr; }
+
+    void OnTerminate(int WXUNUSED(pid), int status) override {
+        if (m_owner) {
+            m_owner->OnProcessTerminated(status);
+        }
+        delete this;
+    }
+
+private:
+    OsmRegionExtractor* m_owner;
+};
+
+OsmRegionExtractor::OsmRegionExtractor(ProgressCallback onProgress, FinishedCallback onFinished)
+    : m_onProgress(std::move(onProgress)),
+      m_onFinished(std::move(onFinished)),
+      m_process(nullptr),
+      m_pollTimer(this),
+      m_currentRegion(0),
+      m_createDatabase(false),
+      m_cancelled(false) {
+    Bind(wxEVT_TIMER, &OsmRegionExtractor::OnPollTimer, this);
+}
+
+OsmRegionExtractor::~OsmRegionExtractor() {
+    Abort();
+}
+
+std::string OsmRegionExtractor::SpatialitePath(const std::string& pbfPath) {
+    namespace fs = std::filesystem;
+
+    // "country.osm.pbf" -> "country.osm.sqlite", as earlier versions named it
+    fs::path pbfFile(pbfPath);
+    return (pbfFile.parent_path() / (pbfFile.stem().string() + ".sqlite")).string();
+}
+
+OsmExtractState OsmRegionExtractor::LoadState(const std::string& pbfPath) {
+    namespace fs = std::filesystem;
+
+    OsmExtractState state;
+    std::string sqlitePath = SpatialitePath(pbfPath);
+
+    std::error_code ec;
+    if (!fs::exists(sqlitePath, ec)) {
+        return state;
+    }
+
+    std::ifstream sidecar(sqlitePath + ".regions");
+    if (!sidecar) {
+        // Full conversion made before region clipping - usable while it is newer than the PBF
+        std::error_code pbfError, sqliteError;
+        auto pbfTime = fs::last_write_time(pbfPath, pbfError);
+        auto sqliteTime = fs::last_write_time(sqlitePath, sqliteError);
+        state.complete = !pbfError && !sqliteError && sqliteTime >= pbfTime;
+        return state;
+    }
+
+    bool sourceMatches = false;
+    std::set<OsmCell> cells;
+    std::string line;
+
+    while (std::getline(sidecar, line)) {
+        if (line.starts_with("source=")) {
+            sourceMatches = line.substr(7) == SourceSignature(pbfPath);
+        } else if (line.starts_with("cell=")) {
+            std::istringstream in(line.substr(5));
+            int lat, lon;
+            char comma;
+            if (in >> lat >> comma >> lon && comma == ',') {
+                cells.insert({lat, lon});
+            }
+        }
+    }
+
+    if (sourceMatches) {
+        state.cells = std::move(cells);
+    }
+    return state;
+}
+
+void OsmRegionExtractor::AddCells(const OsmRegion& region, std::set<OsmCell>& cells) {
+    int firstLat = static_cast<int>(std::floor(std::max(region.min_lat - OSM_PADDING_DEGREES, -90.0) / OSM_CELL_DEGREES));
+    int lastLat = static_cast<int>(std::floor(std::min(region.max_lat + OSM_PADDING_DEGREES, 90.0 - 1e-9) / OSM_CELL_DEGREES));
+    int firstLon = static_cast<int>(std::floor(std::max(region.min_lon - OSM_PADDING_DEGREES, -180.0) / OSM_CELL_DEGREES));
+    int lastLon = static_cast<int>(std::floor(std::min(region.max_lon + OSM_PADDING_DEGREES, 180.0 - 1e-9) / OSM_CELL_DEGREES));
+
+    if (lastLat < firstLat || lastLon < firstLon) {
+        return;
+    }
+    if (lastLat - firstLat >= MAX_ACTIVITY_CELLS_PER_AXIS || lastLon - firstLon >= MAX_ACTIVITY_CELLS_PER_AXIS) {
+        return;
+    }
+
+    for (int lat = firstLat; lat <= lastLat; ++lat) {
+        for (int lon = firstLon; lon <= lastLon; ++lon) {
+            cells.insert({lat, lon});
+        }
+    }
+}
+
+std::vector<OsmRegion> OsmRegionExtractor::ClusterCells(const std::set<OsmCell>& cells) {
+    std::vector<OsmRegion> regions;
+    std::set<OsmCell> remaining = cells;
+
+    // Flood fill 8-connected cells, each cluster becomes its bounding rectangle
+    while (!remaining.empty()) {
+        std::vector<OsmCell> pending{*remaining.begin()};
+        remaining.erase(remaining.begin());
+
+        int minLat = pending.front().first, maxLat = minLat;
+        int minLon = pending.front().second, maxLon = minLon;
+
+        while (!pending.empty()) {
+            OsmCell cell = pending.back();
+            pending.pop_back();
+
+            minLat = std::min(minLat, cell.first);
+            maxLat = std::max(maxLat, cell.first);
+            minLon = std::min(minLon, cell.second);
+            maxLon = std::max(maxLon, cell.second);
+
+            for (int dLat = -1; dLat <= 1; ++dLat) {
+                for (int dLon = -1; dLon <= 1; ++dLon) {
+                    auto it = remaining.find({cell.first + dLat, cell.second + dLon});
+                    if (it != remaining.end()) {
+                        pending.push_back(*it);
+                        remaining.erase(it);
+                    }
+                }
+            }
+        }
+
+        regions.push_back(OsmRegion{
+            minLat * OSM_CELL_DEGREES, minLon * OSM_CELL_DEGREES,
+            (maxLat + 1) * OSM_CELL_DEGREES, (maxLon + 1) * OSM_CELL_DEGREES});
+    }
+
+    // Rectangles of L-shaped clusters may overlap their neighbours - one pass over the PBF covers both
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < regions.size() && !merged; ++i) {
+            for (size_t j = i + 1; j < regions.size(); ++j) {
+                if (Overlaps(regions[i], regions[j])) {
+                    regions[i].min_lat = std::min(regions[i].min_lat, regions[j].min_lat);
+                    regions[i].min_lon = std::min(regions[i].min_lon, regions[j].min_lon);
+                    regions[i].max_lat = std::max(regions[i].max_lat, regions[j].max_lat);
+                    regions[i].max_lon = std::max(regions[i].max_lon, regions[j].max_lon);
+                    regions.erase(regions.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    return regions;
+}
+
+std::vector<OsmRegion> OsmRegionExtractor::CollectArchiveBounds(const std::string& rootDirectory, const std::atomic<bool>& cancel) {
+    namespace fs = std::filesystem;
+
+    std::vector<OsmRegion> bounds;
+    std::error_code ec;
+    darauble::ActivityCache cache(darauble::ActivityCache::findRoot(rootDirectory));
+
+    for (fs::recursive_directory_iterator it(rootDirectory, fs::directory_options::skip_permission_denied, ec), end;
+         !ec && it != end && !cancel; it.increment(ec)) {
+        std::error_code typeError;
+        if (!it->is_regular_file(typeError)) {
+            continue;
+        }
+
+        std::string extension = it->path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if (extension != ".fit") {
+            continue;
+        }
+
+        // Activities list keeps the cache up to date, so this is mostly one stat() per file
+        darauble::CachedActivity activity = cache.load(it->path());
+        if (activity.hasBounds()) {
+            bounds.push_back(OsmRegion{
+                darauble::fromInt32(activity.swcLat), darauble::fromInt32(activity.swcLong),
+                darauble::fromInt32(activity.necLat), darauble::fromInt32(activity.necLong)});
+        }
+    }
+
+    return bounds;
+}
+
+bool OsmRegionExtractor::Start(const std::string& pbfPath, const OsmExtractState& state, const std::set<OsmCell>& newCells) {
+    namespace fs = std::filesystem;
+
+    if (IsRunning() || newCells.empty() || state.complete) {
+        return false;
+    }
+
+    m_pbfPath = pbfPath;
+    m_sqlitePath = SpatialitePath(pbfPath);
+    m_workingPath = m_sqlitePath + ".partial";
+    m_cells = state.cells;
+    m_cells.insert(newCells.begin(), newCells.end());
+    m_regions = ClusterCells(newCells);
+    m_currentRegion = 0;
+    m_cancelled = false;
+    m_lastError.clear();
+
+    RemoveWorkingFiles();
+
+    // Append to a copy of the current extract; the renderer keeps using the original meanwhile
+    m_createDatabase = state.cells.empty();
+    if (!m_createDatabase) {
+        std::error_code ec;
+        fs::copy_file(m_sqlitePath, m_workingPath, fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            wxLogWarning("Could not copy %s, rebuilding the map extract: %s", m_sqlitePath, ec.message());
+            m_createDatabase = true;
+            m_regions = ClusterCells(m_cells);
+        }
+    }
+
+    if (!LaunchNextRegion()) {
+        RemoveWorkingFiles();
+        return false;
+    }
+    return true;
+}
+
+void OsmRegionExtractor::Cancel() {
+    if (!m_process) return;
+
+    // Termination is reported through OnProcessTerminated(), which cleans up
+    m_cancelled = true;
+    wxProcess::Kill(m_process->GetPid(), wxSIGTERM, wxKILL_CHILDREN);
+}
+
+void OsmRegionExtractor::Abort() {
+    m_pollTimer.Stop();
+    if (!m_process) return;
+
+    long pid = m_process->GetPid();
+    m_process->Orphan();
+    m_process = nullptr;
+    wxProcess::Kill(pid, wxSIGTERM, wxKILL_CHILDREN);
+    RemoveWorkingFiles();
+}
+
+bool OsmRegionExtractor::LaunchNextRegion() {
+    const OsmRegion& region = m_regions[m_currentRegion];
+
+    std::vector<std::string> args = {"ogr2ogr", "-f", "SQLite"};
+    if (m_createDatabase) {
+        args.insert(args.end(), {"-dsco", "SPATIALITE=YES"});
+    } else {
+        args.insert(args.end(), {"-update", "-append"});
+    }
+    args.insert(args.end(), {
+        m_workingPath, m_pbfPath,
+        "-spat", FormatCoordinate(region.min_lon), FormatCoordinate(region.min_lat),
+                 FormatCoordinate(region.max_lon), FormatCoordinate(region.max_lat),
+        // Mapnik queries every tile by bounding box, without an R*Tree it scans whole tables
+        "-lco", "SPATIAL_INDEX=YES",
+        // Larger transactions, as recommended by GDAL for SQLite targets
+        "-gt", "65536",
+        "--config", "OSM_USE_CUSTOM_INDEXING", "NO",
+        "-progress"
+    });
+
+    // Custom osmconf for POI and route support
+    wxString osmconfPath = DataDirectoryResolver::FindDataFile("osmconf.ini");
+    if (!osmconfPath.IsEmpty()) {
+        args.insert(args.end(), {"--config", "OSM_CONFIG_FILE", osmconfPath.ToStdString()});
+    }
+
+    std::vector<const char*> argv;
+    for (const auto& arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+
+    m_progressDigits.clear();
+    m_errorLine.clear();
+
+    m_process = new ExtractProcess(this);
+    long pid = wxExecute(argv.data(), wxEXEC_ASYNC | wxEXEC_MAKE_GROUP_LEADER, m_process);
+    if (pid == 0) {
+        delete m_process;
+        m_process = nullptr;
+        wxLogError("Failed to start ogr2ogr. Install gdal-bin for PBF map support.");
+        return false;
+    }
+
+    wxLogMessage("Extracting map region %zu of %zu: %.2f,%.2f - %.2f,%.2f",
+                 m_currentRegion + 1, m_regions.size(),
+                 region.min_lat, region.min_lon, region.max_lat, region.max_lon);
+
+    ReportProgress(0);
+    m_pollTimer.Start(200);
+    return true;
+}
+
+void OsmRegionExtractor::OnPollTimer(wxTimerEvent& WXUNUSED(event)) {
+    DrainOutput();
+}
+
+void OsmRegionExtractor::DrainOutput() {
+    if (!m_process) return;
+
+    // ogr2ogr -progress prints "0...10...20..." on stdout
+    wxInputStream* out = m_process->GetInputStream();
+    while (out && out->CanRead()) {
+        int c = out->GetC();
+        if (out->LastRead() == 0) break;
+
+        if (std::isdigit(c)) {
+            m_progressDigits += static_cast<char>(c);
+        } else if (!m_progressDigits.empty()) {
+            if (m_progressDigits.size() <= 3) {
+                ReportProgress(std::stoi(m_progressDigits));
+            }
+            m_progressDigits.clear();
+        }
+    }
+
+    // stderr must be drained as well, or ogr2ogr blocks once the pipe is full
+    wxInputStream* err = m_process->GetErrorStream();
+    while (err && err->CanRead()) {
+        int c = err->GetC();
+        if (err->LastRead() == 0) break;
+
+        if (c == '\n') {
+            if (!m_errorLine.empty()) {
+                m_lastError = m_errorLine;
+            }
+            m_errorLine.clear();
+        } else {
+            m_errorLine += static_cast<char>(c);
+        }
+    }
+}
+
+void OsmRegionExtractor::ReportProgress(int percent) {
+    if (!m_onProgress || m_regions.empty()) return;
+
+    double fraction = (m_currentRegion + std::clamp(percent, 0, 100) / 100.0) / m_regions.size();
+    m_onProgress(fraction, wxString::Format("Extracting map region %zu of %zu", m_currentRegion + 1, m_regions.size()));
+}
+
+void OsmRegionExtractor::OnProcessTerminated(int status) {
+    namespace fs = std::filesystem;
+
+    DrainOutput();
+    m_process = nullptr; // Deletes itself once this returns
+    m_pollTimer.Stop();
+
+    if (m_cancelled) {
+        wxLogMessage("Map extract cancelled");
+        Finish(false);
+        return;
+    }
+
+    if (status != 0) {
+        wxLogError("Map extract failed (ogr2ogr exit code %d): %s", status, m_lastError);
+        Finish(false);
+        return;
+    }
+
+    m_createDatabase = false;
+    if (++m_currentRegion < m_regions.size()) {
+        if (!LaunchNextRegion()) {
+            Finish(false);
+        }
+        return;
+    }
+
+    std::error_code ec;
+    fs::rename(m_workingPath, m_sqlitePath, ec);
+    if (ec) {
+        wxLogError("Failed to replace %s: %s", m_sqlitePath, ec.message());
+        Finish(false);
+        return;
+    }
+
+    if (!SaveState()) {
+        wxLogWarning("Failed to record extracted map regions, they will be extracted again");
+    }
+    Finish(true);
+}
+
+void OsmRegionExtractor::Finish(bool success) {
+    m_pollTimer.Stop();
+    if (!success) {
+        RemoveWorkingFiles();
+    }
+    if (m_onFinished) {
+        m_onFinished(success, m_sqlitePath);
+    }
+}
+
+void OsmRegionExtractor::RemoveWorkingFiles() {
+    if (m_workingPath.empty()) return;
+
+    std::error_code ec;
+    for (const char* suffix : {"", "-journal", "-wal", "-shm"}) {
+        std::filesystem::remove(m_workingPath + suffix, ec);
+    }
+}
+
+bool OsmRegionExtractor::SaveState() const {
+    std::ofstream sidecar(m_sqlitePath + ".regions", std::ios::trunc);
+    if (!sidecar) {
+        return false;
+    }
+
+    sidecar << "# Map regions extracted from " << m_pbfPath << "\n";
+    sidecar << "source=" << SourceSignature(m_pbfPath) << "\n";
+    for (const auto& cell : m_cells) {
+        sidecar << "cell=" << cell.first << "," << cell.second << "\n";
+    }
+
+    return static_cast<bool>(sidecar);
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+#include <wx/process.h>
+#include <wx/timer.h>
+#include <atomic>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Geographic rectangle in degrees.
+ */
+struct OsmRegion {
+    double min_lat, min_lon, max_lat, max_lon;
+};
+
+/**
+ * Grid cell of OSM_CELL_DEGREES size, as (latitude index, longitude index).
+ */
+using OsmCell = std::pair<int, int>;
+
+// Extract grid resolution and the margin kept around every activity
+constexpr double OSM_CELL_DEGREES = 0.25;
+constexpr double OSM_PADDING_DEGREES = 0.05;
+
+/**
+ * Cells already present in a Spatialite extract of a PBF file.
+ */
+struct OsmExtractState {
+    bool complete = false;   // Whole PBF was converted (extract made before region clipping)
+    std::set<OsmCell> cells; // Extracted cells, empty if there is no usable extract
+};
+
+/**
+ * Builds a Spatialite database from an OSM PBF file, restricted to the regions
+ * where activities actually are.
+ *
+ * Activity bounding boxes are padded and snapped to a grid of OSM_CELL_DEGREES cells.
+ * Adjacent cells are merged into regions and every region is converted with its own
+ * ogr2ogr run (-spat), appended into a working copy of the database which replaces
+ * the previous one only after all regions succeeded. Extracted cells are recorded
+ * in a "<database>.regions" sidecar, so activities in new places only append their
+ * own regions.
+ *
+ * ogr2ogr runs asynchronously; progress and completion are reported through
+ * callbacks on the UI thread. The job can be cancelled at any time.
+ *
+ * Sidecar file format (.regions):
+ *   source=<pbf size>:<pbf modification time>
+ *   cell=217,95
+ */
+class OsmRegionExtractor : public wxEvtHandler {
+public:
+    using ProgressCallback = std::function<void(double fraction, const wxString& status)>;
+    using FinishedCallback = std::function<void(bool success, const std::string& sqlitePath)>;
+
+    OsmRegionExtractor(ProgressCallback onProgress, FinishedCallback onFinished);
+    ~OsmRegionExtractor();
+
+    /**
+     * Get the Spatialite database path for a PBF file (same directory, .sqlite extension).
+     */
+    static std::string SpatialitePath(const std::string& pbfPath);
+
+    /**
+     * Read which cells of the PBF are already extracted.
+     * An extract without a sidecar is a full conversion made by older versions.
+     * @return Empty state if the extract is missing or older than the PBF
+     */
+    static OsmExtractState LoadState(const std::string& pbfPath);
+
+    /**
+     * Grid cells covering a region padded by OSM_PADDING_DEGREES.
+     */
+    static void AddCells(const OsmRegion& region, std::set<OsmCell>& cells);
+
+    /**
+     * Merge cells into rectangular regions: 8-connected cells form one region and
+     * overlapping regions are merged, so the PBF is scanned as few times as possible.
+     */
+    static std::vector<OsmRegion> ClusterCells(const std::set<OsmCell>& cells);
+
+    /**
+     * Collect the bounding boxes of all activities under a directory.
+     * Uses the activity cache of the archive and parses the FIT file otherwise.
+     * Safe to call from a worker thread.
+     * @param cancel Checked between files, returns early when set
+     */
+    static std::vector<OsmRegion> CollectArchiveBounds(const std::string& rootDirectory, const std::atomic<bool>& cancel);
+
+    /**
+     * Start extracting the given cells in the background.
+     * @param pbfPath Source PBF file
+     * @param state Current extract state as returned by LoadState()
+     * @param newCells Cells to add, not present in state
+     * @return true if ogr2ogr was started
+     */
+    bool Start(const std::string& pbfPath, const OsmExtractState& state, const std::set<OsmCell>& newCells);
+
+    /**
+     * Kill the running ogr2ogr and discard the working copy.
+     * The previous extract stays in place.
+     */
+    void Cancel();
+
+    /**
+     * Like Cancel(), but synchronous and without reporting to the finished callback.
+     * Used when the map source changes under a running extract.
+     */
+    void Abort();
+
+    bool IsRunning() const { return m_process != nullptr; }
+
+private:
+    class ExtractProcess;
+
+    bool LaunchNextRegion();
+    void OnPollTimer(wxTimerEvent& event);
+    void OnProcessTerminated(int status);
+    void DrainOutput();
+    void ReportProgress(int percent);
+    void Finish(bool success);
+    void RemoveWorkingFiles();
+    bool SaveState() const;
+
+    ProgressCallback m_onProgress;
+    FinishedCallback m_onFinished;
+
+    ExtractProcess* m_process; // Deletes itself when ogr2ogr terminates
+    wxTimer m_pollTimer;
+
+    std::string m_pbfPath;
+    std::string m_sqlitePath;
+    std::string m_workingPath;
+    std::set<OsmCell> m_cells; // All cells the working copy holds once finished
+    std::vector<OsmRegion> m_regions;
+    size_t m_currentRegion;
+    bool m_createDatabase; // First run creates the working copy instead of appending
+    bool m_cancelled;
+
+    // ogr2ogr output parsing
+    std::string m_progressDigits;
+    std::string m_errorLine;
+    std::string m_lastError;
+};
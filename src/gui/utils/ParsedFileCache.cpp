@@ -0,0 +1,159 @@
+#include "ParsedFileCache.hpp"
+#include "activity-cache/activity-cache.hpp"
+#include "parsers/coordinates-scanner.hpp"
+#include "trace/trace.hpp"
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+
+ParsedFile::ParsedFile(const std::string& path)
+    : m_path(path),
+      m_mapper(std::filesystem::path(path)) {
+    m_size = m_mapper.size();
+    m_mapper.parse();
+    if (!m_mapper.isParsed()) {
+        throw std::runtime_error("Failed to parse FIT file " + path);
+    }
+
+    // The file itself dominates, the message index comes close for large activities
+    size_t bytes = m_size;
+    bytes += m_mapper.dataMessages().size() * sizeof(darauble::FitDataMessage);
+    for (const auto& definition : m_mapper.definitions()) {
+        bytes += sizeof(definition) + definition.fields.size() * sizeof(darauble::FitFieldDefinition);
+    }
+    m_memoryUsage.store(bytes, std::memory_order_relaxed);
+}
+
+const ParsedFile::Track& ParsedFile::GetTrack() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_track) {
+        auto track = std::make_unique<Track>();
+        darauble::CoordinatesScanner scanner{m_mapper, FIT_SPORT_ALL, track->latitudes, track->longitudes};
+        scanner.scan();
+        m_track = std::move(track);
+        m_memoryUsage.fetch_add((m_track->latitudes.size() + m_track->longitudes.size()) * sizeof(int32_t),
+            std::memory_order_relaxed);
+    }
+    return *m_track;
+}
+
+const std::vector<darauble::productId>& ParsedFile::GetProductIds() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_productIds) {
+        darauble::ProductScanner scanner(m_mapper);
+        scanner.scan();
+        m_productIds = std::make_unique<std::vector<darauble::productId>>(scanner.productIds());
+        m_memoryUsage.fetch_add(m_productIds->size() * sizeof(darauble::productId), std::memory_order_relaxed);
+    }
+    return *m_productIds;
+}
+
+ParsedFileCache& ParsedFileCache::Instance() {
+    static ParsedFileCache instance;
+    return instance;
+}
+
+ParsedFileCache::ParsedFileCache()
+    : m_memoryLimit(DEFAULT_MEMORY_LIMIT) {
+}
+
+bool ParsedFileCache::ReadIdentity(const std::string& path, FileIdentity& identity) {
+    std::error_code error;
+    std::filesystem::path file(path);
+
+    identity.size = std::filesystem::file_size(file, error);
+    if (error) {
+        return false;
+    }
+
+    auto modified = std::filesystem::last_write_time(file, error);
+    if (error) {
+        return false;
+    }
+    identity.modified = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        modified.time_since_epoch()).count();
+
+    // Catches rewrites within the timestamp resolution of the file system
+    identity.crc = darauble::ActivityCache::readCrc(file);
+    return true;
+}
+
+std::shared_ptr<ParsedFile> ParsedFileCache::Get(const std::string& path) {
+    FileIdentity identity;
+    if (!ReadIdentity(path, identity)) {
+        Invalidate(path);
+        throw std::runtime_error("Cannot open file " + path);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(path);
+        if (it != m_index.end()) {
+            if (it->second->identity == identity) {
+                GFU_TRACE_COUNT("parsed-cache.hit", 1);
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                return m_entries.front().file;
+            }
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+    }
+
+    GFU_TRACE_COUNT("parsed-cache.miss", 1);
+
+    // Parse without holding the lock, another panel may want a different file meanwhile
+    auto file = std::make_shared<ParsedFile>(path);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(path);
+    if (it != m_index.end()) {
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_entries.push_front(Entry{path, identity, file});
+    m_index[path] = m_entries.begin();
+    Trim();
+    return file;
+}
+
+void ParsedFileCache::Invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(path);
+    if (it != m_index.end()) {
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+}
+
+void ParsedFileCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+}
+
+void ParsedFileCache::SetMemoryLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_memoryLimit = bytes;
+    Trim();
+}
+
+void ParsedFileCache::Trim() {
+    // Derived data grows after insertion, so the usage is summed up each time; there are few entries.
+    // The usage is read without the file's lock, a file being scanned doesn't hold up Get()
+    size_t total = 0;
+    auto it = m_entries.begin();
+    for (; it != m_entries.end(); ++it) {
+        total += it->file->GetMemoryUsage();
+
+        // The most recently used file is kept whatever its size
+        if (total > m_memoryLimit && it != m_entries.begin()) {
+            break;
+        }
+    }
+
+    while (it != m_entries.end()) {
+        m_index.erase(it->path);
+        it = m_entries.erase(it);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "parsers/binary-mapper.hpp"
+#include "parsers/product-scanner.hpp"
+
+/**
+ * A parsed FIT file and what the panels derive from it, computed on first use.
+ * The mapper is shared by every panel and must not be modified; edits work on their own copy.
+ */
+class ParsedFile {
+public:
+    struct Track {
+        std::vector<int32_t> latitudes;  // Semicircles, FIT_SINT32_INVALID where a record has no fix
+        std::vector<int32_t> longitudes;
+    };
+
+    explicit ParsedFile(const std::string& path);
+
+    const std::string& GetPath() const { return m_path; }
+    darauble::BinaryMapper& GetMapper() { return m_mapper; }
+
+    /**
+     * Coordinates of all records, any sport.
+     */
+    const Track& GetTrack();
+
+    /**
+     * Offsets of every product field in file_id and device_info messages.
+     */
+    const std::vector<darauble::productId>& GetProductIds();
+
+    /**
+     * Approximate memory held by the file and its derived data, in bytes.
+     * Never waits for a scan in progress, the derived data is counted once it is built.
+     */
+    size_t GetMemoryUsage() const { return m_memoryUsage.load(std::memory_order_relaxed); }
+
+private:
+    std::string m_path;
+    darauble::BinaryMapper m_mapper;
+    size_t m_size;
+    std::atomic<size_t> m_memoryUsage;
+    std::unique_ptr<Track> m_track;
+    std::unique_ptr<std::vector<darauble::productId>> m_productIds;
+    mutable std::mutex m_mutex;
+};
+
+/**
+ * Process-wide LRU cache of parsed FIT files, so that selecting an activity or switching
+ * tabs parses a file once for all panels.
+ *
+ * Entries are validated by the size, modification time and CRC of the file on every Get(),
+ * so files changed behind the application's back are parsed again. Editors call Invalidate()
+ * after saving. Least recently used files are dropped once the memory limit is exceeded;
+ * panels holding a file keep it alive until they let it go.
+ */
+class ParsedFileCache {
+public:
+    static const size_t DEFAULT_MEMORY_LIMIT = 256 * 1024 * 1024;
+
+    static ParsedFileCache& Instance();
+
+    /**
+     * Parsed file, from the cache if it is still valid.
+     * @throws std::runtime_error if the file can't be read or parsed
+     */
+    std::shared_ptr<ParsedFile> Get(const std::string& path);
+
+    void Invalidate(const std::string& path);
+    void Clear();
+    void SetMemoryLimit(size_t bytes);
+
+private:
+    struct FileIdentity {
+        uint64_t size = 0;
+        int64_t modified = 0;   // Nanoseconds since the epoch
+        uint16_t crc = 0;
+
+        bool operator==(const FileIdentity& other) const = default;
+    };
+
+    struct Entry {
+        std::string path;
+        FileIdentity identity;
+        std::shared_ptr<ParsedFile> file;
+    };
+
+    ParsedFileCache();
+    ParsedFileCache(const ParsedFileCache&) = delete;
+    ParsedFileCache& operator=(const ParsedFileCache&) = delete;
+
+    static bool ReadIdentity(const std::string& path, FileIdentity& identity);
+    void Trim();
+
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+    size_t m_memoryLimit;
+    std::mutex m_mutex;
+};
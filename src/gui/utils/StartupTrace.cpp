@@ -0,0 +1,48 @@
+#include "StartupTrace.hpp"
+#include <chrono>
+
+namespace {
+
+std::chrono::steady_clock::time_point g_start;
+bool g_active = false;
+
+long ElapsedMs() {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - g_start).count());
+}
+
+} // namespace
+
+void StartupTrace::Begin() {
+    g_start = std::chrono::steady_clock::now();
+    g_active = true;
+}
+
+void StartupTrace::Mark(const wxString& milestone) {
+    if (g_active) {
+        wxLogVerbose("Startup: %s after %ld ms", milestone, ElapsedMs());
+    }
+}
+
+void StartupTrace::MarkInteractive() {
+    if (!g_active) {
+        return;
+    }
+
+    long elapsed = ElapsedMs();
+    if (elapsed > BUDGET_MS) {
+        wxLogVerbose("Startup: first interactive frame after %ld ms, over the budget of %ld ms",
+                     elapsed, BUDGET_MS);
+    } else {
+        wxLogVerbose("Startup: first interactive frame after %ld ms", elapsed);
+    }
+}
+
+void StartupTrace::Finish(const wxString& milestone) {
+    Mark(milestone);
+    g_active = false;
+}
+
+bool StartupTrace::IsActive() {
+    return g_active;
+}
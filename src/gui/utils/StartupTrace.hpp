@@ -0,0 +1,33 @@
+#pragma once
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+
+/**
+ * Timing of the application start, logged as verbose messages (run with --verbose).
+ *
+ * Milestones are logged with the milliseconds since Begin(). The first interactive
+ * frame is checked against BUDGET_MS, everything slow must happen after it. The
+ * trace ends with Finish(), e.g. once the restored catalog has been validated;
+ * later milestones of the same kind (another directory opened) are not logged.
+ * UI thread only.
+ */
+class StartupTrace {
+public:
+    // Time to the first interactive frame, whatever the size of the archive
+    static constexpr long BUDGET_MS = 500;
+
+    static void Begin();
+    static void Mark(const wxString& milestone);
+
+    /**
+     * Mark the first frame the user can interact with and check it against the budget.
+     */
+    static void MarkInteractive();
+
+    static void Finish(const wxString& milestone);
+
+    static bool IsActive();
+};
@@ -0,0 +1,220 @@
+#include "logger.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace darauble {
+
+namespace {
+
+// Queued text written at once, or after the delay at the latest
+constexpr size_t BLOCK_SIZE = 64 * 1024;
+constexpr auto WRITE_DELAY = std::chrono::milliseconds(100);
+
+const char* LEVEL_NAMES[] = {"debug", "info", "warning", "error", "off"};
+
+struct Sink {
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::string pending;
+    std::thread writer;
+    bool running {false};
+    bool stopping {false};
+    bool urgent {false};   // An error is queued, written without the delay
+
+    // Blocks of the writer and lines written directly must not interleave
+    std::mutex output;
+
+    std::vector<std::pair<std::string, int>> categories;
+};
+
+// Never destroyed: a detached thread may still log while the process exits
+Sink& sink() {
+    static Sink* instance = new Sink;
+    return *instance;
+}
+
+void output(const std::string& text) {
+    Sink& s = sink();
+    std::lock_guard<std::mutex> lock(s.output);
+    std::fwrite(text.data(), 1, text.size(), stderr);
+    std::fflush(stderr);
+}
+
+void run() {
+    Sink& s = sink();
+    std::unique_lock<std::mutex> lock(s.mutex);
+
+    while (true) {
+        s.wakeup.wait_for(lock, WRITE_DELAY, [&]() { return s.stopping || s.urgent || s.pending.size() >= BLOCK_SIZE; });
+
+        std::string block;
+        block.swap(s.pending);
+        s.urgent = false;
+        bool stopping = s.stopping;
+
+        lock.unlock();
+
+        if (!block.empty()) {
+            output(block);
+        }
+
+        lock.lock();
+
+        if (stopping && s.pending.empty()) {
+            return;
+        }
+    }
+}
+
+bool parseLevel(const std::string& name, int& level) {
+    for (int i = 0; i <= static_cast<int>(LogLevel::Off); i++) {
+        if (name == LEVEL_NAMES[i]) {
+            level = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+bool Logger::categoryEnabled(LogLevel level, const char* category) {
+    for (const auto& [name, categoryLevel] : sink().categories) {
+        if (name == category) {
+            return static_cast<int>(level) >= categoryLevel;
+        }
+    }
+
+    return static_cast<int>(level) >= threshold.load(std::memory_order_relaxed);
+}
+
+bool Logger::configure(const std::string& spec) {
+    int level = threshold.load();
+    std::vector<std::pair<std::string, int>> categories;
+    std::stringstream ss(spec);
+    std::string item;
+
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+
+        size_t equals = item.find('=');
+        int itemLevel;
+
+        if (!parseLevel(equals == std::string::npos ? item : item.substr(equals + 1), itemLevel)) {
+            return false;
+        }
+
+        if (equals == std::string::npos) {
+            level = itemLevel;
+        } else {
+            categories.emplace_back(item.substr(0, equals), itemLevel);
+        }
+    }
+
+    sink().categories = std::move(categories);
+    threshold = level;
+    filtered = !sink().categories.empty();
+    return true;
+}
+
+void Logger::write(LogLevel level, const char* category, const std::string& message) {
+    std::string line;
+    line.reserve(message.size() + std::strlen(category) + 16);
+    line += '[';
+    line += LEVEL_NAMES[static_cast<int>(level)];
+    line += "] ";
+    line += category;
+    line += ": ";
+    line += message;
+    line += '\n';
+
+    Sink& s = sink();
+    std::unique_lock<std::mutex> lock(s.mutex);
+
+    if (!s.running) {
+        lock.unlock();
+        output(line);
+        return;
+    }
+
+    s.pending += line;
+
+    // Errors are not held back
+    if (level >= LogLevel::Error) {
+        s.urgent = true;
+    }
+
+    if (s.urgent || s.pending.size() >= BLOCK_SIZE) {
+        s.wakeup.notify_one();
+    }
+}
+
+void Logger::start() {
+    Sink& s = sink();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    if (!s.running) {
+        s.running = true;
+        s.stopping = false;
+        s.writer = std::thread(run);
+    }
+}
+
+void Logger::stop() {
+    Sink& s = sink();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        if (!s.running) {
+            return;
+        }
+
+        s.stopping = true;
+    }
+
+    s.wakeup.notify_one();
+    s.writer.join();
+
+    // Lines queued after the writer's last look
+    std::string rest;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.running = false;
+        s.stopping = false;
+        s.urgent = false;
+        rest.swap(s.pending);
+    }
+
+    if (!rest.empty()) {
+        output(rest);
+    }
+}
+
+LogSession::LogSession(const std::string& spec) {
+    Logger::configure(spec);
+
+    const char* environment = std::getenv(ENVIRONMENT);
+
+    if (environment && *environment && !Logger::configure(environment)) {
+        std::fprintf(stderr, "Unknown log level in %s=%s, levels: debug, info, warning, error, off\n", ENVIRONMENT, environment);
+    }
+
+    Logger::start();
+}
+
+LogSession::~LogSession() {
+    Logger::stop();
+}
+
+} // namespace darauble
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace darauble {
+
+// Not in capitals: ERROR and friends are macros on some platforms
+enum class LogLevel : int {
+    Debug = 0,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+/*
+  Levelled logging by category to the standard error, for the diagnostics of the
+  libraries; the output a tool is run for still goes to the standard output.
+
+  Filtered before the message is formatted: a disabled GFU_LOG costs a level check.
+  With a LogSession running, lines are queued and written in blocks by a background
+  thread, so workers never wait on the terminal. Safe to use from any thread; the
+  filter is configured once, before the workers start.
+ */
+class Logger {
+private:
+    static inline std::atomic<int> threshold {static_cast<int>(LogLevel::Warning)};
+    static inline std::atomic<bool> filtered {false}; // Some category has a level of its own
+
+    static bool categoryEnabled(LogLevel level, const char* category);
+
+public:
+    static bool enabled(LogLevel level, const char* category) {
+        if (filtered.load(std::memory_order_relaxed)) {
+            return categoryEnabled(level, category);
+        }
+
+        return static_cast<int>(level) >= threshold.load(std::memory_order_relaxed);
+    }
+
+    /*
+      A level, optionally followed by category levels, e.g. "info" or
+      "warning,points=info,scanner=off". Returns false (and changes nothing)
+      on an unknown level.
+     */
+    static bool configure(const std::string& spec);
+
+    static void write(LogLevel level, const char* category, const std::string& message);
+
+    // Start and stop the background writer; stopping writes out everything queued
+    static void start();
+    static void stop();
+};
+
+/*
+  Logging for a whole run of a tool: the default filter, overridden by the
+  environment (GFU_LOG=<spec>), and the background writer until the session ends.
+ */
+class LogSession {
+public:
+    static constexpr auto ENVIRONMENT = "GFU_LOG";
+
+    LogSession(const std::string& spec = "warning");
+    ~LogSession();
+
+    LogSession(const LogSession&) = delete;
+    LogSession& operator=(const LogSession&) = delete;
+};
+
+} // namespace darauble
+
+// GFU_LOG(Info, "points", "Read " << count << " points");
+#define GFU_LOG(level, category, message) \
+    do { \
+        if (darauble::Logger::enabled(darauble::LogLevel::level, category)) { \
+            std::ostringstream gfuLogStream; \
+            gfuLogStream << message; \
+            darauble::Logger::write(darauble::LogLevel::level, category, gfuLogStream.str()); \
+        } \
+    } while (0)
@@ -0,0 +1,73 @@
+#include "profile-index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace darauble::metadata {
+
+namespace {
+
+struct Slot {
+    const fit::Profile::MESG *mesg;
+    std::array<const fit::Profile::FIELD*, 256> fields;
+};
+
+struct Index {
+    std::vector<uint16_t> slots; // By message number, 0 when not in the profile
+    std::vector<Slot> messages;  // Slot 0 is the empty one
+
+    Index() {
+        uint16_t maxNum {0};
+
+        for (auto &m : fit::Profile::mesgs) {
+            maxNum = std::max(maxNum, m.num);
+        }
+
+        slots.assign(static_cast<size_t>(maxNum) + 1, 0);
+        messages.push_back({ nullptr, {} });
+
+        for (auto &m : fit::Profile::mesgs) {
+            Slot s { &m, {} };
+
+            for (uint16_t i = 0; i < m.numFields; i++) {
+                // Same as GetField(), the first one wins
+                if (!s.fields[m.fields[i].num]) {
+                    s.fields[m.fields[i].num] = &m.fields[i];
+                }
+            }
+
+            slots[m.num] = static_cast<uint16_t>(messages.size());
+            messages.push_back(s);
+        }
+    }
+};
+
+const Index& index() {
+    static const Index i;
+    return i;
+}
+
+} // namespace
+
+const fit::Profile::MESG* ProfileIndex::mesg(uint16_t mesgNum) {
+    const Index &i = index();
+
+    if (mesgNum >= i.slots.size()) {
+        return nullptr;
+    }
+
+    return i.messages[i.slots[mesgNum]].mesg;
+}
+
+const fit::Profile::FIELD* ProfileIndex::field(uint16_t mesgNum, uint8_t fieldNum) {
+    const Index &i = index();
+
+    if (mesgNum >= i.slots.size()) {
+        return nullptr;
+    }
+
+    return i.messages[i.slots[mesgNum]].fields[fieldNum];
+}
+
+} // namespace darauble::metadata
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+#include <fit_profile.hpp>
+
+namespace darauble::metadata {
+
+/*
+  Direct lookup of the SDK profile. fit::Profile::GetMesg() and GetField()
+  walk the message list on every call; here the message number picks a slot
+  and the field number indexes that slot's table. The index is built from
+  fit::Profile::mesgs on the first lookup.
+ */
+class ProfileIndex {
+public:
+    static const fit::Profile::MESG* mesg(uint16_t mesgNum);
+    static const fit::Profile::FIELD* field(uint16_t mesgNum, uint8_t fieldNum);
+};
+
+} // namespace darauble::metadata
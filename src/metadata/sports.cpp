@@ -2,7 +2,7 @@
 
 namespace darauble::metadata {
 
-const containers::BiMap<uint8_t, std::string> Sports::names = {
+constinit const Sports::Names Sports::names = Sports::dense({
     { 0, "OTHER" },
     { 1, "RUNNING" },
     { 2, "CYCLING" },
@@ -72,9 +72,9 @@ const containers::BiMap<uint8_t, std::string> Sports::names = {
     { 82, "SNORKELING" },
     { 83, "DANCE" },
     { 84, "JUMP_ROPE" },    
-};
+});
 
-const containers::BiMap<uint8_t, std::string> Sports::subNames = {
+constinit const Sports::Names Sports::subNames = Sports::dense({
     { 0, "GENERIC" },
     { 1, "TREADMILL" },
     { 2, "STREET" },
@@ -164,6 +164,6 @@ const containers::BiMap<uint8_t, std::string> Sports::subNames = {
     { 118, "FLY_VFR" },
     { 119, "FLY_IFR" },
     { 124, "RUCKING" },
-};
+});
 
 } // namespace darauble::metadata
@@ -1,15 +1,39 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
-#include <string>
-#include <bimap.hpp>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 
 namespace darauble::metadata {
 
+/*
+  Sport and sub-sport names indexed directly by their FIT value,
+  an empty name means the value is not known.
+ */
 class Sports {
 public:
-    static const containers::BiMap<uint8_t, std::string> names;
-    static const containers::BiMap<uint8_t, std::string> subNames;
+    using Names = std::array<std::string_view, 256>;
+
+    static const Names names;
+    static const Names subNames;
+
+    template <size_t N>
+    static constexpr Names dense(const std::pair<uint8_t, std::string_view> (&entries)[N]) {
+        Names table {};
+
+        for (const auto &entry : entries) {
+            if (!table[entry.first].empty()) {
+                // Fails the build when the table has a duplicate
+                throw std::invalid_argument("Duplicate sport value");
+            }
+
+            table[entry.first] = entry.second;
+        }
+
+        return table;
+    }
 };
 
-}
\ No newline at end of file
+}
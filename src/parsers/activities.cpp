@@ -39,13 +39,13 @@ void ActivityScanner::record(const FitDefinitionMessage& d, const FitDataMessage
         }
 
         if (subSport > 0) {
-            if (metadata::Sports::subNames.containsKey(subSport)) {
-                activityData[HEAD_SPORT] = metadata::Sports::subNames.atKey(subSport);
+            if (!metadata::Sports::subNames[subSport].empty()) {
+                activityData[HEAD_SPORT] = metadata::Sports::subNames[subSport];
             }
             
         } else {
-            if (metadata::Sports::names.containsKey(sport)) {
-                activityData[HEAD_SPORT] = metadata::Sports::names.atKey(sport);
+            if (!metadata::Sports::names[sport].empty()) {
+                activityData[HEAD_SPORT] = metadata::Sports::names[sport];
             }
         }
 
@@ -1,18 +1,273 @@
 #include "binary-mapper.hpp"
+#include "logger.hpp"
+#include "profile-index.hpp"
+#include "trace.hpp"
 
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 
 #include <fit_crc.hpp>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
 namespace darauble {
 
+namespace {
+
+/*
+  Flush a file (or a directory, for a rename in it) to the disk.
+ */
+bool syncFile(const fs::path& path) {
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#else
+    return true;
+#endif
+}
+
+/*
+  Dirty ranges closer than this are written as one, the unchanged bytes in between
+  cost less than another write call (e.g. every record's timestamp shifted).
+ */
+constexpr uint64_t PATCH_GAP = 4096;
+
+#if !defined(_WIN32)
+bool writeBytes(int fd, const uint8_t* bytes, uint64_t offset, uint64_t length) {
+    while (length > 0) {
+        ssize_t written = ::pwrite(fd, bytes, length, offset);
+
+        if (written < 0) {
+            return false;
+        }
+
+        bytes += written;
+        offset += written;
+        length -= written;
+    }
+
+    return true;
+}
+
+bool writeAt(int fd, const uint8_t* data, uint64_t begin, uint64_t end) {
+    return writeBytes(fd, data + begin, begin, end - begin);
+}
+
+bool readAt(int fd, uint8_t* data, uint64_t begin, uint64_t length) {
+    while (length > 0) {
+        ssize_t got = ::pread(fd, data, length, begin);
+
+        if (got <= 0) {
+            return false;
+        }
+
+        data += got;
+        begin += got;
+        length -= got;
+    }
+
+    return true;
+}
+#endif
+
+/*
+  Undo log of an in-place patch, `<file>.journal`: the original bytes of every range
+  about to be written. It is synced before the file is touched and removed once the
+  patched file is synced, so a journal left behind means the patch was interrupted.
+
+  Layout (host byte order): magic, file size (uint64), range count (uint32), then per
+  range its offset and length (uint64 each) and the original bytes, and a CRC-16 of
+  all that at the end. A journal failing the CRC was itself interrupted, before the
+  file was touched.
+ */
+const char JOURNAL_MAGIC[8] = {'G', 'F', 'U', 'J', 'R', 'N', 'L', '1'};
+
+fs::path journalPath(const fs::path& file) {
+    fs::path journal = file;
+    journal += ".journal";
+    return journal;
+}
+
+fs::path directoryOf(const fs::path& file) {
+    return file.has_parent_path() ? file.parent_path() : fs::path(".");
+}
+
+template <typename T>
+void append(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+bool take(const std::vector<uint8_t>& in, size_t& at, T& value) {
+    if (in.size() - at < sizeof(T)) {
+        return false;
+    }
+
+    memcpy(&value, in.data() + at, sizeof(T));
+    at += sizeof(T);
+    return true;
+}
+
+uint16_t journalCrc(const uint8_t* data, size_t size) {
+    uint16_t crc {0};
+
+    for (size_t i = 0; i < size; i++) {
+        crc = fit::CRC::Get16(crc, data[i]);
+    }
+
+    return crc;
+}
+
+#if !defined(_WIN32)
+bool writeJournal(const fs::path& journal, int fd, uint64_t fileSize, const std::vector<std::pair<uint64_t, uint64_t>>& ranges) {
+    std::vector<uint8_t> content(JOURNAL_MAGIC, JOURNAL_MAGIC + sizeof(JOURNAL_MAGIC));
+
+    append(content, fileSize);
+    append(content, static_cast<uint32_t>(ranges.size()));
+
+    for (const auto& [begin, end] : ranges) {
+        append(content, begin);
+        append(content, end - begin);
+
+        size_t at = content.size();
+        content.resize(at + (end - begin));
+
+        if (!readAt(fd, content.data() + at, begin, end - begin)) {
+            return false;
+        }
+    }
+
+    append(content, journalCrc(content.data(), content.size()));
+
+    std::ofstream out(journal, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(content.data()), content.size());
+    out.close();
+
+    return out && syncFile(journal) && syncFile(directoryOf(journal));
+}
+
+/*
+  Restore the original bytes from the journal of an interrupted patch and remove it.
+  The caller holds the exclusive lock of fd, the file. Returns false when a journal is
+  left, the file could not be restored.
+ */
+bool restoreJournal(int fd, const fs::path& file) {
+    fs::path journal = journalPath(file);
+    std::error_code ec;
+
+    if (!fs::exists(journal, ec)) {
+        return true;
+    }
+
+    std::ifstream in(journal, std::ios::binary);
+    std::vector<uint8_t> content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t at = sizeof(JOURNAL_MAGIC);
+    uint64_t fileSize {0};
+    uint32_t count {0};
+    uint16_t crc {0};
+
+    bool valid = content.size() >= sizeof(JOURNAL_MAGIC) + sizeof(fileSize) + sizeof(count) + sizeof(crc)
+        && memcmp(content.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0;
+
+    if (valid) {
+        memcpy(&crc, content.data() + content.size() - sizeof(crc), sizeof(crc));
+        content.resize(content.size() - sizeof(crc));
+
+        valid = crc == journalCrc(content.data(), content.size())
+            && take(content, at, fileSize) && take(content, at, count)
+            && fileSize == static_cast<uint64_t>(fs::file_size(file, ec));
+    }
+
+    bool restored = true;
+
+    for (uint32_t i = 0; valid && restored && i < count; i++) {
+        uint64_t begin {0}, length {0};
+
+        if (!take(content, at, begin) || !take(content, at, length) || content.size() - at < length) {
+            break;
+        }
+
+        restored = writeBytes(fd, content.data() + at, begin, length);
+        at += length;
+    }
+
+    if (!restored || (valid && ::fsync(fd) != 0)) {
+        GFU_LOG(Error, "mapper", "Cannot roll back the interrupted save of " << file.string() << " from " << journal.string());
+        return false;
+    }
+
+    if (valid) {
+        GFU_LOG(Warning, "mapper", "Rolled back the interrupted save of " << file.string());
+    }
+
+    return fs::remove(journal, ec) && syncFile(directoryOf(journal));
+}
+
+/*
+  Shared lock on a file for as long as it is read: waits for a save in progress, which
+  holds the exclusive one, and refuses a file with an interrupted save. Readers never
+  write, the journal is rolled back by BinaryMapper::recover() on the next edit.
+ */
+class ReadLock {
+    int fd;
+public:
+    ReadLock(const fs::path& file) : fd {::open(file.c_str(), O_RDONLY)} {
+        if (fd >= 0) {
+            ::flock(fd, LOCK_SH);
+        }
+
+        std::error_code ec;
+
+        if (fs::exists(journalPath(file), ec)) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+
+            throw std::runtime_error("Error: the last save of " + file.string() + " was interrupted, it is rolled back when the file is edited again");
+        }
+    }
+
+    ReadLock(const ReadLock&) = delete;
+    ReadLock& operator=(const ReadLock&) = delete;
+
+    ~ReadLock() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+#endif
+
+} // namespace
+
 BinaryMapper::BinaryMapper(const fs::path& filename, bool _showRaw) :
-    binarySize {0}, parsed {false}, showRaw {_showRaw}
+    binarySize {0}, headerParsed {false}, dataParsed {false}, parsed {false}, partial {false}, untracked {false}, showRaw {_showRaw}
 {
+    GFU_TRACE_SCOPE("mapper.read", "io");
+
+#if !defined(_WIN32)
+    ReadLock lock(filename);
+#endif
+
     std::ifstream file(filename, std::ios::binary | std::ios::ate);
     if (!file) {
         throw std::runtime_error("Error: Cannot open file " + filename.string());
@@ -32,9 +287,45 @@ BinaryMapper::BinaryMapper(const fs::path& filename, bool _showRaw) :
     }
 
     file.close();
+
+    std::error_code ec;
+    sourcePath = filename;
+    sourceTime = fs::last_write_time(filename, ec);
+
+    GFU_TRACE_SAMPLE("mapper.bytes", binarySize);
+}
+
+BinaryMapper::BinaryMapper(const fs::path& filename, size_t prefixSize, bool _showRaw) :
+    binarySize {0}, headerParsed {false}, dataParsed {false}, parsed {false}, partial {false}, untracked {false}, showRaw {_showRaw}
+{
+    GFU_TRACE_SCOPE("mapper.read-prefix", "io");
+
+#if !defined(_WIN32)
+    ReadLock lock(filename);
+#endif
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Error: Cannot open file " + filename.string());
+    }
+
+    binaryData.reset(new uint8_t[prefixSize], std::default_delete<uint8_t[]>());
+
+    // A file shorter than the prefix is simply read whole
+    file.read(reinterpret_cast<char*>(binaryData.get()), prefixSize);
+    binarySize = file.gcount();
+
+    if (file.bad()) {
+        throw std::runtime_error("Error: Failed to read file " + filename.string());
+    }
+
+    partial = binarySize == prefixSize;
+    file.close();
 }
 
 std::shared_ptr<uint8_t[]> BinaryMapper::data()  {
+    // Changes made through the buffer can't be tracked, save() writes the whole file
+    untracked = true;
     return binaryData;
 }
 
@@ -47,6 +338,10 @@ bool BinaryMapper::isParsed() {
 }
 
 void BinaryMapper::parseHeader() {
+    if (binarySize < 12) {
+        throw std::runtime_error("Error: File too short for a FIT header");
+    }
+
     if (binaryData[0] != 12 && binaryData[0] != 14) {
         throw std::runtime_error("Error: Invalid header size");
     }
@@ -69,8 +364,11 @@ void BinaryMapper::parseData() {
     }
 
     uint64_t offset = fitHeader.headerSize;
+
+    // A partially read or truncated file ends with the last record that is complete
+    uint64_t end = std::min<uint64_t>(fitHeader.headerSize + fitHeader.dataSize, binarySize);
     
-    while (offset < fitHeader.headerSize + fitHeader.dataSize) {
+    while (offset < end) {
         uint64_t recordOffset = offset;
         uint8_t recordHeader = read(offset);
 
@@ -81,6 +379,11 @@ void BinaryMapper::parseData() {
         if ((recordHeader & TYPE_MASK) > 0) {
             // Definition message
             FitDefinitionMessage d;
+
+            // Fixed part, the fields and the developer field count
+            if (offset + 4 >= end || offset + 4 + 3 * binaryData[offset + 4] + 1 > end) {
+                break;
+            }
             
             d.offset = recordOffset;
             offset++; // Skip the reserved byte
@@ -133,6 +436,9 @@ void BinaryMapper::parseData() {
             }
 
             if ((recordHeader & DEV_DATA_MASK) > 0) {
+                if (offset >= end || offset + 1 + 3 * binaryData[offset] > end) {
+                    break;
+                }
                 d.devFieldCount = read(offset);
 
                 if (showRaw) {
@@ -214,13 +520,20 @@ void BinaryMapper::parseData() {
             }
 
             if (!found) {
-                std::cout << std::endl;
-                std::cerr << "Error: Data message encountered without a definition!\n";
+                if (showRaw) {
+                    std::cout << std::endl;
+                }
+
+                GFU_LOG(Error, "mapper", sourcePath.string() << ": data message without a definition at offset " << recordOffset);
                 return;
             }
 
             FitDefinitionMessage & d = fitDefinitions[m.definitionIndex];
 
+            if (recordOffset + 1 + d.messageSize > end) {
+                break;
+            }
+
             if (showRaw) {
                 std::cout << "global #" << d.globalMessageNumber << std::endl;
                 std::cout << "| ";
@@ -301,7 +614,8 @@ void BinaryMapper::parseData() {
                 if (!devFieldMeta[nativeMesgNum].contains(devFieldDesc.num)) {
                     devFieldMeta[nativeMesgNum][devFieldDesc.num] = devFieldDesc;
                 } else {
-                    std::cerr << "Error: Duplicate developer field description for message #" << nativeMesgNum << ", field #" << +devFieldDesc.num << std::endl;
+                    GFU_LOG(Warning, "mapper", sourcePath.string() << ": duplicate developer field description for message #"
+                        << nativeMesgNum << ", field #" << +devFieldDesc.num);
                 }
             }
         }
@@ -311,15 +625,18 @@ void BinaryMapper::parseData() {
 }
 
 void BinaryMapper::parse() {
+    GFU_TRACE_SCOPE("mapper.parse", "parse");
+
     parseHeader();
     parseData();
 
     parsed = true;
+    GFU_TRACE_SAMPLE("mapper.messages", fitDataMessages.size());
 }
 
 const fit::Profile::FIELD *BinaryMapper::getField(const FitDefinitionMessage& d, FitFieldDefinition &f) {
     if (!f.developer) {
-        return fit::Profile::GetField(d.globalMessageNumber, f.fieldNumber);
+        return metadata::ProfileIndex::field(d.globalMessageNumber, f.fieldNumber);
     } else {
         if (devFieldMeta.contains(d.globalMessageNumber)) {
             if (devFieldMeta[d.globalMessageNumber].contains(f.fieldNumber)) {
@@ -481,11 +798,38 @@ std::string BinaryMapper::readDuration(uint64_t &offset, uint8_t architecture, d
     return oss.str();
 }
 
+void BinaryMapper::markDirty(uint64_t begin, uint64_t end) {
+    // Writes mostly come in file order and only extend the last range
+    if (!dirtyRanges.empty() && begin >= dirtyRanges.back().first && begin <= dirtyRanges.back().second) {
+        dirtyRanges.back().second = std::max(dirtyRanges.back().second, end);
+        return;
+    }
+
+    auto it = std::lower_bound(dirtyRanges.begin(), dirtyRanges.end(), std::make_pair(begin, end));
+
+    if (it != dirtyRanges.begin() && std::prev(it)->second >= begin) {
+        --it;
+        it->second = std::max(it->second, end);
+    } else {
+        it = dirtyRanges.insert(it, {begin, end});
+    }
+
+    auto next = std::next(it);
+
+    while (next != dirtyRanges.end() && next->first <= it->second) {
+        it->second = std::max(it->second, next->second);
+        next = dirtyRanges.erase(next);
+    }
+}
+
 void BinaryMapper::write(uint64_t &offset, uint8_t value) {
+    markDirty(offset, offset + 1);
     binaryData[offset++] = value;
 }
 
 void BinaryMapper::write(uint64_t &offset, uint16_t value, uint8_t architecture) {
+    markDirty(offset, offset + 2);
+
     if (architecture == 0) {
         binaryData[offset++] = value & 0xFF;
         binaryData[offset++] = (value >> 8) & 0xFF;
@@ -502,6 +846,8 @@ void BinaryMapper::write(uint64_t &offset, int32_t value, uint8_t architecture)
 }
 
 void BinaryMapper::write(uint64_t &offset, uint32_t value, uint8_t architecture) {
+    markDirty(offset, offset + 4);
+
     if (architecture == 0) {
         binaryData[offset++] = value & 0xFF;
         binaryData[offset++] = (value >> 8) & 0xFF;
@@ -516,6 +862,8 @@ void BinaryMapper::write(uint64_t &offset, uint32_t value, uint8_t architecture)
 }
 
 void BinaryMapper::write(uint64_t &offset, char* value, size_t length) {
+    markDirty(offset, offset + length);
+
     for (size_t i = 0; i < length; i++) {
         binaryData[offset++] = value[i];
     }
@@ -538,15 +886,237 @@ void BinaryMapper::writeCRC() {
     write(crcOffset, crc, 0);
 }
 
+bool BinaryMapper::sourceUnchanged() const {
+    if (partial || untracked || sourcePath.empty()) {
+        return false;
+    }
+
+    std::error_code ec;
+    auto size = fs::file_size(sourcePath, ec);
+
+    if (ec || size != binarySize) {
+        return false;
+    }
+
+    auto time = fs::last_write_time(sourcePath, ec);
+    return !ec && time == sourceTime;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> BinaryMapper::patchRanges() const {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    uint64_t crcOffset = binarySize - 2;
+    bool crcDirty = false;
+
+    for (size_t i = 0; i < dirtyRanges.size();) {
+        uint64_t begin = dirtyRanges[i].first;
+        uint64_t end = dirtyRanges[i].second;
+
+        for (i++; i < dirtyRanges.size() && dirtyRanges[i].first - end < PATCH_GAP; i++) {
+            end = dirtyRanges[i].second;
+        }
+
+        if (end > crcOffset) {
+            crcDirty = true;
+            end = crcOffset;
+        }
+
+        if (begin < end) {
+            ranges.push_back({begin, end});
+        }
+    }
+
+    // The CRC goes last, see writeDirtyRanges()
+    if (crcDirty) {
+        ranges.push_back({crcOffset, binarySize});
+    }
+
+    return ranges;
+}
+
+bool BinaryMapper::writeDirtyRanges(int fd, const std::vector<std::pair<uint64_t, uint64_t>>& ranges) {
+#if !defined(_WIN32)
+    const uint8_t* buffer = binaryData.get();
+    uint64_t crcOffset = binarySize - 2;
+
+    for (const auto& [begin, end] : ranges) {
+        // The CRC is written after the data is synced, a torn clone fails the CRC check
+        if (begin == crcOffset && ::fsync(fd) != 0) {
+            return false;
+        }
+
+        if (!writeAt(fd, buffer, begin, end)) {
+            return false;
+        }
+    }
+
+    return ::fsync(fd) == 0;
+#else
+    return false;
+#endif
+}
+
+bool BinaryMapper::patchClone(const fs::path& temporary) {
+#if defined(__linux__)
+    int source = ::open(sourcePath.c_str(), O_RDONLY);
+    if (source < 0) {
+        return false;
+    }
+
+    int target = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (target < 0) {
+        ::close(source);
+        return false;
+    }
+
+    // Shares the extents of the source on copy-on-write filesystems (Btrfs, XFS), fails elsewhere
+    bool patched = ::ioctl(target, FICLONE, source) == 0 && writeDirtyRanges(target, patchRanges());
+
+    ::close(target);
+    ::close(source);
+
+    if (!patched) {
+        std::error_code ec;
+        fs::remove(temporary, ec);
+    }
+
+    return patched;
+#else
+    return false;
+#endif
+}
+
+bool BinaryMapper::patchInPlace() {
+#if !defined(_WIN32)
+    int fd = ::open(sourcePath.c_str(), O_RDWR);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Held until the journal is gone, readers wait instead of seeing a half-patched file
+    if (::flock(fd, LOCK_EX) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    fs::path journal = journalPath(sourcePath);
+    std::error_code ec;
+
+    // Left by a save interrupted since the file was read, it no longer matches the buffer
+    if (fs::exists(journal, ec)) {
+        restoreJournal(fd, sourcePath);
+        ::close(fd);
+        return false;
+    }
+
+    auto ranges = patchRanges();
+
+    // The original bytes are safe on the disk before the first one is overwritten
+    if (!writeJournal(journal, fd, binarySize, ranges)) {
+        fs::remove(journal, ec);
+        ::close(fd);
+        return false;
+    }
+
+    if (!writeDirtyRanges(fd, ranges)) {
+        // Undone right away, the file stays as it was
+        restoreJournal(fd, sourcePath);
+        ::close(fd);
+        throw std::runtime_error("BinaryMapper error: cannot patch file " + sourcePath.string());
+    }
+
+    fs::remove(journal, ec);
+    syncFile(directoryOf(journal));
+    ::close(fd);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void BinaryMapper::recover(const fs::path& filename) {
+#if !defined(_WIN32)
+    std::error_code ec;
+
+    if (!fs::exists(journalPath(filename), ec)) {
+        return;
+    }
+
+    int fd = ::open(filename.c_str(), O_RDWR);
+    bool recovered = fd >= 0 && ::flock(fd, LOCK_EX) == 0 && restoreJournal(fd, filename);
+
+    if (fd >= 0) {
+        ::close(fd);
+    }
+
+    if (!recovered) {
+        throw std::runtime_error("BinaryMapper error: cannot roll back the interrupted save of " + filename.string());
+    }
+#endif
+}
+
 void BinaryMapper::save(const fs::path& filename) {
-    std::ofstream outFile(filename.string(), std::ios::binary);
-    
-    if (!outFile) {
-        throw std::runtime_error("BinaryMapper error: cannot open file for writing");
+    GFU_TRACE_SCOPE("mapper.save", "io");
+
+    if (partial) {
+        throw std::runtime_error("BinaryMapper error: a partially read file can't be saved");
+    }
+
+    // A journal left for the target would be rolled back over the new content
+    recover(filename);
+
+    // Written next to the target and renamed over it: a crash leaves either the old or the new file
+    fs::path temporary = filename;
+    temporary += ".tmp";
+
+    std::error_code ec;
+    bool unchanged = sourceUnchanged();
+    bool sameFile = unchanged && fs::equivalent(filename, sourcePath, ec);
+
+    if (unchanged && dirtyRanges.empty() && sameFile) {
+        return;
+    }
+
+    // Only the changed bytes are written: into a reflink clone of the source where
+    // possible, otherwise straight into the source when it is also the target
+    if (unchanged && patchClone(temporary)) {
+        replace(temporary, filename);
+    } else if (!(sameFile && patchInPlace())) {
+        std::ofstream outFile(temporary, std::ios::binary | std::ios::trunc);
+        
+        if (!outFile) {
+            throw std::runtime_error("BinaryMapper error: cannot open file for writing");
+        }
+
+        outFile.write(reinterpret_cast<const char*>(binaryData.get()), binarySize);
+        outFile.close();
+
+        if (!outFile || !syncFile(temporary)) {
+            fs::remove(temporary, ec);
+            throw std::runtime_error("BinaryMapper error: cannot write file " + temporary.string());
+        }
+
+        replace(temporary, filename);
+    }
+
+    // The buffer now mirrors the saved file, the next save patches that one
+    dirtyRanges.clear();
+    untracked = false;
+    sourcePath = filename;
+    sourceTime = fs::last_write_time(filename, ec);
+}
+
+void BinaryMapper::replace(const fs::path& temporary, const fs::path& filename) {
+    std::error_code ec;
+
+    // An edited file keeps the permissions of the original
+    auto original = fs::status(filename, ec);
+    if (!ec && fs::exists(original)) {
+        fs::permissions(temporary, original.permissions(), ec);
     }
 
-    outFile.write(reinterpret_cast<const char*>(binaryData.get()), binarySize);
-    outFile.close();
+    fs::rename(temporary, filename);
+    syncFile(filename.has_parent_path() ? filename.parent_path() : fs::path("."));
 }
 
 } // namespace darauble
@@ -66,6 +66,14 @@ private:
 
     void parseHeader();
     void parseData();
+
+    void markDirty(uint64_t begin, uint64_t end);
+    bool sourceUnchanged() const;
+    std::vector<std::pair<uint64_t, uint64_t>> patchRanges() const;
+    bool writeDirtyRanges(int fd, const std::vector<std::pair<uint64_t, uint64_t>>& ranges);
+    bool patchClone(const fs::path& temporary);
+    bool patchInPlace();
+    void replace(const fs::path& temporary, const fs::path& filename);
 protected:
     std::shared_ptr<uint8_t[]> binaryData;
     size_t binarySize;
@@ -78,15 +86,29 @@ protected:
     bool headerParsed;
     bool dataParsed;
     bool parsed;
+    bool partial; // Only the beginning of the file was read
+
+    fs::path sourcePath; // The file the buffer mirrors, apart from the dirty ranges
+    fs::file_time_type sourceTime;
+    std::vector<std::pair<uint64_t, uint64_t>> dirtyRanges; // Sorted, merged [begin, end) ranges changed by write()
+    bool untracked; // The buffer was handed out by data(), changes are unknown
 
     bool showRaw;
 public:
     BinaryMapper(const fs::path& filename, bool _showRaw = false);
+
+    /*
+      Read only the first prefixSize bytes of the file, e.g. for the File ID message,
+      which is always the first one. Parsing stops at the last complete record.
+      Such a mapper can't be saved or checked with CRC().
+     */
+    BinaryMapper(const fs::path& filename, size_t prefixSize, bool _showRaw = false);
     ~BinaryMapper() = default;
 
     std::shared_ptr<uint8_t[]> data();
     size_t size();
     bool isParsed();
+    bool isPartial() const { return partial; }
     void parse();
 
     const FitFileHeader& header() const { return fitHeader; }
@@ -118,7 +140,20 @@ public:
 
     uint16_t CRC();
     void writeCRC();
+
+    /*
+      Save the buffer atomically. When the source file is still as it was read, only the
+      ranges changed by write() are written: into a reflink clone of the source, or,
+      without reflinks, straight into the source if it is the target, journaled in
+      `<file>.journal`. Anything else writes the whole file.
+     */
     void save(const fs::path& filename);
+
+    /*
+      Roll back an interrupted in-place save of the file from its journal. Readers refuse
+      such a file without touching it, an edit calls this before opening it.
+     */
+    static void recover(const fs::path& filename);
 };
 
 } // namespace darauble
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "binary-scanner.hpp"
-
-#include <iostream>
+#include "logger.hpp"
+#include "trace.hpp"
 
 namespace darauble {
 
@@ -9,6 +9,8 @@ BinaryScanner::BinaryScanner(BinaryMapper& _mapper) :
 {}
 
 void BinaryScanner::scan() {
+    GFU_TRACE_SCOPE("scanner.scan", "scan");
+
     reset();
     
     if (!mapper.isParsed()) {
@@ -19,7 +21,7 @@ void BinaryScanner::scan() {
         }
     }
 
-    std::cout << "BinaryScanner::scan: " << mapper.dataMessages().size() << " data messages" << std::endl;
+    GFU_LOG(Debug, "scanner", "BinaryScanner::scan: " << mapper.dataMessages().size() << " data messages");
 
     stopFlag = false;
 
@@ -40,11 +42,10 @@ void BinaryScanner::stop() {
 }
 
 void BinaryScanner::record(const FitDefinitionMessage& d, const FitDataMessage& m) {
-    std::cout << "BinaryScanner::record: Global #"
+    GFU_LOG(Debug, "scanner", "BinaryScanner::record: Global #"
         << d.globalMessageNumber
         << ", local #" << +m.localMessageType
-        << ", data offset: " << m.offset
-        << std::endl;
+        << ", data offset: " << m.offset);
 }
 
 } // namespace darauble
@@ -0,0 +1,37 @@
+#include "file-id-scanner.hpp"
+
+#include <fit_file_id_mesg.hpp>
+
+namespace darauble {
+
+void FileIdScanner::record(const FitDefinitionMessage& d, const FitDataMessage& m) {
+    if (d.globalMessageNumber != FIT_MESG_NUM_FILE_ID) {
+        return;
+    }
+
+    for (auto &f : d.fields) {
+        if (f.developer) {
+            continue;
+        }
+
+        uint64_t offset = m.offset + f.offset;
+
+        if (f.fieldNumber == fit::FileIdMesg::FieldDefNum::Type && f.size == 1) {
+            fileType = mapper.read(offset);
+        } else if (f.fieldNumber == fit::FileIdMesg::FieldDefNum::TimeCreated && f.size == 4) {
+            fileTimeCreated = mapper.readU32(offset, d.architecture);
+        }
+    }
+
+    // Nothing else is needed from the file
+    fileIdFound = true;
+    stop();
+}
+
+void FileIdScanner::reset() {
+    fileIdFound = false;
+    fileType = FIT_FILE_INVALID;
+    fileTimeCreated = FIT_DATE_TIME_INVALID;
+}
+
+} // namespace darauble
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "binary-scanner.hpp"
+
+#include <fit_profile.hpp>
+#include <ctime>
+
+namespace darauble {
+
+/*
+  Reads the File ID message, which must be the first message of a FIT file,
+  and stops. Meant for a BinaryMapper that has read just the beginning of the file.
+ */
+class FileIdScanner : public BinaryScanner {
+public:
+    // Bytes enough for the header, the File ID definition and its data
+    static const size_t PREFIX_SIZE = 256;
+
+    // FIT time counts seconds since 1989-12-31 00:00 UTC
+    static const std::time_t FIT_EPOCH = 631065600;
+
+protected:
+    bool fileIdFound;
+    uint8_t fileType;
+    uint32_t fileTimeCreated;
+public:
+    FileIdScanner(BinaryMapper& _mapper) :
+        BinaryScanner(_mapper), fileIdFound {false}, fileType {FIT_FILE_INVALID}, fileTimeCreated {FIT_DATE_TIME_INVALID}
+    {}
+
+    virtual void reset() override;
+    virtual void record(const FitDefinitionMessage& d, const FitDataMessage& m) override;
+
+    bool found() const { return fileIdFound; }
+    uint8_t type() const { return fileType; }
+
+    /*
+      FIT time of the file creation, FIT_DATE_TIME_INVALID if not present.
+     */
+    uint32_t timeCreated() const { return fileTimeCreated; }
+};
+
+} // namespace darauble
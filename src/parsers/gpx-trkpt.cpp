@@ -1,50 +1,393 @@
 #include "gpx-trkpt.hpp"
+#include "civil-date.hpp"
 #include "formulae.hpp"
-#include "convert.hpp"
-#include <pugixml.hpp>
+#include "logger.hpp"
+#include "trace.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 namespace darauble::parsers {
 
 using namespace darauble;
 
-std::vector<TrackPoint> ReadTrackpoints(const fs::path& filename, bool calculate_distance) {
-    std::vector<TrackPoint> points;
-    pugi::xml_document doc;
+namespace {
+
+const double NONE = std::numeric_limits<double>::quiet_NaN();
+
+/*
+  Read-only view of a whole file, mapped where possible.
+ */
+class TextFile {
+private:
+    const char *data {nullptr};
+    size_t size {0};
+    bool mapped {false};
+    std::string buffer;
+
+public:
+    TextFile(const fs::path& filename) {
+#if !defined(_WIN32)
+        int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open " + filename.string());
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat " + filename.string());
+        }
+
+        size = static_cast<size_t>(st.st_size);
+
+        if (size > 0) {
+            void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (address != MAP_FAILED) {
+                madvise(address, size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(address);
+                mapped = true;
+            }
+        }
+
+        ::close(fd);
+
+        if (mapped || size == 0) {
+            return;
+        }
+#endif
+        std::ifstream file(filename, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("cannot open " + filename.string());
+        }
+
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+    }
+
+    ~TextFile() {
+#if !defined(_WIN32)
+        if (mapped) {
+            munmap(const_cast<char*>(data), size);
+        }
+#endif
+    }
+
+    TextFile(const TextFile&) = delete;
+    TextFile& operator=(const TextFile&) = delete;
+
+    std::string_view text() const {
+        return { data, size };
+    }
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) {
+        s.remove_prefix(1);
+    }
+
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) {
+        s.remove_suffix(1);
+    }
+
+    return s;
+}
+
+double toDouble(std::string_view s) {
+    s = trim(s);
+    double value;
+
+    if (!s.empty() && s.front() == '+') {
+        s.remove_prefix(1);
+    }
+
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+
+    return ec == std::errc() ? value : NONE;
+}
+
+/* ISO 8601 as used by GPX and TCX: 2024-05-01T06:30:12[.sss](Z|+hh:mm|-hh:mm) */
+double toUnixTime(std::string_view s) {
+    s = trim(s);
+
+    const char *p = s.data(), *end = s.data() + s.size();
+    int fields[6];
+    const char separators[6] = { '-', '-', 'T', ':', ':', 0 };
+
+    for (int i = 0; i < 6; i++) {
+        auto [next, ec] = std::from_chars(p, end, fields[i]);
+
+        if (ec != std::errc()) {
+            return NONE;
+        }
+
+        p = next;
 
-    if (!doc.load_file(filename.string().c_str())) {
-        std::cerr << "Failed to load GPX\n";
-        return points;
+        if (separators[i]) {
+            if (p == end || (*p != separators[i] && !(i == 2 && *p == ' '))) {
+                return NONE;
+            }
+
+            p++;
+        }
     }
 
-    for (auto trkpt : doc.select_nodes("//trkpt")) {
-        auto node = trkpt.node();
-        TrackPoint point;
+    double seconds = static_cast<double>(daysFromCivil(fields[0], fields[1], fields[2]) * 86400
+        + fields[3] * 3600 + fields[4] * 60 + fields[5]);
 
-        point.lat = node.attribute("lat").as_double();
-        point.lon = node.attribute("lon").as_double();
-        point.distance = -1.0;
-        point.cumulative_distance = 0;
+    if (p != end && *p == '.') {
+        const char *fraction = p;
+        double value;
 
-        if (calculate_distance && (!points.empty())) {
-            TrackPoint& previousPoint = points.at(points.size() - 1);
+        while (++p != end && *p >= '0' && *p <= '9') {}
 
-            point.distance = coordinates::haversine_degrees(
-                previousPoint.lat, previousPoint.lon,
-                point.lat, point.lon
-            );
+        if (std::from_chars(fraction, p, value).ec == std::errc()) {
+            seconds += value;
+        }
+    }
 
-            point.cumulative_distance = previousPoint.cumulative_distance + point.distance;
+    if (p != end && (*p == '+' || *p == '-')) {
+        int hours {0}, minutes {0};
+        int sign = *p == '-' ? -1 : 1;
+        auto [next, ec] = std::from_chars(p + 1, end, hours);
+
+        if (ec == std::errc() && next != end && *next == ':') {
+            std::from_chars(next + 1, end, minutes);
         }
 
-        points.push_back(point);
+        seconds -= sign * (hours * 3600 + minutes * 60);
+    }
+
+    return seconds;
+}
+
+/* Text of the first <tag>...</tag> within an element, empty when there is none */
+std::string_view childText(std::string_view element, std::string_view open, std::string_view close) {
+    size_t begin = element.find(open);
+
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+
+    begin += open.size();
+    size_t end = element.find(close, begin);
+
+    return end == std::string_view::npos ? std::string_view {} : element.substr(begin, end - begin);
+}
+
+size_t skipSpace(std::string_view s, size_t at) {
+    while (at < s.size() && std::isspace(static_cast<unsigned char>(s[at]))) {
+        at++;
+    }
+
+    return at;
+}
+
+/* Value of name="..." or name='...' in a start tag, with optional spaces around = */
+std::string_view attribute(std::string_view tag, std::string_view name) {
+    size_t at = 0;
+
+    while ((at = tag.find(name, at)) != std::string_view::npos) {
+        size_t after = at + name.size();
+        size_t equals = skipSpace(tag, after);
+        size_t quote = skipSpace(tag, equals + 1);
 
-        // std::cout << "Track point: lat " << point.lat << ", lon " << point.lon << ", distance " << point.distance << ", cumulative " << point.cumulative_distance << std::endl;
+        // Whole attribute names only, so "lat" does not match inside "plat"
+        if (at > 0 && std::isspace(static_cast<unsigned char>(tag[at - 1]))
+            && equals < tag.size() && tag[equals] == '='
+            && quote < tag.size() && (tag[quote] == '"' || tag[quote] == '\'')) {
+            size_t end = tag.find(tag[quote], quote + 1);
+
+            return end == std::string_view::npos ? std::string_view {} : tag.substr(quote + 1, end - quote - 1);
+        }
+
+        at = after;
+    }
+
+    return {};
+}
+
+/* Next start of the tag at or after at, outside comments and CDATA sections */
+size_t findTag(std::string_view text, std::string_view tag, size_t at) {
+    const std::string_view COMMENT {"<!--"}, COMMENT_END {"-->"};
+    const std::string_view CDATA {"<![CDATA["}, CDATA_END {"]]>"};
+
+    while ((at = text.find('<', at)) != std::string_view::npos) {
+        std::string_view rest = text.substr(at);
+
+        if (rest.starts_with(tag)) {
+            return at;
+        }
+
+        if (rest.starts_with(COMMENT)) {
+            at = text.find(COMMENT_END, at + COMMENT.size());
+            at = at == std::string_view::npos ? at : at + COMMENT_END.size();
+        } else if (rest.starts_with(CDATA)) {
+            at = text.find(CDATA_END, at + CDATA.size());
+            at = at == std::string_view::npos ? at : at + CDATA_END.size();
+        } else {
+            at++;
+        }
+
+        if (at == std::string_view::npos) {
+            break;
+        }
+    }
+
+    return std::string_view::npos;
+}
+
+/* Where the element starting at a tag ends: after "/>" or after the closing tag */
+size_t elementEnd(std::string_view text, size_t tagEnd, std::string_view close) {
+    if (text[tagEnd - 1] == '/') {
+        return tagEnd + 1;
+    }
+
+    size_t end = text.find(close, tagEnd);
+
+    return end == std::string_view::npos ? text.size() : end + close.size();
+}
+
+size_t countTags(std::string_view text, std::string_view tag) {
+    size_t count {0};
+
+    for (size_t at = text.find(tag); at != std::string_view::npos; at = text.find(tag, at + tag.size())) {
+        count++;
+    }
+
+    return count;
+}
+
+void append(TrackPoints& points, double lat, double lon, double ele, double time, bool calculate_distance) {
+    if (calculate_distance) {
+        double distance {0.0}, cumulative {0.0};
+
+        if (!points.empty()) {
+            distance = coordinates::haversine_degrees(points.lat.back(), points.lon.back(), lat, lon);
+            cumulative = points.cumulative_distance.back() + distance;
+        }
+
+        points.distance.push_back(distance);
+        points.cumulative_distance.push_back(cumulative);
+    }
+
+    points.lat.push_back(lat);
+    points.lon.push_back(lon);
+    points.ele.push_back(ele);
+    points.time.push_back(time);
+}
+
+void readGpx(std::string_view text, TrackPoints& points, bool calculate_distance) {
+    const std::string_view TAG {"<trkpt"}, CLOSE {"</trkpt>"};
+
+    for (size_t at = findTag(text, TAG, 0); at != std::string_view::npos; at = findTag(text, TAG, at)) {
+        size_t tagEnd = text.find('>', at);
+
+        if (tagEnd == std::string_view::npos) {
+            break;
+        }
+
+        // Not <trkptSomething>
+        char next = text[at + TAG.size()];
+        if (!std::isspace(static_cast<unsigned char>(next)) && next != '>' && next != '/') {
+            at += TAG.size();
+            continue;
+        }
+
+        std::string_view tag = text.substr(at, tagEnd - at);
+        size_t end = elementEnd(text, tagEnd, CLOSE);
+        std::string_view body = text.substr(tagEnd + 1, end - tagEnd - 1);
+
+        double lat = toDouble(attribute(tag, "lat"));
+        double lon = toDouble(attribute(tag, "lon"));
+
+        if (!std::isnan(lat) && !std::isnan(lon)) {
+            append(points, lat, lon,
+                toDouble(childText(body, "<ele>", "</ele>")),
+                toUnixTime(childText(body, "<time>", "</time>")),
+                calculate_distance);
+        }
+
+        at = end;
+    }
+}
+
+void readTcx(std::string_view text, TrackPoints& points, bool calculate_distance) {
+    const std::string_view TAG {"<Trackpoint>"}, CLOSE {"</Trackpoint>"};
+
+    for (size_t at = findTag(text, TAG, 0); at != std::string_view::npos; at = findTag(text, TAG, at)) {
+        size_t tagEnd = at + TAG.size() - 1;
+        size_t end = elementEnd(text, tagEnd, CLOSE);
+        std::string_view body = text.substr(tagEnd + 1, end - tagEnd - 1);
+
+        // Points without a position (pauses, indoor) are skipped
+        double lat = toDouble(childText(body, "<LatitudeDegrees>", "</LatitudeDegrees>"));
+        double lon = toDouble(childText(body, "<LongitudeDegrees>", "</LongitudeDegrees>"));
+
+        if (!std::isnan(lat) && !std::isnan(lon)) {
+            append(points, lat, lon,
+                toDouble(childText(body, "<AltitudeMeters>", "</AltitudeMeters>")),
+                toUnixTime(childText(body, "<Time>", "</Time>")),
+                calculate_distance);
+        }
+
+        at = end;
+    }
+}
+
+} // namespace
+
+TrackPoints ReadTrackpoints(const fs::path& filename, bool calculate_distance) {
+    GFU_TRACE_SCOPE("gpx.read", "parse");
+
+    TrackPoints points;
+
+    try {
+        TextFile file(filename);
+        std::string_view text = file.text();
+        bool tcx = text.find("<TrainingCenterDatabase") != std::string_view::npos;
+
+        // Counting the tags is a fraction of the parsing, and every array is allocated once
+        size_t count = countTags(text, tcx ? "<Trackpoint>" : "<trkpt");
+
+        points.lat.reserve(count);
+        points.lon.reserve(count);
+        points.ele.reserve(count);
+        points.time.reserve(count);
+
+        if (calculate_distance) {
+            points.distance.reserve(count);
+            points.cumulative_distance.reserve(count);
+        }
+
+        if (tcx) {
+            readTcx(text, points, calculate_distance);
+        } else {
+            readGpx(text, points, calculate_distance);
+        }
+    } catch (const std::exception& e) {
+        GFU_LOG(Error, "gpx", "Failed to load GPX " << filename.string() << ": " << e.what());
     }
 
-    // std::cout << "Total track points: " << points.size() << std::endl;
+    GFU_TRACE_SAMPLE("gpx.points", points.size());
 
     return points;
 }
 
-} // namespace darauble
\ No newline at end of file
+} // namespace darauble
@@ -8,13 +8,33 @@
 namespace fs = std::filesystem;
 namespace darauble::parsers {
 
-struct TrackPoint {
-    double lat;
-    double lon;
-    double distance;
-    double cumulative_distance;
+/*
+  Track points as parallel arrays, index i of each is the same point.
+  Elevation and time are NaN when the point has none. Distances (in meters)
+  are filled only when asked for: distance is from the previous point,
+  zero for the first one.
+ */
+struct TrackPoints {
+    std::vector<double> lat;
+    std::vector<double> lon;
+    std::vector<double> ele;
+    std::vector<double> time; // Unix time, seconds
+    std::vector<double> distance;
+    std::vector<double> cumulative_distance;
+
+    size_t size() const {
+        return lat.size();
+    }
+
+    bool empty() const {
+        return lat.empty();
+    }
 };
 
-std::vector<TrackPoint> ReadTrackpoints(const fs::path& filename, bool calculate_distance = false);
+/*
+  Reads <trkpt> of a GPX or <Trackpoint> of a TCX file. The file is mapped and
+  scanned once for the points, no XML tree is built.
+ */
+TrackPoints ReadTrackpoints(const fs::path& filename, bool calculate_distance = false);
 
-} // namespace darauble
\ No newline at end of file
+} // namespace darauble
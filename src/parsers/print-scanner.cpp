@@ -1,11 +1,13 @@
 #include "print-scanner.hpp"
+#include "civil-date.hpp"
 #include "convert.hpp"
+#include "profile-index.hpp"
 
 #include <algorithm>
-#include <iomanip>
+#include <ctime>
 #include <iostream>
 #include <format>
-#include <sstream>
+#include <iterator>
 
 #include <fit_profile.hpp>
 
@@ -24,15 +26,66 @@ TODO:
 
 namespace darauble {
 
+/* Right-align UTF-8 text by its code point count, as the terminal shows it */
+static void padUtf8(std::string &out, const std::string &text, size_t width) {
+    size_t length = 0;
+
+    for (char c : text) {
+        if ((c & 0xc0) != 0x80) {
+            ++length;
+        }
+    }
+
+    if (length < width) {
+        out.append(width - length, ' ');
+    }
+
+    out += text;
+}
+
 void PrintScanner::defaultOptions(PrintScannerOptions &o) {
     o.offset = false;
     o.raw = false;
     o.degrees = false;
 }
 
-void PrintScanner::printHeader(const FitDefinitionMessage& d) {
-    std::ostringstream ossLine, ossHeader;
-    auto messageMeta = fit::Profile::GetMesg(d.globalMessageNumber);
+PrintScanner::~PrintScanner() {
+    flush();
+}
+
+void PrintScanner::flush() {
+    if (!output.empty()) {
+        std::cout.write(output.data(), output.size());
+        std::cout.flush();
+        output.clear();
+    }
+}
+
+/*
+  Everything that depends only on the definition (column widths, which fields are
+  shown, how each is converted, the header and table lines) is worked out
+  on the first message of a definition and reused for the rest of them.
+ */
+const PrintPlan& PrintScanner::plan(int32_t definitionIndex, const FitDefinitionMessage& d) {
+    if (static_cast<size_t>(definitionIndex) >= plans.size()) {
+        plans.resize(definitionIndex + 1);
+    }
+
+    PrintPlan &p = plans[definitionIndex];
+
+    if (p.ready) {
+        return p;
+    }
+
+    auto messageMeta = metadata::ProfileIndex::mesg(d.globalMessageNumber);
+
+    p.title = std::format("====  Message #{}", d.globalMessageNumber);
+
+    if (messageMeta) {
+        p.title += std::format(" ({})", messageMeta->name);
+    }
+
+    p.title += "  ====\n";
 
     for (auto field : d.fields) {
         if (!fieldFilter.empty() && fieldFilter.find(field.fieldNumber) == fieldFilter.end()) {
@@ -40,143 +93,233 @@ void PrintScanner::printHeader(const FitDefinitionMessage& d) {
         }
 
         auto fieldMeta = mapper.getField(d, field);
-        std::ostringstream ossFieldName;
+        std::string fieldName = std::format("{}{} {}", field.developer ? "*" : "", fieldMeta ? fieldMeta->name : "", field.fieldNumber);
 
-        if (field.developer) {
-            ossFieldName << "*";
-        }
+        bool dateTime = !options.raw && ((fieldMeta && fieldMeta->profileType == fit::Profile::Type::DateTime) || (field.fieldNumber == 253));
+        bool duration = !options.raw && (fieldMeta && fieldMeta->units == "s" && fieldMeta->profileType == fit::Profile::Type::Uint32);
+        bool degrees = options.degrees && (fieldMeta && fieldMeta->units == "semicircles" && fieldMeta->profileType == fit::Profile::Type::Sint32);
+        bool scaled = !options.raw && (fieldMeta && fieldMeta->scale > 1);
 
-        ossFieldName << (fieldMeta ? fieldMeta->name : "") << " " << +field.fieldNumber;
-        int width {0};
+        size_t width {0};
 
         if (field.baseType != FIT_BASE_TYPE_STRING) {
-            if (!options.raw && ((fieldMeta && fieldMeta->profileType == fit::Profile::Type::DateTime) || (field.fieldNumber == 253))) {
+            if (dateTime) {
                 // Date/Time in ISO is 19 chars
-                width = std::max(static_cast<size_t>(ossFieldName.str().length()), static_cast<size_t>(19));
-            } else if (!options.raw && (fieldMeta && fieldMeta->units == "s" && fieldMeta->profileType == fit::Profile::Type::Uint32)) {
+                width = 19;
+            } else if (duration) {
                 // Hundreds of hours should fit. like 112:03:14.25
-                width = std::max(static_cast<size_t>(ossFieldName.str().length()), static_cast<size_t>(12));
-            } else if (options.degrees && (fieldMeta && fieldMeta->units == "semicircles" && fieldMeta->profileType == fit::Profile::Type::Sint32)) {
-                width = std::max(static_cast<size_t>(ossFieldName.str().length()),  static_cast<size_t>(13));
-            } else if (!options.raw && (fieldMeta && fieldMeta->scale > 1)) {
+                width = 12;
+            } else if (degrees) {
+                width = 13;
+            } else if (scaled) {
                 // Scaled fields imply they are of double precision by fit::Profile::FIELD
-                width = std::max(static_cast<size_t>(ossFieldName.str().length()),  static_cast<size_t>(FIT_TYPE_WIDTH.at(FIT_BASE_TYPE_FLOAT64)));
+                width = FIT_TYPE_WIDTH.at(FIT_BASE_TYPE_FLOAT64);
             } else {
-                width = std::max(static_cast<size_t>(ossFieldName.str().length()), static_cast<size_t>(FIT_TYPE_WIDTH.at(field.baseType)));
+                auto typeWidth = FIT_TYPE_WIDTH.find(field.baseType);
+                width = typeWidth != FIT_TYPE_WIDTH.end() ? typeWidth->second : 3;
             }
         } else {
-            width = std::max(static_cast<size_t>(ossFieldName.str().length()), static_cast<size_t>(field.size));
+            width = field.size;
         }
 
+        width = std::max(width, fieldName.length());
+
         if (options.offset) {
-            width = std::max(width, 10);
+            width = std::max(width, static_cast<size_t>(10));
+        }
+
+        PrintColumn c {
+            field.offset, field.size, field.baseType, static_cast<uint16_t>(width), PrintConverter::NUMBER,
+            fieldMeta ? fieldMeta->scale : 1.0, fieldMeta ? fieldMeta->offset : 0.0
+        };
+
+        switch (field.baseType) {
+            case FIT_BASE_TYPE_STRING:
+                c.converter = PrintConverter::STRING;
+                break;
+
+            case FIT_BASE_TYPE_UINT32:
+            case FIT_BASE_TYPE_UINT32Z:
+                if (dateTime) {
+                    c.converter = PrintConverter::DATE_TIME;
+                } else if (duration) {
+                    c.converter = PrintConverter::DURATION;
+                } else if (scaled) {
+                    c.converter = PrintConverter::SCALED;
+                }
+                break;
+
+            case FIT_BASE_TYPE_SINT32:
+                if (scaled) {
+                    c.converter = PrintConverter::SCALED;
+                } else if (options.degrees && fieldMeta && fieldMeta->units == "semicircles") {
+                    c.converter = PrintConverter::DEGREES;
+                }
+                break;
+
+            default:
+                if (scaled) {
+                    c.converter = PrintConverter::SCALED;
+                }
+                break;
         }
-        
-        ossLine << "+-" << std::setw(width) << std::setfill('-') << "-" << "-";
-        ossHeader << "| " << std::setw(width) << std::setfill(' ') << ossFieldName.str() << " ";
 
-        lastFieldWidths.push_back(width);
+        p.columns.push_back(c);
+
+        p.line += "+-";
+        p.line.append(width, '-');
+        p.line += "-";
+
+        p.header += "| ";
+        padUtf8(p.header, fieldName, width);
+        p.header += " ";
     }
 
-    ossLine << "+";
-    ossHeader << "|";
+    p.line += "+";
+    p.header += "|";
+    p.ready = true;
 
-    if ((fieldFilter.size() > 0) && (lastMessageHeader == ossHeader.str())) {
+    return p;
+}
+
+void PrintScanner::printHeader(const PrintPlan& p) {
+    if ((fieldFilter.size() > 0) && (lastMessageHeader == p.header)) {
         return;
     }
 
     if (lastTableLine.length() > 0) {
-        std::cout << lastTableLine << std::endl << std::endl;
+        output += lastTableLine;
+        output += "\n\n";
     }
-    
-    lastFieldWidths.clear();
 
-    std::cout << "====  Message #" << d.globalMessageNumber;
+    output += p.title;
+    output += p.line;
+    output += "\n";
+    output += p.header;
+    output += "\n";
+    output += p.line;
+    output += "\n";
 
-    if (messageMeta) {
-        std::cout << " (" << messageMeta->name << ")";
+    lastMessageHeader = p.header;
+    lastTableLine = p.line;
+}
+
+int64_t PrintScanner::utcOffset(int64_t unixTs) {
+    std::time_t ts = static_cast<std::time_t>(unixTs);
+    std::tm local = *std::localtime(&ts);
+    int64_t localTs = daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 86400
+        + local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+
+    return localTs - unixTs;
+}
+
+void PrintScanner::printDateTime(uint32_t garminTs, uint16_t width) {
+    int64_t unixTs = static_cast<int64_t>(garminTs) + 631065600;
+    int64_t slot = unixTs / ZONE_SLOT;
+
+    // The offset is looked up at both ends of a slot: when they agree, it holds for the
+    // whole slot. Transitions are not on the hour everywhere (Lord Howe changes at :30,
+    // St. John's used to at 00:01), a slot with one is looked up for every timestamp.
+    if (slot != zoneSlot) {
+        zoneSlot = slot;
+        zoneOffset = utcOffset(slot * ZONE_SLOT);
+        zoneMixed = utcOffset(slot * ZONE_SLOT + ZONE_SLOT - 1) != zoneOffset;
     }
 
-    std::cout << "  ====" << std::endl;
-    
-    std::cout << ossLine.str() << std::endl;
-    std::cout << ossHeader.str() << std::endl;
-    std::cout << ossLine.str() << std::endl;
+    int64_t localTs = unixTs + (zoneMixed ? utcOffset(unixTs) : zoneOffset);
+    int64_t days = localTs / 86400;
+    int64_t seconds = localTs % 86400;
+    int64_t year;
+    unsigned month, day;
+
+    civilFromDays(days, year, month, day);
 
-    lastMessageHeader = ossHeader.str();
-    lastTableLine = ossLine.str();
+    auto out = std::back_inserter(output);
+
+    if (width > 19) {
+        output.append(width - 19, ' ');
+    }
+
+    std::format_to(out, "{:04}-{:02}-{:02} {:02}:{:02}:{:02}", year, month, day,
+        seconds / 3600, (seconds % 3600) / 60, seconds % 60);
 }
 
-void PrintScanner::printMessage(const FitDefinitionMessage& d, const FitDataMessage& m) {
-    std::ostringstream oss, ossOffset;
+void PrintScanner::printDuration(uint32_t value, double scale, uint16_t width) {
+    double totalSeconds = static_cast<double>(value) / scale;
 
-    size_t i = 0;
+    int hours = static_cast<int>(totalSeconds) / 3600;
+    int minutes = (static_cast<int>(totalSeconds) % 3600) / 60;
+    double seconds = totalSeconds - (hours * 3600 + minutes * 60);
 
-    for (auto field : d.fields) {
-        if (!fieldFilter.empty() && fieldFilter.find(field.fieldNumber) == fieldFilter.end()) {
-            continue;
-        }
+    auto out = std::back_inserter(output);
 
-        auto fieldMeta = fit::Profile::GetField(d.globalMessageNumber, field.fieldNumber);
-        uint64_t offset = m.offset + field.offset;
-        uint16_t fieldWidth = lastFieldWidths[i++];
-        
-        if (options.offset) {
-            std::ostringstream ossAtOffset;
-            ossAtOffset << "@" << offset;
-            ossOffset << "| " << std::setw(fieldWidth) << std::setfill(' ')
-                << ossAtOffset.str().c_str() << " ";
-        }
+    if (hours > 0) {
+        std::format_to(out, "{:>{}}", std::format("{}:{:02}:{:05.2f}", hours, minutes, seconds), width);
+    } else if (minutes > 0) {
+        std::format_to(out, "{:>{}}", std::format("{}:{:05.2f}", minutes, seconds), width);
+    } else {
+        std::format_to(out, "{:>{}.2f}", seconds, width);
+    }
+}
 
-        oss << "| ";
+void PrintScanner::printMessage(const FitDefinitionMessage& d, const FitDataMessage& m, const PrintPlan& p) {
+    auto out = std::back_inserter(output);
 
-        if (field.baseType != FIT_BASE_TYPE_STRING) {
-            oss << std::setw(fieldWidth) << std::setfill(' ');
+    if (options.offset) {
+        for (const auto &c : p.columns) {
+            std::format_to(out, "| {:>{}} ", std::format("@{}", m.offset + c.offset), c.width);
         }
 
-        switch (field.baseType) {
+        output += "|\n";
+    }
+
+    for (const auto &c : p.columns) {
+        uint64_t offset = m.offset + c.offset;
+        bool scaled = c.converter == PrintConverter::SCALED;
+
+        output += "| ";
+
+        switch (c.baseType) {
             case FIT_BASE_TYPE_ENUM:
             case FIT_BASE_TYPE_BYTE:
             case FIT_BASE_TYPE_UINT8:
             case FIT_BASE_TYPE_UINT8Z:
                 {
                     uint8_t value = mapper.read(offset);
-                    bool valid = ((field.baseType == FIT_BASE_TYPE_UINT8) && (value != FIT_UINT8_INVALID))
-                                || ((field.baseType == FIT_BASE_TYPE_UINT8Z) && (value != FIT_UINT8Z_INVALID));
-                    
+                    bool valid = ((c.baseType == FIT_BASE_TYPE_UINT8) && (value != FIT_UINT8_INVALID))
+                                || ((c.baseType == FIT_BASE_TYPE_UINT8Z) && (value != FIT_UINT8Z_INVALID));
 
-                    if (valid && !options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                        oss << (static_cast<double>(value)) / fieldMeta->scale - fieldMeta->offset;
+                    if (valid && scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
                     } else {
-                        oss << +value;
+                        std::format_to(out, "{:>{}}", value, c.width);
                     }
                 }
                 break;
-            
+
             case FIT_BASE_TYPE_SINT8:
                 {
                     int8_t value = mapper.readS(offset);
 
-                    if ((value != FIT_SINT8_INVALID) && !options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                        oss << (static_cast<double>(value)) / fieldMeta->scale - fieldMeta->offset;
+                    if ((value != FIT_SINT8_INVALID) && scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
                     } else {
-                        oss << +value;
+                        std::format_to(out, "{:>{}}", value, c.width);
                     }
                 }
                 break;
-            
+
             case FIT_BASE_TYPE_UINT16:
             case FIT_BASE_TYPE_UINT16Z:
                 {
                     uint16_t value = mapper.readU16(offset, d.architecture);
-                    // bool valid = true;
-                    bool valid = ((field.baseType == FIT_BASE_TYPE_UINT16) && (value != FIT_UINT16_INVALID))
-                                || ((field.baseType == FIT_BASE_TYPE_UINT16Z) && (value != FIT_UINT16Z_INVALID));
+                    bool valid = ((c.baseType == FIT_BASE_TYPE_UINT16) && (value != FIT_UINT16_INVALID))
+                                || ((c.baseType == FIT_BASE_TYPE_UINT16Z) && (value != FIT_UINT16Z_INVALID));
 
-                    if (valid && !options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                        oss << (static_cast<double>(value)) / fieldMeta->scale - fieldMeta->offset;
+                    if (valid && scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
                     } else {
-                        oss << value;
+                        std::format_to(out, "{:>{}}", value, c.width);
                     }
                 }
                 break;
@@ -185,10 +328,10 @@ void PrintScanner::printMessage(const FitDefinitionMessage& d, const FitDataMess
                 {
                     int16_t value = mapper.readS16(offset, d.architecture);
 
-                    if ((value != FIT_SINT16_INVALID) && !options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                        oss << (static_cast<double>(value)) / fieldMeta->scale - fieldMeta->offset;
+                    if ((value != FIT_SINT16_INVALID) && scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
                     } else {
-                        oss << value;
+                        std::format_to(out, "{:>{}}", value, c.width);
                     }
                 }
                 break;
@@ -196,20 +339,18 @@ void PrintScanner::printMessage(const FitDefinitionMessage& d, const FitDataMess
             case FIT_BASE_TYPE_UINT32:
             case FIT_BASE_TYPE_UINT32Z:
                 {
-                    if (!options.raw && ((fieldMeta && fieldMeta->profileType == fit::Profile::Type::DateTime) || (field.fieldNumber == 253))) {
-                        oss << mapper.readDateTime(offset, d.architecture);
-                    } else if (!options.raw && (fieldMeta && fieldMeta->units == "s" && fieldMeta->profileType == fit::Profile::Type::Uint32)) {
-                        oss << mapper.readDuration(offset, d.architecture, fieldMeta->scale);
+                    uint32_t value = mapper.readU32(offset, d.architecture);
+                    bool valid = ((c.baseType == FIT_BASE_TYPE_UINT32) && (value != FIT_UINT32_INVALID))
+                                || ((c.baseType == FIT_BASE_TYPE_UINT32Z) && (value != FIT_UINT32Z_INVALID));
+
+                    if (c.converter == PrintConverter::DATE_TIME) {
+                        printDateTime(value, c.width);
+                    } else if (c.converter == PrintConverter::DURATION) {
+                        printDuration(value, c.scale, c.width);
+                    } else if (valid && scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
                     } else {
-                        uint32_t value = mapper.readU32(offset, d.architecture);
-                        bool valid = ((field.baseType == FIT_BASE_TYPE_UINT32) && (value != FIT_UINT32_INVALID))
-                            || ((field.baseType == FIT_BASE_TYPE_UINT32Z) && (value != FIT_UINT32Z_INVALID));
-
-                        if (!options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                            oss << (static_cast<double>(value)) / fieldMeta->scale - fieldMeta->offset;
-                        } else {
-                            oss << value;
-                        }
+                        std::format_to(out, "{:>{}}", value, c.width);
                     }
                 }
                 break;
@@ -218,83 +359,78 @@ void PrintScanner::printMessage(const FitDefinitionMessage& d, const FitDataMess
                 {
                     int32_t value = mapper.readS32(offset, d.architecture);
 
-                    if ((value != FIT_SINT32_INVALID) && !options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                        oss << (static_cast<double>(value)) / fieldMeta->scale - fieldMeta->offset;
-                    } else if ((value != FIT_SINT8_INVALID) && options.degrees && (fieldMeta && fieldMeta->units == "semicircles")) {
-                        oss << std::setprecision(9) << fromInt32(value);
+                    if ((value != FIT_SINT32_INVALID) && scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
+                    } else if ((value != FIT_SINT32_INVALID) && c.converter == PrintConverter::DEGREES) {
+                        std::format_to(out, "{:>{}.9g}", fromInt32(value), c.width);
                     } else {
-                        oss << value;
+                        std::format_to(out, "{:>{}}", value, c.width);
                     }
                 }
                 break;
 
             case FIT_BASE_TYPE_FLOAT32:
-                if (!options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                    oss << (static_cast<double>(mapper.readFloat(offset, d.architecture))) / fieldMeta->scale - fieldMeta->offset;
-                } else {
-                    oss << mapper.readFloat(offset, d.architecture);
+                {
+                    float value = mapper.readFloat(offset, d.architecture);
+
+                    if (scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
+                    } else {
+                        std::format_to(out, "{:>{}.6g}", value, c.width);
+                    }
                 }
                 break;
-            
+
             case FIT_BASE_TYPE_FLOAT64:
-                if (!options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                    oss << (static_cast<double>(mapper.readDouble(offset, d.architecture))) / fieldMeta->scale - fieldMeta->offset;
-                } else {
-                    oss << mapper.readDouble(offset, d.architecture);
+                {
+                    double value = mapper.readDouble(offset, d.architecture);
+
+                    if (scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
+                    } else {
+                        std::format_to(out, "{:>{}.6g}", value, c.width);
+                    }
                 }
                 break;
 
             case FIT_BASE_TYPE_UINT64:
-                if (!options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                    oss << (static_cast<double>(mapper.readU64(offset, d.architecture))) / fieldMeta->scale - fieldMeta->offset;
-                } else {
-                    oss << mapper.readU64(offset, d.architecture);
+            case FIT_BASE_TYPE_UINT64Z:
+                {
+                    uint64_t value = mapper.readU64(offset, d.architecture);
+
+                    if (scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
+                    } else {
+                        std::format_to(out, "{:>{}}", value, c.width);
+                    }
                 }
                 break;
 
             case FIT_BASE_TYPE_SINT64:
-                if (!options.raw && (fieldMeta && fieldMeta->scale > 1)) {
-                    oss << (static_cast<double>(mapper.readU64(offset, d.architecture))) / fieldMeta->scale - fieldMeta->offset;
-                } else {
-                    oss << mapper.readS64(offset, d.architecture);
-                }
-                break;
-            
-            case FIT_BASE_TYPE_STRING:
                 {
-                    std::string extractedString = mapper.readString(offset, field.size);
-
-                    size_t utf8_length = 0;
-                    for (char value : extractedString)
-                    {
-                        if ((value & 0xc0) != 0x80)
-                        {
-                            ++utf8_length;
-                        }
-                    }
+                    int64_t value = mapper.readS64(offset, d.architecture);
 
-                    oss << std::setw(fieldWidth + extractedString.length() - utf8_length) << std::setfill(' ');
-                    oss << extractedString.c_str();
+                    if (scaled) {
+                        std::format_to(out, "{:>{}.6g}", value / c.scale - c.valueOffset, c.width);
+                    } else {
+                        std::format_to(out, "{:>{}}", value, c.width);
+                    }
                 }
                 break;
 
+            case FIT_BASE_TYPE_STRING:
+                padUtf8(output, mapper.readString(offset, c.size).c_str(), c.width);
+                break;
+
             default:
-                oss << "???";
+                std::format_to(out, "{:>{}}", "???", c.width);
                 break;
         }
-        oss << " ";
-    }
 
-    if (options.offset) {
-        ossOffset << "|";
+        output += " ";
     }
 
-    oss << "|";
-
-    if (options.offset) {
-        std::cout << ossOffset.str() << std::endl;
-    }
-    std::cout << oss.str() << std::endl;
+    output += "|\n";
 }
 
 void PrintScanner::record(const FitDefinitionMessage& d, const FitDataMessage& m) {
@@ -302,23 +438,34 @@ void PrintScanner::record(const FitDefinitionMessage& d, const FitDataMessage& m
         return;
     }
 
+    const PrintPlan &p = plan(m.definitionIndex, d);
+
     if (lastDefinitionIndex != m.definitionIndex) {
-        printHeader(d);
+        printHeader(p);
         lastDefinitionIndex = m.definitionIndex;
     }
 
-    printMessage(d, m);
+    printMessage(d, m, p);
+
+    if (output.size() >= BLOCK_SIZE) {
+        flush();
+    }
 }
 
 void PrintScanner::reset() {
     lastTableLine = "";
     lastDefinitionIndex = -1;
+    plans.clear();
+    output.reserve(BLOCK_SIZE + BLOCK_SIZE / 8);
 }
 
 void PrintScanner::end() {
     if (lastTableLine.length() > 0) {
-        std::cout << lastTableLine << std::endl;
+        output += lastTableLine;
+        output += "\n";
     }
+
+    flush();
 }
 
 } // namespace darauble
@@ -16,21 +16,66 @@ struct PrintScannerOptions {
     bool degrees; // Show coordinates in degrees (all fields that have units as "semicircles")
 };
 
+/*
+  How a field of a definition is printed, worked out once per definition.
+ */
+enum class PrintConverter : uint8_t {
+    NUMBER,    // As read
+    SCALED,    // value / scale - offset, valid values only
+    DATE_TIME, // Local time, YYYY-MM-DD HH:MM:SS
+    DURATION,  // [H:]MM:SS.ss
+    DEGREES,   // Semicircles to degrees
+    STRING
+};
+
+struct PrintColumn {
+    uint16_t offset;   // From the record start, as FitFieldDefinition::offset
+    uint8_t size;
+    uint8_t baseType;
+    uint16_t width;
+    PrintConverter converter;
+    double scale;
+    double valueOffset;
+};
+
+struct PrintPlan {
+    bool ready {false};
+    std::string title;  // "====  Message #N (name)  ===="
+    std::string header;
+    std::string line;
+    std::vector<PrintColumn> columns;
+};
+
 class PrintScanner : public BinaryScanner {
 protected:
+    // Output is collected and written to std::cout in blocks of this size
+    static const size_t BLOCK_SIZE = 1 << 20;
+    // Seconds of timestamps sharing one time zone offset lookup
+    static const int64_t ZONE_SLOT = 900;
+
     PrintScannerOptions &options;
 
     int32_t lastDefinitionIndex;
     std::string lastMessageHeader;
     std::string lastTableLine;
-    std::vector<uint16_t> lastFieldWidths;
     std::unordered_set<uint16_t> messageFilter;
     std::unordered_set<uint16_t> fieldFilter;
 
-    // bool showOffset;
+    std::vector<PrintPlan> plans; // By definition index
+    std::string output;
 
-    void printHeader(const FitDefinitionMessage& d);
-    void printMessage(const FitDefinitionMessage& d, const FitDataMessage& m);
+    // Local time conversion, the UTC offset is looked up once per 15 minutes of timestamps
+    int64_t zoneSlot;
+    int64_t zoneOffset;
+    bool zoneMixed; // The offset changes within the slot
+
+    const PrintPlan& plan(int32_t definitionIndex, const FitDefinitionMessage& d);
+    void printHeader(const PrintPlan& p);
+    void printMessage(const FitDefinitionMessage& d, const FitDataMessage& m, const PrintPlan& p);
+    static int64_t utcOffset(int64_t unixTs);
+    void printDateTime(uint32_t garminTs, uint16_t width);
+    void printDuration(uint32_t value, double scale, uint16_t width);
+    void flush();
 public:
     const std::map<uint8_t, uint32_t> FIT_TYPE_WIDTH = {
         {FIT_BASE_TYPE_ENUM, 3},
@@ -55,9 +100,11 @@ public:
     PrintScanner(BinaryMapper& _mapper, const std::unordered_set<uint16_t>& _messageFilter, const std::unordered_set<uint16_t>& _fieldFilter, PrintScannerOptions &_options):
         BinaryScanner(_mapper), messageFilter {_messageFilter},
         fieldFilter {_fieldFilter}, lastDefinitionIndex {-1},
-        lastMessageHeader {""}, options {_options}
+        lastMessageHeader {""}, options {_options}, zoneSlot {INT64_MIN}, zoneOffset {0}, zoneMixed {false}
     {}
 
+    ~PrintScanner();
+
     static void defaultOptions(PrintScannerOptions &o);
 
     virtual void reset() override;
@@ -1,6 +1,5 @@
 #include "product-scanner.hpp"
 
-#include <iostream>
 #include <cstdint>
 
 #include <fit_file_id_mesg.hpp>
@@ -21,8 +20,7 @@ void ProductScanner::record(const FitDefinitionMessage& d, const FitDataMessage&
                 }
 
                 if (searchProductId == FIT_UINT16_INVALID || productId == searchProductId) {
-                    std::cout << "File ID product: " << productId << " at offset " << recordOffset << std::endl;
-                    productIdOffsets.push_back({d.architecture, recordOffset});
+                    productIdOffsets.push_back({d.architecture, recordOffset, productId, FIT_MESG_NUM_FILE_ID});
                 }
             }
         }
@@ -38,8 +36,7 @@ void ProductScanner::record(const FitDefinitionMessage& d, const FitDataMessage&
                 }
 
                 if (searchProductId == FIT_UINT16_INVALID || productId == searchProductId) {
-                    std::cout << "Device Info product: " << productId << " at offset " << recordOffset << std::endl;
-                    productIdOffsets.push_back({d.architecture, recordOffset});
+                    productIdOffsets.push_back({d.architecture, recordOffset, productId, FIT_MESG_NUM_DEVICE_INFO});
                 }
             }
         }
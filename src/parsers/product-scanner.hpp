@@ -10,6 +10,8 @@ namespace darauble {
 struct productId {
     uint8_t architecture;
     uint64_t offset;
+    uint16_t product;
+    uint16_t globalMessageNumber; // File ID or Device Info
 };
 
 class ProductScanner : public BinaryScanner {
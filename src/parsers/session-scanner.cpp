@@ -32,6 +32,8 @@ void SessionScanner::record(const FitDefinitionMessage& d, const FitDataMessage&
     } else if (d.globalMessageNumber == FIT_MESG_NUM_SESSION) {
         // Handle session message for activity data
         SessionData session;
+        int32_t startLat = FIT_SINT32_INVALID;
+        int32_t startLong = FIT_SINT32_INVALID;
         
         for (const auto& fieldDef : d.fields) {
             uint64_t fieldOffset = m.offset + fieldDef.offset;
@@ -105,6 +107,42 @@ void SessionScanner::record(const FitDefinitionMessage& d, const FitDataMessage&
                     }
                     break;
                     
+                case fit::SessionMesg::FieldDefNum::NecLat:
+                    if (fieldDef.size == 4) {
+                        session.necLat = mapper.readS32(fieldOffset, d.architecture);
+                    }
+                    break;
+
+                case fit::SessionMesg::FieldDefNum::NecLong:
+                    if (fieldDef.size == 4) {
+                        session.necLong = mapper.readS32(fieldOffset, d.architecture);
+                    }
+                    break;
+
+                case fit::SessionMesg::FieldDefNum::SwcLat:
+                    if (fieldDef.size == 4) {
+                        session.swcLat = mapper.readS32(fieldOffset, d.architecture);
+                    }
+                    break;
+
+                case fit::SessionMesg::FieldDefNum::SwcLong:
+                    if (fieldDef.size == 4) {
+                        session.swcLong = mapper.readS32(fieldOffset, d.architecture);
+                    }
+                    break;
+
+                case fit::SessionMesg::FieldDefNum::StartPositionLat:
+                    if (fieldDef.size == 4) {
+                        startLat = mapper.readS32(fieldOffset, d.architecture);
+                    }
+                    break;
+
+                case fit::SessionMesg::FieldDefNum::StartPositionLong:
+                    if (fieldDef.size == 4) {
+                        startLong = mapper.readS32(fieldOffset, d.architecture);
+                    }
+                    break;
+
                 case 151:  // Total sets field (for strength training)
                     if (fieldDef.size == 2) {
                         uint16_t sets = mapper.readU16(fieldOffset, d.architecture);
@@ -116,7 +154,12 @@ void SessionScanner::record(const FitDefinitionMessage& d, const FitDataMessage&
             }
         }
         
-        
+        // Older devices don't write the bounding box, fall back to the start position
+        if (!session.hasBounds() && startLat != FIT_SINT32_INVALID && startLong != FIT_SINT32_INVALID) {
+            session.necLat = session.swcLat = startLat;
+            session.necLong = session.swcLong = startLong;
+        }
+
         // Only add sessions that have meaningful data
         if (session.sport > 0 || session.totalElapsedTime > 0) {
             activityData.sessions.push_back(session);
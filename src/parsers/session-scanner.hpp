@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -27,12 +28,36 @@ struct SessionData {
     uint16_t avgHeartRate = 0;        // bpm
     uint16_t maxHeartRate = 0;        // bpm
     uint16_t totalSets = 0;           // total sets (for strength training)
+    int32_t necLat = FIT_SINT32_INVALID;   // bounding box north-east corner, semicircles
+    int32_t necLong = FIT_SINT32_INVALID;
+    int32_t swcLat = FIT_SINT32_INVALID;   // bounding box south-west corner, semicircles
+    int32_t swcLong = FIT_SINT32_INVALID;
+
+    bool hasBounds() const {
+        return necLat != FIT_SINT32_INVALID && necLong != FIT_SINT32_INVALID
+            && swcLat != FIT_SINT32_INVALID && swcLong != FIT_SINT32_INVALID;
+    }
+
+    void extendBounds(const SessionData& other) {
+        if (!other.hasBounds()) return;
+        if (!hasBounds()) {
+            necLat = other.necLat;
+            necLong = other.necLong;
+            swcLat = other.swcLat;
+            swcLong = other.swcLong;
+            return;
+        }
+        necLat = std::max(necLat, other.necLat);
+        necLong = std::max(necLong, other.necLong);
+        swcLat = std::min(swcLat, other.swcLat);
+        swcLong = std::min(swcLong, other.swcLong);
+    }
     
     std::string getSportName() const {
-        if (subSport > 0 && metadata::Sports::subNames.containsKey(subSport)) {
-            return metadata::Sports::subNames.atKey(subSport);
-        } else if (metadata::Sports::names.containsKey(sport)) {
-            return metadata::Sports::names.atKey(sport);
+        if (subSport > 0 && !metadata::Sports::subNames[subSport].empty()) {
+            return std::string(metadata::Sports::subNames[subSport]);
+        } else if (!metadata::Sports::names[sport].empty()) {
+            return std::string(metadata::Sports::names[sport]);
         }
         return "Unknown";
     }
@@ -183,6 +208,7 @@ struct ActivityData {
             aggregated.totalDistance += session.totalDistance;
             aggregated.totalCalories += session.totalCalories;
             aggregated.totalSets += session.totalSets;
+            aggregated.extendBounds(session);
         }
         
         // Calculate weighted averages for heart rate and speed
@@ -211,10 +237,10 @@ struct ActivityData {
     }
     
     std::string getPrimarySportName() const {
-        if (primarySubSport > 0 && metadata::Sports::subNames.containsKey(primarySubSport)) {
-            return metadata::Sports::subNames.atKey(primarySubSport);
-        } else if (metadata::Sports::names.containsKey(primarySport)) {
-            return metadata::Sports::names.atKey(primarySport);
+        if (primarySubSport > 0 && !metadata::Sports::subNames[primarySubSport].empty()) {
+            return std::string(metadata::Sports::subNames[primarySubSport]);
+        } else if (!metadata::Sports::names[primarySport].empty()) {
+            return std::string(metadata::Sports::names[primarySport]);
         }
         return "Unknown";
     }
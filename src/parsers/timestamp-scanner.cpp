@@ -1,4 +1,5 @@
 #include "timestamp-scanner.hpp"
+#include "profile-index.hpp"
 
 #include <fit_profile.hpp>
 
@@ -8,7 +9,7 @@ namespace darauble {
 
 void TimestampScanner::record(const FitDefinitionMessage& d, const FitDataMessage& m) {
     for (auto &f : d.fields) {
-        auto fieldMeta = fit::Profile::GetField(d.globalMessageNumber, f.fieldNumber);
+        auto fieldMeta = metadata::ProfileIndex::field(d.globalMessageNumber, f.fieldNumber);
 
         if (fieldMeta && fieldMeta->profileType == fit::Profile::Type::DateTime) {
             uint64_t offset, recordOffset;
@@ -5,6 +5,8 @@
 #include "coordinates-scanner.hpp"
 #include "single-point.hpp"
 #include "exceptions.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
 
 namespace darauble {
 
@@ -28,12 +30,16 @@ static std::map<std::string, FIT_SPORT> sport_map = {
 };
 
 void SinglePointHandler::parse(const fs::path& filepath, std::vector<int32_t>& la, std::vector<int32_t>& lo) {
+    GFU_TRACE_SCOPE("points.parse", "parse");
+
     BinaryMapper mapper {filepath};
     CoordinatesScanner scanner {mapper, sport, la, lo};
     scanner.scan();
 }
 
 uint32_t SinglePointHandler::search(std::vector<int32_t>& la, std::vector<int32_t>& lo) {
+    GFU_TRACE_SCOPE("points.search", "search");
+
     uint32_t found {0};
 
     for (size_t i {0}; i < lo.size() - 1; i++) {
@@ -68,39 +74,35 @@ void SinglePointHandler::handle(const fs::path& filename) {
     std::vector<int32_t> la, lo;
 
     try {
-        auto start = std::chrono::high_resolution_clock::now();
-
         parse(filename, la, lo);
 
-        auto end = std::chrono::high_resolution_clock::now();
-
-        std::cout << "File " << filename << " parsed, read " << lo.size() << " points in " << (double) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1000000000 << " s" << std::endl;
+        GFU_LOG(Info, "points", "File " << filename << " parsed, read " << lo.size() << " points");
 
         if (la.size() != lo.size()) {
-            std::cout << "Something's really very wrong!" << std::endl;
+            GFU_LOG(Error, "points", "File " << filename << ": " << la.size() << " latitudes, but " << lo.size() << " longitudes");
             return;
         }
         
-        start = std::chrono::high_resolution_clock::now();
         uint32_t found = search(la, lo);
 
-        end = std::chrono::high_resolution_clock::now();
-
-        std::cout << "Found intersection(s): " << found << ". Searched for " << (double) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1000000000 << " s" << std::endl;
+        GFU_LOG(Info, "points", "Found intersection(s): " << found);
+        GFU_TRACE_SAMPLE("points.segments", lo.size());
 
         summary.incrementParsedFiles();
         summary.incrementFilteredFiles();
 
         if (found > 0) {
             summary.incrementTotalVisits();
+            GFU_TRACE_COUNT("points.visits", 1);
         }
 
     } catch (const WrongSportException& e) {
         summary.incrementParsedFiles();
-        std::cerr << e.what() << std::endl;
-    } catch (...)
-    {
-        std::cerr << "Exception decoding file" << std::endl;
+        GFU_LOG(Debug, "points", "File " << filename << ": " << e.what());
+    } catch (const std::exception& e) {
+        GFU_LOG(Warning, "points", "File " << filename << ": exception decoding file: " << e.what());
+    } catch (...) {
+        GFU_LOG(Warning, "points", "File " << filename << ": exception decoding file");
     }
 }
 
@@ -18,9 +18,13 @@ private:
     SingleSummary& summary;
 
     void parse(const fs::path& filepath, std::vector<int32_t>& la, std::vector<int32_t>& lo);
-    uint32_t search(std::vector<int32_t>& la, std::vector<int32_t>& lo);
 public:
     SinglePointHandler(SingleSummary& _summary, std::string _sport, BoundingBox _box);
+
+    /*
+      Count the track segments crossing the searched box.
+     */
+    uint32_t search(std::vector<int32_t>& la, std::vector<int32_t>& lo);
     void handle(const fs::path& filename) override;
 };
 
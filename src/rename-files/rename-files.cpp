@@ -1,84 +1,90 @@
-#include <iostream>
-#include <fstream>
 #include <iomanip>
-#include <chrono>
+#include <sstream>
+#include <ctime>
 
-#include <fit_date_time.hpp>
-#include <fit_decode.hpp>
-#include <fit_mesg_broadcaster.hpp>
-
-#include "exceptions.hpp"
+#include "binary-mapper.hpp"
+#include "file-id-scanner.hpp"
+#include "logger.hpp"
 #include "rename-files.hpp"
 
 namespace darauble {
 
+namespace {
 
-void Listener::OnMesg(fit::FileIdMesg& mesg) {
-        fit::DateTime created {mesg.GetTimeCreated()};
-        fileCreated = created.GetTimeT();
-        
-        if (mesg.GetType() != FIT_FILE_ACTIVITY) {
-            throw NotActivityException("File is not of activity type");
-        }
-
-        throw StopParsingException("Date found!");
-    }
+bool readFileId(BinaryMapper& mapper, uint8_t& type, uint32_t& timeCreated) {
+    FileIdScanner scanner {mapper};
+    scanner.scan();
 
-FitFileHandler::FitFileHandler() {
-    broadcaster.AddListener((fit::FileIdMesgListener&)listener);
+    type = scanner.type();
+    timeCreated = scanner.timeCreated();
+    return scanner.found();
 }
 
+} // namespace
+
 void FitFileHandler::handle(const fs::path& filename) {
-    std::cout << "Fit file: " << filename.string() << std::endl;
+    GFU_LOG(Info, "rename", "Fit file: " << filename.string());
+    files++;
 
-    std::ifstream file(filename.string(), std::ios::in | std::ios::binary);
+    bool parsed {false};
+    std::time_t fileCreated {0};
 
-    if (!file.is_open()) {
-        std::cerr << "  Failed to open FIT file." << std::endl;
-        return;
-    }
+    try {
+        uint8_t type;
+        uint32_t timeCreated;
 
-    bool parsed {false};
+        BinaryMapper mapper {filename, FileIdScanner::PREFIX_SIZE};
+        bool found = readFileId(mapper, type, timeCreated);
 
-    if (!decode.CheckIntegrity(file))
-    {
-        std::cerr << "  FIT file integrity failed. Attempting to decode..." << std::endl;
-    }
+        if (!found && mapper.isPartial()) {
+            // Unusually long definitions before the File ID, read the whole file
+            BinaryMapper fullMapper {filename};
+            found = readFileId(fullMapper, type, timeCreated);
+        }
 
-    try {
-        decode.Read(file, broadcaster);
-    } catch (const StopParsingException& e) {
-        parsed = true;
-    } catch (const NotActivityException& e) {
-        std::cerr << "  File is not an activity, skipping." << std::endl;
-        goto except;
-    } catch (const fit::RuntimeException& e) {
-        std::cerr << "  Exception decoding file: " << e.what() << std::endl;
-        goto except;
+        if (!found || timeCreated == FIT_DATE_TIME_INVALID) {
+            GFU_LOG(Info, "rename", "  No File ID creation time found, skipping.");
+        } else if (type != FIT_FILE_ACTIVITY) {
+            GFU_LOG(Info, "rename", "  File is not an activity, skipping.");
+        } else {
+            fileCreated = static_cast<std::time_t>(timeCreated) + FileIdScanner::FIT_EPOCH;
+            parsed = true;
+        }
     } catch (const std::exception& e) {
-        std::cerr << "  Exception decoding file: " << e.what() << std::endl;
-        goto except;
+        GFU_LOG(Warning, "rename", filename.string() << ": exception decoding file: " << e.what());
+        failed++;
+        return;
     }
 
-except:
-    if (parsed) {
-        std::tm ts = *std::localtime(&fileCreated);
+    if (!parsed) {
+        skipped++;
+        return;
+    }
 
-        std::ostringstream oss;
-        oss << std::put_time(&ts, "%Y-%m-%d-%H-%M-%S");
+    std::tm ts = *std::localtime(&fileCreated);
 
-        std::cout << "  File created at: " << fileCreated << ", " << oss.str() << std::endl;
-        fs::path newName = filename.parent_path() / oss.str();
-        newName += ".fit";
-        
-        if (!fs::exists(newName)) {
-            std::cout <<  "  Renaming to: " << newName.string() << std::endl;
-            fs:rename(filename, newName);
-        }
+    std::ostringstream oss;
+    oss << std::put_time(&ts, "%Y-%m-%d-%H-%M-%S");
+
+    GFU_LOG(Info, "rename", "  File created at: " << fileCreated << ", " << oss.str());
+    fs::path newName = filename.parent_path() / oss.str();
+    newName += ".fit";
 
+    if (newName == filename || fs::exists(newName)) {
+        skipped++;
+        return;
     }
 
-    file.close();
+    std::error_code ec;
+    fs::rename(filename, newName, ec);
+
+    if (ec) {
+        GFU_LOG(Warning, "rename", filename.string() << ": cannot rename to " << newName.string() << ": " << ec.message());
+        failed++;
+    } else {
+        GFU_LOG(Info, "rename", "  Renaming to: " << newName.string());
+        renamed++;
+    }
 }
 
 } // namespace darauble
\ No newline at end of file
@@ -1,35 +1,23 @@
 #pragma once
-#include <fit_date_time.hpp>
-#include <fit_decode.hpp>
-#include <fit_mesg_broadcaster.hpp>
+
+#include <cstdint>
 
 #include "directory-scanner.hpp"
 
 namespace darauble {
 
-class Listener :
-    public fit::FileIdMesgListener
-{
-private:
-    std::time_t &fileCreated;
-public:
-    Listener(std::time_t &_fileCreated) :
-        fileCreated {_fileCreated}
-    {
-
-    }
-    
-    void OnMesg(fit::FileIdMesg& mesg) override;
-};
-
+/*
+  Renames activity files after their creation time (File ID time_created), like the watch names them.
+  Reads only the beginning of each file, the File ID is the first message.
+ */
 class FitFileHandler: public IFileHandler {
-private:
-    fit::Decode decode;
-    fit::MesgBroadcaster broadcaster;
-    std::time_t fileCreated {0};
-    Listener listener {fileCreated};
 public:
-    FitFileHandler();
+    // Files seen, renamed, left as they are (not activities, already named) and failed
+    uint64_t files {0};
+    uint64_t renamed {0};
+    uint64_t skipped {0};
+    uint64_t failed {0};
+
     void handle(const fs::path& filename);
 };
 
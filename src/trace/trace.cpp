@@ -0,0 +1,310 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace darauble {
+
+namespace {
+
+enum class StatKind { TIMER, COUNTER, HISTOGRAM };
+
+struct Stat {
+    StatKind kind {StatKind::TIMER};
+    uint64_t count {0};
+    int64_t sum {0};
+    uint64_t min {UINT64_MAX};
+    uint64_t max {0};
+    uint64_t buckets[65] {}; // By bit width: bucket b holds values below 2^b
+
+    void add(uint64_t value) {
+        count++;
+        sum += static_cast<int64_t>(value);
+        min = std::min(min, value);
+        max = std::max(max, value);
+        buckets[std::bit_width(value)]++;
+    }
+
+    void merge(const Stat& other) {
+        kind = other.kind;
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+
+        for (int i = 0; i < 65; i++) {
+            buckets[i] += other.buckets[i];
+        }
+    }
+
+    // Upper bound of the bucket holding the percentile, never above the maximum
+    uint64_t percentile(double p) const {
+        uint64_t rank = static_cast<uint64_t>(p * (count - 1)) + 1;
+        uint64_t seen = 0;
+
+        for (int i = 0; i < 65; i++) {
+            seen += buckets[i];
+
+            if (seen >= rank) {
+                return i == 0 ? 0 : std::min(max, i == 64 ? UINT64_MAX : (uint64_t(1) << i) - 1);
+            }
+        }
+
+        return max;
+    }
+};
+
+struct Event {
+    const char* name;
+    const char* category;
+    uint64_t start;
+    uint64_t end;
+};
+
+// One per thread, so probes never contend; the mutex is only taken by dumps
+struct ThreadBuffer {
+    std::mutex mutex;
+    uint32_t tid {0};
+    uint64_t dropped {0};
+    std::vector<Event> events;
+    std::unordered_map<const char*, Stat> stats;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+// Never destroyed: worker threads may still finish a probe while the process exits
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+ThreadBuffer& local() {
+    // Kept alive by the registry after the thread ends, its data is still dumped
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        buffer->tid = static_cast<uint32_t>(r.buffers.size()) + 1;
+        r.buffers.push_back(buffer);
+    }
+
+    return *buffer;
+}
+
+std::chrono::steady_clock::time_point epoch() {
+    static const auto start = std::chrono::steady_clock::now();
+    return start;
+}
+
+// Statistics of all threads merged by name: literals in different files may differ by pointer
+std::map<std::string, Stat> merged() {
+    std::map<std::string, Stat> stats;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    for (auto& buffer : r.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+        for (const auto& [name, stat] : buffer->stats) {
+            stats[name].merge(stat);
+        }
+    }
+
+    return stats;
+}
+
+std::string escape(const char* value) {
+    std::string escaped;
+
+    for (const char* c = value; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped += '\\';
+        }
+
+        escaped += *c;
+    }
+
+    return escaped;
+}
+
+} // namespace
+
+void Trace::enable() {
+    epoch();
+    active.store(true, std::memory_order_relaxed);
+}
+
+void Trace::disable() {
+    active.store(false, std::memory_order_relaxed);
+}
+
+uint64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch()).count();
+}
+
+void Trace::complete(const char* name, const char* category, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = local();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+
+    if (buffer.events.size() < MAX_EVENTS) {
+        buffer.events.push_back({name, category, start, end});
+    } else {
+        buffer.dropped++;
+    }
+
+    Stat& stat = buffer.stats[name];
+    stat.kind = StatKind::TIMER;
+    stat.add(end - start);
+}
+
+void Trace::count(const char* name, int64_t delta) {
+    ThreadBuffer& buffer = local();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+
+    Stat& stat = buffer.stats[name];
+    stat.kind = StatKind::COUNTER;
+    stat.count++;
+    stat.sum += delta;
+}
+
+void Trace::sample(const char* name, uint64_t value) {
+    ThreadBuffer& buffer = local();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+
+    Stat& stat = buffer.stats[name];
+    stat.kind = StatKind::HISTOGRAM;
+    stat.add(value);
+}
+
+void Trace::chrome(std::ostream& out, const std::string& process) {
+    uint64_t end = now();
+    uint64_t dropped = 0;
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \""
+        << escape(process.c_str()) << "\"}}";
+    out << std::fixed << std::setprecision(3);
+
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        for (auto& buffer : r.buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+            out << "," << std::endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+                << ", \"args\": {\"name\": \"thread " << buffer->tid << "\"}}";
+
+            // Chrome trace times are in microseconds
+            for (const auto& e : buffer->events) {
+                out << "," << std::endl << "{\"name\": \"" << escape(e.name) << "\", \"cat\": \"" << escape(e.category)
+                    << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->tid
+                    << ", \"ts\": " << e.start / 1000.0 << ", \"dur\": " << (e.end - e.start) / 1000.0 << "}";
+            }
+
+            dropped += buffer->dropped;
+        }
+    }
+
+    // Counters show up as tracks with their final value
+    for (const auto& [name, stat] : merged()) {
+        if (stat.kind == StatKind::COUNTER) {
+            out << "," << std::endl << "{\"name\": \"" << escape(name.c_str()) << "\", \"ph\": \"C\", \"pid\": 1, \"ts\": "
+                << end / 1000.0 << ", \"args\": {\"value\": " << stat.sum << "}}";
+        }
+    }
+
+    out << std::endl << "], \"otherData\": {\"droppedEvents\": " << dropped << "}}" << std::endl;
+}
+
+void Trace::summary(std::ostream& out) {
+    auto stats = merged();
+
+    if (stats.empty()) {
+        return;
+    }
+
+    out << std::left << std::setw(28) << "Probe" << std::setw(10) << "Kind"
+        << std::right << std::setw(10) << "Count" << std::setw(14) << "Total"
+        << std::setw(12) << "Mean" << std::setw(12) << "~p50" << std::setw(12) << "~p99" << std::setw(12) << "Max" << std::endl;
+
+    for (const auto& [name, stat] : stats) {
+        out << std::left << std::setw(28) << name << std::right;
+
+        if (stat.kind == StatKind::COUNTER) {
+            out << std::setw(10) << std::left << "counter" << std::right
+                << std::setw(10) << stat.count << std::setw(14) << stat.sum << std::endl;
+            continue;
+        }
+
+        // Timers in milliseconds, histograms as they were sampled
+        double unit = stat.kind == StatKind::TIMER ? 1e6 : 1.0;
+        out << std::setw(10) << std::left << (stat.kind == StatKind::TIMER ? "ms" : "histogram") << std::right
+            << std::setw(10) << stat.count << std::fixed << std::setprecision(stat.kind == StatKind::TIMER ? 3 : 1)
+            << std::setw(14) << stat.sum / unit
+            << std::setw(12) << stat.sum / unit / stat.count
+            << std::setw(12) << stat.percentile(0.5) / unit
+            << std::setw(12) << stat.percentile(0.99) / unit
+            << std::setw(12) << stat.max / unit << std::endl;
+    }
+}
+
+void Trace::reset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    for (auto& buffer : r.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->stats.clear();
+        buffer->dropped = 0;
+    }
+}
+
+TraceSession::TraceSession(const std::string& _process) :
+    process {_process}
+{
+    const char* path = std::getenv(ENVIRONMENT);
+
+    if (path && *path) {
+        output = path;
+        Trace::enable();
+    }
+}
+
+TraceSession::~TraceSession() {
+    if (output.empty()) {
+        return;
+    }
+
+    Trace::disable();
+
+    std::ofstream out(output, std::ios::trunc);
+
+    if (out) {
+        Trace::chrome(out, process);
+    } else {
+        std::cerr << "Cannot write the trace to " << output << std::endl;
+    }
+
+    std::cerr << std::endl;
+    Trace::summary(std::cerr);
+}
+
+} // namespace darauble
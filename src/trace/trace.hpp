@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace darauble {
+
+/*
+  Process-wide instrumentation: scoped timers, counters and histograms, collected
+  per thread and dumped as a Chrome/Perfetto trace (chrome://tracing, ui.perfetto.dev)
+  and as a summary table.
+
+  Disabled by default; then every probe is a single relaxed atomic load. Building
+  without GFU_TRACE (OPT_TRACE=OFF) removes the probes altogether. Names and
+  categories must be string literals, they are kept by pointer.
+ */
+class Trace {
+private:
+    static inline std::atomic<bool> active {false};
+
+public:
+    // Timed scopes kept for the trace per thread, the summary keeps counting past it
+    static const size_t MAX_EVENTS = 1 << 20;
+
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+    static void enable();
+    static void disable();
+
+    // Nanoseconds since the process started tracing
+    static uint64_t now();
+
+    static void complete(const char* name, const char* category, uint64_t start, uint64_t end);
+    static void count(const char* name, int64_t delta = 1);
+    static void sample(const char* name, uint64_t value);
+
+    static void chrome(std::ostream& out, const std::string& process);
+    static void summary(std::ostream& out);
+    static void reset();
+};
+
+class TraceScope {
+private:
+    const char* name;
+    const char* category;
+    uint64_t start;
+    bool active;
+
+public:
+    TraceScope(const char* _name, const char* _category) :
+        name {_name}, category {_category}, start {0}, active {Trace::enabled()}
+    {
+        if (active) {
+            start = Trace::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (active) {
+            Trace::complete(name, category, start, Trace::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+/*
+  Tracing for a whole run of a tool, controlled by the environment:
+  GFU_TRACE=<file.json> enables it and writes the Chrome trace there when the
+  session ends, the summary table goes to the standard error.
+ */
+class TraceSession {
+private:
+    std::string process;
+    std::string output;
+
+public:
+    static constexpr auto ENVIRONMENT = "GFU_TRACE";
+
+    TraceSession(const std::string& _process);
+    ~TraceSession();
+
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+};
+
+} // namespace darauble
+
+#ifdef GFU_TRACE
+#define GFU_TRACE_CONCAT_(a, b) a##b
+#define GFU_TRACE_CONCAT(a, b) GFU_TRACE_CONCAT_(a, b)
+#define GFU_TRACE_SCOPE(name, category) darauble::TraceScope GFU_TRACE_CONCAT(traceScope, __LINE__) {name, category}
+#define GFU_TRACE_COUNT(name, delta) do { if (darauble::Trace::enabled()) { darauble::Trace::count(name, delta); } } while (0)
+#define GFU_TRACE_SAMPLE(name, value) do { if (darauble::Trace::enabled()) { darauble::Trace::sample(name, value); } } while (0)
+#else
+#define GFU_TRACE_SCOPE(name, category) do {} while (0)
+#define GFU_TRACE_COUNT(name, delta) do {} while (0)
+#define GFU_TRACE_SAMPLE(name, value) do {} while (0)
+#endif